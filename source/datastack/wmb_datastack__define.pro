@@ -8,6 +8,12 @@
 ;   an arbitrary dataset.  The data may be stored entirely in 
 ;   memory, or it may be accessed dynamically from disk as needed.
 ;
+;   The Change_Datatype, Negate_Data and Rebin_Data methods do not
+;   change the stored data.  They are recorded in a list of pending
+;   operations, which are applied together to one slab of the data
+;   at a time (see _EvalSlab) when the stack is subscripted or its
+;   statistics are computed.
+;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
 
@@ -83,6 +89,51 @@ function wmb_DataStack::_overloadBracketsRightSide, isRange, sub1, $
     endif
     
     
+    ; apply any pending operations to the selected part of the data
+    if self.ds_ops.Count() gt 0 then $
+        return, self._EvalSubscripts(isrange, inputlist[0:n_inputs-1])
+    
+    
+    ; index arrays cannot be converted to ranges - read the elements
+    ; directly.  any array subscript, even of one element, is an index
+    ; list and keeps its dimension, as for wmb_VirtualArray
+    chk_index_array = 0
+    for i = 0, n_inputs-1 do begin
+        if (isrange[i] eq 0) && (size(inputlist[i], /N_DIMENSIONS) gt 0) then $
+            chk_index_array = 1
+    endfor
+    
+    if chk_index_array eq 1 then begin
+    
+        if self.ds_flag_varray eq 1 then begin
+        
+            return, (self.ds_varray)._overloadBracketsRightSide(isrange, $
+                        sub1, sub2, sub3, sub4, sub5, sub6, sub7, sub8)
+                        
+        endif
+        
+        wmb_varray_generate_read_sequence, isrange, $
+                                           inputlist, $
+                                           tmp_dims, $
+                                           output_scalar, $
+                                           output_dims, $
+                                           n_reads, $
+                                           read_size, $
+                                           read_start, $
+                                           readstart_pos_array
+        
+        elem_pos = rebin(l64indgen(read_size), read_size, n_reads, $
+                         /SAMPLE) + $
+                   rebin(reform(readstart_pos_array, 1, n_reads), $
+                         read_size, n_reads, /SAMPLE)
+        
+        od = (*self.ds_dataptr)[temporary(elem_pos)]
+        
+        return, reform(od, output_dims, /overwrite)
+    
+    endif
+    
+    
     ; convert all inputs to ranges
     tmpa = lonarr(3)
     for i = 0, n_inputs-1 do begin
@@ -228,6 +279,114 @@ function wmb_DataStack::_overloadBracketsRightSide, isRange, sub1, $
 end
 
 
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   Overload array assignment for the wmb_DataStack object
+;
+;   A data stack which accesses a file can only be assigned to if
+;   it was created with the FILEWRITABLE keyword, and the values 
+;   are written to the file (see wmb_VirtualArray).  A data stack
+;   with pending operations cannot be assigned to.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+
+pro wmb_DataStack::_overloadBracketsLeftSide, objref, rvalue, isRange, $
+                        sub1, sub2, sub3, sub4, sub5, sub6, sub7, sub8
+
+    compile_opt idl2, strictarrsubs
+
+
+    if self.ds_ops.Count() gt 0 then begin
+        message, 'Cannot assign to a data stack with pending operations'
+        return
+    endif
+
+    if self.ds_flag_varray eq 1 then begin
+
+        tmp_varray = self.ds_varray
+
+        tmp_varray->_overloadBracketsLeftSide, tmp_varray, rvalue, isrange, $
+                        sub1, sub2, sub3, sub4, sub5, sub6, sub7, sub8
+
+        return
+
+    endif
+
+    tmp_dims = *self.ds_dimsptr
+
+    if N_elements(sub1) eq 0 then begin
+        message, 'No array subscript specified'
+        return
+    endif
+    
+    if N_elements(sub2) eq 0 then sub2=[0,0,1]
+    if N_elements(sub3) eq 0 then sub3=[0,0,1]
+    if N_elements(sub4) eq 0 then sub4=[0,0,1]
+    if N_elements(sub5) eq 0 then sub5=[0,0,1]
+    if N_elements(sub6) eq 0 then sub6=[0,0,1]
+    if N_elements(sub7) eq 0 then sub7=[0,0,1]
+    if N_elements(sub8) eq 0 then sub8=[0,0,1]
+
+    n_inputs = N_elements(isrange)
+
+    if n_inputs ne self.ds_rank then begin
+        message, 'Invalid number of array subscripts'
+        return
+    endif
+
+    inputlist = list(sub1,sub2,sub3,sub4,sub5,sub6,sub7,sub8) 
+
+    chkpass = 1
+    for i = 0, n_inputs-1 do begin
+        
+        tmpinput = inputlist[i]
+        chkdim = tmp_dims[i]
+                    
+        if isrange[i] eq 1 then begin
+            if ~ wmb_Rangevalid(tmpinput, chkdim) then chkpass = 0
+        endif else begin
+            if ~ wmb_Indexvalid(tmpinput, chkdim) then chkpass = 0
+        endelse
+    endfor
+
+    if chkpass eq 0 then begin
+        message, 'Array subscript out of range'
+        return
+    endif
+
+
+    ; the data is stored in memory - assign to the selected elements,
+    ; or insert an array starting at a single element
+
+    wmb_varray_generate_read_sequence, isrange, $
+                                       inputlist, $
+                                       tmp_dims, $
+                                       output_scalar, $
+                                       output_dims, $
+                                       n_reads, $
+                                       read_size, $
+                                       read_start, $
+                                       readstart_pos_array
+
+    if output_scalar then begin
+
+        (*self.ds_dataptr)[read_start] = rvalue
+
+    endif else begin
+
+        elem_pos = rebin(l64indgen(read_size), read_size, n_reads, $
+                         /SAMPLE) + $
+                   rebin(reform(readstart_pos_array, 1, n_reads), $
+                         read_size, n_reads, /SAMPLE)
+
+        (*self.ds_dataptr)[temporary(elem_pos)] = rvalue
+
+    endelse
+
+end
+
+
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
 ;   This is the Max_Value method
@@ -238,7 +397,20 @@ end
 
 function wmb_DataStack::Max_Value
 
-    if self.ds_flag_varray eq 0 then begin
+    if self.ds_ops.Count() gt 0 then begin
+
+        n_last = (*self.ds_dimsptr)[self.ds_rank-1]
+        slab_n = self._SlabSize()
+
+        for s0 = 0LL, n_last-1, slab_n do begin
+
+            tmpvalue = max(self._EvalSlab(s0, (s0 + slab_n - 1) < (n_last - 1)))
+
+            if s0 eq 0 then maxvalue = tmpvalue else maxvalue = maxvalue > tmpvalue
+
+        endfor
+
+    endif else if self.ds_flag_varray eq 0 then begin
 
         maxvalue = max(*(self.ds_dataptr))
         
@@ -265,7 +437,20 @@ end
 
 function wmb_DataStack::Min_Value
 
-    if self.ds_flag_varray eq 0 then begin
+    if self.ds_ops.Count() gt 0 then begin
+
+        n_last = (*self.ds_dimsptr)[self.ds_rank-1]
+        slab_n = self._SlabSize()
+
+        for s0 = 0LL, n_last-1, slab_n do begin
+
+            tmpvalue = min(self._EvalSlab(s0, (s0 + slab_n - 1) < (n_last - 1)))
+
+            if s0 eq 0 then minvalue = tmpvalue else minvalue = minvalue < tmpvalue
+
+        endfor
+
+    endif else if self.ds_flag_varray eq 0 then begin
         
         minvalue = min(*(self.ds_dataptr))
         
@@ -284,34 +469,138 @@ end
 
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
-;   This is the Change_Datatype method
+;   This is the Statistics method
 ;   
-;   Returns 1 if successful.
+;   Returns a structure with the min, max, sum, mean, variance,
+;   standard deviation and (optionally) a histogram of the data 
+;   stack.  See wmb_VirtualArray::Statistics for the keywords.
 ;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-function wmb_DataStack::Change_Datatype, newtype
+function wmb_DataStack::Statistics, nbins = nbins, $
+                                    hist_min = hist_min, $
+                                    hist_max = hist_max, $
+                                    _Extra = extra
 
     compile_opt idl2, strictarrsubs
 
-    if self.ds_flag_varray eq 0 then begin
+    if self.ds_flag_varray eq 1 && self.ds_ops.Count() eq 0 then begin
+    
+        varray_obj = self.ds_varray
+        
+        return, varray_obj.Statistics(nbins = nbins, $
+                                      hist_min = hist_min, $
+                                      hist_max = hist_max, $
+                                      _Extra = extra)
+    
+    endif
+    
+    if N_elements(nbins) eq 0 then nbins = 0
+    
+    if nbins gt 0 then begin
+    
+        ; the minimum and maximum for a histogram without a range come
+        ; from a first reduce pass, which finds them both at once
+
+        if N_elements(hist_min) eq 0 || N_elements(hist_max) eq 0 then begin
+
+            tmp_stats = self.Statistics()
+
+            if N_elements(hist_min) eq 0 then hist_min = tmp_stats.min
+            if N_elements(hist_max) eq 0 then hist_max = tmp_stats.max
+
+        endif
+
+        if hist_max lt hist_min then message, 'Invalid histogram range'
+        
+        tmp_binsize = (hist_max eq hist_min) ? 1.0D : $
+                      (double(hist_max) - hist_min) / nbins
+    
+    endif
+    
+    if self.ds_ops.Count() gt 0 then begin
+    
+        ; reduce the data one slab at a time
+    
+        n_last = (*self.ds_dimsptr)[self.ds_rank-1]
+        slab_n = self._SlabSize()
+        
+        for s0 = 0LL, n_last-1, slab_n do begin
         
-        rawdata = *(self.ds_dataptr)
+            wmb_varray_reduce, state, $
+                               self._EvalSlab(s0, (s0 + slab_n - 1) < (n_last - 1)), $
+                               nbins = nbins, $
+                               hist_min = hist_min, $
+                               hist_max = hist_max, $
+                               binsize = tmp_binsize
         
-        newdata = fix(temporary(rawdata), type=newtype)
+        endfor
         
-        ptr_free, self.ds_dataptr
+        wmb_varray_reduce, state, /finish
+    
+    endif else begin
+    
+        wmb_varray_reduce, state, *(self.ds_dataptr), $
+                           nbins = nbins, $
+                           hist_min = hist_min, $
+                           hist_max = hist_max, $
+                           binsize = tmp_binsize, $
+                           /finish
+    
+    endelse
+    
+    return, state
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Change_Datatype method
+;   
+;   The conversion is recorded as a pending operation, or for a 
+;   virtual array with no pending operations and no output scale or
+;   offset, is made by the virtual array as the data is read.  The
+;   virtual array converts before it scales, so once a scale or
+;   offset is set (e.g. by Negate_Data) the conversion must follow
+;   it as an operation.
+;
+;   Returns 1 if successful.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataStack::Change_Datatype, newtype
+
+    compile_opt idl2, strictarrsubs
+
+    if (newtype eq 0) or (newtype eq 7) or (newtype eq 8) or $
+       (newtype eq 10) or (newtype eq 11) then return, 0
+
+    chk_convert = 0
+
+    if self.ds_flag_varray eq 1 && self.ds_ops.Count() eq 0 then begin
+
+        self.ds_varray->GetProperty, output_scale = tmp_scale, $
+                                     output_offset = tmp_offset
+
+        chk_convert = (tmp_scale eq 1) && (tmp_offset eq 0)
+
+    endif
+
+    if chk_convert then begin
         
-        self.ds_dataptr = ptr_new(newdata, /NO_COPY)
+        ; the virtual array converts the data as it is read
         
-        self.ds_datatype = newtype
+        self.ds_varray->SetProperty, output_type = newtype
         
     endif else begin
         
-        return, 0
+        self._AddOp, 'datatype', datatype = newtype
         
     endelse
     
+    self.ds_datatype = newtype
+    
     return, 1
 
 end
@@ -321,6 +610,10 @@ end
 ;
 ;   This is the Negate_Data method
 ;   
+;   The negation is recorded as a pending operation, or for a 
+;   virtual array with no pending operations, is made by the
+;   virtual array as the data is read.
+;
 ;   Returns 1 if successful
 ;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
@@ -330,17 +623,19 @@ function wmb_DataStack::Negate_Data
     compile_opt idl2, strictarrsubs
 
 
-    if self.ds_flag_varray eq 0 then begin
+    if self.ds_flag_varray eq 1 && self.ds_ops.Count() eq 0 then begin
         
-        newdata = - *(self.ds_dataptr)
-
-        ptr_free, self.ds_dataptr
+        ; negate the output scale and offset of the virtual array
         
-        self.ds_dataptr = ptr_new(newdata, /NO_COPY)
+        self.ds_varray->GetProperty, output_scale = tmp_scale, $
+                                     output_offset = tmp_offset
+        
+        self.ds_varray->SetProperty, output_scale = - tmp_scale, $
+                                     output_offset = - tmp_offset
         
     endif else begin
         
-        return, 0
+        self._AddOp, 'negate'
         
     endelse
     
@@ -353,7 +648,8 @@ end
 ;
 ;   This is the Rebin_Data method
 ;   
-;   This is analogous to the REBIN function in IDL
+;   This is analogous to the REBIN function in IDL.  The rebinning
+;   is recorded as a pending operation.
 ;   
 ;   Returns 1 if successful
 ;
@@ -365,34 +661,482 @@ function wmb_DataStack::Rebin_Data, newdims, sample=sample
 
     if N_elements(sample) eq 0 then sample = 0
     
+    ; check that the new dimensions are valid
+    curdims = *self.ds_dimsptr
+    if N_elements(curdims) ne N_elements(newdims) then return, 0
+    if min(newdims) lt 1 then return, 0
+    large_dims = newdims > curdims
+    small_dims = newdims < curdims
+    rslt_mod = large_dims mod small_dims
+    if max(rslt_mod) gt 0 then return, 0
+    
+    self._AddOp, 'rebin', dims = newdims, sample = sample
+    
+    ptr_free, self.ds_dimsptr
+    self.ds_dimsptr = ptr_new(long(newdims))
+    
+    return, 1
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _AddOp method
+;   
+;   Adds an operation to the list of pending operations.  The dims
+;   field of each operation is the dimensions of its result, and 
+;   the dimensions of the stored data are saved when the first
+;   operation is added.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_DataStack::_AddOp, name, $
+                           datatype = datatype, $
+                           dims = dims, $
+                           sample = sample
+
+    compile_opt idl2, strictarrsubs
+
+    if self.ds_ops.Count() eq 0 then begin
+        ptr_free, self.ds_src_dimsptr
+        self.ds_src_dimsptr = ptr_new(long64(*self.ds_dimsptr))
+    endif
+
+    if N_elements(datatype) eq 0 then datatype = self.ds_datatype
+    if N_elements(dims) eq 0 then dims = *self.ds_dimsptr
+    if N_elements(sample) eq 0 then sample = 0
+
+    self.ds_ops.Add, {name     : name,                $
+                      datatype : fix(datatype),       $
+                      dims     : long64(dims),        $
+                      sample   : fix(sample ne 0)}
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _SlabRanges method
+;   
+;   Returns the range along the last dimension of the data, before
+;   each pending operation, which is needed to compute the range
+;   s0 to s1 of the last dimension of the result.  Element [*,k] is
+;   the range before operation k, and element [*,n_ops] is s0, s1.
+;
+;   Rebinning to a larger size interpolates between neighbouring
+;   elements, so one extra element is included.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataStack::_SlabRanges, s0, s1
+
+    compile_opt idl2, strictarrsubs
+
+    n_ops = self.ds_ops.Count()
+    last = self.ds_rank - 1
+
+    ranges = lon64arr(2, n_ops+1)
+    ranges[*,n_ops] = [s0, s1]
+
+    for k = n_ops-1, 0, -1 do begin
+
+        tmp_op = self.ds_ops[k]
+
+        tmp_a = ranges[0,k+1]
+        tmp_b = ranges[1,k+1]
+
+        if tmp_op.name eq 'rebin' then begin
+
+            in_dims = (k eq 0) ? *self.ds_src_dimsptr : (self.ds_ops[k-1]).dims
+
+            n_in = in_dims[last]
+            n_out = tmp_op.dims[last]
+
+            if n_out ge n_in then begin
+
+                f = n_out / n_in
+                tmp_a = tmp_a / f
+                tmp_b = (tmp_b / f + 1) < (n_in - 1)
+
+            endif else begin
+
+                f = n_in / n_out
+                tmp_a = tmp_a * f
+                tmp_b = tmp_b * f + f - 1
+
+            endelse
+
+        endif
+
+        ranges[*,k] = [tmp_a, tmp_b]
+
+    endfor
+
+    return, ranges
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _SlabSize method
+;   
+;   Returns the number of elements along the last dimension of the
+;   result which are computed together by _EvalSlab, so that no
+;   stage of the computation holds more than about 4M elements.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataStack::_SlabSize
+
+    compile_opt idl2, strictarrsubs
+
+    budget = 4194304LL
+
+    n_ops = self.ds_ops.Count()
+    last = self.ds_rank - 1
+
+    out_dims = long64(*self.ds_dimsptr)
+    frame = product(out_dims, /integer) / out_dims[last]
+
+    slab_n = ((budget / frame) > 1LL) < out_dims[last]
+
+    while slab_n gt 1 do begin
+
+        ranges = self._SlabRanges(0LL, slab_n-1)
+
+        tmp_max = 0LL
+
+        for k = 0, n_ops do begin
+
+            tmp_dims = (k eq 0) ? *self.ds_src_dimsptr : (self.ds_ops[k-1]).dims
+
+            tmp_max = tmp_max > (product(tmp_dims, /integer) / tmp_dims[last]) * $
+                                (ranges[1,k] - ranges[0,k] + 1)
+
+        endfor
+
+        if tmp_max le budget then break
+
+        slab_n = slab_n / 2
+
+    endwhile
+
+    return, slab_n
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _ReadSourceSlab method
+;   
+;   Returns the stored data for the range a to b of the last
+;   dimension, and the whole of the other dimensions.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataStack::_ReadSourceSlab, a, b
+
+    compile_opt idl2, strictarrsubs
+
+    last = self.ds_rank - 1
+
+    tmp_dims = *self.ds_src_dimsptr
+    tmp_dims[last] = b - a + 1
+
     if self.ds_flag_varray eq 0 then begin
-        
-        rawdata = *(self.ds_dataptr)
-        
-        ; check that the new dimensions are valid
-        curdims = *self.ds_dimsptr
-        if N_elements(curdims) ne N_elements(newdims) then return, 0
-        large_dims = newdims > curdims
-        small_dims = newdims < curdims
-        rslt_mod = large_dims mod small_dims
-        if max(rslt_mod) gt 0 then return, 0
-        
-        ; rebin the data
-        newdata = rebin(rawdata,newdims,sample=sample)
-        
-        ptr_free, self.ds_dataptr
-        ptr_free, self.ds_dimsptr
-        
-        self.ds_dataptr = ptr_new(newdata, /NO_COPY)
-        self.ds_dimsptr = ptr_new(long(newdims))
-        
+
+        ; the last dimension varies slowest, so the slab is one
+        ; contiguous range of the data
+
+        frame = product(tmp_dims, /integer) / tmp_dims[last]
+
+        data = (*self.ds_dataptr)[a*frame : (b+1)*frame - 1]
+
     endif else begin
-        
-        return, 0
-        
+
+        subs = list()
+        for i = 0, 7 do subs.Add, [0,-1,1]
+        subs[last] = [a, b, 1]
+
+        data = (self.ds_varray)._overloadBracketsRightSide(replicate(1, last+1), $
+                            subs[0], subs[1], subs[2], subs[3], $
+                            subs[4], subs[5], subs[6], subs[7])
+
     endelse
-    
-    return, 1
+
+    return, reform(data, tmp_dims, /overwrite)
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _EvalSlab method
+;   
+;   Returns the range s0 to s1 of the last dimension of the result
+;   of the pending operations, and the whole of the other 
+;   dimensions.  The stored data is read once, for the range which
+;   is needed, and all of the operations are applied to it in turn
+;   before the next slab is read.  The array operations use the IDL
+;   thread pool.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataStack::_EvalSlab, s0, s1
+
+    compile_opt idl2, strictarrsubs
+
+    n_ops = self.ds_ops.Count()
+    last = self.ds_rank - 1
+
+    ranges = self._SlabRanges(s0, s1)
+
+    tmp_a = ranges[0,0]
+    tmp_b = ranges[1,0]
+
+    data = self._ReadSourceSlab(tmp_a, tmp_b)
+
+    for k = 0, n_ops-1 do begin
+
+        tmp_op = self.ds_ops[k]
+
+        case tmp_op.name of
+
+            'datatype': data = fix(temporary(data), TYPE=tmp_op.datatype)
+
+            'negate': data = - temporary(data)
+
+            'rebin': begin
+
+                in_dims = (k eq 0) ? *self.ds_src_dimsptr : (self.ds_ops[k-1]).dims
+
+                n_in = in_dims[last]
+                n_out = tmp_op.dims[last]
+
+                in_dims[last] = tmp_b - tmp_a + 1
+                data = reform(data, in_dims, /overwrite)
+
+                out_dims = tmp_op.dims
+
+                if n_out ge n_in then begin
+
+                    ; rebin the slab, then trim it to the range needed
+                    ; by the next operation
+
+                    f = n_out / n_in
+
+                    out_dims[last] = (tmp_b - tmp_a + 1) * f
+
+                    data = rebin(temporary(data), out_dims, sample=tmp_op.sample)
+
+                    frame = product(out_dims, /integer) / out_dims[last]
+
+                    c0 = ranges[0,k+1] - tmp_a * f
+                    c1 = ranges[1,k+1] - tmp_a * f
+
+                    data = data[c0*frame : (c1+1)*frame - 1]
+
+                    out_dims[last] = c1 - c0 + 1
+                    data = reform(data, out_dims, /overwrite)
+
+                endif else begin
+
+                    f = n_in / n_out
+
+                    out_dims[last] = (tmp_b - tmp_a + 1) / f
+
+                    data = rebin(temporary(data), out_dims, sample=tmp_op.sample)
+
+                endelse
+
+            end
+
+        endcase
+
+        tmp_a = ranges[0,k+1]
+        tmp_b = ranges[1,k+1]
+
+    endfor
+
+    return, data
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _EvalSubscripts method
+;   
+;   Returns the subscripted part of the result of the pending 
+;   operations.  The result is computed one slab along the last
+;   dimension at a time, and only the slabs which contain selected
+;   elements are computed.  The subscripts follow the same rules 
+;   as for a wmb_VirtualArray.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataStack::_EvalSubscripts, isrange, subscript_list
+
+    compile_opt idl2, strictarrsubs
+
+    n_inputs = self.ds_rank
+    last = n_inputs - 1
+
+    tmp_dims = long64(*self.ds_dimsptr)
+
+
+    ; convert all inputs to lists of positive indices
+
+    index_list = list()
+    index_is_array = bytarr(n_inputs)
+
+    for i = 0, n_inputs-1 do begin
+
+        chkdim = tmp_dims[i]
+        tmp_input = subscript_list[i]
+
+        if isrange[i] then begin
+
+            tmp_start = long64(tmp_input[0])
+            tmp_end = long64(tmp_input[1])
+            tmp_stride = long64(tmp_input[2])
+
+            if tmp_start lt 0 then tmp_start = tmp_start + chkdim
+            if tmp_end lt 0 then tmp_end = tmp_end + chkdim
+
+            tmp_n = abs((tmp_end - tmp_start) / tmp_stride) + 1
+
+            tmp_index = tmp_start + (tmp_stride * l64indgen(tmp_n))
+
+        endif else begin
+
+            index_is_array[i] = size(tmp_input, /N_DIMENSIONS) gt 0
+
+            tmp_index = long64(reform([tmp_input], N_elements(tmp_input)))
+
+            tmp_neg = where(tmp_index lt 0, tmp_count)
+            if tmp_count gt 0 then tmp_index[tmp_neg] = tmp_index[tmp_neg] + chkdim
+
+        endelse
+
+        index_list.Add, tmp_index
+
+    endfor
+
+
+    ; index arrays without any ranges are combined element by element,
+    ; as for IDL arrays - otherwise each subscript adds a dimension
+
+    arraydimindex = where(index_is_array eq 1, arraycount)
+
+    chk_elementwise = (total(isrange) eq 0) && (arraycount gt 0)
+
+    if chk_elementwise then begin
+
+        n_out = N_elements(index_list[arraydimindex[0]])
+
+        for i = 0, n_inputs-1 do begin
+
+            tmp_index = index_list[i]
+
+            if N_elements(tmp_index) eq 1 then begin
+                index_list[i] = replicate(tmp_index[0], n_out)
+            endif else if N_elements(tmp_index) ne n_out then begin
+                message, 'Array subscripts must have the same number of elements'
+                return, 0
+            endif
+
+        endfor
+
+        output_scalar = 0
+        output_dims = size(subscript_list[arraydimindex[0]], /DIMENSIONS)
+
+    endif else begin
+
+        counts = lon64arr(n_inputs)
+        for i = 0, n_inputs-1 do counts[i] = N_elements(index_list[i])
+
+        n_out = product(counts, /integer)
+        n_inner = n_out / counts[last]
+
+        keepdimindex = where((isrange eq 1) or (index_is_array eq 1), keepcount)
+
+        output_scalar = keepcount eq 0
+        if keepcount gt 0 then output_dims = counts[keepdimindex]
+
+    endelse
+
+
+    ; compute the result one slab at a time
+
+    span = long64(shift(product(tmp_dims, /integer, /cumulative), 1))
+    span[0] = 1
+
+    last_index = index_list[last]
+
+    lmin = min(last_index, max = lmax)
+
+    slab_n = self._SlabSize()
+
+    od = make_array(n_out, TYPE=self.ds_datatype, /NOZERO)
+
+    for s0 = lmin, lmax, slab_n do begin
+
+        s1 = (s0 + slab_n - 1) < lmax
+
+        w = where((last_index ge s0) and (last_index le s1), wcount)
+
+        if wcount eq 0 then continue
+
+        slab = self._EvalSlab(s0, s1)
+
+        if chk_elementwise then begin
+
+            tmp_pos = (last_index[w] - s0) * span[last]
+
+            for i = 0, last-1 do tmp_pos = tmp_pos + (index_list[i])[w] * span[i]
+
+            od[w] = slab[tmp_pos]
+
+        endif else begin
+
+            offset_list = list()
+
+            for i = 0, last-1 do offset_list.Add, index_list[i] * span[i]
+
+            offset_list.Add, (last_index[w] - s0) * span[last]
+
+            od[wmb_varray_outer_index(list(l64indgen(n_inner), w * n_inner))] = $
+                slab[wmb_varray_outer_index(offset_list)]
+
+        endelse
+
+    endfor
+
+    if output_scalar then return, od[0]
+
+    return, reform(od, output_dims, /overwrite)
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Flush method
+;   
+;   Writes any modified data to the file, for a data stack which
+;   was created with the FILEWRITABLE keyword.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_DataStack::Flush
+
+    compile_opt idl2, strictarrsubs
+
+    if self.ds_flag_varray eq 1 then self.ds_varray->Flush
 
 end
 
@@ -453,6 +1197,9 @@ pro wmb_DataStack::SetProperty, Data = indata, $
         self.ds_flag_varray = 0
         self.ds_varray_filename = ''
         self.ds_varray = obj_new()
+        
+        self.ds_ops.Remove, /ALL
+        ptr_free, self.ds_src_dimsptr
         
     endif
 
@@ -472,7 +1219,8 @@ pro wmb_DataStack::GetProperty,  Rank = rank, $
                                  DataType = datatype, $
                                  Varray_obj = varray_obj, $
                                  Varray_flag = varray_flag, $
-                                 Varray_filename = varray_filename
+                                 Varray_filename = varray_filename, $
+                                 Pending_ops = pending_ops
 
     compile_opt idl2, strictarrsubs
 
@@ -487,6 +1235,8 @@ pro wmb_DataStack::GetProperty,  Rank = rank, $
     if Arg_present(varray_filename) ne 0 then $
                    varray_filename=self.ds_varray_filename
     
+    if Arg_present(pending_ops) ne 0 then pending_ops=self.ds_ops.Count()
+    
     
 end
 
@@ -505,6 +1255,16 @@ end
 ;   If the NO_COPY keyword is set to 1, the input data variable 
 ;   will be undefined after the object is created.
 ;
+;   Set FILEMMAP to 0 to read the file through an assoc variable
+;   rather than memory mapping it.
+;
+;   Set FILEWRITABLE to allow the data in the file to be modified
+;   by assigning to the data stack.
+;
+;   FILEOUTTYPE, FILESCALE and FILEOFFSETVALUE convert the data read
+;   from a file to another data type, then scale and offset it, as
+;   it is read.  See wmb_VirtualArray::_ConvertOutput.
+;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
 
@@ -514,8 +1274,15 @@ function wmb_DataStack::Init, Indata=indata, $
                               Filename=filename, $
                               Filedtype=filedtype, $     
                               Filechunksize=filechunksize, $                        
+                              Filecachesize=filecachesize, $
+                              Filereadahead=filereadahead, $
                               Fileoffset=fileoffset, $
-                              Fileswapendian=fileswapendian
+                              Fileswapendian=fileswapendian, $
+                              Filemmap=filemmap, $
+                              Filewritable=filewritable, $
+                              Fileouttype=fileouttype, $
+                              Filescale=filescale, $
+                              Fileoffsetvalue=fileoffsetvalue
                              
 
 
@@ -621,17 +1388,18 @@ function wmb_DataStack::Init, Indata=indata, $
             ; data type - create a virtual array object which will be used
             ; to access the data
 
-            if N_elements(datadims) eq 0 then begin
+            ; bricked array files contain their dimensions and data type
+
+            chk_bricked = size(wmb_varray_read_brick_header(filename), $
+                               /TYPE) eq 8
+
+            if N_elements(datadims) eq 0 && ~ chk_bricked then begin
                 message, 'Data dimensions must be specified when ' + $
                          'initializing a virtual data stack'
                 return, 0
             endif
 
-            filedims = datadims
-
-            tmp_rank = N_elements(filedims)
-            tmp_dims = filedims
-            tmp_dtype = filedtype
+            if N_elements(datadims) ne 0 then filedims = datadims
             
             tmp_dataptr = ptr_new()
             
@@ -640,8 +1408,20 @@ function wmb_DataStack::Init, Indata=indata, $
                                  filedims, $
                                  filedtype, $
                                  chunksize_bytes = filechunksize, $
+                                 cachesize_bytes = filecachesize, $
+                                 readahead_chunks = filereadahead, $
                                  fileoffset_bytes = fileoffset, $
-                                 fileswapendian = fileswapendian)
+                                 fileswapendian = fileswapendian, $
+                                 mmap = filemmap, $
+                                 writable = filewritable, $
+                                 output_type = fileouttype, $
+                                 output_scale = filescale, $
+                                 output_offset = fileoffsetvalue)
+            
+            tmp_varray->GetProperty, datadims = filedims, output_type = tmp_dtype
+            
+            tmp_rank = N_elements(filedims)
+            tmp_dims = filedims
                                  
             tmp_flag_varray = 1 
             
@@ -665,6 +1445,8 @@ function wmb_DataStack::Init, Indata=indata, $
     self.ds_flag_varray = tmp_flag_varray
     self.ds_varray_filename = filename
     self.ds_varray = tmp_varray
+    
+    self.ds_ops = list()
 
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
@@ -690,7 +1472,9 @@ pro wmb_DataStack::Cleanup
 
     ptr_free, self.ds_dimsptr
     ptr_free, self.ds_dataptr
+    ptr_free, self.ds_src_dimsptr
     if self.ds_flag_varray then obj_destroy, self.ds_varray
+    obj_destroy, self.ds_ops
 
 end
 
@@ -741,7 +1525,10 @@ pro wmb_DataStack__define
                                                          $
                ds_flag_varray     : fix(0),              $
                ds_varray_filename : '',                  $
-               ds_varray          : obj_new()            }
+               ds_varray          : obj_new(),           $
+                                                         $
+               ds_ops             : obj_new(),           $
+               ds_src_dimsptr     : ptr_new()            }
 
 end
 
@@ -128,11 +128,37 @@ pro wmb_DataTable::_overloadBracketsLeftSide, objref,  $
 
         ; open the file
         loc_id = self -> Vtable_Open(dset_name=dset_name)
+
+        ; overwritten records may change the range of each zone,
+        ; so the zone map is discarded
+        self -> Invalidate_zone_map, loc_id, dset_name
         
         ; write the data to disk
-        
-        if chk_range eq 1 then begin
-                                       
+
+        if self.dt_flag_columnar eq 1 then begin
+
+            ; write each field to its column
+
+            if chk_range eq 1 then begin
+
+                wmb_h5col_write_records, loc_id, $
+                                         dset_name, $
+                                         value, $
+                                         start = startrecord, $
+                                         nrecords = range_size, $
+                                         stride = stride
+
+            endif else begin
+
+                wmb_h5col_write_records, loc_id, $
+                                         dset_name, $
+                                         value, $
+                                         index = index
+
+            endelse
+
+        endif else if chk_range eq 1 then begin
+
             wmb_h5tb_write_records_range, loc_id, $
                                           dset_name, $
                                           startrecord, $
@@ -153,10 +179,21 @@ pro wmb_DataTable::_overloadBracketsLeftSide, objref,  $
         ; close the file
         self -> Vtable_Close
 
+    endif else if self.dt_flag_columnar eq 1 then begin
+
+        ; write each field to its column in memory
+
+        foreach tmpcol, self.dt_columns, i do begin
+
+            if chk_range eq 1 then tmpcol[startrecord:endrecord:stride] = value.(i) $
+                              else tmpcol[index] = value.(i)
+
+        endforeach
+
     endif else begin
-        
+
         ; write the data to memory
-        
+
         datavector = self.dt_datavector
         
         if chk_range eq 1 then begin
@@ -273,9 +310,34 @@ function wmb_DataTable::_overloadBracketsRightSide, isRange, sub1, $
         loc_id = self -> Vtable_Open(dset_name=dset_name)
         
         ; get the data from disk
-        
-        if chk_range eq 1 then begin
-            
+
+        if self.dt_flag_columnar eq 1 then begin
+
+            ; read each column and assemble the records
+
+            if chk_range eq 1 then begin
+
+                range_size = ceil( (abs(startrecord-endrecord)+1) $
+                                   / double(abs(stride)), /L64)
+
+                wmb_h5col_read_records, loc_id, $
+                                        dset_name, $
+                                        databuffer, $
+                                        start = startrecord, $
+                                        nrecords = range_size, $
+                                        stride = stride
+
+            endif else begin
+
+                wmb_h5col_read_records, loc_id, $
+                                        dset_name, $
+                                        databuffer, $
+                                        index = index
+
+            endelse
+
+        endif else if chk_range eq 1 then begin
+
             wmb_h5tb_read_records_range, loc_id, $
                                          dset_name, $
                                          startrecord, $
@@ -296,10 +358,29 @@ function wmb_DataTable::_overloadBracketsRightSide, isRange, sub1, $
         ; close the file
         self -> Vtable_Close
 
+    endif else if self.dt_flag_columnar eq 1 then begin
+
+        ; get each column from memory and assemble the records
+
+        recdef = *(self.dt_record_def_ptr)
+
+        foreach tmpcol, self.dt_columns, i do begin
+
+            if chk_range eq 1 then tmpdata = tmpcol[startrecord:endrecord:stride] $
+                              else tmpdata = tmpcol[index]
+
+            if i eq 0 then databuffer = replicate(recdef, N_elements(tmpdata))
+
+            databuffer.(i) = temporary(tmpdata)
+
+        endforeach
+
+        if chk_return_scalar then databuffer = databuffer[0]
+
     endif else begin
-        
+
         ; get the data from memory
-        
+
         datavector = self.dt_datavector
         
         if chk_range eq 1 then begin
@@ -390,7 +471,12 @@ function wmb_DataTable::Append, indata, no_copy=no_copy
     endif else begin
         
         recdef = wmb_h5tb_data_to_record_definition(indata)
-        
+
+        if self.dt_flag_columnar eq 1 && ~self.Columnar_valid(recdef) then begin
+            message, 'Error: invalid record definition for a columnar table'
+            return, 0
+        endif
+
         self.dt_nfields = n_tags(recdef)
         self.dt_record_def_ptr = ptr_new(recdef)
         self.dt_flag_record_def_init = 1
@@ -477,12 +563,30 @@ function wmb_DataTable::Append, indata, no_copy=no_copy
             ; write the new records to disk
         
             loc_id = self -> Vtable_Open(dset_name=dset_name)
-        
-            wmb_h5tb_append_records, loc_id, $
-                                     dset_name, $
-                                     indata_length, $
-                                     tmp_indata
-        
+
+            if self.dt_flag_columnar eq 1 then begin
+
+                wmb_h5col_append_records, loc_id, $
+                                          dset_name, $
+                                          indata_length, $
+                                          tmp_indata
+
+            endif else begin
+
+                wmb_h5tb_append_records, loc_id, $
+                                         dset_name, $
+                                         indata_length, $
+                                         tmp_indata
+
+            endelse
+
+            ; add the new records to the zone map
+
+            self -> Update_zone_map, self.dt_nrecords, tmp_indata, $
+                                     first_zone = first_zone
+
+            self -> Save_zone_map, loc_id, dset_name, first_zone = first_zone
+
             self.dt_nrecords = self.dt_nrecords + indata_length
 
             ; release the tmp_indata variable
@@ -493,8 +597,31 @@ function wmb_DataTable::Append, indata, no_copy=no_copy
             
         endelse
 
+    endif else if self.dt_flag_columnar eq 1 then begin
+
+        ; is the table empty?
+
+        if self.dt_flag_table_empty then begin
+
+            ; create one vector for each column
+
+            self -> Create_columns
+
+            self.dt_flag_table_empty = 0
+
+        endif
+
+        ; add each field of the new records to its column
+
+        foreach tmpcol, self.dt_columns, i do tmpcol.Append, tmp_indata.(i)
+
+        self.dt_nrecords = (self.dt_columns[0]).size
+
+        ; release the tmp_indata variable
+        tmp_indata = 0
+
     endif else begin
-        
+
         tmp_nrecords = size(tmp_indata, /dimensions)
         
         ; is the table empty?
@@ -579,8 +706,13 @@ function wmb_DataTable::Append_table, input_table
     endif else begin
         
         recdef = input_table.recorddef
-        
-        self.dt_nfields = n_tags(recdef)        
+
+        if self.dt_flag_columnar eq 1 && ~self.Columnar_valid(recdef) then begin
+            message, 'Error: invalid record definition for a columnar table'
+            return, 0
+        endif
+
+        self.dt_nfields = n_tags(recdef)
         self.dt_record_def_ptr = ptr_new(recdef)
         self.dt_flag_record_def_init = 1
 
@@ -655,11 +787,23 @@ pro wmb_DataTable::Check_autosave
         
         ; we now have a valid filename, title, group name, and dataset name
         tmp_recdef = *(self.dt_record_def_ptr)
-        tmp_data = (self.dt_datavector)[*]
         tmp_nrecords = self.dt_nrecords
 
-        ; destroy the datavector object
-        obj_destroy, self.dt_datavector
+        if self.dt_flag_columnar eq 1 then begin
+
+            tmp_data = self[*]
+
+            ; destroy the column vectors
+            self -> Destroy_columns
+
+        endif else begin
+
+            tmp_data = (self.dt_datavector)[*]
+
+            ; destroy the datavector object
+            obj_destroy, self.dt_datavector
+
+        endelse
 
         ; check if filename exists
         fn_exists = (file_info(tmp_fn)).exists
@@ -680,15 +824,34 @@ pro wmb_DataTable::Check_autosave
         loc_id = h5g_open(fid, grp_name)
 
         ; write the table
-        wmb_h5tb_make_table, title, $
-                             loc_id, $
-                             dset_name, $
-                             tmp_nrecords, $
-                             tmp_recdef, $
-                             chunksize, $
-                             compressflag, $
-                             databuffer = tmp_data
+        if self.dt_flag_columnar eq 1 then begin
+
+            wmb_h5col_make_table, title, $
+                                  loc_id, $
+                                  dset_name, $
+                                  tmp_nrecords, $
+                                  tmp_recdef, $
+                                  chunksize, $
+                                  compressflag, $
+                                  databuffer = tmp_data
+
+        endif else begin
+
+            wmb_h5tb_make_table, title, $
+                                 loc_id, $
+                                 dset_name, $
+                                 tmp_nrecords, $
+                                 tmp_recdef, $
+                                 chunksize, $
+                                 compressflag, $
+                                 databuffer = tmp_data
+
+        endelse
 
+        ; build the zone map of the table
+        self -> Reset_zone_map
+        self -> Update_zone_map, 0LL, tmp_data
+        self -> Save_zone_map, loc_id, dset_name
 
         ; we are done!  populate the self fields
         self.dt_autosave_activated = 1
@@ -736,615 +899,1901 @@ pro wmb_DataTable::Consolidate_memory
     if self.dt_flag_vtable eq 0 and $
        self.dt_autosave_activated eq 0 and $
        obj_valid(self.dt_datavector) then begin
-        
+
         datavector = self.dt_datavector
-        
+
         datavector.Consolidate
-        
-    endif 
-    
+
+    endif
+
+    if self.dt_flag_vtable eq 0 and $
+       self.dt_autosave_activated eq 0 and $
+       obj_valid(self.dt_columns) then begin
+
+        foreach tmpcol, self.dt_columns do tmpcol.Consolidate
+
+    endif
+
 end
 
 
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
-;   This is the Flush_writebuffer method
+;   This is the Columnar_valid method
 ;
-;   Flush the contents of the write buffer to disk
+;   Returns 1 if the record definition can be stored in a columnar
+;   table, i.e. each field is a scalar number or string.
 ;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-pro wmb_DataTable::Flush_writebuffer
+function wmb_DataTable::Columnar_valid, recdef
 
     compile_opt idl2, strictarrsubs
-    
-    if (self.dt_flag_vtable eq 1 or self.dt_autosave_activated eq 1) $
-       and obj_valid(self.dt_write_buffer) then begin
-        
-        writebuffer = self.dt_write_buffer
-        writebuffer_len = self.dt_write_buffer_length
-        
-        if writebuffer.size gt 0 then begin
-        
-            loc_id = self -> Vtable_Open(dset_name=dset_name)
-    
-            buf_nrecs = writebuffer.size        
-            
-            ; write the contents of the write buffer to disk
-    
-            buf_data = writebuffer[*]
-            
-            wmb_h5tb_append_records, loc_id, $
-                                     dset_name, $
-                                     buf_nrecs, $
-                                     buf_data
-            
-            ; close the file
-            self -> Vtable_Close
-            
-            ; empty the write buffer
-            obj_destroy, writebuffer
-        
-        endif
-        
-    endif
-    
+
+    for i = 0, n_tags(recdef)-1 do begin
+
+        tmp_field = recdef.(i)
+        tmp_type = size(tmp_field, /TYPE)
+
+        if size(tmp_field, /N_DIMENSIONS) ne 0 then return, 0
+
+        if tmp_type eq 0 or tmp_type eq 6 or tmp_type eq 8 or $
+           tmp_type eq 9 or tmp_type eq 10 or tmp_type eq 11 then return, 0
+
+    endfor
+
+    return, 1
+
 end
 
 
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
-;   This is the Read_column method
+;   This is the Create_columns method
+;
+;   Create an empty vector in memory for each column of a columnar
+;   table.
 ;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-function wmb_DataTable::Read_column, col_name, $
-                                     start_index = start_index, $
-                                     n_records = n_records
+pro wmb_DataTable::Create_columns
 
     compile_opt idl2, strictarrsubs
-    
-    table_nrecs = self.dt_nrecords
-    
-    if N_elements(start_index) eq 0 then start_index = 0
-    if N_elements(n_records) eq 0 then n_records = table_nrecs
-    
-    if (start_index + n_records) gt table_nrecs then $
-        message, 'Invalid record range'
-    
-    ; which column are we working with?
-    
+
     recdef = *(self.dt_record_def_ptr)
-    stored_colnames = strupcase(tag_names(recdef))
-    input_colname = strupcase(col_name)
-    col_ind = where(stored_colnames eq input_colname, tmpcnt)
-    if tmpcnt ne 1 then message, 'Invalid column name'
 
-    databuffer = []
-    
-    if self.dt_flag_table_empty eq 0 then begin
+    columns = list()
 
-        if self.dt_flag_vtable eq 1 or $
-           self.dt_autosave_activated eq 1 then begin
-            
-            ; flush the write buffer
-            self -> Flush_writebuffer
-            
-            loc_id = self.Vtable_Open(dset_name=dset_name)
-            
-            wmb_h5tb_read_fields_index, loc_id, $
-                                        dset_name, $
-                                        col_ind, $
-                                        start_index, $
-                                        n_records, $
-                                        databuffer
-            
-            ; convert the array of (single field) structures into a 
-            ; normal array
+    for i = 0, n_tags(recdef)-1 do begin
+
+        tmpcol = obj_new('wmb_vector', $
+                         datatype = size(recdef.(i), /TYPE), $
+                         initial_capacity = 10000, $
+                         double_capacity_if_full = 1)
+
+        columns.Add, tmpcol
+
+    endfor
+
+    self.dt_columns = columns
 
-            databuffer = temporary(databuffer.(0))
-            
-            ; close the file
-            self.Vtable_Close
-            
-        endif else begin
-            
-            dvector = self.dt_datavector
-            
-            ; create an array of the correct type
-            
-            firstrec = dvector[0]
-            tmp_element = firstrec.(col_ind)
-            tmp_dtype = size(tmp_element, /TYPE)
-            databuffer = make_array(n_records, type=tmp_dtype, /NOZERO)
-            
-            chunksize = 100000 < n_records
-            
-            n_chunks = ceil(double(n_records) / chunksize)
-            
-            last_rec = (start_index + n_records) - 1
-            
-            for i = 0, n_chunks-1 do begin
-                
-                srec = (i*chunksize) + start_index
-                erec = ((((i+1)*chunksize) - 1) + start_index) < last_rec
-                
-                tmpdata = dvector[srec:erec]
-                databuffer[i*chunksize] = tmpdata.(col_ind)
-                
-            endfor
-    
-        endelse
-        
-    endif
-    
-    return, databuffer
-    
 end
 
 
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
-;   This is the Read_column_index method
+;   This is the Destroy_columns method
+;
+;   Destroy the column vectors of a columnar table.
 ;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-function wmb_DataTable::Read_column_index, col_index, $
-                                           start_index = start_index, $
-                                           n_records = n_records
+pro wmb_DataTable::Destroy_columns
 
     compile_opt idl2, strictarrsubs
-    
-    table_nrecs = self.dt_nrecords
-    
 
-    ; which column are we working with?
-    
-    recdef = *(self.dt_record_def_ptr)
-    stored_colnames = strupcase(tag_names(recdef))
-    input_colname = stored_colnames[col_index]
-    
-    return, self.Read_column(input_colname, $
-                             start_index = start_index, $
-                             n_records = n_records)
-    
+    if obj_valid(self.dt_columns) then begin
+
+        foreach tmpcol, self.dt_columns do obj_destroy, tmpcol
+
+        obj_destroy, self.dt_columns
+
+    endif
+
+    self.dt_columns = obj_new()
+
 end
 
 
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
-;   This is the Write_column method
+;   This is the Zone_map_definition method
+;
+;   The zone map holds the minimum, maximum and number of NaN 
+;   values of each numeric column, for each zone of dt_zone_nrecs
+;   records.  Returns the record definition of the zone map, with
+;   the fields <column>_MIN, <column>_MAX and <column>_NNULL for
+;   each numeric column, or 0 if the table has no numeric columns.
+;
+;   zone_cols: the indices of the numeric columns
 ;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-pro wmb_DataTable::Write_column, col_name, start_index, databuffer
+function wmb_DataTable::Zone_map_definition, zone_cols = zone_cols
 
     compile_opt idl2, strictarrsubs
-    
-    table_nrecs = self.dt_nrecords
-    n_records = N_elements(databuffer)    
-    
-    if (start_index + n_records) gt table_nrecs then $
-        message, 'Invalid record range'
-    
-    ; which column are we working with?
-    
+
     recdef = *(self.dt_record_def_ptr)
-    stored_colnames = strupcase(tag_names(recdef))
-    input_colname = strupcase(col_name)
-    col_ind = where(stored_colnames eq input_colname, tmpcnt)
-    if tmpcnt ne 1 then message, 'Invalid column name'
+    colnames = tag_names(recdef)
 
-    if self.dt_flag_vtable eq 1 or self.dt_autosave_activated eq 1 then begin
-        
-        ; flush the write buffer
-        self -> Flush_writebuffer
-        
-        ; convert databuffer from a normal array to an array of 
-        ; single field structures
-        
-        tmpstruct = create_struct(col_name, databuffer[0])
-        tmpbuffer = replicate(tmpstruct, n_records)
-        tmpbuffer.(0) = databuffer
-        
-        loc_id = self.Vtable_Open(dset_name=dset_name)
-        
-        chunksize = 100000 < n_records
-        n_chunks = ceil(double(n_records) / chunksize)
-        
-        last_read = (n_records-1)
-        last_write = (start_index + n_records) - 1
-        
-        for i = 0, n_chunks-1 do begin
-            
-            srec_read = (i*chunksize)
-            erec_read = (((i+1)*chunksize) - 1) < last_read
-            
-            srec_write = (i*chunksize) + start_index
-            erec_write = ((((i+1)*chunksize) - 1) + start_index) < last_write
-            
-            nrecs = (erec_write - srec_write) + 1
-            
-            input_buffer = tmpbuffer[srec_read:erec_read]
-            
-            wmb_h5tb_write_fields_index, loc_id, $
-                                         dset_name, $
-                                         col_ind, $
-                                         srec_write, $
-                                         nrecs, $
-                                         input_buffer
-            
-            
-        endfor
-        
-        ; close the file
-        self.Vtable_Close
-        
-    endif else begin
-        
-        dvector = self.dt_datavector
-        
-        chunksize = 100000 < n_records
-        n_chunks = ceil(double(n_records) / chunksize)
-        
-        last_read = (n_records-1)
-        last_write = (start_index + n_records) - 1
-        
-        for i = 0, n_chunks-1 do begin
-            
-            srec_read = (i*chunksize)
-            erec_read = (((i+1)*chunksize) - 1) < last_read
-            
-            srec_write = (i*chunksize) + start_index
-            erec_write = ((((i+1)*chunksize) - 1) + start_index) < last_write
-            
-            nrecs = (erec_write - srec_write) + 1
-            
-            input_buffer = databuffer[srec_read:erec_read]
-            
-            tmpdata = dvector[srec_write:erec_write]
-            tmpdata.(col_ind) = input_buffer
-            
-            dvector[srec_write:erec_write] = tmpdata
-            
-        endfor
+    zone_cols = []
+    zone_def = 0
+
+    for i = 0, n_tags(recdef)-1 do begin
+
+        tmp_field = recdef.(i)
+        tmp_type = size(tmp_field, /TYPE)
+
+        if size(tmp_field, /N_DIMENSIONS) ne 0 then continue
+
+        if tmp_type eq 0 or tmp_type eq 6 or $
+           (tmp_type ge 7 and tmp_type le 11) then continue
+
+        if N_elements(zone_cols) eq 0 then begin
+
+            zone_def = create_struct(colnames[i] + '_MIN', tmp_field, $
+                                     colnames[i] + '_MAX', tmp_field, $
+                                     colnames[i] + '_NNULL', 0LL)
+
+        endif else begin
+
+            zone_def = create_struct(zone_def, $
+                                     colnames[i] + '_MIN', tmp_field, $
+                                     colnames[i] + '_MAX', tmp_field, $
+                                     colnames[i] + '_NNULL', 0LL)
+
+        endelse
+
+        zone_cols = [zone_cols, i]
+
+    endfor
+
+    return, zone_def
 
-    endelse
-    
 end
 
 
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
-;   This is the Write_multiple_columns method
+;   This is the Reset_zone_map method
 ;
-;   Databuffer should be a 1D array of structures
-;   
-;   The field names of the structures must match the column
-;   names of the table.
+;   Start a new, empty zone map.
 ;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-pro wmb_DataTable::Write_multiple_columns, start_index, databuffer
+pro wmb_DataTable::Reset_zone_map
 
     compile_opt idl2, strictarrsubs
 
-    table_nrecs = self.dt_nrecords
-    n_records = N_elements(databuffer)
+    self -> Clear_zone_map
 
-    if (start_index + n_records) gt table_nrecs then $
-        message, 'Invalid record range'
+    zone_def = self.Zone_map_definition(zone_cols = zone_cols)
 
-    ; which column are we working with?
+    self.dt_zone_valid = N_elements(zone_cols) gt 0
 
-    recdef = *(self.dt_record_def_ptr)
-    stored_colnames = strupcase(tag_names(recdef))
-    
-    tmprec = databuffer[0]
-    if size(tmprec,/TYPE) ne 8 then message, 'Invalid data type'
-    
-    n_records = N_elements(databuffer)
-    input_colnames = strupcase(tag_names(tmprec))
-    n_cols = N_elements(input_colnames)
+end
 
-    col_ind = lonarr(n_cols)
 
-    for i = 0, n_cols-1 do begin
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Clear_zone_map method
+;
+;   Discard the zone map in memory.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-        tmpname = input_colnames[i]
-        col_ind[i] = where(stored_colnames eq tmpname, tmpcnt)
+pro wmb_DataTable::Clear_zone_map
 
-        if tmpcnt ne 1 then message, 'Invalid column name'
+    compile_opt idl2, strictarrsubs
 
-    endfor
+    ptr_free, self.dt_zone_map
 
+    self.dt_zone_map = ptr_new()
+    self.dt_zone_valid = 0
 
-    if self.dt_flag_vtable eq 1 or self.dt_autosave_activated eq 1 then begin
+end
 
-        ; flush the write buffer
-        self -> Flush_writebuffer
 
-        loc_id = self.Vtable_Open(dset_name=dset_name)
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Invalidate_zone_map method
+;
+;   Discard the zone map in memory, and delete the saved zone map
+;   from the file.  loc_id and dset_name are those returned by
+;   Vtable_Open.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-        chunksize = 500000 < n_records
-        n_chunks = ceil(double(n_records) / chunksize)
+pro wmb_DataTable::Invalidate_zone_map, loc_id, dset_name
 
-        last_read = (n_records-1)
-        last_write = (start_index + n_records) - 1
+    compile_opt idl2, strictarrsubs
 
-        for i = 0, n_chunks-1 do begin
+    self -> Clear_zone_map
 
-            srec_read = (i*chunksize)
-            erec_read = (((i+1)*chunksize) - 1) < last_read
+    zone_dset = dset_name + '_ZONEMAP'
 
-            srec_write = (i*chunksize) + start_index
-            erec_write = ((((i+1)*chunksize) - 1) + start_index) < last_write
+    if wmb_h5_object_exists(loc_id, zone_dset) then h5g_unlink, loc_id, zone_dset
 
-            nrecs = (erec_write - srec_write) + 1
+end
 
-            input_buffer = databuffer[srec_read:erec_read]
 
-            wmb_h5tb_write_fields_index, loc_id, $
-                                         dset_name, $
-                                         col_ind, $
-                                         srec_write, $
-                                         nrecs, $
-                                         input_buffer
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Update_zone_map method
+;
+;   Add the statistics of the records in databuffer, which start
+;   at record first_record, to the zone map.  The records must 
+;   follow the records already in the zone map.
+;
+;   first_zone: returns the index of the first zone which changed
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
+pro wmb_DataTable::Update_zone_map, first_record, $
+                                    databuffer, $
+                                    first_zone = first_zone
 
-        endfor
+    compile_opt idl2, strictarrsubs
 
-        ; close the file
-        self.Vtable_Close
+    first_zone = 0LL
 
-    endif else begin
+    if self.dt_zone_valid eq 0 then return
 
-        dvector = self.dt_datavector
+    n_new = N_elements(databuffer)
 
-        chunksize = 100000 < n_records
-        n_chunks = ceil(double(n_records) / chunksize)
+    if n_new eq 0 then return
 
-        last_read = (n_records-1)
-        last_write = (start_index + n_records) - 1
+    zone_def = self.Zone_map_definition(zone_cols = zone_cols)
+    zone_nrecs = self.dt_zone_nrecs
 
-        for i = 0, n_chunks-1 do begin
+    last_record = long64(first_record) + n_new - 1
 
-            srec_read = (i*chunksize)
-            erec_read = (((i+1)*chunksize) - 1) < last_read
+    z_first = long64(first_record) / zone_nrecs
+    z_last = last_record / zone_nrecs
 
-            srec_write = (i*chunksize) + start_index
-            erec_write = ((((i+1)*chunksize) - 1) + start_index) < last_write
+    if ptr_valid(self.dt_zone_map) then zone_map = *self.dt_zone_map $
+                                   else zone_map = []
 
-            nrecs = (erec_write - srec_write) + 1
+    n_zones = N_elements(zone_map)
 
-            input_buffer = databuffer[srec_read:erec_read]
+    if z_first gt n_zones then message, 'Zone map out of sync'
 
-            tmpdata = dvector[srec_write:erec_write]
-            
-            for j = 0, n_cols-1 do begin
-                
-                tmpdata.(col_ind[j]) = input_buffer.(j)
+    ; add the new zones
 
-            endfor
+    if z_last ge n_zones then $
+        zone_map = [zone_map, replicate(zone_def, (z_last + 1) - n_zones)]
 
-            dvector[srec_write:erec_write] = tmpdata
+    ; if the first zone already holds records, the new statistics
+    ; are merged with the existing ones
 
-        endfor
+    chk_merge = z_first lt n_zones
 
-    endelse
+    foreach col, zone_cols, k do begin
 
-end
+        colvals = [databuffer.(col)]
 
+        tmp_type = size(colvals, /TYPE)
+        chk_float = tmp_type eq 4 or tmp_type eq 5
 
+        for z = z_first, z_last do begin
 
-;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
-;
-;   This is the Reorder_table method
-;
-;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+            srec = ((z * zone_nrecs) > first_record) - first_record
+            erec = ((((z+1) * zone_nrecs) - 1) < last_record) - first_record
 
-pro wmb_DataTable::Reorder_table, reorder_index, $
-                                  reorder_in_memory = reorder_in_memory, $
-                                  progress_bar = progress_bar
+            tmpvals = colvals[srec:erec]
 
-    compile_opt idl2, strictarrsubs
-    
-    if N_elements(reorder_in_memory) eq 0 then reorder_in_memory = 0
+            tmp_min = min(tmpvals, MAX=tmp_max, /NAN)
 
-    ; start the progress bar if necessary
+            if chk_float then tmp_nnull = total(finite(tmpvals, /NAN), /INTEGER) $
+                         else tmp_nnull = 0LL
 
-    if obj_valid(progress_bar) then begin
+            if z eq z_first and chk_merge then begin
 
-        progress_bar.label_text = 'Re-ordering data: '
-        progress_bar.Update_fraction, 0.0
+                tmp_min = min([zone_map[z].(3*k), tmp_min], /NAN)
+                tmp_max = max([zone_map[z].(3*k+1), tmp_max], /NAN)
+                tmp_nnull = tmp_nnull + zone_map[z].(3*k+2)
 
-    endif
+            endif
 
-    ; open the virtual table and create a temporary file if necessary
-    
-    if self.dt_flag_vtable eq 1 or self.dt_autosave_activated eq 1 then begin
+            zone_map[z].(3*k) = tmp_min
+            zone_map[z].(3*k+1) = tmp_max
+            zone_map[z].(3*k+2) = tmp_nnull
 
-        ; flush the write buffer
-        self -> Flush_writebuffer
+        endfor
 
-        ; open the virtual table
-        
-        loc_id = self.Vtable_Open(dset_name=dset_name)
+    endforeach
 
-        recdef = *(self.dt_record_def_ptr)
-        
-        ; create a temporary file
-        
-        tmpfile = filepath(cmunique_id() + '.tmp', /TMP)
+    ptr_free, self.dt_zone_map
+    self.dt_zone_map = ptr_new(zone_map, /NO_COPY)
 
-        ; check if the temporary file already exists
+    first_zone = z_first
 
-        fn_exists = (file_info(tmpfile)).exists
-        
-        if fn_exists then message, 'Error: temporary file already exists'
-        
-        ; create the file
-        
-        tmp_fid = h5f_create(tmpfile)
-        h5f_close, tmp_fid
-        
-        ; create the group
-        
-        full_group_name = 'temporary_group'
-        rslt = wmb_h5_create_group(tmpfile, full_group_name)
-        if rslt ne 1 then message, 'Error opening group'    
-        
-        ; open the file
-        tmp_fid = h5f_open(tmpfile, /WRITE)
+end
 
-        ; open the group
-        tmp_loc_id = h5g_open(tmp_fid, full_group_name)
 
-        ; create the table
-                
-        tmp_title = 'temporary_table'
-        tmp_dset_name = 'temporary_table'
-        table_chunksize = 100000
-        compressflag = 0                
-            
-        wmb_h5tb_make_table, tmp_title, $
-                             tmp_loc_id, $
-                             tmp_dset_name, $
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Build_zone_map method
+;
+;   Rebuild the zone map of a table stored on disk by reading the
+;   whole table, one zone at a time.  This is done after the table
+;   is re-ordered, and may be called after records are overwritten
+;   (which discards the zone map) or for a table which was saved
+;   without one.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_DataTable::Build_zone_map
+
+    compile_opt idl2, strictarrsubs
+
+    ; a table in memory does not keep a zone map
+
+    if self.dt_flag_vtable eq 0 and self.dt_autosave_activated eq 0 then return
+
+    self -> Flush_writebuffer
+
+    self -> Reset_zone_map
+
+    zone_nrecs = self.dt_zone_nrecs
+    n_recs = self.dt_nrecords
+
+    for srec = 0LL, n_recs-1, zone_nrecs do begin
+
+        erec = (srec + zone_nrecs - 1) < (n_recs - 1)
+
+        self -> Update_zone_map, srec, self[srec:erec]
+
+    endfor
+
+    loc_id = self.Vtable_Open(dset_name=dset_name)
+
+    self -> Save_zone_map, loc_id, dset_name
+
+    self.Vtable_Close
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Save_zone_map method
+;
+;   Write the zone map to the dataset <dset_name>_ZONEMAP, next to
+;   the table.  loc_id and dset_name are those returned by 
+;   Vtable_Open.  
+;   
+;   If first_zone is given, only the zones from first_zone onward
+;   are written, and the rest of the saved zone map is kept.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_DataTable::Save_zone_map, loc_id, $
+                                  dset_name, $
+                                  first_zone = first_zone
+
+    compile_opt idl2, strictarrsubs
+
+    zone_dset = dset_name + '_ZONEMAP'
+
+    chk_exists = wmb_h5_object_exists(loc_id, zone_dset)
+
+    if self.dt_zone_valid eq 0 or ~ptr_valid(self.dt_zone_map) then begin
+
+        ; there is no zone map - remove the saved copy
+
+        if chk_exists then h5g_unlink, loc_id, zone_dset
+        return
+
+    endif
+
+    zone_map = *self.dt_zone_map
+    n_zones = N_elements(zone_map)
+
+    if chk_exists and N_elements(first_zone) ne 0 then begin
+
+        ; overwrite the zones which changed, and append the new zones
+
+        wmb_h5tb_get_table_info, loc_id, zone_dset, tmp_nfields, n_saved
+
+        n_saved = long64(n_saved)
+
+        if first_zone gt n_saved then message, 'Zone map out of sync'
+
+        n_overwrite = n_saved - first_zone
+
+        if n_overwrite gt 0 then begin
+
+            wmb_h5tb_write_records, loc_id, $
+                                    zone_dset, $
+                                    first_zone, $
+                                    n_overwrite, $
+                                    zone_map[first_zone:n_saved-1]
+
+        endif
+
+        if n_zones gt n_saved then begin
+
+            wmb_h5tb_append_records, loc_id, $
+                                     zone_dset, $
+                                     n_zones - n_saved, $
+                                     zone_map[n_saved:*]
+
+        endif
+
+    endif else begin
+
+        if chk_exists then h5g_unlink, loc_id, zone_dset
+
+        wmb_h5tb_make_table, 'Zone map', $
+                             loc_id, $
+                             zone_dset, $
+                             n_zones, $
+                             zone_map[0], $
+                             256, $
                              0, $
-                             recdef, $
-                             table_chunksize, $
-                             compressflag
+                             databuffer = zone_map
 
-        n_records = self.dt_nrecords
-        chunksize = 500000 < n_records
-        n_chunks = ceil(double(n_records) / chunksize)
-        last_write = (n_records-1)
+        wmb_h5lt_set_attribute_string, loc_id, zone_dset, 'ZONE_SIZE', $
+                                       self.dt_zone_nrecs
 
-        ; reorder the table into temporary storage
+    endelse
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Load_zone_map method
+;
+;   Read the zone map saved next to the table.  A zone map which
+;   does not match the table is deleted from the file.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_DataTable::Load_zone_map, loc_id, dset_name
+
+    compile_opt idl2, strictarrsubs
+
+    self -> Clear_zone_map
+
+    zone_dset = dset_name + '_ZONEMAP'
+
+    if ~wmb_h5_object_exists(loc_id, zone_dset) then return
+
+    did = h5d_open(loc_id, zone_dset)
+    wmb_h5lt_get_attribute_disk, did, 'ZONE_SIZE', zone_nrecs
+    h5d_close, did
+
+    zone_nrecs = long64(zone_nrecs[0])
+
+    wmb_h5tb_read_table, loc_id, zone_dset, zone_map
+
+    zone_def = self.Zone_map_definition(zone_cols = zone_cols)
+
+    chk_match = N_elements(zone_cols) gt 0 and zone_nrecs gt 0
+
+    if chk_match then begin
+
+        n_zones = (self.dt_nrecords + zone_nrecs - 1) / zone_nrecs
+
+        chk_match = N_elements(zone_map) eq n_zones
+
+    endif
+
+    if chk_match then chk_match = wmb_compare_struct(zone_map[0], $
+                                                     zone_def, $
+                                                     /COMPARE_FIELD_NAMES, $
+                                                     /IGNORE_FIELD_VALUES)
+
+    if ~chk_match then begin
+
+        h5g_unlink, loc_id, zone_dset
+        return
+
+    endif
+
+    self.dt_zone_nrecs = zone_nrecs
+    self.dt_zone_map = ptr_new(zone_map, /NO_COPY)
+    self.dt_zone_valid = 1
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Zone_may_pass method
+;
+;   Returns 0 if the zone map shows that no record of the zone 
+;   can pass all of the Select filters, and 1 otherwise.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataTable::Zone_may_pass, zone_index, $
+                                       col_index_list, $
+                                       filter_types, $
+                                       filter_values
+
+    compile_opt idl2, strictarrsubs
+
+    zone_def = self.Zone_map_definition(zone_cols = zone_cols)
+
+    zone = (*self.dt_zone_map)[zone_index]
+
+    zone_len = self.dt_zone_nrecs < $
+               (self.dt_nrecords - (zone_index * self.dt_zone_nrecs))
+
+    foreach colindex, col_index_list, tmpi do begin
+
+        ; only numeric columns have zone statistics
+
+        k = where(zone_cols eq colindex[0], tmpcnt)
+
+        if tmpcnt eq 0 then continue
+
+        k = k[0]
+
+        zone_min = zone.(3*k)
+        zone_max = zone.(3*k+1)
+        zone_nnull = zone.(3*k+2)
+
+        ftype = filter_types[tmpi]
+        fval = filter_values[tmpi]
+
+        ; a zone of NaN values only passes a not-equal filter
+
+        if zone_nnull eq zone_len then begin
+
+            if ftype ne 4 then return, 0
+            continue
+
+        endif
+
+        case ftype of
+
+            0: if zone_max lt fval[0] then return, 0
+
+            1: if zone_min gt fval[0] then return, 0
+
+            2: if zone_max lt fval[0] or zone_min gt fval[1] then return, 0
+
+            3: if zone_max lt fval[0] or zone_min gt fval[0] then return, 0
+
+            4: if zone_nnull eq 0 and zone_min eq fval[0] and $
+                  zone_max eq fval[0] then return, 0
+
+            else:
+
+        endcase
+
+    endforeach
+
+    return, 1
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Flush_writebuffer method
+;
+;   Flush the contents of the write buffer to disk
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_DataTable::Flush_writebuffer
+
+    compile_opt idl2, strictarrsubs
+    
+    if (self.dt_flag_vtable eq 1 or self.dt_autosave_activated eq 1) $
+       and obj_valid(self.dt_write_buffer) then begin
         
-        for i = 0, n_chunks-1 do begin
-            
-            srec = (i*chunksize)
-            erec = (((i+1)*chunksize) - 1) < last_write
-            
-            nrecs = (erec - srec) + 1
-            
-            tmp_reorder_index = reorder_index[srec:erec]
+        writebuffer = self.dt_write_buffer
+        writebuffer_len = self.dt_write_buffer_length
+        
+        if writebuffer.size gt 0 then begin
+        
+            loc_id = self -> Vtable_Open(dset_name=dset_name)
+    
+            buf_nrecs = writebuffer.size        
             
-            if reorder_in_memory eq 0 then begin
-                
-                ; read a chunk
-                
-                wmb_h5tb_read_records_index, loc_id, $
-                                             dset_name, $
-                                             tmp_reorder_index, $
-                                             databuffer
-                
+            ; write the contents of the write buffer to disk
+    
+            buf_data = writebuffer[*]
+
+            if self.dt_flag_columnar eq 1 then begin
+
+                wmb_h5col_append_records, loc_id, $
+                                          dset_name, $
+                                          buf_nrecs, $
+                                          buf_data
+
             endif else begin
-                
-                firstrec = min(tmp_reorder_index)
-                lastrec  = max(tmp_reorder_index)
-                tmp_nrec = (lastrec - firstrec) + 1
-                
-                ; read a chunk
-                
-                wmb_h5tb_read_records, loc_id, $
-                                       dset_name, $
-                                       firstrec, $
-                                       tmp_nrec, $
-                                       tmp_databuffer
-                
-                ; reorder in memory
-                
-                databuffer = tmp_databuffer[tmp_reorder_index - firstrec]
-                
+
+                wmb_h5tb_append_records, loc_id, $
+                                         dset_name, $
+                                         buf_nrecs, $
+                                         buf_data
+
             endelse
 
-        
-            ; write a chunk to the temporary file
-            
-            wmb_h5tb_append_records, tmp_loc_id, $
-                                     tmp_dset_name, $
-                                     nrecs, $
-                                     databuffer
-            
-            if obj_valid(progress_bar) then begin
+            ; add the flushed records to the zone map (the buffered
+            ; records are already counted in dt_nrecords)
+
+            self -> Update_zone_map, self.dt_nrecords - buf_nrecs, buf_data, $
+                                     first_zone = first_zone
+
+            self -> Save_zone_map, loc_id, dset_name, first_zone = first_zone
+
+            ; close the file
+            self -> Vtable_Close
+            
+            ; empty the write buffer
+            obj_destroy, writebuffer
+        
+        endif
+        
+    endif
+    
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Read_column method
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataTable::Read_column, col_name, $
+                                     start_index = start_index, $
+                                     n_records = n_records
+
+    compile_opt idl2, strictarrsubs
+    
+    table_nrecs = self.dt_nrecords
+    
+    if N_elements(start_index) eq 0 then start_index = 0
+    if N_elements(n_records) eq 0 then n_records = table_nrecs
+    
+    if (start_index + n_records) gt table_nrecs then $
+        message, 'Invalid record range'
+    
+    ; which column are we working with?
+    
+    recdef = *(self.dt_record_def_ptr)
+    stored_colnames = strupcase(tag_names(recdef))
+    input_colname = strupcase(col_name)
+    col_ind = where(stored_colnames eq input_colname, tmpcnt)
+    if tmpcnt ne 1 then message, 'Invalid column name'
+
+    databuffer = []
+    
+    if self.dt_flag_table_empty eq 0 then begin
+
+        if self.dt_flag_vtable eq 1 or $
+           self.dt_autosave_activated eq 1 then begin
+            
+            ; flush the write buffer
+            self -> Flush_writebuffer
+            
+            loc_id = self.Vtable_Open(dset_name=dset_name)
+
+            if self.dt_flag_columnar eq 1 then begin
+
+                ; only the dataset holding the column is read
+
+                wmb_h5col_read_field, loc_id, $
+                                      dset_name, $
+                                      col_ind[0], $
+                                      databuffer, $
+                                      start = start_index, $
+                                      nrecords = n_records
+
+            endif else begin
+
+                wmb_h5tb_read_fields_index, loc_id, $
+                                            dset_name, $
+                                            col_ind, $
+                                            start_index, $
+                                            n_records, $
+                                            databuffer
+
+                ; convert the array of (single field) structures into a
+                ; normal array
+
+                databuffer = temporary(databuffer.(0))
+
+            endelse
+
+            ; close the file
+            self.Vtable_Close
+
+        endif else if self.dt_flag_columnar eq 1 then begin
+
+            ; copy the records directly from the column vector
+
+            tmpcol = self.dt_columns[col_ind[0]]
+
+            last_rec = (start_index + n_records) - 1
+
+            databuffer = tmpcol[start_index:last_rec]
+
+        endif else begin
+            
+            dvector = self.dt_datavector
+            
+            ; create an array of the correct type
+            
+            firstrec = dvector[0]
+            tmp_element = firstrec.(col_ind)
+            tmp_dtype = size(tmp_element, /TYPE)
+            databuffer = make_array(n_records, type=tmp_dtype, /NOZERO)
+            
+            chunksize = 100000 < n_records
+            
+            n_chunks = ceil(double(n_records) / chunksize)
+            
+            last_rec = (start_index + n_records) - 1
+            
+            for i = 0, n_chunks-1 do begin
+                
+                srec = (i*chunksize) + start_index
+                erec = ((((i+1)*chunksize) - 1) + start_index) < last_rec
+                
+                tmpdata = dvector[srec:erec]
+                databuffer[i*chunksize] = tmpdata.(col_ind)
+                
+            endfor
+    
+        endelse
+        
+    endif
+    
+    return, databuffer
+    
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Read_column_index method
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataTable::Read_column_index, col_index, $
+                                           start_index = start_index, $
+                                           n_records = n_records
+
+    compile_opt idl2, strictarrsubs
+    
+    table_nrecs = self.dt_nrecords
+    
+
+    ; which column are we working with?
+    
+    recdef = *(self.dt_record_def_ptr)
+    stored_colnames = strupcase(tag_names(recdef))
+    input_colname = stored_colnames[col_index]
+    
+    return, self.Read_column(input_colname, $
+                             start_index = start_index, $
+                             n_records = n_records)
+    
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Write_column method
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_DataTable::Write_column, col_name, start_index, databuffer
+
+    compile_opt idl2, strictarrsubs
+    
+    table_nrecs = self.dt_nrecords
+    n_records = N_elements(databuffer)    
+    
+    if (start_index + n_records) gt table_nrecs then $
+        message, 'Invalid record range'
+    
+    ; which column are we working with?
+    
+    recdef = *(self.dt_record_def_ptr)
+    stored_colnames = strupcase(tag_names(recdef))
+    input_colname = strupcase(col_name)
+    col_ind = where(stored_colnames eq input_colname, tmpcnt)
+    if tmpcnt ne 1 then message, 'Invalid column name'
+
+    if self.dt_flag_columnar eq 1 then begin
+
+        ; a columnar table writes only the column itself
+
+        if self.dt_flag_vtable eq 1 or self.dt_autosave_activated eq 1 then begin
+
+            ; flush the write buffer
+            self -> Flush_writebuffer
+
+            loc_id = self.Vtable_Open(dset_name=dset_name)
+
+            ; overwritten records may change the range of each zone,
+            ; so the zone map is discarded
+            self -> Invalidate_zone_map, loc_id, dset_name
+
+            wmb_h5col_write_field, loc_id, $
+                                   dset_name, $
+                                   col_ind[0], $
+                                   databuffer, $
+                                   start = start_index, $
+                                   nrecords = n_records
+
+            ; close the file
+            self.Vtable_Close
+
+        endif else begin
+
+            tmpcol = self.dt_columns[col_ind[0]]
+
+            tmpcol[start_index] = databuffer
+
+        endelse
+
+    endif else if self.dt_flag_vtable eq 1 or $
+                  self.dt_autosave_activated eq 1 then begin
+
+        ; flush the write buffer
+        self -> Flush_writebuffer
+
+        ; convert databuffer from a normal array to an array of 
+        ; single field structures
+        
+        tmpstruct = create_struct(col_name, databuffer[0])
+        tmpbuffer = replicate(tmpstruct, n_records)
+        tmpbuffer.(0) = databuffer
+        
+        loc_id = self.Vtable_Open(dset_name=dset_name)
+
+        ; overwritten records may change the range of each zone,
+        ; so the zone map is discarded
+        self -> Invalidate_zone_map, loc_id, dset_name
+        
+        chunksize = 100000 < n_records
+        n_chunks = ceil(double(n_records) / chunksize)
+        
+        last_read = (n_records-1)
+        last_write = (start_index + n_records) - 1
+        
+        for i = 0, n_chunks-1 do begin
+            
+            srec_read = (i*chunksize)
+            erec_read = (((i+1)*chunksize) - 1) < last_read
+            
+            srec_write = (i*chunksize) + start_index
+            erec_write = ((((i+1)*chunksize) - 1) + start_index) < last_write
+            
+            nrecs = (erec_write - srec_write) + 1
+            
+            input_buffer = tmpbuffer[srec_read:erec_read]
+            
+            wmb_h5tb_write_fields_index, loc_id, $
+                                         dset_name, $
+                                         col_ind, $
+                                         srec_write, $
+                                         nrecs, $
+                                         input_buffer
+            
+            
+        endfor
+        
+        ; close the file
+        self.Vtable_Close
+        
+    endif else begin
+        
+        dvector = self.dt_datavector
+        
+        chunksize = 100000 < n_records
+        n_chunks = ceil(double(n_records) / chunksize)
+        
+        last_read = (n_records-1)
+        last_write = (start_index + n_records) - 1
+        
+        for i = 0, n_chunks-1 do begin
+            
+            srec_read = (i*chunksize)
+            erec_read = (((i+1)*chunksize) - 1) < last_read
+            
+            srec_write = (i*chunksize) + start_index
+            erec_write = ((((i+1)*chunksize) - 1) + start_index) < last_write
+            
+            nrecs = (erec_write - srec_write) + 1
+            
+            input_buffer = databuffer[srec_read:erec_read]
+            
+            tmpdata = dvector[srec_write:erec_write]
+            tmpdata.(col_ind) = input_buffer
+            
+            dvector[srec_write:erec_write] = tmpdata
+            
+        endfor
+
+    endelse
+    
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Write_multiple_columns method
+;
+;   Databuffer should be a 1D array of structures
+;   
+;   The field names of the structures must match the column
+;   names of the table.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_DataTable::Write_multiple_columns, start_index, databuffer
+
+    compile_opt idl2, strictarrsubs
+
+    table_nrecs = self.dt_nrecords
+    n_records = N_elements(databuffer)
+
+    if (start_index + n_records) gt table_nrecs then $
+        message, 'Invalid record range'
+
+    ; which column are we working with?
+
+    recdef = *(self.dt_record_def_ptr)
+    stored_colnames = strupcase(tag_names(recdef))
+    
+    tmprec = databuffer[0]
+    if size(tmprec,/TYPE) ne 8 then message, 'Invalid data type'
+    
+    n_records = N_elements(databuffer)
+    input_colnames = strupcase(tag_names(tmprec))
+    n_cols = N_elements(input_colnames)
+
+    col_ind = lonarr(n_cols)
+
+    for i = 0, n_cols-1 do begin
+
+        tmpname = input_colnames[i]
+        col_ind[i] = where(stored_colnames eq tmpname, tmpcnt)
+
+        if tmpcnt ne 1 then message, 'Invalid column name'
+
+    endfor
+
+
+    if self.dt_flag_columnar eq 1 then begin
+
+        ; each column is stored separately, so write them one at a time
+
+        for j = 0, n_cols-1 do begin
+
+            self -> Write_column, input_colnames[j], start_index, databuffer.(j)
+
+        endfor
+
+    endif else if self.dt_flag_vtable eq 1 or $
+                  self.dt_autosave_activated eq 1 then begin
+
+        ; flush the write buffer
+        self -> Flush_writebuffer
+
+        loc_id = self.Vtable_Open(dset_name=dset_name)
+
+        ; overwritten records may change the range of each zone,
+        ; so the zone map is discarded
+        self -> Invalidate_zone_map, loc_id, dset_name
+
+        chunksize = 500000 < n_records
+        n_chunks = ceil(double(n_records) / chunksize)
+
+        last_read = (n_records-1)
+        last_write = (start_index + n_records) - 1
+
+        for i = 0, n_chunks-1 do begin
+
+            srec_read = (i*chunksize)
+            erec_read = (((i+1)*chunksize) - 1) < last_read
+
+            srec_write = (i*chunksize) + start_index
+            erec_write = ((((i+1)*chunksize) - 1) + start_index) < last_write
+
+            nrecs = (erec_write - srec_write) + 1
+
+            input_buffer = databuffer[srec_read:erec_read]
+
+            wmb_h5tb_write_fields_index, loc_id, $
+                                         dset_name, $
+                                         col_ind, $
+                                         srec_write, $
+                                         nrecs, $
+                                         input_buffer
+
+
+        endfor
+
+        ; close the file
+        self.Vtable_Close
+
+    endif else begin
+
+        dvector = self.dt_datavector
+
+        chunksize = 100000 < n_records
+        n_chunks = ceil(double(n_records) / chunksize)
+
+        last_read = (n_records-1)
+        last_write = (start_index + n_records) - 1
+
+        for i = 0, n_chunks-1 do begin
+
+            srec_read = (i*chunksize)
+            erec_read = (((i+1)*chunksize) - 1) < last_read
+
+            srec_write = (i*chunksize) + start_index
+            erec_write = ((((i+1)*chunksize) - 1) + start_index) < last_write
+
+            nrecs = (erec_write - srec_write) + 1
+
+            input_buffer = databuffer[srec_read:erec_read]
+
+            tmpdata = dvector[srec_write:erec_write]
+            
+            for j = 0, n_cols-1 do begin
+                
+                tmpdata.(col_ind[j]) = input_buffer.(j)
+
+            endfor
+
+            dvector[srec_write:erec_write] = tmpdata
+
+        endfor
+
+    endelse
+
+end
+
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Reorder_table method
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_DataTable::Reorder_table, reorder_index, $
+                                  reorder_in_memory = reorder_in_memory, $
+                                  progress_bar = progress_bar
+
+    compile_opt idl2, strictarrsubs
+    
+    if N_elements(reorder_in_memory) eq 0 then reorder_in_memory = 0
+
+    ; start the progress bar if necessary
+
+    if obj_valid(progress_bar) then begin
+
+        progress_bar.label_text = 'Re-ordering data: '
+        progress_bar.Update_fraction, 0.0
+
+    endif
+
+    ; a columnar table is re-ordered one column at a time, so that
+    ; only one column is held in memory
+
+    if self.dt_flag_columnar eq 1 then begin
+
+        colnames = tag_names(*(self.dt_record_def_ptr))
+        n_cols = N_elements(colnames)
+
+        for i = 0, n_cols-1 do begin
+
+            if self.dt_flag_vtable eq 1 or $
+               self.dt_autosave_activated eq 1 then begin
+
+                tmpdata = self.Read_column(colnames[i])
+
+                self -> Write_column, colnames[i], 0, tmpdata[reorder_index]
+
+            endif else begin
+
+                tmpcol = self.dt_columns[i]
+
+                tmpcol[0] = tmpcol[reorder_index]
+
+            endelse
+
+            if obj_valid(progress_bar) then begin
+
+                progress_bar.Update_fraction, (float(i+1)/n_cols)
+
+            endif
+
+        endfor
+
+        ; the zone map of a file backed table is rebuilt for the new
+        ; record order
+        self -> Build_zone_map
+
+        return
+
+    endif
+
+    ; open the virtual table and create a temporary file if necessary
+
+    if self.dt_flag_vtable eq 1 or self.dt_autosave_activated eq 1 then begin
+
+        ; flush the write buffer
+        self -> Flush_writebuffer
+
+        ; open the virtual table
+        
+        loc_id = self.Vtable_Open(dset_name=dset_name)
+
+        recdef = *(self.dt_record_def_ptr)
+        
+        ; create a temporary file
+        
+        tmpfile = filepath(cmunique_id() + '.tmp', /TMP)
+
+        ; check if the temporary file already exists
+
+        fn_exists = (file_info(tmpfile)).exists
+        
+        if fn_exists then message, 'Error: temporary file already exists'
+        
+        ; create the file
+        
+        tmp_fid = h5f_create(tmpfile)
+        h5f_close, tmp_fid
+        
+        ; create the group
+        
+        full_group_name = 'temporary_group'
+        rslt = wmb_h5_create_group(tmpfile, full_group_name)
+        if rslt ne 1 then message, 'Error opening group'    
+        
+        ; open the file
+        tmp_fid = h5f_open(tmpfile, /WRITE)
+
+        ; open the group
+        tmp_loc_id = h5g_open(tmp_fid, full_group_name)
+
+        ; create the table
+                
+        tmp_title = 'temporary_table'
+        tmp_dset_name = 'temporary_table'
+        table_chunksize = 100000
+        compressflag = 0                
+            
+        wmb_h5tb_make_table, tmp_title, $
+                             tmp_loc_id, $
+                             tmp_dset_name, $
+                             0, $
+                             recdef, $
+                             table_chunksize, $
+                             compressflag
+
+        n_records = self.dt_nrecords
+        chunksize = 500000 < n_records
+        n_chunks = ceil(double(n_records) / chunksize)
+        last_write = (n_records-1)
+
+        ; reorder the table into temporary storage
+        
+        for i = 0, n_chunks-1 do begin
+            
+            srec = (i*chunksize)
+            erec = (((i+1)*chunksize) - 1) < last_write
+            
+            nrecs = (erec - srec) + 1
+            
+            tmp_reorder_index = reorder_index[srec:erec]
+            
+            if reorder_in_memory eq 0 then begin
+                
+                ; read a chunk
+                
+                wmb_h5tb_read_records_index, loc_id, $
+                                             dset_name, $
+                                             tmp_reorder_index, $
+                                             databuffer
+                
+            endif else begin
+                
+                firstrec = min(tmp_reorder_index)
+                lastrec  = max(tmp_reorder_index)
+                tmp_nrec = (lastrec - firstrec) + 1
+                
+                ; read a chunk
+                
+                wmb_h5tb_read_records, loc_id, $
+                                       dset_name, $
+                                       firstrec, $
+                                       tmp_nrec, $
+                                       tmp_databuffer
+                
+                ; reorder in memory
+                
+                databuffer = tmp_databuffer[tmp_reorder_index - firstrec]
+                
+            endelse
+
+        
+            ; write a chunk to the temporary file
+            
+            wmb_h5tb_append_records, tmp_loc_id, $
+                                     tmp_dset_name, $
+                                     nrecs, $
+                                     databuffer
+            
+            if obj_valid(progress_bar) then begin
+
+                progress_bar.Update_fraction, (float(i+1)/(2*n_chunks))
+
+            endif
+            
+        endfor
+    
+        ; copy the reordered data back to the original location
+    
+        for i = 0, n_chunks-1 do begin
+            
+            srec = (i*chunksize)
+            erec = (((i+1)*chunksize) - 1) < last_write
+            
+            nrecs = (erec - srec) + 1
+            
+            tmp_reorder_index = reorder_index[srec:erec]
+            
+            ; read a chunk
+            
+            wmb_h5tb_read_records, tmp_loc_id, $
+                                   tmp_dset_name, $
+                                   srec, $
+                                   nrecs, $
+                                   databuffer
+        
+            ; write a chunk to the original table
+            
+            wmb_h5tb_write_records, loc_id, $
+                                    dset_name, $
+                                    srec, $
+                                    nrecs, $
+                                    databuffer
+            
+            if obj_valid(progress_bar) then begin
+
+                progress_bar.Update_fraction, (float(i+n_chunks+1)/(2*n_chunks))
+
+            endif
+            
+        endfor
+        
+        ; close the temporary file and delete it
+            
+        h5g_close, tmp_loc_id
+        h5f_close, tmp_fid
+        file_delete, tmpfile
+        
+        ; close the virtual table
+        self.Vtable_Close
+
+        ; rebuild the zone map for the new record order
+        self -> Build_zone_map
+
+    endif else begin
+        
+        dvector = self.dt_datavector
+        
+        ; perform the entire operation in memory
+        
+        dvector[0] = dvector[reorder_index]
+        
+    endelse
+    
+end
+
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Use_external_sort method
+;
+;   Returns 1 if the table is stored on disk and is larger than 
+;   the memory budget for sorting, in which case the Sort methods
+;   use External_sort.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataTable::Use_external_sort, memory_mbytes
+
+    compile_opt idl2, strictarrsubs
+
+    if N_elements(memory_mbytes) eq 0 then memory_mbytes = self.dt_sort_memory_mbytes
+
+    if self.dt_flag_vtable eq 0 and self.dt_autosave_activated eq 0 then return, 0
+
+    table_bytes = self.dt_nrecords * self.dt_size_of_record_def
+
+    return, table_bytes gt (long64(memory_mbytes) * (1024LL^2))
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Sort_keys method
+;
+;   Returns the permutation which sorts an array of records by 
+;   the columns key_ind.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataTable::Sort_keys, records, key_ind
+
+    compile_opt idl2, strictarrsubs
+
+    if N_elements(key_ind) eq 1 then return, sort(records.(key_ind[0]))
+
+    tmpcols = list()
+
+    foreach tmp_key, key_ind do tmpcols.Add, records.(tmp_key)
+
+    sort_index = wmb_sort_columns(tmpcols)
+
+    obj_destroy, tmpcols
+
+    return, sort_index
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Merge_keys_le method
+;
+;   Returns a byte array which is 1 for each record which sorts 
+;   before, or equal to, the cutoff record, comparing the columns 
+;   key_ind in order.  NaN values sort after all other values, as 
+;   they do with SORT.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataTable::Merge_keys_le, records, cutoff, key_ind
+
+    compile_opt idl2, strictarrsubs
+
+    result = replicate(1B, N_elements(records))
+
+    ; work back from the last key: a record is before the cutoff if
+    ; its key is smaller, or if it is equal and the remaining keys 
+    ; are before the cutoff
+
+    for i = N_elements(key_ind)-1, 0, -1 do begin
+
+        tmp_keys = records.(key_ind[i])
+        tmp_cutoff = cutoff.(key_ind[i])
+
+        if tmp_cutoff ne tmp_cutoff then begin
+
+            ; the cutoff is NaN
+
+            tmp_lt = tmp_keys eq tmp_keys
+            tmp_eq = tmp_keys ne tmp_keys
+
+        endif else begin
+
+            tmp_lt = tmp_keys lt tmp_cutoff
+            tmp_eq = tmp_keys eq tmp_cutoff
+
+        endelse
+
+        result = tmp_lt or (tmp_eq and result)
+
+    endfor
+
+    return, result
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the External_sort method
+;
+;   Sort a table stored on disk by one or more columns, using no
+;   more than about memory_mbytes of memory for the records.
+;
+;   The table is read in runs which fit in half of the memory 
+;   budget.  Each run is sorted in memory and written to a 
+;   temporary file.  The runs are then merged: a buffer of records
+;   is kept for each run, and at each step the buffered records 
+;   which sort before the last buffered record of every unfinished
+;   run (the cutoff) are sorted and written, in place, to the next 
+;   records of the table.  No record still on disk can sort before
+;   the cutoff.
+;
+;   If an error occurs the temporary file is deleted and the table
+;   is closed before the error is passed on.  Once the merge has 
+;   begun the table holds a mix of merged and original records, so
+;   the sorted runs are first copied back to the table, which then
+;   holds every record, though not in order.  If that also fails the
+;   temporary file is kept and named in the error message.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_DataTable::External_sort, col_names, $
+                                  descending = descending, $
+                                  memory_mbytes = memory_mbytes, $
+                                  progress_bar = progress_bar
+
+    compile_opt idl2, strictarrsubs
+
+    if N_elements(descending) ne 1 then descending = 0
+
+    if N_elements(memory_mbytes) eq 0 then memory_mbytes = self.dt_sort_memory_mbytes
+
+    if memory_mbytes le 0 then message, 'Invalid memory budget'
+
+    ; the state needed to clean up after an error
+
+    tmpfile = ''
+    chk_merging = 0
+    chk_zone_invalid = 0
+
+    catch, error_status
+
+    if error_status ne 0 then begin
+
+        catch, /cancel
+
+        tmp_msg = !error_state.msg
+
+        ; copy the sorted runs back if the table was being overwritten
+
+        chk_complete = 1
+
+        if chk_merging then $
+            chk_complete = self.External_sort_restore(loc_id, $
+                                                      dset_name, $
+                                                      tmp_loc_id, $
+                                                      run_names, $
+                                                      run_size)
+
+        ; close the table, and the temporary file with it
+
+        self.Vtable_Close
+
+        if tmpfile ne '' then begin
+
+            if chk_complete then file_delete, tmpfile, /ALLOW_NONEXISTENT $
+            else tmp_msg = tmp_msg + ' (the table is incomplete, its ' + $
+                           'records are in ' + tmpfile + ')'
+
+        endif
+
+        ; the zone map was discarded when the table was opened
+
+        if chk_zone_invalid && chk_complete then self -> Build_zone_map
+
+        message, tmp_msg
+
+    endif
+
+    n_keys = N_elements(col_names)
+
+    if n_keys lt 1 then message, 'Invalid number of sort columns'
+
+    if self.dt_flag_vtable eq 0 and self.dt_autosave_activated eq 0 then $
+        message, 'Error: table is not stored on disk'
+
+    ; which columns are we working with?
+
+    recdef = *(self.dt_record_def_ptr)
+    stored_colnames = strupcase(tag_names(recdef))
+
+    key_ind = lonarr(n_keys)
+
+    for i = 0, n_keys-1 do begin
+
+        tmp_ind = where(stored_colnames eq strupcase(col_names[i]), tmpcnt)
+        if tmpcnt ne 1 then message, 'Invalid column name'
+
+        key_ind[i] = tmp_ind[0]
+
+    endfor
+
+    ; start the progress bar if necessary
+
+    if obj_valid(progress_bar) then begin
+
+        progress_bar.label_text = 'Sorting data: '
+        progress_bar.Update_fraction, 0.0
+
+    endif
+
+    ; flush the write buffer
+    self -> Flush_writebuffer
+
+    n_records = self.dt_nrecords
+
+    if n_records eq 0 then begin
+        catch, /cancel
+        return
+    endif
+
+    rec_bytes = long64(self.dt_size_of_record_def) > 1LL
+    budget_bytes = long64(memory_mbytes) * (1024LL^2)
+
+    ; a run and its sorted copy fit in the budget
+
+    run_len = (budget_bytes / (2 * rec_bytes)) > 1LL
+    n_runs = (n_records + run_len - 1) / run_len
+
+    ; during the merge, the run buffers use half of the budget, and 
+    ; the records merged at each step the other half
+
+    buf_len = (budget_bytes / (2 * n_runs * rec_bytes)) > 1LL
+
+    ; create a temporary file for the sorted runs
+
+    tmp_name = filepath(cmunique_id() + '.tmp', /TMP)
+
+    fn_exists = (file_info(tmp_name)).exists
+
+    if fn_exists then message, 'Error: temporary file already exists'
+
+    tmpfile = tmp_name
+
+    tmp_fid = h5f_create(tmpfile)
+    h5f_close, tmp_fid
+
+    tmp_group_name = 'sort_runs'
+    rslt = wmb_h5_create_group(tmpfile, tmp_group_name)
+    if rslt ne 1 then message, 'Error opening group'
+
+    tmp_fid = h5f_open(tmpfile, /WRITE)
+    tmp_loc_id = h5g_open(tmp_fid, tmp_group_name)
+
+    ; open the virtual table
+
+    loc_id = self.Vtable_Open(dset_name=dset_name)
+
+    ; every record is rewritten, so the zone map is discarded
+    self -> Invalidate_zone_map, loc_id, dset_name
+    chk_zone_invalid = 1
+
+    ; write each run, sorted, to the temporary file
+
+    run_names = 'run_' + strtrim(string(l64indgen(n_runs)),2)
+    run_size = lon64arr(n_runs)
+
+    for r = 0LL, n_runs-1 do begin
+
+        srec = r * run_len
+        nrecs = (run_len < (n_records - srec))
+
+        if self.dt_flag_columnar eq 1 then begin
+
+            wmb_h5col_read_records, loc_id, $
+                                    dset_name, $
+                                    databuffer, $
+                                    start = srec, $
+                                    nrecords = nrecs
+
+        endif else begin
+
+            wmb_h5tb_read_records, loc_id, $
+                                   dset_name, $
+                                   srec, $
+                                   nrecs, $
+                                   databuffer
+
+        endelse
+
+        databuffer = databuffer[self.Sort_keys(databuffer, key_ind)]
+
+        wmb_h5tb_make_table, 'sort run', $
+                             tmp_loc_id, $
+                             run_names[r], $
+                             nrecs, $
+                             recdef, $
+                             (nrecs < 100000), $
+                             0, $
+                             databuffer = databuffer
+
+        run_size[r] = nrecs
+
+        if obj_valid(progress_bar) then begin
+
+            progress_bar.Update_fraction, (float(r+1)/(2*n_runs))
+
+        endif
+
+    endfor
+
+    databuffer = 0
+
+    ; merge the runs into the table
+
+    run_next = lon64arr(n_runs)
+    buffers = list(LENGTH=n_runs)
+
+    n_written = 0LL
+    chk_merging = 1
+
+    while n_written lt n_records do begin
+
+        ; top up the buffers which are less than half full
+
+        for r = 0LL, n_runs-1 do begin
+
+            n_buf = N_elements(buffers[r])
+            n_load = (buf_len - n_buf) < (run_size[r] - run_next[r])
+
+            if (2*n_buf lt buf_len or n_buf eq 0) and n_load gt 0 then begin
+
+                wmb_h5tb_read_records, tmp_loc_id, $
+                                       run_names[r], $
+                                       run_next[r], $
+                                       n_load, $
+                                       tmp_recs
+
+                if n_buf gt 0 then buffers[r] = [buffers[r], tmp_recs] $
+                              else buffers[r] = tmp_recs
+
+                run_next[r] = run_next[r] + n_load
+
+            endif
+
+        endfor
+
+        ; find the cutoff, from the runs which have records left on disk
+
+        active = where(run_next lt run_size, n_active)
+
+        cutoff_run = -1LL
+
+        if n_active gt 0 then begin
+
+            last_recs = replicate(recdef, n_active)
+
+            for j = 0LL, n_active-1 do last_recs[j] = (buffers[active[j]])[-1]
+
+            tmp_order = self.Sort_keys(last_recs, key_ind)
+
+            cutoff = last_recs[tmp_order[0]]
+            cutoff_run = active[tmp_order[0]]
+
+        endif
+
+        ; take the buffered records which sort before the cutoff.  all
+        ; of the buffer of the cutoff run is taken.
+
+        merge_list = list()
+        n_merge = 0LL
+
+        for r = 0LL, n_runs-1 do begin
+
+            tmp_buf = buffers[r]
+
+            n_buf = N_elements(tmp_buf)
+
+            if n_buf eq 0 then continue
+
+            if n_active eq 0 or r eq cutoff_run then begin
+
+                merge_list.Add, tmp_buf
+                buffers[r] = !NULL
+
+                n_merge = n_merge + n_buf
+
+            endif else begin
+
+                tmp_take = where(self.Merge_keys_le(tmp_buf, cutoff, key_ind), $
+                                 n_take, $
+                                 COMPLEMENT = tmp_keep, $
+                                 NCOMPLEMENT = n_keep)
+
+                if n_take eq 0 then continue
+
+                merge_list.Add, tmp_buf[tmp_take]
+
+                if n_keep gt 0 then buffers[r] = tmp_buf[tmp_keep] $
+                               else buffers[r] = !NULL
+
+                n_merge = n_merge + n_take
+
+            endelse
+
+        endfor
+
+        merge_recs = replicate(recdef, n_merge)
+
+        tmp_pos = 0LL
+
+        foreach tmp_recs, merge_list do begin
+
+            merge_recs[tmp_pos] = tmp_recs
+            tmp_pos = tmp_pos + N_elements(tmp_recs)
+
+        endforeach
+
+        merge_list = 0
+
+        merge_recs = merge_recs[self.Sort_keys(merge_recs, key_ind)]
+
+        ; write the merged records to the table.  in descending order,
+        ; the table is filled from the end.
+
+        if descending eq 1 then begin
+
+            merge_recs = merge_recs[(n_merge - 1) - l64indgen(n_merge)]
+            wstart = (n_records - n_written) - n_merge
+
+        endif else begin
+
+            wstart = n_written
+
+        endelse
+
+        if self.dt_flag_columnar eq 1 then begin
+
+            wmb_h5col_write_records, loc_id, $
+                                     dset_name, $
+                                     merge_recs, $
+                                     start = wstart, $
+                                     nrecords = n_merge
+
+        endif else begin
+
+            wmb_h5tb_write_records, loc_id, $
+                                    dset_name, $
+                                    wstart, $
+                                    n_merge, $
+                                    merge_recs
+
+        endelse
+
+        n_written = n_written + n_merge
+
+        if obj_valid(progress_bar) then begin
+
+            progress_bar.Update_fraction, 0.5 + (0.5 * n_written / n_records)
+
+        endif
+
+    endwhile
+
+    ; close the temporary file and delete it
+
+    chk_merging = 0
+
+    h5g_close, tmp_loc_id
+    h5f_close, tmp_fid
+    file_delete, tmpfile
+
+    ; close the virtual table
+    self.Vtable_Close
+
+    ; rebuild the zone map for the new record order
+    self -> Build_zone_map
+
+    catch, /cancel
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the External_sort_restore method
+;
+;   After an error during the merge of External_sort, copy the 
+;   sorted runs back to the table one after another, so that the
+;   table holds every record again.  Returns 1 if the records were
+;   copied.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_DataTable::External_sort_restore, loc_id, $
+                                               dset_name, $
+                                               tmp_loc_id, $
+                                               run_names, $
+                                               run_size
+
+    compile_opt idl2, strictarrsubs
+
+    catch, error_status
+
+    if error_status ne 0 then begin
+        catch, /cancel
+        return, 0
+    endif
+
+    wstart = 0LL
+
+    for r = 0LL, N_elements(run_names)-1 do begin
+
+        nrecs = run_size[r]
+
+        wmb_h5tb_read_records, tmp_loc_id, $
+                               run_names[r], $
+                               0LL, $
+                               nrecs, $
+                               databuffer
+
+        if self.dt_flag_columnar eq 1 then begin
 
-                progress_bar.Update_fraction, (float(i+1)/(2*n_chunks))
+            wmb_h5col_write_records, loc_id, $
+                                     dset_name, $
+                                     databuffer, $
+                                     start = wstart, $
+                                     nrecords = nrecs
+
+        endif else begin
 
-            endif
-            
-        endfor
-    
-        ; copy the reordered data back to the original location
-    
-        for i = 0, n_chunks-1 do begin
-            
-            srec = (i*chunksize)
-            erec = (((i+1)*chunksize) - 1) < last_write
-            
-            nrecs = (erec - srec) + 1
-            
-            tmp_reorder_index = reorder_index[srec:erec]
-            
-            ; read a chunk
-            
-            wmb_h5tb_read_records, tmp_loc_id, $
-                                   tmp_dset_name, $
-                                   srec, $
-                                   nrecs, $
-                                   databuffer
-        
-            ; write a chunk to the original table
-            
             wmb_h5tb_write_records, loc_id, $
                                     dset_name, $
-                                    srec, $
+                                    wstart, $
                                     nrecs, $
                                     databuffer
-            
-            if obj_valid(progress_bar) then begin
 
-                progress_bar.Update_fraction, (float(i+n_chunks+1)/(2*n_chunks))
+        endelse
 
-            endif
-            
-        endfor
-        
-        ; close the temporary file and delete it
-            
-        h5g_close, tmp_loc_id
-        h5f_close, tmp_fid
-        file_delete, tmpfile
-        
-        ; close the virtual table
-        self.Vtable_Close
+        wstart = wstart + nrecs
 
-    endif else begin
-        
-        dvector = self.dt_datavector
-        
-        ; perform the entire operation in memory
-        
-        dvector[0] = dvector[reorder_index]
-        
-    endelse
-    
-end
+    endfor
+
+    catch, /cancel
 
+    return, 1
+
+end
 
 
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
 ;   This is the Sort_single_index method
 ;
+;   A table stored on disk which is larger than memory_mbytes 
+;   (by default the Sort_memory_mbytes property) is sorted with
+;   External_sort.  This also applies to the other Sort methods.
+;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-pro wmb_DataTable::Sort_single_index, col_name, descending=descending
+pro wmb_DataTable::Sort_single_index, col_name, descending=descending, $
+                                      memory_mbytes = memory_mbytes, $
+                                      progress_bar = progress_bar
 
     compile_opt idl2, strictarrsubs
     
     if N_elements(descending) ne 1 then descending = 0
+
+    if self.Use_external_sort(memory_mbytes) then begin
+
+        self -> External_sort, [col_name], descending = descending, $
+                               memory_mbytes = memory_mbytes, $
+                               progress_bar = progress_bar
+        return
+
+    endif
     
     table_nrecs = self.dt_nrecords
     
@@ -1356,7 +2805,7 @@ pro wmb_DataTable::Sort_single_index, col_name, descending=descending
     
     if descending eq 1 then sort_index = reverse(sort_index, /OVERWRITE)
     
-    self -> Reorder_table, sort_index
+    self -> Reorder_table, sort_index, progress_bar = progress_bar
 
 end
 
@@ -1372,11 +2821,22 @@ pro wmb_DataTable::Sort_double_index, col_name_1, $
                                       col_name_2, $
                                       descending=descending, $
                                       reorder_in_memory = reorder_in_memory, $
+                                      memory_mbytes = memory_mbytes, $
                                       progress_bar = progress_bar
 
     compile_opt idl2, strictarrsubs
     
     if N_elements(descending) ne 1 then descending = 0
+
+    if self.Use_external_sort(memory_mbytes) then begin
+
+        self -> External_sort, [col_name_1, col_name_2], $
+                               descending = descending, $
+                               memory_mbytes = memory_mbytes, $
+                               progress_bar = progress_bar
+        return
+
+    endif
     
     table_nrecs = self.dt_nrecords
     
@@ -1409,11 +2869,22 @@ pro wmb_DataTable::Sort_triple_index, col_name_1, $
                                       col_name_3, $
                                       descending=descending, $
                                       reorder_in_memory = reorder_in_memory, $
+                                      memory_mbytes = memory_mbytes, $
                                       progress_bar = progress_bar
 
     compile_opt idl2, strictarrsubs
     
     if N_elements(descending) ne 1 then descending = 0
+
+    if self.Use_external_sort(memory_mbytes) then begin
+
+        self -> External_sort, [col_name_1, col_name_2, col_name_3], $
+                               descending = descending, $
+                               memory_mbytes = memory_mbytes, $
+                               progress_bar = progress_bar
+        return
+
+    endif
     
     table_nrecs = self.dt_nrecords
     
@@ -1439,6 +2910,56 @@ pro wmb_DataTable::Sort_triple_index, col_name_1, $
 end
 
 
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Sort_multi_index method
+;
+;   Sort the table by any number of columns, given as a string
+;   array with the primary sort column first.  Records with equal
+;   keys keep their original order.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_DataTable::Sort_multi_index, col_names, $
+                                     descending=descending, $
+                                     reorder_in_memory = reorder_in_memory, $
+                                     memory_mbytes = memory_mbytes, $
+                                     progress_bar = progress_bar
+
+    compile_opt idl2, strictarrsubs
+    
+    if N_elements(descending) ne 1 then descending = 0
+
+    if N_elements(col_names) eq 0 then message, 'Invalid number of sort columns'
+
+    if self.Use_external_sort(memory_mbytes) then begin
+
+        self -> External_sort, col_names, $
+                               descending = descending, $
+                               memory_mbytes = memory_mbytes, $
+                               progress_bar = progress_bar
+        return
+
+    endif
+    
+    ; read the sort columns, in order of precedence
+    
+    tmpcols = list()
+
+    foreach tmp_name, col_names do tmpcols.Add, self.Read_column(tmp_name)
+    
+    sort_index = wmb_sort_columns(tmpcols)
+
+    obj_destroy, tmpcols
+    
+    if descending eq 1 then sort_index = reverse(sort_index, /OVERWRITE)
+    
+    self -> Reorder_table, sort_index, reorder_in_memory = reorder_in_memory, $
+                                       progress_bar = progress_bar
+
+end
+
+
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
 ;   This is the View method
@@ -1486,7 +3007,13 @@ end
 ;   filter_values: A list of filter values.  For range filters,
 ;                  the value is a two-element array of [min,max].
 ;
-;   Returns an array of indices to the table.
+;   Returns an array of indices to the table.  If the 
+;   selection_mask keyword is present, it returns a byte array
+;   with one element per record, set to 1 for selected records.
+;
+;   The table is processed in chunks of the zone size.  For a table
+;   stored on disk, chunks which the zone map shows cannot contain 
+;   a selected record are skipped without being read.
 ;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
@@ -1494,7 +3021,8 @@ end
 function wmb_DataTable::Select, filter_columns, $
                                 filter_types, $
                                 filter_values, $
-                                n_selected = n_selected
+                                n_selected = n_selected, $
+                                selection_mask = selection_mask
 
     compile_opt idl2, strictarrsubs
 
@@ -1520,89 +3048,118 @@ function wmb_DataTable::Select, filter_columns, $
 
     n_filters = N_elements(col_index_list)
 
-    ; are we going to process the table in chunks or in 
-    ; one pass?
-    
-    chunksize = 500000
-    
+    ; the table is processed one zone at a time
+
+    chunksize = self.dt_zone_nrecs
+
+    ; the zone map of a table stored on disk is used to skip zones.
+    ; it is only complete once the write buffer has been flushed.
+
+    chk_zones = 0
+
+    if self.dt_flag_vtable eq 1 or self.dt_autosave_activated eq 1 then begin
+
+        self -> Flush_writebuffer
+
+        chk_zones = self.dt_zone_valid
+
+    endif
+
     n_recs = self.dt_nrecords
     
     nchunks = ceil(double(n_recs)/chunksize)
-    
-    select_results = []
-    
+
+    chk_mask = Arg_present(selection_mask)
+
+    if chk_mask then selection_mask = bytarr(n_recs)
+
+    ; the indices selected from each chunk are collected in a list,
+    ; and copied into the result array once at the end
+
+    select_list = list()
+    n_selected = 0LL
+
     for i = 0, nchunks-1 do begin
         
         si = i*chunksize
         ei = (((i+1)*chunksize)-1) < (n_recs-1)
         tmp_nr = (ei-si) + 1
-        
-        tmp_pass_markers = bytarr(tmp_nr,n_filters)
-        
-        tmpdat = self[si:ei]
-        
+
+        if chk_zones eq 1 then begin
+
+            if ~self.Zone_may_pass(i, col_index_list, $
+                                   filter_types, filter_values) then continue
+
+        endif
+
+        ; a columnar table reads only the filter columns
+
+        if self.dt_flag_columnar eq 0 then tmpdat = self[si:ei]
+
+        ; every filter is combined into a single pass mask.  once no 
+        ; record of the chunk passes, the remaining filters (and 
+        ; their columns) are skipped.
+
+        tmp_pass = replicate(1B, tmp_nr)
+
         foreach colindex, col_index_list, tmpi do begin
-            
+
             ftype = filter_types[tmpi]
             fval = filter_values[tmpi]
-            
+
+            if self.dt_flag_columnar eq 1 then begin
+                tmpvals = self.Read_column_index(colindex[0], $
+                                                 start_index = si, $
+                                                 n_records = tmp_nr)
+            endif else begin
+                tmpvals = tmpdat.(colindex)
+            endelse
+
             case ftype of
-                
-                0: begin
-                    
-                    tmp_rslt = where(tmpdat.(colindex) ge fval, tmpcnt)
-                    if tmpcnt gt 0 then tmp_pass_markers[tmp_rslt,tmpi] = 1
-                    
-                end
-                
-                1: begin
-                    
-                    tmp_rslt = where(tmpdat.(colindex) le fval, tmpcnt)
-                    if tmpcnt gt 0 then tmp_pass_markers[tmp_rslt,tmpi] = 1
-                    
-                end
-                
-                2: begin
-                    
-                    tmpmin = fval[0]
-                    tmpmax = fval[1]
-                    tmp_rslt = where(tmpdat.(colindex) ge tmpmin and $
-                                     tmpdat.(colindex) le tmpmax, tmpcnt)
-                    if tmpcnt gt 0 then tmp_pass_markers[tmp_rslt,tmpi] = 1
-                    
-                end
-                
-                3: begin
 
-                    tmp_rslt = where(tmpdat.(colindex) eq fval, tmpcnt)
-                    if tmpcnt gt 0 then tmp_pass_markers[tmp_rslt,tmpi] = 1
-                    
-                end
-                
-                4: begin
+                0: tmp_pass and= (tmpvals ge fval[0])
+
+                1: tmp_pass and= (tmpvals le fval[0])
+
+                2: tmp_pass and= (tmpvals ge fval[0]) and (tmpvals le fval[1])
+
+                3: tmp_pass and= (tmpvals eq fval[0])
+
+                4: tmp_pass and= (tmpvals ne fval[0])
+
+                else: message, 'Invalid filter type'
 
-                    tmp_rslt = where(tmpdat.(colindex) ne fval, tmpcnt)
-                    if tmpcnt gt 0 then tmp_pass_markers[tmp_rslt,tmpi] = 1
-                    
-                end
-                
             endcase
-            
+
+            if max(tmp_pass) eq 0 then break
+
         endforeach
-        
-        tmp_pass_markers = reform(tmp_pass_markers, $
-                                  tmp_nr, $
-                                  n_filters, $
-                                  /OVERWRITE)
-        
-        overall_pass = where(total(tmp_pass_markers,2) eq n_filters, tmpcnt) $
-                       + si
-        
-        if tmpcnt gt 0 then select_results = [select_results, overall_pass]
-        
+
+        overall_pass = where(tmp_pass, tmpcnt)
+
+        if tmpcnt gt 0 then begin
+
+            select_list.Add, overall_pass + long64(si)
+            n_selected = n_selected + tmpcnt
+
+        endif
+
+        if chk_mask then selection_mask[si] = tmp_pass
+
     endfor
 
-    n_selected = N_elements(select_results)
+    if n_selected eq 0 then return, []
+
+    select_results = lon64arr(n_selected)
+
+    tmp_pos = 0LL
+
+    foreach tmp_rslt, select_list do begin
+
+        select_results[tmp_pos] = tmp_rslt
+        tmp_pos = tmp_pos + N_elements(tmp_rslt)
+
+    endforeach
 
     return, select_results
 
@@ -1658,7 +3215,18 @@ function wmb_DataTable::Load, filename, full_group_name, dset_name
     
     chk_dset_exists = wmb_h5_dataset_exists(filename,full_group_name,dset_name)
 
+    ; a columnar table is stored as a group of datasets
+
+    chk_columnar = 0
+
     if ~chk_dset_exists then begin
+
+        tmp_path = wmb_h5_form_dataset_path(full_group_name, dset_name)
+        chk_columnar = wmb_h5_group_exists(filename, tmp_path)
+
+    endif
+
+    if ~chk_dset_exists && ~chk_columnar then begin
         message, 'Error: HDF5 dataset not found'
         return, 0
     endif
@@ -1671,23 +3239,41 @@ function wmb_DataTable::Load, filename, full_group_name, dset_name
     
     loc_id = h5g_open(fid, full_group_name)
 
-    ; get information about the table size
-    
-    wmb_h5tb_get_table_info, loc_id, $
-                             dset_name, $
-                             nfields, $
-                             nrecords, $
-                             TITLE=dset_title_attr, $
-                             CLASS=dset_class_attr
+    ; get information about the table size, and the record data structure
 
-    if strupcase(dset_class_attr) ne 'TABLE' then begin
-        message, 'Error: HDF5 dataset is not a table type'
-        return, 0
-    endif
+    if chk_columnar then begin
 
-    ; get the record data structure
-    
-    wmb_h5tb_get_field_info, loc_id, dset_name, record_definition
+        wmb_h5col_get_table_info, loc_id, $
+                                  dset_name, $
+                                  nfields, $
+                                  nrecords, $
+                                  TITLE=dset_title_attr, $
+                                  CLASS=dset_class_attr
+
+        if strupcase(dset_class_attr) ne 'COLUMN_TABLE' then begin
+            message, 'Error: HDF5 group is not a column table'
+            return, 0
+        endif
+
+        wmb_h5col_get_field_info, loc_id, dset_name, record_definition
+
+    endif else begin
+
+        wmb_h5tb_get_table_info, loc_id, $
+                                 dset_name, $
+                                 nfields, $
+                                 nrecords, $
+                                 TITLE=dset_title_attr, $
+                                 CLASS=dset_class_attr
+
+        if strupcase(dset_class_attr) ne 'TABLE' then begin
+            message, 'Error: HDF5 dataset is not a table type'
+            return, 0
+        endif
+
+        wmb_h5tb_get_field_info, loc_id, dset_name, record_definition
+
+    endelse
 
 
     ; we are done!  populate the self fields
@@ -1699,6 +3285,7 @@ function wmb_DataTable::Load, filename, full_group_name, dset_name
     self.dt_flag_record_def_init = 1
     self.dt_nfields = nfields
     self.dt_nrecords = nrecords
+    self.dt_flag_columnar = chk_columnar
     self.dt_flag_vtable = 1
     self.dt_vtable_open = 1
     self.dt_vtable_filename = filename
@@ -1706,6 +3293,9 @@ function wmb_DataTable::Load, filename, full_group_name, dset_name
     self.dt_vtable_loc_id = loc_id
     self.dt_flag_table_empty = 0
 
+    ; read the zone map, if one was saved with the table
+    self -> Load_zone_map, loc_id, dset_name
+
     ; close the file
     self -> Vtable_Close
 
@@ -1804,6 +3394,11 @@ function wmb_DataTable::Save, filename, $
     
             self.dt_autosave_activated = 0
     
+        endif else if self.dt_flag_columnar eq 1 then begin
+
+            ; destroy the column vectors
+            self -> Destroy_columns
+
         endif else begin
     
             ; destroy the datavector object
@@ -1842,6 +3437,13 @@ function wmb_DataTable::Save, filename, $
                                                     full_group_name, $
                                                     dset_name)
                                                     
+            ; a columnar table is stored as a group of the same name
+
+            if ~chk_dset_exists then begin
+                tmp_path = wmb_h5_form_dataset_path(full_group_name, dset_name)
+                chk_dset_exists = wmb_h5_group_exists(filename, tmp_path)
+            endif
+
             if chk_dset_exists then begin
                 message, 'Error: dataset exists'
                 return, 0
@@ -1894,16 +3496,39 @@ function wmb_DataTable::Save, filename, $
 
     ; write the table
 
-    wmb_h5tb_make_table, title, $
-                         loc_id, $
-                         dset_name, $
-                         tmp_nrecords, $
-                         tmp_recdef, $
-                         chunksize, $
-                         compressflag, $
-                         databuffer = tmp_data
+    if self.dt_flag_columnar eq 1 then begin
+
+        wmb_h5col_make_table, title, $
+                              loc_id, $
+                              dset_name, $
+                              tmp_nrecords, $
+                              tmp_recdef, $
+                              chunksize, $
+                              compressflag, $
+                              databuffer = tmp_data
+
+    endif else begin
+
+        wmb_h5tb_make_table, title, $
+                             loc_id, $
+                             dset_name, $
+                             tmp_nrecords, $
+                             tmp_recdef, $
+                             chunksize, $
+                             compressflag, $
+                             databuffer = tmp_data
 
+    endelse
+
+    ; write the zone map next to the table.  a table which stays in
+    ; memory does not keep its zone map up to date.
 
+    self -> Reset_zone_map
+    self -> Update_zone_map, 0LL, tmp_data
+    self -> Save_zone_map, loc_id, dset_name
+
+    if skip_file_association eq 1 and $
+       self.dt_autosave_activated eq 0 then self -> Clear_zone_map
     
     if skip_file_association eq 0 then begin
 
@@ -1961,6 +3586,8 @@ function wmb_DataTable::Copy, index = data_indices
                               Autosave_enable = tmp_autosave_enable, $
                               Autosave_thresh_mbytes = tmp_autosave_thresh, $
                               Write_buffer_length = tmp_write_buf_len, $
+                              Columnar = self.dt_flag_columnar, $
+                              Sort_memory_mbytes = self.dt_sort_memory_mbytes, $
                               /NO_COPY)
                               
     return, new_dt
@@ -1992,9 +3619,11 @@ pro wmb_DataTable::Erase, delete_file_if_empty = delete_file_if_empty
         
         loc_id = self.Vtable_Open(dset_name=dset_name)
         
-        ; unlink the dataset
+        ; unlink the dataset and its zone map
         
         h5g_unlink, loc_id, dset_name
+
+        self -> Invalidate_zone_map, loc_id, dset_name
         
         ; close the table
          
@@ -2040,6 +3669,9 @@ pro wmb_DataTable::Erase, delete_file_if_empty = delete_file_if_empty
         ; delete the data vector from memory
         obj_destroy, self.dt_datavector
 
+        ; delete the column vectors from memory
+        self -> Destroy_columns
+
     endelse
 
 
@@ -2056,6 +3688,8 @@ pro wmb_DataTable::Erase, delete_file_if_empty = delete_file_if_empty
     self.dt_autosave_vtable_open = 0
     self.dt_autosave_filename = ''
 
+    self -> Clear_zone_map
+
     self.dt_flag_table_empty = 1
 
 end
@@ -2187,6 +3821,7 @@ end
 
 
 pro wmb_DataTable::SetProperty,  title = title, $
+                                 sort_memory_mbytes = sort_memory_mbytes, $
                                  _Extra=extra
 
     compile_opt idl2, strictarrsubs
@@ -2198,6 +3833,12 @@ pro wmb_DataTable::SetProperty,  title = title, $
         
     endif
 
+    if N_elements(sort_memory_mbytes) ne 0 then begin
+
+        self.dt_sort_memory_mbytes = sort_memory_mbytes
+
+    endif
+
     
     ; pass extra keywords
 
@@ -2222,6 +3863,8 @@ pro wmb_DataTable::GetProperty,  recorddef = recorddef, $
                                  vtable_flag = vtable_flag, $
                                  filename = filename, $
                                  table_empty = table_empty, $
+                                 columnar = columnar, $
+                                 sort_memory_mbytes = sort_memory_mbytes, $
                                  _Ref_Extra=extra
 
     compile_opt idl2, strictarrsubs
@@ -2236,6 +3879,9 @@ pro wmb_DataTable::GetProperty,  recorddef = recorddef, $
     if Arg_present(vtable_flag) ne 0 then vtable_flag=self.dt_flag_vtable
     if Arg_present(filename) ne 0 then filename=self.dt_vtable_filename
     if Arg_present(table_empty) ne 0 then table_empty=self.dt_flag_table_empty
+    if Arg_present(columnar) ne 0 then columnar=self.dt_flag_columnar
+    if Arg_present(sort_memory_mbytes) ne 0 then $
+        sort_memory_mbytes=self.dt_sort_memory_mbytes
     
     ; pass extra keywords
 
@@ -2267,6 +3913,13 @@ end
 ;   If a record definition is not provided, it is set automatically
 ;   the first time data is added to the table.
 ;
+;   If the Columnar keyword is set, each field of the table is 
+;   stored separately: in a vector for each column in memory, and 
+;   in a dataset for each column on disk (see wmb_h5col_make_table).
+;   Read_column, Write_column and Select then access only the 
+;   columns which they use.  The fields of a columnar table must be
+;   scalar numbers or strings.
+;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
 
@@ -2276,7 +3929,9 @@ function wmb_DataTable::Init, Indata=indata, $
                               Title = title, $
                               Autosave_enable = autosave_enable, $
                               Autosave_thresh_mbytes = autosave_thresh_mbytes, $
-                              Write_buffer_length = write_buffer_length
+                              Write_buffer_length = write_buffer_length, $
+                              Columnar = columnar, $
+                              Sort_memory_mbytes = sort_memory_mbytes
                               
 
     compile_opt idl2, strictarrsubs
@@ -2290,9 +3945,14 @@ function wmb_DataTable::Init, Indata=indata, $
     
     if N_elements(autosave_enable) eq 0 then autosave_enable = 0
     
+    if N_elements(columnar) eq 0 then columnar = 0
+
     ; default autosave threshold is 1024MB
     if N_elements(autosave_thresh_mbytes) eq 0 then autosave_thresh_mbytes=1024
 
+    ; default memory budget for sorting tables on disk is 1024MB
+    if N_elements(sort_memory_mbytes) eq 0 then sort_memory_mbytes=1024
+
     indata_present = N_elements(indata) ne 0
     recorddef_present = N_elements(recorddef) ne 0
     
@@ -2321,6 +3981,11 @@ function wmb_DataTable::Init, Indata=indata, $
             return, 0
         endif
 
+        if columnar ne 0 && ~self.Columnar_valid(recorddef) then begin
+            message, 'Error: invalid record definition for a columnar table'
+            return, 0
+        endif
+
         recdef_size_bytes = wmb_sizeofstruct(recorddef)
         
         autosave_thresh_nrecs = ( (autosave_thresh_mbytes*(1024LL^2)) $
@@ -2344,6 +4009,12 @@ function wmb_DataTable::Init, Indata=indata, $
     self.dt_nrecords               = 0
     
     self.dt_datavector             = obj_new()
+    self.dt_columns                = obj_new()
+    self.dt_flag_columnar          = columnar ne 0
+    self.dt_zone_nrecs             = 500000
+    self.dt_zone_map               = ptr_new()
+    self.dt_zone_valid             = 0
+    self.dt_sort_memory_mbytes     = sort_memory_mbytes
     self.dt_write_buffer           = obj_new()
     self.dt_write_buffer_length    = write_buffer_length
   
@@ -2426,8 +4097,12 @@ pro wmb_DataTable::Cleanup
     self -> Vtable_Close
 
     ptr_free, self.dt_record_def_ptr
+
+    ptr_free, self.dt_zone_map
     
     if obj_valid(self.dt_datavector) then obj_destroy, self.dt_datavector
+
+    self -> Destroy_columns
     
     if obj_valid(self.dt_write_buffer) then obj_destroy, self.dt_write_buffer
 
@@ -2452,6 +4127,10 @@ end
 ;   memory - this is transparent to the user.  When stored on 
 ;   disk, the data is stored in the HDF5 table format.
 ;
+;   A columnar table stores each field in a separate vector, and
+;   on disk in a separate dataset, so that single columns can be
+;   read and written without touching the other fields.
+;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
 
@@ -2475,9 +4154,16 @@ pro wmb_DataTable__define
         dt_nrecords                 : long64(0),           $
                                                            $                                                  
         dt_datavector               : obj_new(),           $
+        dt_columns                  : obj_new(),           $
+        dt_flag_columnar            : fix(0),              $
         dt_write_buffer             : obj_new(),           $
         dt_write_buffer_length      : 0L,                  $
                                                            $
+        dt_zone_nrecs               : 0LL,                 $
+        dt_zone_map                 : ptr_new(),           $
+        dt_zone_valid               : fix(0),              $
+        dt_sort_memory_mbytes       : 0LL,                 $
+                                                           $
         dt_autosave_thresh_mbytes   : 0LL,                 $
         dt_autosave_thresh_nrecs    : 0LL,                 $
         dt_autosave_enabled         : fix(0),              $
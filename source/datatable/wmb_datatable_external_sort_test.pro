@@ -0,0 +1,102 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_datatable_external_sort_test
+;
+;   Checks that External_sort orders a table on disk the same way
+;   as the in-memory sort.  The table is autosaved to disk and
+;   sorted with a 1MB memory budget, which splits its 2MB of
+;   records into at least four runs.  The keys have few distinct
+;   values, so that records with equal keys span the runs and the
+;   cutoff records, and one key holds NaN values.  Row and columnar
+;   tables are sorted by one and by several keys, ascending and
+;   descending.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_datatable_external_sort_test
+
+    compile_opt idl2, strictarrsubs
+
+    n = 100000L
+
+    seed = 7L
+
+    recdef = {A:0L, B:0.0D, C:0L, ID:0L}
+
+    recs = replicate(recdef, n)
+    recs.a = long(randomu(seed, n) * 10)
+    recs.b = double(long(randomu(seed, n) * 50)) / 4
+    recs.c = long(randomu(seed, n) * 5)
+    recs.id = lindgen(n)
+
+    recs[long(randomu(seed, 500) * n)].b = !values.d_nan
+
+    key_sets = list(['B'], ['A', 'C'], ['A', 'B', 'C'])
+
+    for columnar = 0, 1 do begin
+
+        foreach keys, key_sets do begin
+
+            for descending = 0, 1 do begin
+
+                disk_table = obj_new('wmb_DataTable', Indata = recs, $
+                                     Autosave_enable = 1, $
+                                     Autosave_thresh_mbytes = 1, $
+                                     Columnar = columnar)
+
+                mem_table = obj_new('wmb_DataTable', Indata = recs, $
+                                    Columnar = columnar)
+
+                if ~ disk_table.Use_external_sort(1) then $
+                    message, 'The table was not stored on disk'
+
+                disk_table -> Sort_multi_index, keys, $
+                                                descending = descending, $
+                                                memory_mbytes = 1
+
+                mem_table -> Sort_multi_index, keys, descending = descending
+
+                tmp_case = string(columnar, strjoin(keys, ','), descending, $
+                                  FORMAT='("columnar ",I0,", keys ",A,' + $
+                                         '", descending ",I0)')
+
+                ; records with equal keys may be in any order, so only
+                ; the keys are compared
+
+                foreach tmp_key, keys do begin
+
+                    disk_col = disk_table.Read_column(tmp_key)
+                    mem_col = mem_table.Read_column(tmp_key)
+
+                    tmp_same = (disk_col eq mem_col) or $
+                               ((disk_col ne disk_col) and (mem_col ne mem_col))
+
+                    tmp_bad = where(~ tmp_same, n_bad)
+
+                    if n_bad gt 0 then $
+                        message, string(tmp_case, tmp_key, n_bad, tmp_bad[0], $
+                            FORMAT='(A,": ",A," differs at ",I0,' + $
+                                   '" records, first at ",I0)')
+
+                endforeach
+
+                ; every record must still be in the table, once
+
+                tmp_id = disk_table.Read_column('ID')
+
+                if ~ array_equal(tmp_id[sort(tmp_id)], lindgen(n)) then $
+                    message, tmp_case + ': records were lost or duplicated'
+
+                obj_destroy, [disk_table, mem_table]
+
+            endfor
+
+        endforeach
+
+    endfor
+
+    obj_destroy, key_sets
+
+    print, 'wmb_datatable_external_sort_test: passed'
+
+end
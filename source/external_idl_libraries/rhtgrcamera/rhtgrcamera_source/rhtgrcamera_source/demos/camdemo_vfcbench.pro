@@ -0,0 +1,228 @@
+;:tabSize=4:indentSize=4:noTabs=true:
+;:folding=explicit:collapseFolds=1:
+;+
+; NAME:
+;       CAMDEMO_VFCBENCH
+;
+; PURPOSE:
+;       This program benchmarks the view frustum culling kernel used by
+;       RHTgrCamera (RHTgrCamera_AABBIntersectFrustum).  It recreates the
+;       "Swarm of Orbs" test described in docs/RHTgrCamera_VFCperf.html:
+;       a uniformly distributed cloud of bounding boxes is created and the
+;       camera is moved from one end of the cloud, thru the middle, to the
+;       other end.  For each object count the average time to cull the
+;       cloud is reported for the interleaved (3xN) and structure-of-arrays
+;       (Nx3, /SOA) input layouts along with a plain IDL implementation of
+;       the same test.  The cloud is also culled as static content using a
+;       world space BVH (RHTgrCamera_BVHCull) with the plane cache enabled
+;       and the fraction of plane tests saved by plane masking and
+;       frame to frame coherence is reported.
+;
+;       The results returned by the DLM (intersect and CLIPMASK) are
+;       compared against the IDL implementation for every frame and any
+;       mismatch is reported.
+;
+;       No graphics are drawn, only the culling is timed.
+;
+;
+;       DISCLAIMER: The camdemo_* programs are quick examples of some
+;                   of the features of my camera object.  They are
+;                   NOT provided as examples of proper programming
+;                   technique. Use at your own risk!
+;
+;
+; CATEGORY:
+;       Object Graphics
+;
+;
+; KEYWORDS:
+;   nObjects:       Set this keyword to a scalar or vector defining the
+;                   number of objects in the cloud for each test.  The
+;                   default is [100, 1000, 10000, 100000, 1000000].
+;
+;     nSteps:       Set this keyword to the number of camera positions
+;                   sampled on the way thru the cloud. Default is 50.
+;
+;   filename:       Set this keyword to the name of a file to which the
+;                   results will be written in CSV format.
+;
+;     noIDL:        Set this keyword to skip timing the IDL implementation
+;                   (results are still verified).
+;
+;
+; DEPENDENCIES:     RHTgrCamera__define.pro
+;                   RHTgrCamera DLM
+;
+;
+; MODIFICATION HISTORY:
+;       Written to accompany the batched culling kernel.
+;
+;
+; LICENSE
+;
+;   This program is free software; you can redistribute it and/or
+;   modify it under the terms of the GNU General Public License
+;   as published by the Free Software Foundation; either version 2
+;   of the License, or (at your option) any later version.
+;
+;   This program is distributed in the hope that it will be useful,
+;   but WITHOUT ANY WARRANTY; without even the implied warranty of
+;   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;   GNU General Public License for more details.
+;
+;   You should have received a copy of the GNU General Public License
+;   along with this program; if not, write to the Free Software
+;   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+;
+;   A full copy of the GNU General Public License can be found on line at
+;   http://www.gnu.org/copyleft/gpl.html#SEC1
+;
+;-
+
+
+;   camdemo_vfcbench_idlcull {{{
+function camdemo_vfcbench_idlcull, pos, ext, planes, clipMask=clipMask
+
+    ;  IDL implementation of the frustum / AABB test.  pos and ext are Nx3.
+    ;  Plane tests are evaluated in the same order as the DLM so the
+    ;  results should be identical.
+
+    compile_opt idl2
+
+    nBox = N_ELEMENTS(pos) / 3
+    alive = REPLICATE(1B, nBox)
+    clipMask = INTARR(nBox)
+
+    for p=0, 5 do begin
+        np = ext[*,0] * ABS(planes[0,p]) + ext[*,1] * ABS(planes[1,p]) + $
+            ext[*,2] * ABS(planes[2,p])
+        mp = pos[*,0] * planes[0,p] + pos[*,1] * planes[1,p] + $
+            pos[*,2] * planes[2,p] + planes[3,p]
+
+        alive = alive and ((mp + np) ge 0D)
+        clipMask = clipMask or FIX(p * (alive and ((mp - np) lt 0D)))
+    endfor
+
+    RETURN, FIX(alive)
+
+end
+;   }}}
+
+;   camdemo_vfcbench {{{
+pro camdemo_vfcbench,   nObjects=nObjects, $
+                        nSteps=nSteps, $
+                        filename=filename, $
+                        noIDL=noIDL
+
+    compile_opt idl2
+
+    ;  Check our keywords.
+    nObjects = (N_ELEMENTS(nObjects) eq 0) ? $
+        [100L, 1000L, 10000L, 100000L, 1000000L] : LONG(nObjects)
+    nSteps = (N_ELEMENTS(nSteps) eq 0) ? 50 : 2 > FIX(nSteps)
+    timeIDL = ~KEYWORD_SET(noIDL)
+
+    ;  Create the camera using the same view as camdemo_cullnfly.
+    camera = OBJ_NEW('RHTgrCamera', FRUSTUM_DIMS=[120,120,400], $
+            CAMERA_LOCATION=[0,10,130])
+    camera -> GetProperty, EYE=eye, THIRD_PERSON=thirdPerson, $
+        QUATERNION=oOrientation, FRUSTUM_PLANES=planes
+
+    ;  Camera trajectory - thru the cloud along the z axis.
+    zPath = 130D - 260D * DINDGEN(nSteps) / (nSteps - 1)
+
+    results = DBLARR(7, N_ELEMENTS(nObjects))
+    nBad = 0L
+
+    PRINT, '  nObjects  visible      AoS (ms)      SoA (ms)      IDL (ms)' + $
+        '      BVH (ms)  saved'
+
+    for i=0, N_ELEMENTS(nObjects)-1 do begin
+
+        nObj = nObjects[i]
+
+        ;  Sprinkle the boxes about the same volume as the orbs in
+        ;  camdemo_cullnfly.
+        seed = 1L
+        location = [[(RANDOMU(seed,nObj,/DOUBLE) - 0.5) * 50], $
+            [RANDOMU(seed,nObj,/DOUBLE) * 50], $
+            [(RANDOMU(seed,nObj,/DOUBLE) - 0.5) * 150]]
+        extents = REBIN((RANDOMU(seed,nObj,/DOUBLE) + 1.) * 2., nObj, 3)
+        bvh = RHTgrCamera_BVHBuild(TRANSPOSE(location), TRANSPOSE(extents))
+        cache = 0B
+        bvhStats = LON64ARR(5)
+
+        tAoS = 0D
+        tSoA = 0D
+        tIDL = 0D
+        tBVH = 0D
+        nVisible = 0D
+
+        for s=0, nSteps-1 do begin
+
+            ;  Transform the boxes into view space.
+            transform = RHTgrCamera_Transform(oOrientation -> GetCTM(), $
+                [0D, 10D, zPath[s]], eye - thirdPerson)
+            rot = transform[0:2,0:2]
+            pos = location # rot + REBIN(REFORM(transform[3,0:2], 1, 3), $
+                nObj, 3)
+            ext = extents # ABS(rot)
+            posAoS = TRANSPOSE(pos)
+            extAoS = TRANSPOSE(ext)
+
+            t0 = SYSTIME(/SECONDS)
+            inAoS = RHTgrCamera_AABBIntersectFrustum(posAoS, extAoS, $
+                planes, CLIPMASK=clipAoS)
+            t1 = SYSTIME(/SECONDS)
+            inSoA = RHTgrCamera_AABBIntersectFrustum(pos, ext, planes, $
+                CLIPMASK=clipSoA, /SOA)
+            t2 = SYSTIME(/SECONDS)
+            inIDL = camdemo_vfcbench_idlcull(pos, ext, planes, $
+                CLIPMASK=clipIDL)
+            t3 = SYSTIME(/SECONDS)
+            null = RHTgrCamera_BVHCull(bvh, planes, TRANSFORM=transform, $
+                CACHE=cache, STATS=stats)
+            t4 = SYSTIME(/SECONDS)
+
+            tAoS = tAoS + (t1 - t0)
+            tSoA = tSoA + (t2 - t1)
+            tIDL = tIDL + (t3 - t2)
+            tBVH = tBVH + (t4 - t3)
+            bvhStats = bvhStats + stats
+            nVisible = nVisible + TOTAL(inIDL)
+
+            ;  Verify.
+            nBad = nBad + TOTAL(inAoS ne inIDL) + TOTAL(clipAoS ne clipIDL) + $
+                TOTAL(inSoA ne inIDL) + TOTAL(clipSoA ne clipIDL)
+
+        endfor
+
+        results[*,i] = [nObj, nVisible / (nSteps * nObj), $
+            1000D * [tAoS, tSoA, tIDL, tBVH] / nSteps, $
+            TOTAL(bvhStats[2:3], /DOUBLE) / (6D * bvhStats[0])]
+        if (~timeIDL) then results[4,i] = !VALUES.D_NAN
+
+        PRINT, results[*,i], FORMAT='(I10,F9.3,4F14.4,F7.3)'
+
+    endfor
+
+    if (nBad gt 0) then $
+        PRINT, 'WARNING: ' + STRTRIM(nBad,2) + $
+            ' results differ from the IDL implementation.' $
+    else PRINT, 'DLM results are identical to the IDL implementation.'
+
+    ;  Write the results.
+    if (N_ELEMENTS(filename) eq 1) then begin
+        OPENW, lun, filename, /GET_LUN
+        PRINTF, lun, 'nobjects,visible_fraction,aos_ms,soa_ms,idl_ms,' + $
+            'bvh_ms,bvh_saved_fraction'
+        for i=0, N_ELEMENTS(nObjects)-1 do $
+            PRINTF, lun, results[*,i], $
+                FORMAT='(I0,",",F0.4,4(",",F0.5),",",F0.4)'
+        FREE_LUN, lun
+    endif
+
+    OBJ_DESTROY, camera
+
+end
+;   }}}
@@ -40,6 +40,9 @@
 ;
 ; MODIFICATION HISTORY:
 ;       Written by: Rick Towler, 03 June 2003.
+;       Batched bounding boxes for many models (RHTgrAABB_CalcBBArray) and
+;       tight boxes from vertex data with a SIMD min/max reduction
+;       (RHTgrAABB_VertexBB).
 ;
 ;
 ; LICENSE
@@ -70,6 +73,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "vec.h"
 #include "export.h"
 
@@ -77,15 +87,368 @@
 #define ARRLEN(arr) (sizeof(arr)/sizeof(arr[0]))
 
 
+/*
+	Bounding box kernels.
+
+	Boxes are returned in the form used by RHTgrAABB::CalcBB, a 3x3 array
+	[[min], [max], [valid]] where valid is [1,1,1] for a box containing
+	geometry and [0,0,0], with a zero min and max, for an empty one.
+
+	When built with OpenMP, models are spread across threads once more
+	than BB_MT_MIN are given.  Vertex data is reduced in pieces of at
+	most BB_CHUNK vertices so a single large mesh is threaded as well.
+	The min/max reduction reads the interleaved 3xN data directly: with
+	W lanes, three vectors hold W whole vertices and lane k of vector j
+	always holds component (j*W + k) mod 3, so the inner loop needs no
+	shuffles.  MIN/MAX are exact, so every path returns the same box.
+*/
+#define BB_MT_MIN		1024
+#define BB_CHUNK		65536
+#define BB_BLOCK		256
+
+#if defined(__AVX512F__)
+#define VD				__m512d
+#define VD_WIDTH		8
+#define VD_SET1(a)		_mm512_set1_pd(a)
+#define VD_LOAD(p)		_mm512_loadu_pd(p)
+#define VD_STORE(p,a)	_mm512_storeu_pd(p,a)
+#define VD_MIN(a,b)		_mm512_min_pd(a,b)
+#define VD_MAX(a,b)		_mm512_max_pd(a,b)
+#define VF				__m512
+#define VF_WIDTH		16
+#define VF_SET1(a)		_mm512_set1_ps(a)
+#define VF_LOAD(p)		_mm512_loadu_ps(p)
+#define VF_STORE(p,a)	_mm512_storeu_ps(p,a)
+#define VF_MIN(a,b)		_mm512_min_ps(a,b)
+#define VF_MAX(a,b)		_mm512_max_ps(a,b)
+#elif defined(__AVX2__)
+#define VD				__m256d
+#define VD_WIDTH		4
+#define VD_SET1(a)		_mm256_set1_pd(a)
+#define VD_LOAD(p)		_mm256_loadu_pd(p)
+#define VD_STORE(p,a)	_mm256_storeu_pd(p,a)
+#define VD_MIN(a,b)		_mm256_min_pd(a,b)
+#define VD_MAX(a,b)		_mm256_max_pd(a,b)
+#define VF				__m256
+#define VF_WIDTH		8
+#define VF_SET1(a)		_mm256_set1_ps(a)
+#define VF_LOAD(p)		_mm256_loadu_ps(p)
+#define VF_STORE(p,a)	_mm256_storeu_ps(p,a)
+#define VF_MIN(a,b)		_mm256_min_ps(a,b)
+#define VF_MAX(a,b)		_mm256_max_ps(a,b)
+#endif
+
+typedef struct {
+	IDL_MEMINT		group, first, count;
+} BBPIECE;
+
+
+/*
+	Build the matrix that maps data to model space from the coordinate
+	conversion cc ([x0,x1,y0,y1,z0,z1]) and the 4x4 matrix t1d (IDL order,
+	t[n][o] = t1d[n*4+o]), combined as RHTgrAABB_CalcBB always has.
+	Either may be NULL.
+*/
+static void bb_matrix(const double *cc, const double *t1d, double t[4][4])
+{
+	short		n, o;
+	double		scale[4][4];
+
+	if (t1d) {
+		for (n = 0; n < 4; ++n) {
+			for (o = 0; o < 4; ++o)
+				t[n][o] = t1d[n*4+o];
+		}
+	} else IDENTMAT4(t);
+
+	if (cc) {
+		IDENTMAT4(scale);
+		scale[0][0] = cc[1];
+		scale[0][3] = cc[0];
+		scale[1][1] = cc[3];
+		scale[1][3] = cc[2];
+		scale[2][2] = cc[5];
+		scale[2][3] = cc[4];
+
+		MXM4d(t, scale, t);
+	}
+}
+
+
+/*
+	Box the 8 corners of the data range range ([x0,x1,y0,y1,z0,z1]) after
+	transforming them by t.  box receives the 3x3 result.
+*/
+static void bb_corners(const double *range, double t[4][4], double *box)
+{
+	short		n;
+	double		vertex[4];
+
+	for (n = 0; n < 8; n++) {
+
+		vertex[0] = range[n & 1];
+		vertex[1] = range[2 + ((n / 2) & 1)];
+		vertex[2] = range[4 + ((n / 4) & 1)];
+		vertex[3] = 1.;
+
+		MXV4d(vertex,t,vertex);
+
+		if (vertex[3] != 0 && vertex[3] != 1) {
+			vertex[0] = vertex[0] / vertex[3];
+			vertex[1] = vertex[1] / vertex[3];
+			vertex[2] = vertex[2] / vertex[3];
+		}
+
+		if (n == 0) {
+			box[0] = box[3] = vertex[0];
+			box[1] = box[4] = vertex[1];
+			box[2] = box[5] = vertex[2];
+			continue;
+		}
+
+		if (box[0] > vertex[0]) box[0] = vertex[0];
+		if (box[1] > vertex[1]) box[1] = vertex[1];
+		if (box[2] > vertex[2]) box[2] = vertex[2];
+		if (box[3] < vertex[0]) box[3] = vertex[0];
+		if (box[4] < vertex[1]) box[4] = vertex[1];
+		if (box[5] < vertex[2]) box[5] = vertex[2];
+
+	}
+
+	box[6] = 1.;
+	box[7] = 1.;
+	box[8] = 1.;
+}
+
+
+/*  Grow box to contain b.  Empty boxes are ignored. */
+static void bb_union(double *box, const double *b)
+{
+	short		k;
+
+	if (!b[6]) return;
+
+	if (!box[6]) {
+		for (k = 0; k < 9; ++k) box[k] = b[k];
+		return;
+	}
+
+	for (k = 0; k < 3; ++k) {
+		if (box[k] > b[k]) box[k] = b[k];
+		if (box[k+3] < b[k+3]) box[k+3] = b[k+3];
+	}
+}
+
+
+/*
+	Grow mn and mx to include n interleaved double precision vertices.
+	NaNs are skipped in every path: the vector MIN/MAX return their second
+	operand if either is a NaN.
+*/
+static void bb_minmax_d(IDL_MEMINT n, const double *v, double *mn,
+	double *mx)
+{
+	short		k;
+	IDL_MEMINT	i = 0;
+
+#ifdef VD
+	if (n >= VD_WIDTH) {
+
+		double	lo[3*VD_WIDTH], hi[3*VD_WIDTH];
+		VD		a, lo0, lo1, lo2, hi0, hi1, hi2;
+
+		lo0 = lo1 = lo2 = VD_SET1(HUGE_VAL);
+		hi0 = hi1 = hi2 = VD_SET1(-HUGE_VAL);
+
+		for (; i + VD_WIDTH <= n; i += VD_WIDTH) {
+			a = VD_LOAD(v + i*3);
+			lo0 = VD_MIN(a, lo0);
+			hi0 = VD_MAX(a, hi0);
+			a = VD_LOAD(v + i*3 + VD_WIDTH);
+			lo1 = VD_MIN(a, lo1);
+			hi1 = VD_MAX(a, hi1);
+			a = VD_LOAD(v + i*3 + 2*VD_WIDTH);
+			lo2 = VD_MIN(a, lo2);
+			hi2 = VD_MAX(a, hi2);
+		}
+
+		VD_STORE(lo, lo0);
+		VD_STORE(lo + VD_WIDTH, lo1);
+		VD_STORE(lo + 2*VD_WIDTH, lo2);
+		VD_STORE(hi, hi0);
+		VD_STORE(hi + VD_WIDTH, hi1);
+		VD_STORE(hi + 2*VD_WIDTH, hi2);
+
+		for (k = 0; k < 3*VD_WIDTH; ++k) {
+			if (mn[k % 3] > lo[k]) mn[k % 3] = lo[k];
+			if (mx[k % 3] < hi[k]) mx[k % 3] = hi[k];
+		}
+	}
+#endif
+
+	for (; i < n; ++i) {
+		for (k = 0; k < 3; ++k) {
+			if (mn[k] > v[i*3+k]) mn[k] = v[i*3+k];
+			if (mx[k] < v[i*3+k]) mx[k] = v[i*3+k];
+		}
+	}
+}
+
+
+/*  Grow mn and mx to include n interleaved single precision vertices. */
+static void bb_minmax_f(IDL_MEMINT n, const float *v, double *mn,
+	double *mx)
+{
+	short		k;
+	IDL_MEMINT	i = 0;
+
+#ifdef VF
+	if (n >= VF_WIDTH) {
+
+		float	lo[3*VF_WIDTH], hi[3*VF_WIDTH];
+		VF		a, lo0, lo1, lo2, hi0, hi1, hi2;
+
+		lo0 = lo1 = lo2 = VF_SET1((float) HUGE_VAL);
+		hi0 = hi1 = hi2 = VF_SET1((float) -HUGE_VAL);
+
+		for (; i + VF_WIDTH <= n; i += VF_WIDTH) {
+			a = VF_LOAD(v + i*3);
+			lo0 = VF_MIN(a, lo0);
+			hi0 = VF_MAX(a, hi0);
+			a = VF_LOAD(v + i*3 + VF_WIDTH);
+			lo1 = VF_MIN(a, lo1);
+			hi1 = VF_MAX(a, hi1);
+			a = VF_LOAD(v + i*3 + 2*VF_WIDTH);
+			lo2 = VF_MIN(a, lo2);
+			hi2 = VF_MAX(a, hi2);
+		}
+
+		VF_STORE(lo, lo0);
+		VF_STORE(lo + VF_WIDTH, lo1);
+		VF_STORE(lo + 2*VF_WIDTH, lo2);
+		VF_STORE(hi, hi0);
+		VF_STORE(hi + VF_WIDTH, hi1);
+		VF_STORE(hi + 2*VF_WIDTH, hi2);
+
+		for (k = 0; k < 3*VF_WIDTH; ++k) {
+			if (mn[k % 3] > lo[k]) mn[k % 3] = lo[k];
+			if (mx[k % 3] < hi[k]) mx[k % 3] = hi[k];
+		}
+	}
+#endif
+
+	for (; i < n; ++i) {
+		for (k = 0; k < 3; ++k) {
+			if (mn[k] > v[i*3+k]) mn[k] = v[i*3+k];
+			if (mx[k] < v[i*3+k]) mx[k] = v[i*3+k];
+		}
+	}
+}
+
+
+/*
+	Box n vertices (float if isFloat, else double) after transforming them
+	by t, which may be NULL.  Vertices are transformed BB_BLOCK at a time
+	into a double buffer which is then reduced.  The perspective divide is
+	skipped when the last row of t is [0,0,0,1].
+*/
+static void bb_vertices(IDL_MEMINT n, const void *v, int isFloat,
+	double t[4][4], double *box)
+{
+	short		k;
+	int			affine;
+	IDL_MEMINT	i, j, count;
+	double		x, y, z, w, mn[3], mx[3], buf[3*BB_BLOCK];
+
+	for (k = 0; k < 3; ++k) {
+		mn[k] = HUGE_VAL;
+		mx[k] = -HUGE_VAL;
+	}
+
+	if (!t) {
+		if (isFloat) bb_minmax_f(n, (const float *) v, mn, mx);
+			else bb_minmax_d(n, (const double *) v, mn, mx);
+	} else {
+		affine = (t[3][0] == 0 && t[3][1] == 0 && t[3][2] == 0 &&
+			t[3][3] == 1);
+		for (i = 0; i < n; i += BB_BLOCK) {
+			count = (n - i < BB_BLOCK) ? n - i : BB_BLOCK;
+			for (j = 0; j < count; ++j) {
+				if (isFloat) {
+					x = ((const float *) v)[(i+j)*3];
+					y = ((const float *) v)[(i+j)*3+1];
+					z = ((const float *) v)[(i+j)*3+2];
+				} else {
+					x = ((const double *) v)[(i+j)*3];
+					y = ((const double *) v)[(i+j)*3+1];
+					z = ((const double *) v)[(i+j)*3+2];
+				}
+				for (k = 0; k < 3; ++k)
+					buf[j*3+k] = t[k][0]*x + t[k][1]*y + t[k][2]*z + t[k][3];
+				if (!affine) {
+					w = t[3][0]*x + t[3][1]*y + t[3][2]*z + t[3][3];
+					if (w != 0 && w != 1) {
+						buf[j*3] = buf[j*3] / w;
+						buf[j*3+1] = buf[j*3+1] / w;
+						buf[j*3+2] = buf[j*3+2] / w;
+					}
+				}
+			}
+			bb_minmax_d(count, buf, mn, mx);
+		}
+	}
+
+	for (k = 0; k < 3; ++k) {
+		box[k] = (n > 0) ? mn[k] : 0.;
+		box[k+3] = (n > 0) ? mx[k] : 0.;
+		box[k+6] = (n > 0) ? 1. : 0.;
+	}
+}
+
+
+/*
+	Convert the optional COUNTS keyword to an array of group sizes whose
+	sum must be nTotal.  Returns the number of groups and sets *oCounts
+	to the converted variable (NULL if COUNTS was not set, in which case
+	*counts points at nTotal).
+*/
+static IDL_MEMINT bb_counts(IDL_VPTR oCountsKw, IDL_MEMINT *nTotal,
+	IDL_VPTR *oCounts, IDL_MEMINT **counts)
+{
+	IDL_MEMINT		m, nGroups, sum;
+
+	*oCounts = NULL;
+	*counts = nTotal;
+	if (!oCountsKw) return 1;
+
+	IDL_ENSURE_ARRAY(oCountsKw);
+	*oCounts = IDL_BasicTypeConversion(1, &oCountsKw, IDL_TYP_MEMINT);
+	*counts = (IDL_MEMINT *) (*oCounts)->value.arr->data;
+	nGroups = (*oCounts)->value.arr->n_elts;
+
+	for (m = 0, sum = 0; m < nGroups; ++m) {
+		if ((*counts)[m] < 0)
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"COUNTS must not be negative.");
+		sum += (*counts)[m];
+	}
+	if (sum != *nTotal)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"TOTAL(COUNTS) must equal the number of elements boxed.");
+
+	return nGroups;
+}
+
+
+//  RHTgrAABB_CalcBB
 IDL_VPTR IDL_CDECL RHTgrAABB_CalcBB(int argc, IDL_VPTR *argv)
 {
 
-	short		n,o;
+	short		n;
 	double		*xCoordConv, *yCoordConv, *zCoordConv, *transIn;
 	double		*xRange, *yRange, *zRange, *pBox;
-	double		vertex[4], transform[4][4], scale[4][4];
-	double		minRange[3], maxRange[3], bBox[3][3];
-	IDL_LONG	size[] = {3,3};
+	double		range[6], coordConv[6], transform[4][4];
+	IDL_MEMINT	size[] = {3,3};
 	IDL_VPTR	oBox;
 
 	xRange = (double *) argv[0]->value.arr->data;
@@ -96,79 +459,273 @@ IDL_VPTR IDL_CDECL RHTgrAABB_CalcBB(int argc, IDL_VPTR *argv)
 	zCoordConv = (double *) argv[5]->value.arr->data;
 	transIn = (double *) argv[6]->value.arr->data;
 
-	for (n = 0; n < 4; ++n) {
-		for (o = 0; o < 4; ++o) 
-			transform[n][o] = transIn[n*4+o];
+	for (n = 0; n < 2; ++n) {
+		range[n] = xRange[n];
+		range[n+2] = yRange[n];
+		range[n+4] = zRange[n];
+		coordConv[n] = xCoordConv[n];
+		coordConv[n+2] = yCoordConv[n];
+		coordConv[n+4] = zCoordConv[n];
 	}
 
 	pBox = (double *) IDL_MakeTempArray((int)IDL_TYP_DOUBLE, 2, size,
 		IDL_ARR_INI_NOP, &oBox);
 
-	IDENTMAT4(scale);
-	scale[0][0] = xCoordConv[1];
-	scale[0][3] = xCoordConv[0];
-	scale[1][1] = yCoordConv[1];
-	scale[1][3] = yCoordConv[0];
-	scale[2][2] = zCoordConv[1];
-	scale[2][3] = zCoordConv[0];
-
-	MXM4d(transform, scale, transform);
-
-	vertex[0] = xRange[0];
-	vertex[1] = yRange[0];
-	vertex[2] = zRange[0];
-	vertex[3] = 1.;
-	
-	MXV4d(vertex,transform,vertex);
-
-	if (vertex[3] != 0 && vertex[3] != 1) {
-		vertex[0] = vertex[0] / vertex[3];
-		vertex[1] = vertex[1] / vertex[3];
-		vertex[2] = vertex[2] / vertex[3];
-	}
-
-	minRange[0] = vertex[0];
-	minRange[1] = vertex[1];
-	minRange[2] = vertex[2];
-	maxRange[0] = vertex[0];
-	maxRange[1] = vertex[1];
-	maxRange[2] = vertex[2];
-
-	for (n = 1; n<8; n++) {
-
-		vertex[0] = xRange[n & 1];
-		vertex[1] = yRange[(n / 2) & 1];
-		vertex[2] = zRange[(n / 4) & 1];
-		vertex[3] = 1.;
+	bb_matrix(coordConv, transIn, transform);
+	bb_corners(range, transform, pBox);
 
-		MXV4d(vertex,transform,vertex);
+	return oBox;
 
-		if (vertex[3] != 0 && vertex[3] != 1) {
-			vertex[0] = vertex[0] / vertex[3];
-			vertex[1] = vertex[1] / vertex[3];
-			vertex[2] = vertex[2] / vertex[3];
+}
+
+
+//  RHTgrAABB_CalcBBArray
+IDL_VPTR IDL_CDECL RHTgrAABB_CalcBBArray(int argc, IDL_VPTR *argv, char *argk)
+{
+	/*
+
+		bBoxes = RHTgrAABB_CalcBBArray(ranges, coordConv, transform)
+
+		Batched form of RHTgrAABB_CalcBB.  ranges is a 2x3xN array holding
+		[xRange, yRange, zRange] for each of N models and coordConv is the
+		matching 2x3xN array of [xCoordConv, yCoordConv, zCoordConv].
+		transform is either one 4x4 matrix used for every model or a 4x4xN
+		array with a matrix per model.  Returns a 3x3xN array of boxes in
+		the form returned by RHTgrAABB_CalcBB.
+
+		Set COUNTS to an M element array to merge the boxes of consecutive
+		models: box 0 contains the first COUNTS[0] models, box 1 the next
+		COUNTS[1] and so on.  A 3x3xM array is returned and groups with a
+		count of zero return an empty box.
+
+	*/
+
+	IDL_MEMINT		m, n, first, nModels, nTrans, nGroups, *counts, size[3];
+	double			*pRanges, *pConv, *pTrans, *pBoxes, *pOut;
+	IDL_VPTR		oRanges, oConv, oTrans, oCounts, oBoxes, outargv[3];
+	static IDL_VPTR oCountsKw;
+
+	static IDL_KW_PAR keywords[]={
+		{"COUNTS", IDL_TYP_UNDEF, 1, IDL_KW_VIN|IDL_KW_ZERO,0,IDL_CHARA(oCountsKw)},
+		{NULL}
+	};
+
+	IDL_KWGetParams(argc,argv,argk, keywords,outargv,1);
+
+	for (n = 0; n < 3; ++n)
+		IDL_ENSURE_ARRAY(outargv[n]);
+
+	oRanges = (outargv[0]->type == IDL_TYP_DOUBLE) ? outargv[0] :
+		IDL_BasicTypeConversion(1, &outargv[0], IDL_TYP_DOUBLE);
+	oConv = (outargv[1]->type == IDL_TYP_DOUBLE) ? outargv[1] :
+		IDL_BasicTypeConversion(1, &outargv[1], IDL_TYP_DOUBLE);
+	oTrans = (outargv[2]->type == IDL_TYP_DOUBLE) ? outargv[2] :
+		IDL_BasicTypeConversion(1, &outargv[2], IDL_TYP_DOUBLE);
+
+	nModels = oRanges->value.arr->n_elts / 6;
+	nTrans = oTrans->value.arr->n_elts / 16;
+	pRanges = (double *) oRanges->value.arr->data;
+	pConv = (double *) oConv->value.arr->data;
+	pTrans = (double *) oTrans->value.arr->data;
+
+	if (nModels < 1 || oRanges->value.arr->n_elts != nModels * 6)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"ranges must be a 2x3xN array.");
+	if (oConv->value.arr->n_elts != nModels * 6)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"coordConv must be a 2x3xN array.");
+	if ((nTrans != 1 && nTrans != nModels) ||
+		oTrans->value.arr->n_elts != nTrans * 16)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"transform must be a 4x4 or 4x4xN array.");
+
+	nGroups = bb_counts(oCountsKw, &nModels, &oCounts, &counts);
+	if (!oCounts) nGroups = nModels;
+
+	size[0] = 3;
+	size[1] = 3;
+	size[2] = nGroups;
+	pOut = (double *) IDL_MakeTempArray((int)IDL_TYP_DOUBLE,
+		(nGroups > 1) ? 3 : 2, size, IDL_ARR_INI_ZERO, &oBoxes);
+
+	/*  Box each model, into the result directly unless merging. */
+	if (oCounts) {
+		pBoxes = (double *) malloc(nModels * 9 * sizeof(double));
+		if (!pBoxes)
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"Unable to allocate memory for bounding boxes.");
+	} else pBoxes = pOut;
+
+#ifdef _OPENMP
+	#pragma omp parallel for schedule(static) if (nModels >= BB_MT_MIN)
+#endif
+	for (m = 0; m < nModels; ++m) {
+
+		double			t[4][4];
+
+		bb_matrix(pConv + m*6, pTrans + ((nTrans > 1) ? m*16 : 0), t);
+		bb_corners(pRanges + m*6, t, pBoxes + m*9);
+	}
+
+	if (oCounts) {
+		for (m = 0, first = 0; m < nGroups; ++m) {
+			for (n = first; n < first + counts[m]; ++n)
+				bb_union(pOut + m*9, pBoxes + n*9);
+			first += counts[m];
 		}
+		free(pBoxes);
+		if (oCounts != oCountsKw) IDL_Deltmp(oCounts);
+	}
+
+	if (oTrans != outargv[2]) IDL_Deltmp(oTrans);
+	if (oConv != outargv[1]) IDL_Deltmp(oConv);
+	if (oRanges != outargv[0]) IDL_Deltmp(oRanges);
+
+	return oBoxes;
+
+}
+
+
+//  RHTgrAABB_VertexBB
+IDL_VPTR IDL_CDECL RHTgrAABB_VertexBB(int argc, IDL_VPTR *argv, char *argk)
+{
+	/*
+
+		bBox = RHTgrAABB_VertexBB(vertices)
+
+		Returns the tight bounding box of the 3xN array vertices in the
+		form returned by RHTgrAABB_CalcBB.  Float and double vertices are
+		read directly, other types are converted to double.
 
-		if (minRange[0] > vertex[0]) minRange[0] = vertex[0];
-		if (minRange[1] > vertex[1]) minRange[1] = vertex[1];
-		if (minRange[2] > vertex[2]) minRange[2] = vertex[2];
-		if (maxRange[0] < vertex[0]) maxRange[0] = vertex[0];
-		if (maxRange[1] < vertex[1]) maxRange[1] = vertex[1];
-		if (maxRange[2] < vertex[2]) maxRange[2] = vertex[2];
+		Set COUNTS to an M element array of the number of vertices in each
+		of M meshes stored one after another in vertices to return a
+		3x3xM array with a box per mesh.
+
+		Set COORD_CONV to a 2x3 array [xCoordConv, yCoordConv, zCoordConv]
+		and/or TRANSFORM to a 4x4 matrix to box the vertices after they
+		are scaled and transformed, as RHTgrAABB_CalcBB does with a data
+		range.  Either may also be given per mesh (2x3xM, 4x4xM).  Since
+		each vertex is transformed the box is tight rather than the box
+		around the 8 transformed corners of the data range.
+
+	*/
+
+	int				isFloat;
+	IDL_MEMINT		m, n, p, first, nVerts, nGroups, nConv, nTrans, nPieces;
+	IDL_MEMINT		*counts, size[3];
+	double			*pConv, *pTrans, *pOut, *pPieceBoxes;
+	char			*pIn;
+	BBPIECE			*pieces;
+	IDL_VPTR		oIn, oConv = NULL, oTrans = NULL, oCounts, oBoxes;
+	IDL_VPTR		outargv[1];
+	static IDL_VPTR oConvKw, oCountsKw, oTransKw;
+
+	static IDL_KW_PAR keywords[]={
+		{"COORD_CONV", IDL_TYP_UNDEF, 1, IDL_KW_VIN|IDL_KW_ZERO,0,IDL_CHARA(oConvKw)},
+		{"COUNTS", IDL_TYP_UNDEF, 1, IDL_KW_VIN|IDL_KW_ZERO,0,IDL_CHARA(oCountsKw)},
+		{"TRANSFORM", IDL_TYP_UNDEF, 1, IDL_KW_VIN|IDL_KW_ZERO,0,IDL_CHARA(oTransKw)},
+		{NULL}
+	};
 
+	IDL_KWGetParams(argc,argv,argk, keywords,outargv,1);
+
+	IDL_ENSURE_ARRAY(outargv[0]);
+
+	isFloat = (outargv[0]->type == IDL_TYP_FLOAT);
+	oIn = (isFloat || outargv[0]->type == IDL_TYP_DOUBLE) ? outargv[0] :
+		IDL_BasicTypeConversion(1, &outargv[0], IDL_TYP_DOUBLE);
+	nVerts = oIn->value.arr->n_elts / 3;
+	pIn = (char *) oIn->value.arr->data;
+
+	if (oIn->value.arr->n_elts != nVerts * 3)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"vertices must be a 3xN array.");
+
+	nGroups = bb_counts(oCountsKw, &nVerts, &oCounts, &counts);
+
+	/*  Optional per mesh or shared coordinate conversions and transforms. */
+	nConv = nTrans = 0;
+	pConv = pTrans = NULL;
+	if (oConvKw) {
+		IDL_ENSURE_ARRAY(oConvKw);
+		oConv = (oConvKw->type == IDL_TYP_DOUBLE) ? oConvKw :
+			IDL_BasicTypeConversion(1, &oConvKw, IDL_TYP_DOUBLE);
+		nConv = oConv->value.arr->n_elts / 6;
+		pConv = (double *) oConv->value.arr->data;
+		if ((nConv != 1 && nConv != nGroups) ||
+			oConv->value.arr->n_elts != nConv * 6)
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"COORD_CONV must be a 2x3 or 2x3xM array.");
+	}
+	if (oTransKw) {
+		IDL_ENSURE_ARRAY(oTransKw);
+		oTrans = (oTransKw->type == IDL_TYP_DOUBLE) ? oTransKw :
+			IDL_BasicTypeConversion(1, &oTransKw, IDL_TYP_DOUBLE);
+		nTrans = oTrans->value.arr->n_elts / 16;
+		pTrans = (double *) oTrans->value.arr->data;
+		if ((nTrans != 1 && nTrans != nGroups) ||
+			oTrans->value.arr->n_elts != nTrans * 16)
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"TRANSFORM must be a 4x4 or 4x4xM array.");
 	}
 
-	pBox[0] = minRange[0];
-	pBox[1] = minRange[1];
-	pBox[2] = minRange[2];
-	pBox[3] = maxRange[0];
-	pBox[4] = maxRange[1];
-	pBox[5] = maxRange[2];
-	pBox[6] = 1.;
-	pBox[7] = 1.;
-	pBox[8] = 1.;
+	/*  Split the meshes into pieces of at most BB_CHUNK vertices. */
+	for (m = 0, nPieces = 0; m < nGroups; ++m)
+		nPieces += (counts[m] + BB_CHUNK - 1) / BB_CHUNK;
 
-	return oBox;
+	pieces = (BBPIECE *) malloc((nPieces + 1) * sizeof(BBPIECE));
+	pPieceBoxes = (double *) malloc((nPieces + 1) * 9 * sizeof(double));
+	if (!pieces || !pPieceBoxes) {
+		free(pieces); free(pPieceBoxes);
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"Unable to allocate memory for bounding boxes.");
+	}
+
+	for (m = 0, p = 0, first = 0; m < nGroups; ++m) {
+		for (n = 0; n < counts[m]; n += BB_CHUNK, ++p) {
+			pieces[p].group = m;
+			pieces[p].first = first + n;
+			pieces[p].count = (counts[m] - n < BB_CHUNK) ?
+				counts[m] - n : BB_CHUNK;
+		}
+		first += counts[m];
+	}
+
+#ifdef _OPENMP
+	#pragma omp parallel for schedule(static) if (nPieces > 1 && nVerts >= BB_CHUNK)
+#endif
+	for (p = 0; p < nPieces; ++p) {
+
+		IDL_MEMINT		g = pieces[p].group;
+		double			t[4][4];
+
+		if (pConv || pTrans)
+			bb_matrix((pConv) ? pConv + ((nConv > 1) ? g*6 : 0) : NULL,
+				(pTrans) ? pTrans + ((nTrans > 1) ? g*16 : 0) : NULL, t);
+
+		bb_vertices(pieces[p].count, pIn + pieces[p].first * 3 *
+			oIn->value.arr->elt_len, isFloat, (pConv || pTrans) ? t : NULL,
+			pPieceBoxes + p*9);
+	}
+
+	size[0] = 3;
+	size[1] = 3;
+	size[2] = nGroups;
+	pOut = (double *) IDL_MakeTempArray((int)IDL_TYP_DOUBLE,
+		(nGroups > 1) ? 3 : 2, size, IDL_ARR_INI_ZERO, &oBoxes);
+
+	for (p = 0; p < nPieces; ++p)
+		bb_union(pOut + pieces[p].group * 9, pPieceBoxes + p*9);
+
+	free(pieces);
+	free(pPieceBoxes);
+
+	if (oCounts && oCounts != oCountsKw) IDL_Deltmp(oCounts);
+	if (oTrans && oTrans != oTransKw) IDL_Deltmp(oTrans);
+	if (oConv && oConv != oConvKw) IDL_Deltmp(oConv);
+	if (oIn != outargv[0]) IDL_Deltmp(oIn);
+
+	return oBoxes;
 
 }
 
@@ -178,6 +735,10 @@ int IDL_Load(void)
 
 	static IDL_SYSFUN_DEF2 function_addr[] = {
 		{(IDL_SYSRTN_GENERIC) RHTgrAABB_CalcBB, "RHTGRAABB_CALCBB", 7, 7, 0, 0},
+		{(IDL_SYSRTN_GENERIC) RHTgrAABB_CalcBBArray, "RHTGRAABB_CALCBBARRAY", 3, 3, 
+			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
+		{(IDL_SYSRTN_GENERIC) RHTgrAABB_VertexBB, "RHTGRAABB_VERTEXBB", 1, 1, 
+			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
 	};
 
 	return IDL_SysRtnAdd(function_addr, TRUE, ARRLEN(function_addr));
@@ -23,6 +23,8 @@ SET IDL_LIBDIR=%IDL_DIR%\bin\bin.x86
 IF NOT EXIST %IDL_LIBDIR%\idl32.lib GOTO NO_IDL_LIB
 IF NOT EXIST %IDL_DIR%\external\export.h GOTO NO_EXPORT_H
 
+REM  Add /openmp (VC 2005 or later) to thread the bounding box kernels and
+REM  /arch:AVX2 (VC 2015 or later) to enable their vector paths.
 cl /Ob2gity /GDd6 -I%IDL_DIR%\external -nologo -DWIN32_LEAN_AND_MEAN -DWIN32 -c RHTgrAABB.c
 link /DLL /OUT:RHTgrAABB.dll /DEF:RHTgrAABB.def RHTgrAABB.obj %IDL_LIBDIR%\idl32.lib
 
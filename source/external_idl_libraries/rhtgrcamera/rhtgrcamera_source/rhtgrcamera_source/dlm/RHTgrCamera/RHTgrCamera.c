@@ -40,6 +40,17 @@
 ;
 ; MODIFICATION HISTORY:
 ;       Written by: Rick Towler, 15 November 2002.
+;       Batched frustum culling kernel with SIMD and OpenMP paths and
+;       structure-of-arrays input (SOA keyword).
+;       Native BVH build, cull and refit (RHTgrCamera_BVH*).
+;       Batched SIMD vertex transform with a float path, OUTPUT and
+;       per-mesh transforms (RHTgrCamera_VertT3D).
+;       Software hierarchical-Z occlusion culling against user supplied
+;       occluder boxes (RHTgrCamera_HiZBuild, RHTgrCamera_HiZTest).
+;       Screen space error level of detail selection in the BVH cull
+;       (LOD and LOD_ERRORS keywords to RHTgrCamera_BVHCull).
+;       Cached shared vertex geodesic meshes for RHTgrPSolid
+;       (RHTgrCamera_GeodesicMesh).
 ;
 ;
 ; LICENSE
@@ -71,12 +82,29 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <float.h>
+#include <string.h>
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "vec.h"
 #include "export.h"
 
 #define STRICT
 #define ARRLEN(arr) (sizeof(arr)/sizeof(arr[0]))
 #define SQR(x) ((x)*(x))
+#define MIN(a,b) (((a) < (b)) ? (a) : (b))
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+/*
+	Culling kernels work on blocks of CULL_BLOCK boxes.  Batches larger than
+	CULL_MT_MIN boxes are split across threads when built with OpenMP.
+*/
+#define CULL_BLOCK		512
+#define CULL_MT_MIN		32768
 
 const int	faceConn[6][3]={{0,1,2},{4,7,6},{7,4,0},{6,2,1},{0,4,5},{2,6,7}};
 
@@ -118,7 +146,7 @@ IDL_VPTR IDL_CDECL RHTgrCamera_Transform(int argc, IDL_VPTR *argv)
 	double		*rotation, *location, *pTransform;
 	double		viewZ;
 	double		transMatrix[4][4], transform[4][4], rotMatrix[4][4];
-	IDL_LONG	size[] = {4,4};
+	IDL_MEMINT	size[] = {4,4};
 	IDL_VPTR	oTransform;
 
 	for (n = 0; n < 2; ++n)
@@ -161,6 +189,175 @@ IDL_VPTR IDL_CDECL RHTgrCamera_Transform(int argc, IDL_VPTR *argv)
 }
 
 
+/*
+	Vertex transform kernels.
+
+	Vertices are transformed in blocks of VERT_BLOCK.  Each block is split
+	into x, y and z arrays, transformed with the SIMD width available at
+	compile time and interleaved again, so the output may overwrite the
+	input.  Each component is evaluated as
+		((t[i][0]*x + t[i][1]*y) + t[i][2]*z) + t[i][3]
+	in every path, the same as M4XV3, so results do not depend on the path
+	taken (build with -ffp-contract=off).  Blocks are spread across threads
+	for meshes with more than VERT_MT_MIN vertices when built with OpenMP.
+*/
+#define VERT_BLOCK		256
+#define VERT_MT_MIN		65536
+
+#if defined(__AVX512F__)
+#define VD				__m512d
+#define VD_WIDTH		8
+#define VD_SET1(a)		_mm512_set1_pd(a)
+#define VD_LOAD(p)		_mm512_loadu_pd(p)
+#define VD_STORE(p,a)	_mm512_storeu_pd(p,a)
+#define VD_ADD(a,b)		_mm512_add_pd(a,b)
+#define VD_MUL(a,b)		_mm512_mul_pd(a,b)
+#define VF				__m512
+#define VF_WIDTH		16
+#define VF_SET1(a)		_mm512_set1_ps(a)
+#define VF_LOAD(p)		_mm512_loadu_ps(p)
+#define VF_STORE(p,a)	_mm512_storeu_ps(p,a)
+#define VF_ADD(a,b)		_mm512_add_ps(a,b)
+#define VF_MUL(a,b)		_mm512_mul_ps(a,b)
+#elif defined(__AVX2__)
+#define VD				__m256d
+#define VD_WIDTH		4
+#define VD_SET1(a)		_mm256_set1_pd(a)
+#define VD_LOAD(p)		_mm256_loadu_pd(p)
+#define VD_STORE(p,a)	_mm256_storeu_pd(p,a)
+#define VD_ADD(a,b)		_mm256_add_pd(a,b)
+#define VD_MUL(a,b)		_mm256_mul_pd(a,b)
+#define VF				__m256
+#define VF_WIDTH		8
+#define VF_SET1(a)		_mm256_set1_ps(a)
+#define VF_LOAD(p)		_mm256_loadu_ps(p)
+#define VF_STORE(p,a)	_mm256_storeu_ps(p,a)
+#define VF_ADD(a,b)		_mm256_add_ps(a,b)
+#define VF_MUL(a,b)		_mm256_mul_ps(a,b)
+#endif
+
+
+/*  Transform one block of at most VERT_BLOCK double precision vertices. */
+static void vert_block_d(IDL_MEMINT n, const double *in, double *out,
+	const double t[4][4])
+{
+	short		k;
+	IDL_MEMINT	i = 0;
+	double		v[3][VERT_BLOCK], r[3][VERT_BLOCK];
+
+	for (i = 0; i < n; ++i) {
+		v[0][i] = in[i*3];
+		v[1][i] = in[i*3+1];
+		v[2][i] = in[i*3+2];
+	}
+
+	for (k = 0; k < 3; ++k) {
+		i = 0;
+#ifdef VD
+		{
+			VD	t0 = VD_SET1(t[k][0]), t1 = VD_SET1(t[k][1]);
+			VD	t2 = VD_SET1(t[k][2]), t3 = VD_SET1(t[k][3]);
+			for (; i + VD_WIDTH <= n; i += VD_WIDTH)
+				VD_STORE(r[k] + i, VD_ADD(VD_ADD(VD_ADD(
+					VD_MUL(t0, VD_LOAD(v[0] + i)),
+					VD_MUL(t1, VD_LOAD(v[1] + i))),
+					VD_MUL(t2, VD_LOAD(v[2] + i))), t3));
+		}
+#endif
+		for (; i < n; ++i)
+			r[k][i] = t[k][0]*v[0][i] + t[k][1]*v[1][i] +
+				t[k][2]*v[2][i] + t[k][3];
+	}
+
+	for (i = 0; i < n; ++i) {
+		out[i*3] = r[0][i];
+		out[i*3+1] = r[1][i];
+		out[i*3+2] = r[2][i];
+	}
+}
+
+
+/*  Transform one block of at most VERT_BLOCK single precision vertices. */
+static void vert_block_f(IDL_MEMINT n, const float *in, float *out,
+	const float t[4][4])
+{
+	short		k;
+	IDL_MEMINT	i = 0;
+	float		v[3][VERT_BLOCK], r[3][VERT_BLOCK];
+
+	for (i = 0; i < n; ++i) {
+		v[0][i] = in[i*3];
+		v[1][i] = in[i*3+1];
+		v[2][i] = in[i*3+2];
+	}
+
+	for (k = 0; k < 3; ++k) {
+		i = 0;
+#ifdef VF
+		{
+			VF	t0 = VF_SET1(t[k][0]), t1 = VF_SET1(t[k][1]);
+			VF	t2 = VF_SET1(t[k][2]), t3 = VF_SET1(t[k][3]);
+			for (; i + VF_WIDTH <= n; i += VF_WIDTH)
+				VF_STORE(r[k] + i, VF_ADD(VF_ADD(VF_ADD(
+					VF_MUL(t0, VF_LOAD(v[0] + i)),
+					VF_MUL(t1, VF_LOAD(v[1] + i))),
+					VF_MUL(t2, VF_LOAD(v[2] + i))), t3));
+		}
+#endif
+		for (; i < n; ++i)
+			r[k][i] = t[k][0]*v[0][i] + t[k][1]*v[1][i] +
+				t[k][2]*v[2][i] + t[k][3];
+	}
+
+	for (i = 0; i < n; ++i) {
+		out[i*3] = r[0][i];
+		out[i*3+1] = r[1][i];
+		out[i*3+2] = r[2][i];
+	}
+}
+
+
+/*
+	Transform n vertices by the 4x4 matrix t1d (IDL order, t[n][o] =
+	t1d[n*4+o]).  isFloat selects the single precision kernel.
+*/
+static void vert_transform(IDL_MEMINT n, const void *in, void *out,
+	const double *t1d, int isFloat)
+{
+	short		j, k;
+	int			nblk, nblocks;
+	double		td[4][4];
+	float		tf[4][4];
+
+	for (j = 0; j < 4; ++j) {
+		for (k = 0; k < 4; ++k) {
+			td[j][k] = t1d[j*4+k];
+			tf[j][k] = (float) t1d[j*4+k];
+		}
+	}
+
+	nblocks = (int) ((n + VERT_BLOCK - 1) / VERT_BLOCK);
+
+#ifdef _OPENMP
+	#pragma omp parallel for schedule(static) if (n >= VERT_MT_MIN)
+#endif
+	for (nblk = 0; nblk < nblocks; ++nblk) {
+
+		IDL_MEMINT		first, count;
+
+		first = (IDL_MEMINT) nblk * VERT_BLOCK;
+		count = (n - first < VERT_BLOCK) ? n - first : VERT_BLOCK;
+
+		if (isFloat)
+			vert_block_f(count, (const float *) in + first*3,
+				(float *) out + first*3, (const float (*)[4]) tf);
+		else
+			vert_block_d(count, (const double *) in + first*3,
+				(double *) out + first*3, (const double (*)[4]) td);
+	}
+}
+
+
 //  RHTgrCamera_VertT3D
 IDL_VPTR IDL_CDECL RHTgrCamera_VertT3D(int argc, IDL_VPTR *argv, char *argk)
 {
@@ -168,36 +365,120 @@ IDL_VPTR IDL_CDECL RHTgrCamera_VertT3D(int argc, IDL_VPTR *argv, char *argk)
 
 		Tvertices = RHTgrCamera_VertT3D(vertices, transform)
 
+		nVerts = RHTgrCamera_VertT3D(vertices, transform, OUTPUT=tvertices)
+
+		vertices is a 3xN float or double array (other types are converted
+		to double).  Float vertices are transformed in single precision and
+		returned as float.
+
+		transform is a 4x4 matrix, or a 4x4xM array of matrices.  When M
+		matrices are given COUNTS must be an M element array of the number
+		of vertices in each of the M meshes stored one after another in
+		vertices.  Mesh m is transformed by transform[*,*,m].
+
+		Set OUTPUT to a named variable to receive the result.  If it
+		already holds an array of the same type and number of elements as
+		vertices it is overwritten in place (it may be vertices itself) and
+		the number of vertices transformed is returned as a MEMINT.
+
 	*/
 
-	int			n,o;
-	double		*pTrans1d, *pVerts1d, *pTVerts;
-	double		vertex[3], transform[4][4];
-	IDL_LONG	size[] = {3,0};
-	IDL_VPTR	oVerts;
+	int				isFloat, type;
+	IDL_MEMINT		n, m, nVerts, nMats, first, count, *counts, size[2];
+	double			*pTrans1d;
+	char			*pIn, *pOut;
+	const char		*msg = NULL;
+	IDL_VPTR		oVerts, oTrans, oCounts = NULL, oIn, outargv[2];
+	static IDL_VPTR oCountsKw, oOutput;
 
-	for (n = 0; n < 2; ++n)
-		IDL_ENSURE_ARRAY(argv[n]);
+	static IDL_KW_PAR keywords[]={
+		{"COUNTS", IDL_TYP_UNDEF, 1, IDL_KW_VIN|IDL_KW_ZERO,0,IDL_CHARA(oCountsKw)},
+		{"OUTPUT", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oOutput)},
+		{NULL}
+	};
 
-	pVerts1d = (double *) argv[0]->value.arr->data;
-	pTrans1d = (double *) argv[1]->value.arr->data;
-	size[1] = argv[0]->value.arr->dim[1];
-	
-	pTVerts = (double *) IDL_MakeTempArray((int)IDL_TYP_DOUBLE, 2, size,
-		IDL_ARR_INI_NOP, &oVerts);
+	IDL_KWGetParams(argc,argv,argk, keywords,outargv,1);
 
-	for (n = 0; n < 4; ++n) {
-		for (o = 0; o < 4; ++o) 
-			transform[n][o] = pTrans1d[n*4+o];
+	for (n = 0; n < 2; ++n)
+		IDL_ENSURE_ARRAY(outargv[n]);
+
+	/*  Check the shapes before any temporaries are made. */
+	if (outargv[0]->value.arr->n_elts % 3 != 0)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"vertices must be a 3xN array.");
+	nMats = outargv[1]->value.arr->n_elts / 16;
+	if (nMats < 1 || outargv[1]->value.arr->n_elts != nMats * 16)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"transform must be a 4x4 or 4x4xM array.");
+	if (nMats > 1 && !oCountsKw)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"COUNTS must be set when more than one transform is given.");
+	if (oCountsKw)
+		IDL_ENSURE_ARRAY(oCountsKw);
+
+	isFloat = (outargv[0]->type == IDL_TYP_FLOAT);
+	type = (isFloat) ? IDL_TYP_FLOAT : IDL_TYP_DOUBLE;
+	oIn = (outargv[0]->type == type) ? outargv[0] :
+		IDL_BasicTypeConversion(1, &outargv[0], type);
+	oTrans = (outargv[1]->type == IDL_TYP_DOUBLE) ? outargv[1] :
+		IDL_BasicTypeConversion(1, &outargv[1], IDL_TYP_DOUBLE);
+
+	nVerts = oIn->value.arr->n_elts / 3;
+	pIn = (char *) oIn->value.arr->data;
+	pTrans1d = (double *) oTrans->value.arr->data;
+
+	/*  Vertex counts per matrix.  The converted arrays are freed before
+		an error is raised, since IDL_MSG_LONGJMP does not return. */
+	if (oCountsKw) {
+		oCounts = (oCountsKw->type == IDL_TYP_MEMINT) ? oCountsKw :
+			IDL_BasicTypeConversion(1, &oCountsKw, IDL_TYP_MEMINT);
+		counts = (IDL_MEMINT *) oCounts->value.arr->data;
+		if (oCounts->value.arr->n_elts != nMats)
+			msg = "COUNTS must have one element per transform.";
+		/*  Every mesh must lie inside vertices, so that a negative count
+			can not be offset by a larger one. */
+		for (m = 0, count = 0; !msg && m < nMats; ++m) {
+			if (counts[m] < 0)
+				msg = "COUNTS must not be negative.";
+			else if (counts[m] > nVerts - count)
+				msg = "TOTAL(COUNTS) must equal the number of vertices.";
+			else count += counts[m];
+		}
+		if (!msg && count != nVerts)
+			msg = "TOTAL(COUNTS) must equal the number of vertices.";
+		if (msg) {
+			if (oCounts != oCountsKw) IDL_Deltmp(oCounts);
+			if (oTrans != outargv[1]) IDL_Deltmp(oTrans);
+			if (oIn != outargv[0]) IDL_Deltmp(oIn);
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP, msg);
+		}
+	} else counts = &nVerts;
+
+	/*  Write in place into OUTPUT if it matches, otherwise make a new array. */
+	if (oOutput && (oOutput->flags & IDL_V_ARR) && oOutput->type == type &&
+		oOutput->value.arr->n_elts == nVerts * 3) {
+		pOut = (char *) oOutput->value.arr->data;
+		oVerts = NULL;
+	} else {
+		size[0] = 3;
+		size[1] = nVerts;
+		pOut = IDL_MakeTempArray(type, 2, size, IDL_ARR_INI_NOP, &oVerts);
 	}
-	for (n = 0; n < size[1]; ++n) {
-			vertex[0] = pVerts1d[n*3];
-			vertex[1] = pVerts1d[n*3+1];
-			vertex[2] = pVerts1d[n*3+2];
-			M4XV3d(vertex,transform,vertex);
-			pTVerts[n*3] = vertex[0];
-			pTVerts[n*3+1] = vertex[1];
-			pTVerts[n*3+2] = vertex[2];
+
+	for (m = 0, first = 0; m < nMats; ++m) {
+		vert_transform(counts[m], pIn + first * 3 * oIn->value.arr->elt_len,
+			pOut + first * 3 * oIn->value.arr->elt_len, pTrans1d + m*16,
+			isFloat);
+		first += counts[m];
+	}
+
+	if (oCounts && oCounts != oCountsKw) IDL_Deltmp(oCounts);
+	if (oTrans != outargv[1]) IDL_Deltmp(oTrans);
+	if (oIn != outargv[0]) IDL_Deltmp(oIn);
+
+	if (oOutput) {
+		if (oVerts) IDL_VarCopy(oVerts, oOutput);
+		return IDL_GettmpMEMINT(nVerts);
 	}
 
 	return oVerts;
@@ -215,7 +496,7 @@ IDL_VPTR IDL_CDECL RHTgrCamera_ComputeFrustum(int argc, IDL_VPTR *argv, char *ar
 	*/
 
 	int				n,o,p;
-	IDL_LONG		size[] = {3,0};
+	IDL_MEMINT		size[] = {3,0};
 	double			l, xnear, ynear, xfar, yfar, zfar, lvn;
 	double			frustum[8][3], planes[6][4], vertices[3][3];
 	double			eye, *zclip, *fov, *viewcoord;
@@ -314,6 +595,211 @@ IDL_VPTR IDL_CDECL RHTgrCamera_ComputeFrustum(int argc, IDL_VPTR *argv, char *ar
 }
 
 
+/*
+	Frustum / AABB intersection kernel.
+
+	Adapted from code posted to the GDAlgorithms list by Ville Miettinen
+	and deconstruction by Per Vognsen in Bruce Mitchener's "scratch area":
+	http://agora.cubik.org/wiki/view/Scratch/WebHome
+
+	Boxes are passed as structure-of-arrays (center x,y,z and extents x,y,z).
+	For each box intersect is set to 1 if the box is inside or straddles the
+	frustum and 0 if it is outside.  clipMask (which may be NULL) accumulates
+	p for every plane p the box straddles, up to the first rejecting plane.
+	The vector paths evaluate the same expressions, in the same order, as the
+	scalar path so that all three return identical results.  Build with
+	-ffp-contract=off (gcc) so that the compiler does not fuse them.
+*/
+static void cull_frustum_soa(IDL_MEMINT n, const double *cx, const double *cy,
+	const double *cz, const double *ex, const double *ey, const double *ez,
+	const double *planes, short *intersect, short *clipMask)
+{
+
+	short			p, intx, clip;
+	IDL_MEMINT		nbox = 0;
+	double			NP, MP, absPl[6][3];
+
+	for (p = 0; p < 6; ++p) {
+		absPl[p][0] = fabs(planes[p*4]);
+		absPl[p][1] = fabs(planes[p*4+1]);
+		absPl[p][2] = fabs(planes[p*4+2]);
+	}
+
+#if defined(__AVX512F__)
+
+	for (; nbox + 8 <= n; nbox += 8) {
+
+		__m512d		x, y, z, ax, ay, az, vNP, vMP, zero;
+		__m512i		vClip;
+		__mmask8	alive, out, strad;
+
+		x = _mm512_loadu_pd(cx + nbox);
+		y = _mm512_loadu_pd(cy + nbox);
+		z = _mm512_loadu_pd(cz + nbox);
+		ax = _mm512_loadu_pd(ex + nbox);
+		ay = _mm512_loadu_pd(ey + nbox);
+		az = _mm512_loadu_pd(ez + nbox);
+		zero = _mm512_setzero_pd();
+		vClip = _mm512_setzero_si512();
+		alive = 0xFF;
+
+		for (p = 0; p < 6 && alive; ++p) {
+
+			vNP = _mm512_add_pd(_mm512_add_pd(
+				_mm512_mul_pd(ax, _mm512_set1_pd(absPl[p][0])),
+				_mm512_mul_pd(ay, _mm512_set1_pd(absPl[p][1]))),
+				_mm512_mul_pd(az, _mm512_set1_pd(absPl[p][2])));
+			vMP = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(
+				_mm512_mul_pd(x, _mm512_set1_pd(planes[p*4])),
+				_mm512_mul_pd(y, _mm512_set1_pd(planes[p*4+1]))),
+				_mm512_mul_pd(z, _mm512_set1_pd(planes[p*4+2]))),
+				_mm512_set1_pd(planes[p*4+3]));
+
+			out = _mm512_mask_cmp_pd_mask(alive, _mm512_add_pd(vMP, vNP),
+				zero, _CMP_LT_OQ);
+			strad = _mm512_mask_cmp_pd_mask(alive & ~out,
+				_mm512_sub_pd(vMP, vNP), zero, _CMP_LT_OQ);
+			vClip = _mm512_mask_or_epi64(vClip, strad, vClip,
+				_mm512_set1_epi64(p));
+			alive &= ~out;
+		}
+
+		for (p = 0; p < 8; ++p)
+			intersect[nbox+p] = (alive >> p) & 1;
+		if (clipMask)
+			_mm_storeu_si128((__m128i *) (clipMask + nbox),
+				_mm512_cvtepi64_epi16(vClip));
+	}
+
+#elif defined(__AVX2__)
+
+	for (; nbox + 4 <= n; nbox += 4) {
+
+		__m256d		x, y, z, ax, ay, az, vNP, vMP, zero, out, strad, alive;
+		__m256i		vClip;
+		long long	lClip[4];
+		int			aliveBits;
+
+		x = _mm256_loadu_pd(cx + nbox);
+		y = _mm256_loadu_pd(cy + nbox);
+		z = _mm256_loadu_pd(cz + nbox);
+		ax = _mm256_loadu_pd(ex + nbox);
+		ay = _mm256_loadu_pd(ey + nbox);
+		az = _mm256_loadu_pd(ez + nbox);
+		zero = _mm256_setzero_pd();
+		vClip = _mm256_setzero_si256();
+		alive = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+		aliveBits = 0xF;
+
+		for (p = 0; p < 6 && aliveBits; ++p) {
+
+			vNP = _mm256_add_pd(_mm256_add_pd(
+				_mm256_mul_pd(ax, _mm256_set1_pd(absPl[p][0])),
+				_mm256_mul_pd(ay, _mm256_set1_pd(absPl[p][1]))),
+				_mm256_mul_pd(az, _mm256_set1_pd(absPl[p][2])));
+			vMP = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(
+				_mm256_mul_pd(x, _mm256_set1_pd(planes[p*4])),
+				_mm256_mul_pd(y, _mm256_set1_pd(planes[p*4+1]))),
+				_mm256_mul_pd(z, _mm256_set1_pd(planes[p*4+2]))),
+				_mm256_set1_pd(planes[p*4+3]));
+
+			out = _mm256_and_pd(alive, _mm256_cmp_pd(_mm256_add_pd(vMP, vNP),
+				zero, _CMP_LT_OQ));
+			strad = _mm256_andnot_pd(out, _mm256_and_pd(alive,
+				_mm256_cmp_pd(_mm256_sub_pd(vMP, vNP), zero, _CMP_LT_OQ)));
+			vClip = _mm256_or_si256(vClip, _mm256_and_si256(
+				_mm256_castpd_si256(strad), _mm256_set1_epi64x(p)));
+			alive = _mm256_andnot_pd(out, alive);
+			aliveBits = _mm256_movemask_pd(alive);
+		}
+
+		for (p = 0; p < 4; ++p)
+			intersect[nbox+p] = (aliveBits >> p) & 1;
+		if (clipMask) {
+			_mm256_storeu_si256((__m256i *) lClip, vClip);
+			for (p = 0; p < 4; ++p)
+				clipMask[nbox+p] = (short) lClip[p];
+		}
+	}
+
+#endif
+
+	for (; nbox < n; ++nbox) {
+
+		intx = 1;
+		clip = 0;
+
+		for (p = 0; p < 6; ++p) {
+
+			NP = ex[nbox]*absPl[p][0] + ey[nbox]*absPl[p][1] +
+				ez[nbox]*absPl[p][2];
+			MP = cx[nbox]*planes[p*4] + cy[nbox]*planes[p*4+1] +
+				cz[nbox]*planes[p*4+2] + planes[p*4+3];
+
+			if ((MP+NP) < 0.0) {
+				intx = 0;
+				break;
+			}
+
+			if ((MP-NP) < 0.0) clip |= p;
+		}
+
+		intersect[nbox] = intx;
+		if (clipMask) clipMask[nbox] = clip;
+	}
+
+}
+
+
+/*
+	Cull a batch of boxes.  Interleaved (3xN) location and extents arrays are
+	split into structure-of-arrays blocks on the fly, Nx3 arrays (soa != 0)
+	are passed straight to the kernel.  Large batches are spread across
+	threads one block at a time.
+*/
+static void cull_frustum_batch(IDL_MEMINT n, const double *location,
+	const double *extents, int soa, const double *planes, short *intersect,
+	short *clipMask)
+{
+
+	int			nblk, nblocks;
+
+	nblocks = (int) ((n + CULL_BLOCK - 1) / CULL_BLOCK);
+
+#ifdef _OPENMP
+	#pragma omp parallel for schedule(static) if (n >= CULL_MT_MIN)
+#endif
+	for (nblk = 0; nblk < nblocks; ++nblk) {
+
+		IDL_MEMINT		i, first, count;
+		double			buf[6][CULL_BLOCK];
+
+		first = (IDL_MEMINT) nblk * CULL_BLOCK;
+		count = (n - first < CULL_BLOCK) ? n - first : CULL_BLOCK;
+
+		if (soa) {
+			cull_frustum_soa(count, location + first, location + n + first,
+				location + 2*n + first, extents + first, extents + n + first,
+				extents + 2*n + first, planes, intersect + first,
+				(clipMask) ? clipMask + first : NULL);
+		} else {
+			for (i = 0; i < count; ++i) {
+				buf[0][i] = location[(first+i)*3];
+				buf[1][i] = location[(first+i)*3+1];
+				buf[2][i] = location[(first+i)*3+2];
+				buf[3][i] = extents[(first+i)*3];
+				buf[4][i] = extents[(first+i)*3+1];
+				buf[5][i] = extents[(first+i)*3+2];
+			}
+			cull_frustum_soa(count, buf[0], buf[1], buf[2], buf[3], buf[4],
+				buf[5], planes, intersect + first,
+				(clipMask) ? clipMask + first : NULL);
+		}
+	}
+
+}
+
+
 /*  RHTgrCamera_AABBIntersectFrustum */
 IDL_VPTR IDL_CDECL RHTgrCamera_AABBIntersectFrustum(int argc, IDL_VPTR *argv, char *argk)
 {
@@ -321,20 +807,23 @@ IDL_VPTR IDL_CDECL RHTgrCamera_AABBIntersectFrustum(int argc, IDL_VPTR *argv, ch
     /*
 
 		inview = RHTgrCamera_AABBIntersectFrustum(location, extents, frustPlanes, $
-				     CLIPMASK=clip)
+				     CLIPMASK=clip, /SOA)
+
+		location and extents are 3xN arrays, or Nx3 arrays if SOA is set.
 
     */
 
-	short			p, intx;
-	short			*intersect, *clipMask;
-	IDL_LONG		nbox, nbdx, pldx, size[] = {1};
+	short			p;
+	short			*intersect, *clipMask = NULL;
+	IDL_MEMINT		nbox, size[] = {1};
 	double			*location, *extents, *planes;
-	double			NP, MP, loc[3], ext[3];
 	IDL_VPTR		oIntersect, outargv[3];
+	static IDL_LONG soa;
 	static IDL_VPTR oClipMask, oTemp;
 
 	static IDL_KW_PAR keywords[]={
 		{"CLIPMASK", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oClipMask)},
+		{"SOA", IDL_TYP_LONG, 1, IDL_KW_ZERO, 0, IDL_CHARA(soa)},
 		{NULL}
 	};
 
@@ -349,7 +838,8 @@ IDL_VPTR IDL_CDECL RHTgrCamera_AABBIntersectFrustum(int argc, IDL_VPTR *argv, ch
 	location = (double *) outargv[0]->value.arr->data;
 	extents = (double *) outargv[1]->value.arr->data;
 	planes = (double *) outargv[2]->value.arr->data;
-	size[0] = outargv[0]->value.arr->dim[1];
+	nbox = outargv[0]->value.arr->n_elts / 3;
+	size[0] = nbox;
 
 	intersect = (short *) IDL_MakeTempArray((int)IDL_TYP_INT, 1, 
 		size, IDL_ARR_INI_NOP, &oIntersect);
@@ -358,61 +848,2212 @@ IDL_VPTR IDL_CDECL RHTgrCamera_AABBIntersectFrustum(int argc, IDL_VPTR *argv, ch
 			IDL_ARR_INI_ZERO, &oTemp);
 	}
 
-	/*
+	cull_frustum_batch(nbox, location, extents, soa, planes, intersect,
+		clipMask);
 
-		Test frustum / AABB intersection.
+	if (oClipMask) IDL_VarCopy(oTemp, oClipMask);
 
-	    Adapted from code posted to the GDAlgorithms list by Ville Miettinen
-	    and deconstruction by Per Vognsen in Bruce Mitchener's "scratch area":
-	    http://agora.cubik.org/wiki/view/Scratch/WebHome
+	return oIntersect;
 
-	*/
+}
 
-	for (nbox = 0; nbox < size[0]; ++nbox) {
 
-		nbdx = nbox * 3;
-		intx = 1;
+/*
+	Bounding volume hierarchy.
 
-		for (p = 0; p < 6; ++p) {
+	The BVH is held by IDL as a single 8 x (1 + nNodes + nObjects) double
+	array so that it can be stored, saved and passed back in without any
+	pointers.  Every row is a BVHNODE (a box plus two links, 64 bytes).
 
-			pldx = p * 4;
-			NP = extents[nbdx]*fabs(planes[pldx]) + extents[nbdx+1]*fabs(planes[pldx+1]) +
-				extents[nbdx+2]*fabs(planes[pldx+2]);
-			MP = location[nbdx]*planes[pldx] + location[nbdx+1]*planes[pldx+1] +
-				location[nbdx+2]*planes[pldx+2] + planes[pldx+3];
+	Row 0					header: c = {nNodes, nObjects, maxDepth},
+							e = {leafSize, stale, 0}
+	Rows 1 .. nNodes		tree nodes in depth first order.  The left child
+							of node i is i+1.
+	Remaining rows			object boxes in leaf order.
 
-			if ((MP+NP) < 0.0) {
-				intersect[nbox] = 0;
-				intx = 0;
-				p = 6;
-				continue;
+	Interior node:	link = row of right child, count = objects below node
+	Leaf node:		link = row of first object, count = objects in leaf
+	Object row k:	link = object index, count = row holding object k
+
+	Leaves are recognised by link pointing past the last tree node.  The
+	count of the k-th object row maps object k back to its row so that
+	RHTgrCamera_BVHRefit can update a few objects without a search.
+
+	The array can be edited in IDL so every link is range checked before
+	it is followed, and an inconsistent BVH is reported as invalid.
+
+	stale is set by RHTgrCamera_BVHRefit when so many objects moved that
+	refitting the nodes would cost more than testing every object.  The
+	node boxes of a stale BVH are out of date and RHTgrCamera_BVHCull
+	tests the object rows one by one until a later refit clears it.
+*/
+typedef struct {
+	double		c[3], e[3];
+	double		link, count;
+} BVHNODE;
+
+#define BVH_NCOLS		8
+#define BVH_BINS		16
+#define BVH_LEAFSIZE	4
+#define BVH_REFIT_MAX	0.25
+
+
+/*  Surface area heuristic cost of a [min,max] box (half area). */
+static double bvh_area(const double *bmin, const double *bmax)
+{
+	double		dx, dy, dz;
+
+	dx = bmax[0] - bmin[0];
+	dy = bmax[1] - bmin[1];
+	dz = bmax[2] - bmin[2];
+
+	return dx*dy + dy*dz + dz*dx;
+}
+
+
+/*  Set node box from a [min,max] range. */
+static void bvh_setbox(BVHNODE *node, const double *bmin, const double *bmax)
+{
+	short		k;
+
+	for (k = 0; k < 3; ++k) {
+		node->e[k] = (bmax[k] - bmin[k]) * 0.5;
+		node->c[k] = bmin[k] + node->e[k];
+	}
+}
+
+
+/*  Grow a [min,max] range by a node box. */
+static void bvh_grow(double *bmin, double *bmax, const BVHNODE *node)
+{
+	short		k;
+
+	for (k = 0; k < 3; ++k) {
+		if (node->c[k] - node->e[k] < bmin[k]) bmin[k] = node->c[k] - node->e[k];
+		if (node->c[k] + node->e[k] > bmax[k]) bmax[k] = node->c[k] + node->e[k];
+	}
+}
+
+
+/*  Partition idx[0..n) about the median centroid along axis. */
+static void bvh_select(IDL_MEMINT *idx, IDL_MEMINT n, IDL_MEMINT mid,
+	const BVHNODE *obj, short axis)
+{
+	IDL_MEMINT	lo = 0, hi = n - 1, i, j, t;
+	double		pivot;
+
+	while (lo < hi) {
+		pivot = obj[idx[(lo + hi) / 2]].c[axis];
+		i = lo;
+		j = hi;
+		while (i <= j) {
+			while (obj[idx[i]].c[axis] < pivot) ++i;
+			while (obj[idx[j]].c[axis] > pivot) --j;
+			if (i <= j) {
+				t = idx[i]; idx[i] = idx[j]; idx[j] = t;
+				++i;
+				--j;
 			}
-			
-			if ((oClipMask) && ((MP-NP) < 0.0)) clipMask[nbox] |= p;
+		}
+		if (mid <= j) hi = j;
+		else if (mid >= i) lo = i;
+		else break;
+	}
+}
+
+
+/*  SAH bin of a centroid coordinate.  A NaN goes in the first bin. */
+static short bvh_bin(double c, double cmin, double scale)
+{
+	double		f = (c - cmin) * scale;
+
+	if (!(f >= 0.0)) return 0;
+	return (f >= BVH_BINS) ? BVH_BINS - 1 : (short) f;
+}
+
+
+/*
+	Find a binned SAH split of idx[0..n).  Returns the number of objects
+	placed on the left (idx is partitioned) or 0 if no useful split exists.
+*/
+static IDL_MEMINT bvh_split_sah(IDL_MEMINT *idx, IDL_MEMINT n,
+	const BVHNODE *obj, const double *cmin, const double *cmax)
+{
+	short		axis, b, bestAxis = -1, bestBin = 0;
+	IDL_MEMINT	i, j, cnt[BVH_BINS], nl;
+	double		bmin[BVH_BINS][3], bmax[BVH_BINS][3];
+	double		lmin[3], lmax[3], rmin[3], rmax[3];
+	double		larea[BVH_BINS], scale, cost, bestCost = HUGE_VAL;
+	IDL_MEMINT	lcnt[BVH_BINS];
+
+	for (axis = 0; axis < 3; ++axis) {
+
+		if (cmax[axis] <= cmin[axis]) continue;
+		scale = BVH_BINS / (cmax[axis] - cmin[axis]);
+
+		for (b = 0; b < BVH_BINS; ++b) {
+			cnt[b] = 0;
+			bmin[b][0] = bmin[b][1] = bmin[b][2] = HUGE_VAL;
+			bmax[b][0] = bmax[b][1] = bmax[b][2] = -HUGE_VAL;
+		}
+
+		for (i = 0; i < n; ++i) {
+			b = bvh_bin(obj[idx[i]].c[axis], cmin[axis], scale);
+			++cnt[b];
+			bvh_grow(bmin[b], bmax[b], obj + idx[i]);
 		}
 
-		if (intx) intersect[nbox] = 1;
+		/*  Sweep left to right then right to left. */
+		lmin[0] = lmin[1] = lmin[2] = HUGE_VAL;
+		lmax[0] = lmax[1] = lmax[2] = -HUGE_VAL;
+		for (b = 0, j = 0; b < BVH_BINS - 1; ++b) {
+			j += cnt[b];
+			for (i = 0; i < 3; ++i) {
+				if (bmin[b][i] < lmin[i]) lmin[i] = bmin[b][i];
+				if (bmax[b][i] > lmax[i]) lmax[i] = bmax[b][i];
+			}
+			lcnt[b] = j;
+			larea[b] = (j > 0) ? bvh_area(lmin, lmax) : 0.0;
+		}
 
+		rmin[0] = rmin[1] = rmin[2] = HUGE_VAL;
+		rmax[0] = rmax[1] = rmax[2] = -HUGE_VAL;
+		for (b = BVH_BINS - 1, j = 0; b > 0; --b) {
+			j += cnt[b];
+			for (i = 0; i < 3; ++i) {
+				if (bmin[b][i] < rmin[i]) rmin[i] = bmin[b][i];
+				if (bmax[b][i] > rmax[i]) rmax[i] = bmax[b][i];
+			}
+			if (lcnt[b-1] == 0 || j == 0) continue;
+			cost = lcnt[b-1] * larea[b-1] + j * bvh_area(rmin, rmax);
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b;
+			}
+		}
 	}
 
-	if (oClipMask) IDL_VarCopy(oTemp, oClipMask);
+	if (bestAxis < 0) return 0;
 
-	return oIntersect;
+	/*  Partition about the chosen bin boundary. */
+	scale = BVH_BINS / (cmax[bestAxis] - cmin[bestAxis]);
+	for (i = 0, nl = 0; i < n; ++i) {
+		b = bvh_bin(obj[idx[i]].c[bestAxis], cmin[bestAxis], scale);
+		if (b < bestBin) {
+			j = idx[i]; idx[i] = idx[nl]; idx[nl] = j;
+			++nl;
+		}
+	}
 
+	return (nl > 0 && nl < n) ? nl : 0;
 }
 
 
-int IDL_Load(void)
+/*
+	Build a BVH over n boxes.  On success *out holds the full BVH array
+	(header, nodes and objects) and the number of rows is returned.  Returns
+	0 if memory could not be allocated.
+*/
+static IDL_MEMINT bvh_build(IDL_MEMINT n, const double *location,
+	const double *extents, IDL_MEMINT leafSize, int median, BVHNODE **out)
 {
 
-	static IDL_SYSFUN_DEF2 function_addr[] = {
-		{(IDL_SYSRTN_GENERIC) RHTgrCamera_AABBIntersectFrustum, "RHTGRCAMERA_AABBINTERSECTFRUSTUM", 3, 3, 
-			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
-		{(IDL_SYSRTN_GENERIC) RHTgrCamera_ComputeFrustum, "RHTGRCAMERA_COMPUTEFRUSTUM", 3, 3, 
-			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
-		{(IDL_SYSRTN_GENERIC) RHTgrCamera_Transform, "RHTGRCAMERA_TRANSFORM", 3, 3, 0, 0},
-		{(IDL_SYSRTN_GENERIC) RHTgrCamera_VertT3D, "RHTGRCAMERA_VERTT3D", 2, 2, 0, 0},
+	typedef struct {
+		IDL_MEMINT	first, count, parent, depth;
+		int			right;
+	} BVHTASK;
+
+	short		k, axis;
+	IDL_MEMINT	i, nNodes = 0, maxDepth = 0, nl, nRows, nTasks = 0;
+	IDL_MEMINT	*idx;
+	double		bmin[3], bmax[3], cmin[3], cmax[3];
+	BVHNODE		*obj, *tree, *bvh, *node;
+	BVHTASK		*stack, task;
+
+	*out = NULL;
+	obj = (BVHNODE *) malloc(n * sizeof(BVHNODE));
+	tree = (BVHNODE *) malloc(2 * n * sizeof(BVHNODE));
+	idx = (IDL_MEMINT *) malloc(n * sizeof(IDL_MEMINT));
+	stack = (BVHTASK *) malloc((n + 1) * sizeof(BVHTASK));
+	if (!obj || !tree || !idx || !stack) {
+		free(obj); free(tree); free(idx); free(stack);
+		return 0;
+	}
+
+	for (i = 0; i < n; ++i) {
+		for (k = 0; k < 3; ++k) {
+			obj[i].c[k] = location[i*3+k];
+			obj[i].e[k] = fabs(extents[i*3+k]);
+		}
+		obj[i].link = (double) i;
+		obj[i].count = 1.0;
+		idx[i] = i;
+	}
+
+	/*
+		Depth first build using an explicit stack.  The right task is pushed
+		before the left so the left child is always the next node created.
+	*/
+	task.first = 0;
+	task.count = n;
+	task.parent = -1;
+	task.depth = 0;
+	task.right = 0;
+	stack[nTasks++] = task;
+
+	while (nTasks > 0) {
+
+		task = stack[--nTasks];
+		node = tree + nNodes;
+
+		/*  Right children are linked from their parent. */
+		if (task.right) tree[task.parent].link = (double) nNodes;
+		++nNodes;
+		if (task.depth > maxDepth) maxDepth = task.depth;
+
+		bmin[0] = bmin[1] = bmin[2] = HUGE_VAL;
+		bmax[0] = bmax[1] = bmax[2] = -HUGE_VAL;
+		cmin[0] = cmin[1] = cmin[2] = HUGE_VAL;
+		cmax[0] = cmax[1] = cmax[2] = -HUGE_VAL;
+		for (i = task.first; i < task.first + task.count; ++i) {
+			bvh_grow(bmin, bmax, obj + idx[i]);
+			for (k = 0; k < 3; ++k) {
+				if (obj[idx[i]].c[k] < cmin[k]) cmin[k] = obj[idx[i]].c[k];
+				if (obj[idx[i]].c[k] > cmax[k]) cmax[k] = obj[idx[i]].c[k];
+			}
+		}
+		bvh_setbox(node, bmin, bmax);
+		node->count = (double) task.count;
+
+		if (task.count <= leafSize) {
+			/*  Leaf - link to the first object, fixed up below. */
+			node->link = (double) -(task.first + 1);
+			continue;
+		}
+
+		nl = (median) ? 0 : bvh_split_sah(idx + task.first, task.count,
+			obj, cmin, cmax);
+
+		if (nl == 0) {
+			/*  Median split along the longest centroid axis. */
+			axis = 0;
+			for (k = 1; k < 3; ++k)
+				if (cmax[k] - cmin[k] > cmax[axis] - cmin[axis]) axis = k;
+			nl = task.count / 2;
+			bvh_select(idx + task.first, task.count, nl, obj, axis);
+		}
+
+		stack[nTasks].first = task.first + nl;
+		stack[nTasks].count = task.count - nl;
+		stack[nTasks].parent = nNodes - 1;
+		stack[nTasks].depth = task.depth + 1;
+		stack[nTasks++].right = 1;
+
+		stack[nTasks].first = task.first;
+		stack[nTasks].count = nl;
+		stack[nTasks].parent = nNodes - 1;
+		stack[nTasks].depth = task.depth + 1;
+		stack[nTasks++].right = 0;
+	}
+
+	nRows = 1 + nNodes + n;
+	bvh = (BVHNODE *) malloc(nRows * sizeof(BVHNODE));
+	if (bvh) {
+		memset(bvh, 0, sizeof(BVHNODE));
+		bvh[0].c[0] = (double) nNodes;
+		bvh[0].c[1] = (double) n;
+		bvh[0].c[2] = (double) maxDepth;
+		bvh[0].e[0] = (double) leafSize;
+
+		/*  Offset node links by the header row, point leaves at objects. */
+		for (i = 0; i < nNodes; ++i) {
+			bvh[i+1] = tree[i];
+			if (tree[i].link < 0.0)
+				bvh[i+1].link = (double) (1 + nNodes) - tree[i].link - 1.0;
+			else
+				bvh[i+1].link = tree[i].link + 1.0;
+		}
+		for (i = 0; i < n; ++i)
+			bvh[1+nNodes+i] = obj[idx[i]];
+		for (i = 0; i < n; ++i)
+			bvh[1+nNodes+idx[i]].count = (double) (1 + nNodes + i);
+	}
+
+	free(obj); free(tree); free(idx); free(stack);
+
+	*out = bvh;
+	return (bvh) ? nRows : 0;
+}
+
+
+/*
+	Check the links of node i of a BVH with nRows rows.  A leaf must point
+	at a run of object rows and an interior node at a right child after
+	its left child (i+1).  Returns 0 if a link is out of range.
+*/
+static int bvh_node_ok(const BVHNODE *bvh, IDL_MEMINT i, IDL_MEMINT nNodes,
+	IDL_MEMINT nRows)
+{
+	IDL_MEMINT	link = (IDL_MEMINT) bvh[i].link;
+	IDL_MEMINT	count = (IDL_MEMINT) bvh[i].count;
+
+	if (bvh[i].link > nNodes)
+		return link > nNodes && count >= 1 && count <= nRows - link;
+
+	return link > i + 1 && link <= nNodes;
+}
+
+
+/*
+	Refit node boxes bottom up after the object rows have changed.  If
+	dirty is not NULL it holds one byte per BVH row, set for the object
+	rows that moved, and only the nodes above them are refit.  Children
+	always follow their parent so a single backwards pass reaches every
+	node after its children.  Returns 0 if the BVH is invalid.
+*/
+static int bvh_refit(BVHNODE *bvh, IDL_MEMINT nRows, UCHAR *dirty)
+{
+	IDL_MEMINT	i, k, nNodes, first, last;
+	double		bmin[3], bmax[3];
+	BVHNODE		*node;
+
+	nNodes = (IDL_MEMINT) bvh[0].c[0];
+
+	for (i = nNodes; i > 0; --i) {
+
+		node = bvh + i;
+		if (!bvh_node_ok(bvh, i, nNodes, nRows)) return 0;
+
+		if (node->link > nNodes) {
+			first = (IDL_MEMINT) node->link;
+			last = first + (IDL_MEMINT) node->count;
+			if (dirty) {
+				for (k = first; k < last && !dirty[k]; ++k);
+				if (k == last) continue;
+			}
+		} else if (dirty && !dirty[i+1] && !dirty[(IDL_MEMINT) node->link])
+			continue;
+
+		bmin[0] = bmin[1] = bmin[2] = HUGE_VAL;
+		bmax[0] = bmax[1] = bmax[2] = -HUGE_VAL;
+
+		if (node->link > nNodes) {
+			for (k = first; k < last; ++k)
+				bvh_grow(bmin, bmax, bvh + k);
+		} else {
+			bvh_grow(bmin, bmax, bvh + i + 1);
+			bvh_grow(bmin, bmax, bvh + (IDL_MEMINT) node->link);
+		}
+
+		bvh_setbox(node, bmin, bmax);
+		if (dirty) dirty[i] = 1;
+	}
+
+	return 1;
+}
+
+
+/*  qsort order of BVH rows. */
+static int bvh_cmp_rows(const void *a, const void *b)
+{
+	IDL_MEMINT	ra = *(const IDL_MEMINT *) a, rb = *(const IDL_MEMINT *) b;
+
+	return (ra > rb) - (ra < rb);
+}
+
+
+/*
+	Refit only the nodes above the object rows rows[0..nMoved), which must
+	be sorted.  The tree is descended from the root into the subtrees
+	whose run of object rows holds a moved row, and each node on the way
+	is refit after its children, so the cost grows with the number of
+	moved objects times the depth rather than with the size of the tree.
+	Returns 0 if the BVH is invalid or memory could not be allocated.
+*/
+static int bvh_refit_rows(BVHNODE *bvh, IDL_MEMINT nRows,
+	const IDL_MEMINT *rows, IDL_MEMINT nMoved)
+{
+
+	typedef struct {
+		IDL_MEMINT	node, first, lo, hi;
+		int			done;
+	} BVHREFIT;
+
+	int			valid = 1;
+	IDL_MEMINT	i, k, nNodes, maxStack, nStack = 0, count, right, nl, lo, hi;
+	double		bmin[3], bmax[3];
+	BVHNODE		*node;
+	BVHREFIT	*stack, task;
+
+	if (nMoved < 1) return 1;
+
+	nNodes = (IDL_MEMINT) bvh[0].c[0];
+
+	/*  Each level leaves the node itself and its right child pending. */
+	if (!(bvh[0].c[2] >= 0.0 && bvh[0].c[2] < (double) nNodes)) return 0;
+	maxStack = 2 * (IDL_MEMINT) bvh[0].c[2] + 3;
+	stack = (BVHREFIT *) malloc(maxStack * sizeof(BVHREFIT));
+	if (!stack) return 0;
+
+	task.node = 1;
+	task.first = 1 + nNodes;
+	task.lo = 0;
+	task.hi = nMoved;
+	task.done = 0;
+	stack[nStack++] = task;
+
+	while (nStack > 0) {
+
+		task = stack[--nStack];
+		i = task.node;
+		node = bvh + i;
+
+		bmin[0] = bmin[1] = bmin[2] = HUGE_VAL;
+		bmax[0] = bmax[1] = bmax[2] = -HUGE_VAL;
+
+		if (task.done) {
+			bvh_grow(bmin, bmax, bvh + i + 1);
+			bvh_grow(bmin, bmax, bvh + (IDL_MEMINT) node->link);
+			bvh_setbox(node, bmin, bmax);
+			continue;
+		}
+
+		/*  A leaf must hold the run of objects its place in the tree
+			implies. */
+		if (!bvh_node_ok(bvh, i, nNodes, nRows)) {
+			valid = 0;
+			break;
+		}
+		count = (IDL_MEMINT) node->count;
+
+		if (node->link > nNodes) {
+			if ((IDL_MEMINT) node->link != task.first) {
+				valid = 0;
+				break;
+			}
+			for (k = task.first; k < task.first + count; ++k)
+				bvh_grow(bmin, bmax, bvh + k);
+			bvh_setbox(node, bmin, bmax);
+			continue;
+		}
+
+		/*  Split the moved rows between the children. */
+		right = (IDL_MEMINT) node->link;
+		nl = (IDL_MEMINT) bvh[i+1].count;
+		if (nl < 1 || nl >= count || nStack + 3 > maxStack) {
+			valid = 0;
+			break;
+		}
+		lo = task.lo;
+		hi = task.hi;
+		while (lo < hi) {
+			k = lo + (hi - lo) / 2;
+			if (rows[k] < task.first + nl) lo = k + 1;
+			else hi = k;
+		}
+
+		task.done = 1;
+		stack[nStack++] = task;
+		if (lo < task.hi) {
+			stack[nStack].node = right;
+			stack[nStack].first = task.first + nl;
+			stack[nStack].lo = lo;
+			stack[nStack].hi = task.hi;
+			stack[nStack++].done = 0;
+		}
+		if (task.lo < lo) {
+			stack[nStack].node = i + 1;
+			stack[nStack].first = task.first;
+			stack[nStack].lo = task.lo;
+			stack[nStack].hi = lo;
+			stack[nStack++].done = 0;
+		}
+	}
+
+	free(stack);
+
+	return valid;
+}
+
+
+/*
+	Culling statistics.  Every box tested could take six plane tests, the
+	tests that were not made are counted as saved, either because the plane
+	was already known to contain the box (its parent was inside the plane)
+	or because the box was rejected early.  cacheHits counts boxes rejected
+	by the plane that rejected them on the previous frame.
+*/
+typedef struct {
+	IDL_LONG64	boxes, tests, savedMask, savedEarly, cacheHits;
+} BVHSTATS;
+
+#define BVH_NSTATS		5
+#define BVH_ALLPLANES	0x3F
+
+
+/*  Test a box against plane p.  Returns 0 outside, 1 straddling, 2 inside. */
+static int bvh_plane(const BVHNODE *box, const double *planes,
+	const double absPl[6][3], short p)
+{
+	double		NP, MP;
+
+	NP = box->e[0]*absPl[p][0] + box->e[1]*absPl[p][1] +
+		box->e[2]*absPl[p][2];
+	MP = box->c[0]*planes[p*4] + box->c[1]*planes[p*4+1] +
+		box->c[2]*planes[p*4+2] + planes[p*4+3];
+
+	if ((MP+NP) < 0.0) return 0;
+	if ((MP-NP) < 0.0) return 1;
+	return 2;
+}
+
+
+/*
+	Test a box against the planes in the active mask (bit p set for plane
+	p).  Returns -1 if the box is outside, otherwise a mask of the planes
+	the box straddles (0 means the box is entirely inside).  If last is not
+	NULL it holds the plane (+1) that rejected this box on the previous
+	call, which is tested first, and is updated with the rejecting plane.
+*/
+static int bvh_test(const BVHNODE *box, const double *planes,
+	const double absPl[6][3], int active, UCHAR *last, BVHSTATS *stats)
+{
+	short		p, first = -1;
+	int			nActive = 0, nTests = 0, straddle = 0, result;
+
+	for (p = 0; p < 6; ++p)
+		if (active & (1 << p)) ++nActive;
+
+	++stats->boxes;
+	stats->savedMask += 6 - nActive;
+
+	if (last && *last && (active & (1 << (*last - 1)))) {
+		first = *last - 1;
+		++nTests;
+		result = bvh_plane(box, planes, absPl, first);
+		if (result == 0) {
+			++stats->cacheHits;
+			stats->tests += nTests;
+			stats->savedEarly += nActive - nTests;
+			return -1;
+		}
+		if (result == 1) straddle |= 1 << first;
+	}
+
+	for (p = 0; p < 6; ++p) {
+
+		if (!(active & (1 << p)) || p == first) continue;
+
+		++nTests;
+		result = bvh_plane(box, planes, absPl, p);
+
+		if (result == 0) {
+			if (last) *last = (UCHAR) (p + 1);
+			stats->tests += nTests;
+			stats->savedEarly += nActive - nTests;
+			return -1;
+		}
+		if (result == 1) straddle |= 1 << p;
+	}
+
+	if (last) *last = 0;
+	stats->tests += nTests;
+
+	return straddle;
+}
+
+
+/*
+	Level of detail selection.  Level l of an object with bounding radius r
+	at distance d from the eye is acceptable when errors[l] * r / d <= 1,
+	errors holding the screen space error of each level (finest first) for
+	an object of unit radius at unit distance in units of the tolerated
+	error.  The coarsest acceptable level is chosen.  The radius is taken
+	from the box half diagonal scaled by the largest column of t, which is
+	exact for rigid and uniformly scaled transforms.
+*/
+typedef struct {
+	const double	*t, *errors;
+	double			eye, scale;
+	int				nLevels;
+} BVHLOD;
+
+static UCHAR bvh_lod(const BVHNODE *obj, const BVHLOD *lod)
+{
+	int			l;
+	double		z, d, r;
+
+	z = (lod->t) ? ((lod->t[8]*obj->c[0] + lod->t[9]*obj->c[1]) +
+		lod->t[10]*obj->c[2]) + lod->t[11] : obj->c[2];
+	d = lod->eye - z;
+	r = lod->scale * sqrt(SQR(obj->e[0]) + SQR(obj->e[1]) + SQR(obj->e[2]));
+
+	/*  Objects around the eye are always drawn in full detail. */
+	if (d <= r) return 0;
+
+	for (l = lod->nLevels - 1; l > 0; --l)
+		if (lod->errors[l] * r <= d) break;
+
+	return (UCHAR) l;
+}
+
+
+/*
+	Traverse the BVH and set mask[i] to 1 for every visible object i.
+
+	Each node is only tested against the planes its parent straddles, a box
+	inside a plane is inside it for all of its children.  Nodes entirely
+	inside the frustum are accepted without visiting their children and
+	objects in leaves that straddle the frustum are tested individually.
+	cache (which may be NULL) holds one byte per BVH row and carries the
+	last rejecting plane of each node from frame to frame.  If lod is not
+	NULL levels[i] is set to the detail level of every visible object.
+	The objects of a stale BVH are tested one by one.  stack holds
+	maxStack entries.  Returns the number of visible objects, or -1 if a
+	link of the BVH is out of range.
+*/
+static IDL_MEMINT bvh_cull(const BVHNODE *bvh, IDL_MEMINT nRows,
+	const double *planes, UCHAR *mask, IDL_MEMINT *stack,
+	IDL_MEMINT maxStack, UCHAR *cache, BVHSTATS *stats, const BVHLOD *lod,
+	UCHAR *levels)
+{
+	short		p;
+	int			result, active = BVH_ALLPLANES;
+	IDL_MEMINT	i, k, o, nNodes, nObj, first, last, nStack = 0, nVisible = 0;
+	double		absPl[6][3];
+	const BVHNODE	*node;
+
+	nNodes = (IDL_MEMINT) bvh[0].c[0];
+	nObj = (IDL_MEMINT) bvh[0].c[1];
+
+	for (p = 0; p < 6; ++p) {
+		absPl[p][0] = fabs(planes[p*4]);
+		absPl[p][1] = fabs(planes[p*4+1]);
+		absPl[p][2] = fabs(planes[p*4+2]);
+	}
+
+	/*  Object rows are visited from the range checked first..last and
+		their links are checked before they index the mask. */
+	if (bvh[0].e[1] != 0.0) {
+		for (k = 1 + nNodes; k < nRows; ++k) {
+			if (bvh_test(bvh + k, planes, absPl, BVH_ALLPLANES, (cache) ?
+				cache + k : NULL, stats) >= 0) {
+				o = (IDL_MEMINT) bvh[k].link;
+				if (o < 0 || o >= nObj) return -1;
+				mask[o] = 1;
+				if (lod) levels[o] = bvh_lod(bvh + k, lod);
+				++nVisible;
+			}
+		}
+		return nVisible;
+	}
+
+	i = 1;
+	while (i > 0) {
+
+		node = bvh + i;
+		if (!bvh_node_ok(bvh, i, nNodes, nRows)) return -1;
+		result = bvh_test(node, planes, absPl, active, (cache) ? cache + i :
+			NULL, stats);
+
+		if (result == 0) {
+			/*  Inside - accept every object below this node. */
+			for (k = i; k <= nNodes && bvh[k].link <= nNodes; ++k);
+			if (k > nNodes || !bvh_node_ok(bvh, k, nNodes, nRows)) return -1;
+			first = (IDL_MEMINT) bvh[k].link;
+			last = first + (IDL_MEMINT) node->count;
+			if (last > nRows || last < first) return -1;
+			for (k = first; k < last; ++k) {
+				o = (IDL_MEMINT) bvh[k].link;
+				if (o < 0 || o >= nObj) return -1;
+				mask[o] = 1;
+				if (lod) levels[o] = bvh_lod(bvh + k, lod);
+			}
+			nVisible += last - first;
+		} else if (result > 0 && node->link > nNodes) {
+			/*  Straddling leaf - test the objects. */
+			first = (IDL_MEMINT) node->link;
+			last = first + (IDL_MEMINT) node->count;
+			for (k = first; k < last; ++k) {
+				if (bvh_test(bvh + k, planes, absPl, result, (cache) ?
+					cache + k : NULL, stats) >= 0) {
+					o = (IDL_MEMINT) bvh[k].link;
+					if (o < 0 || o >= nObj) return -1;
+					mask[o] = 1;
+					if (lod) levels[o] = bvh_lod(bvh + k, lod);
+					++nVisible;
+				}
+			}
+		} else if (result > 0) {
+			/*  Straddling interior node - descend. */
+			if (nStack + 2 > maxStack) return -1;
+			stack[nStack++] = (IDL_MEMINT) node->link;
+			stack[nStack++] = result;
+			active = result;
+			i = i + 1;
+			continue;
+		}
+
+		if (nStack > 0) {
+			active = (int) stack[--nStack];
+			i = stack[--nStack];
+		} else i = 0;
+	}
+
+	return nVisible;
+}
+
+
+/*  Move view space frustum planes into the space of a 4x4 transform. */
+static void bvh_transform_planes(const double *planes, const double *t,
+	double *out)
+{
+	short		p, i, j;
+
+	for (p = 0; p < 6; ++p) {
+		for (j = 0; j < 4; ++j) {
+			out[p*4+j] = (j == 3) ? planes[p*4+3] : 0.0;
+			for (i = 0; i < 3; ++i)
+				out[p*4+j] += planes[p*4+i] * t[i*4+j];
+		}
+	}
+}
+
+
+/*  Return a pointer to a valid BVH array or throw an IDL error. */
+static BVHNODE *bvh_get(IDL_VPTR oBVH)
+{
+	BVHNODE		*bvh;
+
+	IDL_ENSURE_ARRAY(oBVH);
+	if (oBVH->type != IDL_TYP_DOUBLE || oBVH->value.arr->n_dim != 2 ||
+		oBVH->value.arr->dim[0] != BVH_NCOLS)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"BVH must be an 8xN double array from RHTgrCamera_BVHBuild.");
+
+	bvh = (BVHNODE *) oBVH->value.arr->data;
+	if (bvh[0].c[0] < 1.0 || !(bvh[0].c[1] >= 1.0) ||
+		!(bvh[0].c[2] >= 0.0 && bvh[0].c[2] < bvh[0].c[0]) ||
+		(IDL_MEMINT) (1 + bvh[0].c[0] + bvh[0].c[1]) !=
+		oBVH->value.arr->dim[1])
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"Invalid BVH header.");
+
+	return bvh;
+}
+
+
+/*  RHTgrCamera_BVHBuild */
+IDL_VPTR IDL_CDECL RHTgrCamera_BVHBuild(int argc, IDL_VPTR *argv, char *argk)
+{
+
+    /*
+
+		bvh = RHTgrCamera_BVHBuild(location, extents, LEAF_SIZE=4, /MEDIAN)
+
+		location and extents are 3xN arrays of box centers and half widths.
+		By default nodes are split using a binned surface area heuristic, set
+		MEDIAN to split at the median along the longest axis instead.
+
+    */
+
+	short			n;
+	IDL_MEMINT		nbox, nRows, size[2];
+	BVHNODE			*bvh;
+	IDL_VPTR		oBVH, outargv[2], dargv[2];
+	static IDL_LONG	leafSize, median;
+
+	static IDL_KW_PAR keywords[]={
+		{"LEAF_SIZE", IDL_TYP_LONG, 1, IDL_KW_ZERO, 0, IDL_CHARA(leafSize)},
+		{"MEDIAN", IDL_TYP_LONG, 1, IDL_KW_ZERO, 0, IDL_CHARA(median)},
+		{NULL}
+	};
+
+	IDL_KWGetParams(argc,argv,argk, keywords,outargv,1);
+
+	for (n = 0; n < 2; ++n) {
+		IDL_ENSURE_ARRAY(outargv[n]);
+		dargv[n] = (outargv[n]->type == IDL_TYP_DOUBLE) ? outargv[n] :
+			IDL_BasicTypeConversion(1, &outargv[n], IDL_TYP_DOUBLE);
+	}
+
+	nbox = dargv[0]->value.arr->n_elts / 3;
+	if (nbox < 1 || dargv[0]->value.arr->n_elts != dargv[1]->value.arr->n_elts)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"location and extents must be matching 3xN arrays.");
+
+	nRows = bvh_build(nbox, (double *) dargv[0]->value.arr->data,
+		(double *) dargv[1]->value.arr->data,
+		(leafSize > 0) ? leafSize : BVH_LEAFSIZE, median, &bvh);
+
+	for (n = 0; n < 2; ++n)
+		if (dargv[n] != outargv[n]) IDL_Deltmp(dargv[n]);
+
+	if (nRows == 0)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"Unable to allocate memory for BVH.");
+
+	size[0] = BVH_NCOLS;
+	size[1] = nRows;
+	memcpy(IDL_MakeTempArray((int)IDL_TYP_DOUBLE, 2, size, IDL_ARR_INI_NOP,
+		&oBVH), bvh, nRows * sizeof(BVHNODE));
+	free(bvh);
+
+	return oBVH;
+
+}
+
+
+/*  RHTgrCamera_BVHCull */
+IDL_VPTR IDL_CDECL RHTgrCamera_BVHCull(int argc, IDL_VPTR *argv, char *argk)
+{
+
+    /*
+
+		visible = RHTgrCamera_BVHCull(bvh, frustPlanes, CACHE=cache, $
+				      COUNT=count, EYE=eye, LOD=lod, LOD_ERRORS=errors, $
+				      MASK=mask, STATS=stats, TRANSFORM=transform)
+
+		Returns the indices of the objects that intersect the frustum in
+		ascending order, or -1 if none do.  MASK returns a byte array with
+		1 for visible objects.  Set TRANSFORM to the 4x4 transform from the
+		space the BVH was built in to view space.
+
+		Set CACHE to a named variable to enable frame to frame coherence.
+		The variable holds the last rejecting plane of every BVH row and
+		is created on the first call and updated on the following ones.
+		STATS returns a 5 element LONG64 array [boxes tested, plane tests,
+		tests saved by plane masking, tests saved by early rejection,
+		boxes rejected by the cached plane].
+
+		Set LOD_ERRORS to a vector of the screen space error of each
+		level of detail, finest first, for an object of unit radius at
+		unit distance from the eye, scaled so the tolerated error is 1.
+		LOD then returns a byte array with the coarsest acceptable level
+		of every visible object (0 for culled objects).  EYE is the view
+		space z of the eye (RHTgrCamera's eye[2]).
+
+    */
+
+	short			n;
+	IDL_MEMINT		i, nObj, nRows, nVisible, *stack, maxStack, size[] = {1};
+	IDL_LONG		*visible;
+	IDL_LONG64		*pStats;
+	UCHAR			*mask, *cache = NULL, *levels = NULL;
+	double			*planes, tPlanes[24], colNorm;
+	BVHNODE			*bvh;
+	BVHSTATS		stats = {0, 0, 0, 0, 0};
+	BVHLOD			lod;
+	IDL_VPTR		oVisible, oMask, oNewCache = NULL, oStatsOut, outargv[2];
+	IDL_VPTR		oLevels = NULL, oErrors = NULL;
+	static double	eye;
+	static IDL_VPTR oCache, oCount, oLod, oLodErrors, oMaskOut, oStats, oTransform;
+
+	static IDL_KW_PAR keywords[]={
+		{"CACHE", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oCache)},
+		{"COUNT", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oCount)},
+		{"EYE", IDL_TYP_DOUBLE, 1, IDL_KW_ZERO, 0, IDL_CHARA(eye)},
+		{"LOD", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oLod)},
+		{"LOD_ERRORS", IDL_TYP_UNDEF, 1, IDL_KW_VIN|IDL_KW_ZERO,0,IDL_CHARA(oLodErrors)},
+		{"MASK", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oMaskOut)},
+		{"STATS", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oStats)},
+		{"TRANSFORM", IDL_TYP_UNDEF, 1, IDL_KW_VIN|IDL_KW_ZERO,0,IDL_CHARA(oTransform)},
+		{NULL}
+	};
+
+	IDL_KWGetParams(argc,argv,argk, keywords,outargv,1);
+
+	bvh = bvh_get(outargv[0]);
+	IDL_ENSURE_ARRAY(outargv[1]);
+	planes = (double *) outargv[1]->value.arr->data;
+
+	if (oTransform) {
+		IDL_ENSURE_ARRAY(oTransform);
+		if (oTransform->type != IDL_TYP_DOUBLE ||
+			oTransform->value.arr->n_elts != 16)
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"TRANSFORM must be a 4x4 double array.");
+		bvh_transform_planes(planes, (double *) oTransform->value.arr->data,
+			tPlanes);
+		planes = tPlanes;
+	}
+
+	nObj = (IDL_MEMINT) bvh[0].c[1];
+	nRows = outargv[0]->value.arr->dim[1];
+
+	if (oLod) {
+		if (!oLodErrors)
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"LOD requires LOD_ERRORS.");
+		IDL_ENSURE_ARRAY(oLodErrors);
+		if (oLodErrors->value.arr->n_elts > 255)
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"LOD_ERRORS can not hold more than 255 levels.");
+		oErrors = (oLodErrors->type == IDL_TYP_DOUBLE) ? oLodErrors :
+			IDL_BasicTypeConversion(1, &oLodErrors, IDL_TYP_DOUBLE);
+		lod.errors = (double *) oErrors->value.arr->data;
+		lod.nLevels = (int) oErrors->value.arr->n_elts;
+		lod.eye = eye;
+		lod.t = (oTransform) ? (double *) oTransform->value.arr->data : NULL;
+		lod.scale = 1.0;
+		for (n = 0; lod.t && n < 3; ++n) {
+			colNorm = sqrt(SQR(lod.t[n]) + SQR(lod.t[4+n]) + SQR(lod.t[8+n]));
+			if (n == 0 || colNorm > lod.scale) lod.scale = colNorm;
+		}
+		size[0] = nObj;
+		levels = (UCHAR *) IDL_MakeTempArray((int)IDL_TYP_BYTE, 1, size,
+			IDL_ARR_INI_ZERO, &oLevels);
+	}
+
+	/*  Use the caller's cache in place if it matches this BVH. */
+	if (oCache) {
+		if ((oCache->flags & IDL_V_ARR) && oCache->type == IDL_TYP_BYTE &&
+			oCache->value.arr->n_elts == nRows)
+			cache = (UCHAR *) oCache->value.arr->data;
+		else {
+			size[0] = nRows;
+			cache = (UCHAR *) IDL_MakeTempArray((int)IDL_TYP_BYTE, 1, size,
+				IDL_ARR_INI_ZERO, &oNewCache);
+		}
+	}
+
+	size[0] = nObj;
+	mask = (UCHAR *) IDL_MakeTempArray((int)IDL_TYP_BYTE, 1, size,
+		IDL_ARR_INI_ZERO, &oMask);
+
+	maxStack = 2 * ((IDL_MEMINT) bvh[0].c[2] + 2);
+	stack = (IDL_MEMINT *) malloc(maxStack * sizeof(IDL_MEMINT));
+	nVisible = (stack) ? bvh_cull(bvh, nRows, planes, mask, stack, maxStack,
+		cache, &stats, (oLod) ? &lod : NULL, levels) : -2;
+	free(stack);
+	if (oErrors && oErrors != oLodErrors) IDL_Deltmp(oErrors);
+
+	if (nVisible < 0) {
+		IDL_Deltmp(oMask);
+		if (oNewCache) IDL_Deltmp(oNewCache);
+		if (oLevels) IDL_Deltmp(oLevels);
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP, (nVisible == -1) ?
+			"Invalid BVH: a node or object link is out of range." :
+			"Unable to allocate memory for BVH traversal.");
+	}
+
+	if (nVisible > 0) {
+		size[0] = nVisible;
+		visible = (IDL_LONG *) IDL_MakeTempArray((int)IDL_TYP_LONG, 1, size,
+			IDL_ARR_INI_NOP, &oVisible);
+		for (i = 0, nVisible = 0; i < nObj; ++i)
+			if (mask[i]) visible[nVisible++] = (IDL_LONG) i;
+	} else oVisible = IDL_GettmpLong(-1);
+
+	if (oCount) IDL_VarCopy(IDL_GettmpLong((IDL_LONG) nVisible), oCount);
+	if (oMaskOut) IDL_VarCopy(oMask, oMaskOut);
+	else IDL_Deltmp(oMask);
+	if (oNewCache) IDL_VarCopy(oNewCache, oCache);
+	if (oLevels) IDL_VarCopy(oLevels, oLod);
+	if (oStats) {
+		size[0] = BVH_NSTATS;
+		pStats = (IDL_LONG64 *) IDL_MakeTempArray((int)IDL_TYP_LONG64, 1,
+			size, IDL_ARR_INI_NOP, &oStatsOut);
+		pStats[0] = stats.boxes;
+		pStats[1] = stats.tests;
+		pStats[2] = stats.savedMask;
+		pStats[3] = stats.savedEarly;
+		pStats[4] = stats.cacheHits;
+		IDL_VarCopy(oStatsOut, oStats);
+	}
+
+	return oVisible;
+
+}
+
+
+/*  RHTgrCamera_BVHRefit */
+void IDL_CDECL RHTgrCamera_BVHRefit(int argc, IDL_VPTR *argv, char *argk)
+{
+
+    /*
+
+		RHTgrCamera_BVHRefit, bvh, location, extents, INDICES=indices, $
+			MOVED=moved
+
+		Update the object boxes of an existing BVH in place and refit the
+		node bounds.  location and extents are 3xN arrays in the original
+		object order.
+
+		Set INDICES to the objects that moved.  Only their rows are read
+		and only the nodes above them are visited, so the cost grows with
+		the number of moved objects rather than with N.  Without INDICES
+		every box is compared with its row to find the moved objects,
+		which costs about as much as testing every box against the
+		frustum, so pass INDICES whenever the caller knows them.
+
+		If more than a quarter of the objects moved the nodes are not
+		refit: the BVH is marked stale and RHTgrCamera_BVHCull tests every
+		object directly, which is cheaper than a refit followed by a
+		traversal.  A later refit with few moved objects refits every node
+		and clears it.  When most objects move every frame test their
+		boxes directly with RHTgrCamera_AABBIntersectFrustum, as
+		RHTgrCamera does for its dynamic models.  MOVED returns the number
+		of objects whose boxes were updated.  The tree topology is kept so the tree should be
+		rebuilt if objects move far from their original neighbours.
+
+    */
+
+	short			n, k;
+	int				changed, valid = 1;
+	IDL_MEMINT		i, o, r, nNodes, nObj, nRows, nMoved = 0, *rows = NULL;
+	IDL_MEMINT		*indices = NULL;
+	double			*location, *extents, e;
+	UCHAR			*dirty = NULL;
+	BVHNODE			*bvh, *obj;
+	IDL_VPTR		dargv[2], outargv[3], oIdx = NULL;
+	static IDL_VPTR	oIndices, oMoved;
+
+	static IDL_KW_PAR keywords[]={
+		{"INDICES", IDL_TYP_UNDEF, 1, IDL_KW_VIN|IDL_KW_ZERO,0,IDL_CHARA(oIndices)},
+		{"MOVED", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oMoved)},
+		{NULL}
+	};
+
+	IDL_KWGetParams(argc,argv,argk, keywords,outargv,1);
+
+	IDL_EXCLUDE_EXPR(outargv[0]);
+	bvh = bvh_get(outargv[0]);
+	nNodes = (IDL_MEMINT) bvh[0].c[0];
+	nObj = (IDL_MEMINT) bvh[0].c[1];
+	nRows = outargv[0]->value.arr->dim[1];
+
+	if (oIndices) {
+		IDL_ENSURE_ARRAY(oIndices);
+		oIdx = (oIndices->type == IDL_TYP_MEMINT) ? oIndices :
+			IDL_BasicTypeConversion(1, &oIndices, IDL_TYP_MEMINT);
+		indices = (IDL_MEMINT *) oIdx->value.arr->data;
+		nMoved = oIdx->value.arr->n_elts;
+		for (i = 0; i < nMoved; ++i) {
+			if (indices[i] < 0 || indices[i] >= nObj) {
+				if (oIdx != oIndices) IDL_Deltmp(oIdx);
+				IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+					"INDICES must be in the range 0 to N-1.");
+			}
+		}
+	}
+
+	for (n = 0; n < 2; ++n) {
+		IDL_ENSURE_ARRAY(outargv[n+1]);
+		dargv[n] = (outargv[n+1]->type == IDL_TYP_DOUBLE) ? outargv[n+1] :
+			IDL_BasicTypeConversion(1, &outargv[n+1], IDL_TYP_DOUBLE);
+		if (dargv[n]->value.arr->n_elts != nObj * 3) {
+			for (k = 0; k <= n; ++k)
+				if (dargv[k] != outargv[k+1]) IDL_Deltmp(dargv[k]);
+			if (oIdx && oIdx != oIndices) IDL_Deltmp(oIdx);
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"location and extents must match the BVH object count.");
+		}
+	}
+
+	location = (double *) dargv[0]->value.arr->data;
+	extents = (double *) dargv[1]->value.arr->data;
+	obj = bvh + 1 + nNodes;
+
+	if (indices) {
+
+		/*  Find the rows of the moved objects thru the object map. */
+		rows = (IDL_MEMINT *) malloc((nMoved + 1) * sizeof(IDL_MEMINT));
+		for (i = 0; rows && i < nMoved; ++i) {
+			o = indices[i];
+			r = (IDL_MEMINT) obj[o].count;
+			if (r <= nNodes || r >= nRows || (IDL_MEMINT) bvh[r].link != o) {
+				valid = 0;
+				break;
+			}
+			for (k = 0; k < 3; ++k) {
+				bvh[r].c[k] = location[o*3+k];
+				bvh[r].e[k] = fabs(extents[o*3+k]);
+			}
+			rows[i] = r;
+		}
+
+		if (!rows || !valid)
+			;
+		else if (nMoved > BVH_REFIT_MAX * nObj)
+			bvh[0].e[1] = 1.0;
+		else if (bvh[0].e[1] != 0.0) {
+			valid = bvh_refit(bvh, nRows, NULL);
+			bvh[0].e[1] = 0.0;
+		} else {
+			qsort(rows, nMoved, sizeof(IDL_MEMINT), bvh_cmp_rows);
+			valid = bvh_refit_rows(bvh, nRows, rows, nMoved);
+		}
+
+	} else {
+
+		/*  Without memory for the flags every node is refit. */
+		dirty = (UCHAR *) calloc(nRows, 1);
+
+		/*  The object rows are in leaf order so the reads from location
+			and extents are scattered.  Fetch them a few objects ahead. */
+		for (i = 0; i < nObj; ++i) {
+			o = (IDL_MEMINT) obj[i].link;
+			if (o < 0 || o >= nObj) {
+				valid = 0;
+				break;
+			}
+#ifdef __GNUC__
+			if (i + 16 < nObj) {
+				r = (IDL_MEMINT) obj[i+16].link;
+				if (r >= 0 && r < nObj) {
+					__builtin_prefetch(location + 3 * r);
+					__builtin_prefetch(extents + 3 * r);
+				}
+			}
+#endif
+			changed = 0;
+			for (k = 0; k < 3; ++k) {
+				e = fabs(extents[o*3+k]);
+				if (obj[i].c[k] != location[o*3+k] || obj[i].e[k] != e) {
+					obj[i].c[k] = location[o*3+k];
+					obj[i].e[k] = e;
+					changed = 1;
+				}
+			}
+			if (changed) {
+				if (dirty) dirty[1+nNodes+i] = 1;
+				++nMoved;
+			}
+		}
+
+		if (!valid)
+			;
+		else if (nMoved > BVH_REFIT_MAX * nObj)
+			bvh[0].e[1] = 1.0;
+		else if (bvh[0].e[1] != 0.0 || !dirty) {
+			valid = bvh_refit(bvh, nRows, NULL);
+			bvh[0].e[1] = 0.0;
+		} else if (nMoved > 0)
+			valid = bvh_refit(bvh, nRows, dirty);
+	}
+
+	free(dirty);
+	free(rows);
+	for (n = 0; n < 2; ++n)
+		if (dargv[n] != outargv[n+1]) IDL_Deltmp(dargv[n]);
+	if (oIdx && oIdx != oIndices) IDL_Deltmp(oIdx);
+
+	if (indices && valid && !rows)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"Unable to allocate memory for BVH refit.");
+	if (!valid)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"Invalid BVH: a node or object link is out of range.  Rebuild "
+			"it with RHTgrCamera_BVHBuild.");
+
+	if (oMoved) IDL_VarCopy(IDL_GettmpLong((IDL_LONG) nMoved), oMoved);
+
+}
+
+
+/*
+	Software hierarchical-Z occlusion culling.
+
+	A small set of occluder boxes is rasterized into a low resolution
+	depth buffer which is reduced into a pyramid holding, for each texel
+	of each level, the farthest and the nearest occluder depth below it.
+	Boxes that survive frustum culling are projected and compared against
+	the coarsest level on which they cover at most 2x2 texels, refining
+	by up to HIZ_REFINE levels while the answer is ambiguous.  A box is
+	occluded when its nearest point lies behind the farthest occluder
+	depth of every texel it covers, and is accepted as soon as it lies in
+	front of the nearest occluder depth of any of them.
+
+	Depths are stored as reciprocal view distances (1/d), which are
+	linear in screen space, so larger values are nearer and empty texels
+	hold 0.  Occluders only write the pixels they cover entirely, at the
+	farthest depth they reach over the pixel rounded away from the eye, so
+	a pixel's depth holds for every point of it and the test is
+	conservative.  Each face is drawn at its own depth and the silhouette
+	of the box at the depth of its farthest corner, which fills the
+	pixels along the edges between faces.  Tested boxes are compared
+	against every pixel their screen rectangle touches.  Occluders are
+	drawn as solid boxes so they must lie inside solid geometry (for
+	example the inscribed box of a sphere).  Occluders that
+	cross the near plane are skipped and boxes that cross it are always
+	visible.
+
+	The pyramid is passed to IDL as a float vector.  Elements 0 thru
+	HIZ_HEADER-1 hold [width, height, levels, tan(fov x), tan(fov y), eye,
+	near distance, 0] and are followed by the levels, finest first, each
+	as a width_l x height_l far plane (min 1/d) then near plane (max 1/d)
+	where width_l = ceil(width_(l-1) / 2).  Boxes are tested in parallel
+	when more than HIZ_MT_MIN are given and the DLM is built with OpenMP.
+*/
+#define HIZ_HEADER		8
+#define HIZ_REFINE		2
+#define HIZ_MAXDIM		4096
+#define HIZ_MAXLEVELS	16
+#define HIZ_MT_MIN		4096
+
+typedef struct {
+	int			w, h, nLevels;
+	int			lw[HIZ_MAXLEVELS], lh[HIZ_MAXLEVELS];
+	double		tanX, tanY, eye, dNear;
+	float		*zFar[HIZ_MAXLEVELS], *zNear[HIZ_MAXLEVELS];
+} HIZ;
+
+static const short hizFaces[6][4] = {
+	{0, 2, 6, 4}, {1, 3, 7, 5}, {0, 1, 5, 4},
+	{2, 3, 7, 6}, {0, 1, 3, 2}, {4, 5, 7, 6}
+};
+
+
+/*
+	Set the level dimensions of a hiz->w x hiz->h pyramid and, if data is
+	not NULL, its plane pointers.  Returns the length of the float vector.
+*/
+static IDL_MEMINT hiz_layout(HIZ *hiz, float *data)
+{
+	int				l = 0, w = hiz->w, h = hiz->h;
+	IDL_MEMINT		n = HIZ_HEADER;
+
+	for (;;) {
+		hiz->lw[l] = w;
+		hiz->lh[l] = h;
+		if (data) {
+			hiz->zFar[l] = data + n;
+			hiz->zNear[l] = data + n + (IDL_MEMINT) w * h;
+		}
+		n += 2 * (IDL_MEMINT) w * h;
+		++l;
+		if (w == 1 && h == 1) break;
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+	}
+	hiz->nLevels = l;
+
+	return n;
+}
+
+
+/*  Check a pyramid passed from IDL and fill in hiz. */
+static void hiz_get(IDL_VPTR oHiz, HIZ *hiz)
+{
+	float			*data;
+
+	IDL_ENSURE_ARRAY(oHiz);
+	if (oHiz->type != IDL_TYP_FLOAT || oHiz->value.arr->n_elts < HIZ_HEADER)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"HiZ must be a float array from RHTgrCamera_HiZBuild.");
+
+	data = (float *) oHiz->value.arr->data;
+	hiz->w = (int) data[0];
+	hiz->h = (int) data[1];
+	if (hiz->w < 1 || hiz->w > HIZ_MAXDIM || hiz->h < 1 ||
+		hiz->h > HIZ_MAXDIM || hiz_layout(hiz, data) !=
+		oHiz->value.arr->n_elts || hiz->nLevels != (int) data[2])
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"Invalid HiZ header.");
+
+	hiz->tanX = data[3];
+	hiz->tanY = data[4];
+	hiz->eye = data[5];
+	hiz->dNear = data[6];
+}
+
+
+/*
+	Compute the 8 view space corners of the box c +/- e, transformed by t
+	unless it is NULL.  Corner n is on the + side of x, y and z for bits
+	0, 1 and 2 of n.
+*/
+static void hiz_corners(const double *c, const double *e, double t[4][4],
+	double corners[8][3])
+{
+	short		n, k;
+	double		v[3];
+
+	for (n = 0; n < 8; ++n) {
+		v[0] = (n & 1) ? c[0] + e[0] : c[0] - e[0];
+		v[1] = (n & 2) ? c[1] + e[1] : c[1] - e[1];
+		v[2] = (n & 4) ? c[2] + e[2] : c[2] - e[2];
+		for (k = 0; k < 3; ++k)
+			corners[n][k] = (t) ? ((t[k][0]*v[0] + t[k][1]*v[1]) +
+				t[k][2]*v[2]) + t[k][3] : v[k];
+	}
+}
+
+
+/*
+	Project the view space point v to pixel coordinates and 1/d.  Returns
+	0 if the point is not beyond the near plane.
+*/
+static int hiz_project(const HIZ *hiz, const double *v, double *p)
+{
+	double		d = hiz->eye - v[2];
+
+	if (d <= hiz->dNear) return 0;
+
+	p[0] = (v[0] / (d * hiz->tanX) + 1.) * 0.5 * hiz->w;
+	p[1] = (v[1] / (d * hiz->tanY) + 1.) * 0.5 * hiz->h;
+	p[2] = 1. / d;
+
+	return 1;
+}
+
+
+/*
+	Rasterize the projected convex polygon p (n vertices in order, either
+	winding) into the finest level.  Only pixels entirely inside the
+	polygon are written.  If iz is negative the depth is the plane thru
+	the first three vertices, taken at the farthest corner of each pixel,
+	otherwise every pixel is written at depth iz.
+*/
+static void hiz_polygon(HIZ *hiz, const double p[][3], int n, double iz)
+{
+	int			i, j, x, y, x0, x1, y0, y1;
+	float		*row;
+	double		area, lo, hi, dx[8], dy[8], m[8], e[8], e0[8], z, z0;
+	double		dzdx = 0, dzdy = 0, margin = 0;
+
+	for (i = 0, area = 0; i < n; ++i) {
+		j = (i + 1) % n;
+		area += p[i][0] * p[j][1] - p[j][0] * p[i][1];
+	}
+	if (area == 0) return;
+
+	/*  Edge i runs from vertex i to vertex i+1 and is non-negative inside.
+		A pixel is inside if its center is at least m[i] inside every edge. */
+	for (i = 0; i < n; ++i) {
+		j = (i + 1) % n;
+		dx[i] = (area > 0) ? p[j][0] - p[i][0] : p[i][0] - p[j][0];
+		dy[i] = (area > 0) ? p[j][1] - p[i][1] : p[i][1] - p[j][1];
+		m[i] = 0.5 * (fabs(dx[i]) + fabs(dy[i]));
+	}
+
+	/*  The plane of the first three vertices. */
+	if (iz < 0) {
+		z = (p[1][0] - p[0][0]) * (p[2][1] - p[0][1]) -
+			(p[1][1] - p[0][1]) * (p[2][0] - p[0][0]);
+		if (z == 0) return;
+		dzdx = ((p[1][2] - p[0][2]) * (p[2][1] - p[0][1]) -
+			(p[2][2] - p[0][2]) * (p[1][1] - p[0][1])) / z;
+		dzdy = ((p[2][2] - p[0][2]) * (p[1][0] - p[0][0]) -
+			(p[1][2] - p[0][2]) * (p[2][0] - p[0][0])) / z;
+		margin = 0.5 * (fabs(dzdx) + fabs(dzdy));
+	}
+
+	/*  Pixels which may lie entirely inside the polygon. */
+	lo = hi = p[0][0];
+	for (i = 1; i < n; ++i) {
+		lo = MIN(lo, p[i][0]);
+		hi = MAX(hi, p[i][0]);
+	}
+	lo = ceil(lo);
+	hi = floor(hi) - 1;
+	x0 = (lo < 0) ? 0 : (lo > hiz->w) ? hiz->w : (int) lo;
+	x1 = (hi >= hiz->w) ? hiz->w - 1 : (hi < -1) ? -1 : (int) hi;
+	lo = hi = p[0][1];
+	for (i = 1; i < n; ++i) {
+		lo = MIN(lo, p[i][1]);
+		hi = MAX(hi, p[i][1]);
+	}
+	lo = ceil(lo);
+	hi = floor(hi) - 1;
+	y0 = (lo < 0) ? 0 : (lo > hiz->h) ? hiz->h : (int) lo;
+	y1 = (hi >= hiz->h) ? hiz->h - 1 : (hi < -1) ? -1 : (int) hi;
+
+	for (y = y0; y <= y1; ++y) {
+
+		/*  Edge functions and depth at the first pixel center of the row. */
+		for (i = 0; i < n; ++i)
+			e0[i] = dx[i] * (y + 0.5 - p[i][1]) - dy[i] * (x0 + 0.5 - p[i][0]);
+		z0 = (iz < 0) ? p[0][2] + dzdx * (x0 + 0.5 - p[0][0]) +
+			dzdy * (y + 0.5 - p[0][1]) - margin : iz;
+		row = hiz->zNear[0] + (IDL_MEMINT) y * hiz->w;
+
+		for (x = x0; x <= x1; ++x) {
+			for (i = 0; i < n; ++i) {
+				e[i] = e0[i] - dy[i] * (x - x0);
+				if (e[i] < m[i]) break;
+			}
+			if (i == n) {
+				z = (iz < 0) ? z0 + dzdx * (x - x0) : iz;
+				if (z > row[x]) {
+					row[x] = (float) z;
+					if (row[x] > z) row[x] *= 1.f - FLT_EPSILON;
+				}
+			}
+		}
+	}
+}
+
+
+/*
+	Convex hull of the projected corners p, in order.  Returns the number
+	of hull vertices.
+*/
+static int hiz_hull(const double p[8][3], double hull[16][3])
+{
+	int			i, j, k, n = 0, t, idx[8];
+	const double	*q;
+
+	/*  Sort the corners by x then y. */
+	for (i = 0; i < 8; ++i) idx[i] = i;
+	for (i = 1; i < 8; ++i) {
+		for (j = i; j > 0 && (p[idx[j]][0] < p[idx[j-1]][0] ||
+			(p[idx[j]][0] == p[idx[j-1]][0] &&
+			p[idx[j]][1] < p[idx[j-1]][1])); --j) {
+			k = idx[j];
+			idx[j] = idx[j-1];
+			idx[j-1] = k;
+		}
+	}
+
+	/*  Monotone chain: the lower hull left to right, then the upper hull
+		right to left.  Collinear points are dropped. */
+	for (i = 0, t = 2; i < 15; ++i) {
+		if (i == 8) t = n + 1;
+		q = p[idx[(i < 8) ? i : 14 - i]];
+		while (n >= t && (hull[n-1][0] - hull[n-2][0]) *
+			(q[1] - hull[n-2][1]) - (hull[n-1][1] - hull[n-2][1]) *
+			(q[0] - hull[n-2][0]) <= 0) --n;
+		hull[n][0] = q[0];
+		hull[n][1] = q[1];
+		hull[n][2] = q[2];
+		++n;
+	}
+
+	/*  The last point repeats the first. */
+	return n - 1;
+}
+
+
+/*  Build the coarser levels from the finest one. */
+static void hiz_reduce(HIZ *hiz)
+{
+	int			l, x, y, pw, ph, x1, y1;
+	float		*f, *n, zf, zn;
+
+	for (l = 1; l < hiz->nLevels; ++l) {
+
+		pw = hiz->lw[l-1];
+		ph = hiz->lh[l-1];
+		f = hiz->zFar[l-1];
+		n = hiz->zNear[l-1];
+
+		for (y = 0; y < hiz->lh[l]; ++y) {
+			y1 = (2*y + 1 < ph) ? 2*y + 1 : 2*y;
+			for (x = 0; x < hiz->lw[l]; ++x) {
+				x1 = (2*x + 1 < pw) ? 2*x + 1 : 2*x;
+				zf = MIN(MIN(f[2*y*pw + 2*x], f[2*y*pw + x1]),
+					MIN(f[y1*pw + 2*x], f[y1*pw + x1]));
+				zn = MAX(MAX(n[2*y*pw + 2*x], n[2*y*pw + x1]),
+					MAX(n[y1*pw + 2*x], n[y1*pw + x1]));
+				hiz->zFar[l][y*hiz->lw[l] + x] = zf;
+				hiz->zNear[l][y*hiz->lw[l] + x] = zn;
+			}
+		}
+	}
+}
+
+
+/*  Returns 0 if the box c +/- e is occluded and 1 otherwise. */
+static int hiz_test(const HIZ *hiz, const double *c, const double *e,
+	double t[4][4])
+{
+	short		n;
+	int			l, lev, tx, ty, px[2], py[2], occluded;
+	float		*zf, *zn;
+	double		corners[8][3], p[3], lo[2] = {0, 0}, hi[2] = {0, 0}, iz = 0;
+
+	hiz_corners(c, e, t, corners);
+
+	for (n = 0; n < 8; ++n) {
+		if (!hiz_project(hiz, corners[n], p)) return 1;
+		if (n == 0) {
+			lo[0] = hi[0] = p[0];
+			lo[1] = hi[1] = p[1];
+			iz = p[2];
+			continue;
+		}
+		if (lo[0] > p[0]) lo[0] = p[0];
+		if (hi[0] < p[0]) hi[0] = p[0];
+		if (lo[1] > p[1]) lo[1] = p[1];
+		if (hi[1] < p[1]) hi[1] = p[1];
+		if (iz < p[2]) iz = p[2];
+	}
+
+	/*  Leave boxes off screen to the frustum cull. */
+	if (hi[0] < 0 || hi[1] < 0 || lo[0] >= hiz->w || lo[1] >= hiz->h)
+		return 1;
+
+	/*  Every pixel the rectangle touches, widened to whole pixels before
+		the level is chosen. */
+	px[0] = (lo[0] < 0) ? 0 : (int) floor(lo[0]);
+	px[1] = (hi[0] >= hiz->w) ? hiz->w - 1 : (int) floor(hi[0]);
+	py[0] = (lo[1] < 0) ? 0 : (int) floor(lo[1]);
+	py[1] = (hi[1] >= hiz->h) ? hiz->h - 1 : (int) floor(hi[1]);
+
+	/*  Start on the level where the box covers at most 2x2 texels. */
+	for (l = 0; l < hiz->nLevels - 1; ++l)
+		if ((px[1] >> l) - (px[0] >> l) <= 1 &&
+			(py[1] >> l) - (py[0] >> l) <= 1) break;
+
+	for (lev = l; lev >= 0 && lev >= l - HIZ_REFINE; --lev) {
+		occluded = 1;
+		for (ty = py[0] >> lev; ty <= py[1] >> lev; ++ty) {
+			zf = hiz->zFar[lev] + (IDL_MEMINT) ty * hiz->lw[lev];
+			zn = hiz->zNear[lev] + (IDL_MEMINT) ty * hiz->lw[lev];
+			for (tx = px[0] >> lev; tx <= px[1] >> lev; ++tx) {
+				if (iz >= zn[tx]) return 1;
+				if (iz >= zf[tx]) occluded = 0;
+			}
+		}
+		if (occluded) return 0;
+	}
+
+	return 1;
+}
+
+
+//  RHTgrCamera_HiZBuild
+IDL_VPTR IDL_CDECL RHTgrCamera_HiZBuild(int argc, IDL_VPTR *argv, char *argk)
+{
+
+    /*
+
+		hiz = RHTgrCamera_HiZBuild(location, extents, fov, eye, zclip, $
+				  DIMENSIONS=[width, height], TRANSFORM=transform)
+
+		Rasterizes the occluder boxes given by the 3xN arrays location
+		(centers) and extents (half widths) into a width x height depth
+		buffer (256x256 by default) and returns its depth pyramid for
+		RHTgrCamera_HiZTest.  fov, eye and zclip are the camera values
+		passed to RHTgrCamera_ComputeFrustum.  Set TRANSFORM to the 4x4
+		transform from the space the boxes are given in to view space.
+
+    */
+
+	short			n, f;
+	IDL_MEMINT		i, nBox, size[] = {1};
+	float			*data;
+	double			*location, *extents, *fov, *zclip, t[4][4];
+	int				nHull;
+	double			corners[8][3], proj[8][3], face[4][3], hull[16][3], iz;
+	HIZ				hiz;
+	IDL_VPTR		oHiz, oLong, dargv[4], outargv[5];
+	static IDL_VPTR oDims, oTransform;
+
+	static IDL_KW_PAR keywords[]={
+		{"DIMENSIONS", IDL_TYP_UNDEF, 1, IDL_KW_VIN|IDL_KW_ZERO,0,IDL_CHARA(oDims)},
+		{"TRANSFORM", IDL_TYP_UNDEF, 1, IDL_KW_VIN|IDL_KW_ZERO,0,IDL_CHARA(oTransform)},
+		{NULL}
+	};
+
+	IDL_KWGetParams(argc,argv,argk, keywords,outargv,1);
+
+	for (n = 0; n < 5; ++n) {
+		if (n == 3) continue;
+		IDL_ENSURE_ARRAY(outargv[n]);
+		dargv[n < 3 ? n : 3] = (outargv[n]->type == IDL_TYP_DOUBLE) ?
+			outargv[n] : IDL_BasicTypeConversion(1, &outargv[n],
+			IDL_TYP_DOUBLE);
+	}
+	location = (double *) dargv[0]->value.arr->data;
+	extents = (double *) dargv[1]->value.arr->data;
+	fov = (double *) dargv[2]->value.arr->data;
+	zclip = (double *) dargv[3]->value.arr->data;
+	nBox = dargv[0]->value.arr->n_elts / 3;
+
+	if (dargv[1]->value.arr->n_elts != dargv[0]->value.arr->n_elts)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"location and extents must be 3xN arrays of the same size.");
+	if (dargv[2]->value.arr->n_elts < 2 || dargv[3]->value.arr->n_elts < 2)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"fov and zclip must be 2 element arrays.");
+
+	hiz.w = hiz.h = 256;
+	if (oDims) {
+		IDL_ENSURE_ARRAY(oDims);
+		if (oDims->value.arr->n_elts != 2)
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"DIMENSIONS must be a 2 element array.");
+		oLong = IDL_BasicTypeConversion(1, &oDims, IDL_TYP_LONG);
+		hiz.w = (int) ((IDL_LONG *) oLong->value.arr->data)[0];
+		hiz.h = (int) ((IDL_LONG *) oLong->value.arr->data)[1];
+		if (oLong != oDims) IDL_Deltmp(oLong);
+		if (hiz.w < 1 || hiz.w > HIZ_MAXDIM || hiz.h < 1 ||
+			hiz.h > HIZ_MAXDIM)
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"DIMENSIONS must be between 1 and 4096.");
+	}
+
+	if (oTransform) {
+		IDL_ENSURE_ARRAY(oTransform);
+		if (oTransform->type != IDL_TYP_DOUBLE ||
+			oTransform->value.arr->n_elts != 16)
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"TRANSFORM must be a 4x4 double array.");
+		for (n = 0; n < 16; ++n)
+			t[n / 4][n % 4] = ((double *) oTransform->value.arr->data)[n];
+	}
+
+	/*  Write the header and read it back so the tests see the same values. */
+	size[0] = hiz_layout(&hiz, NULL);
+	data = (float *) IDL_MakeTempArray((int)IDL_TYP_FLOAT, 1, size,
+		IDL_ARR_INI_ZERO, &oHiz);
+	data[0] = (float) hiz.w;
+	data[1] = (float) hiz.h;
+	data[2] = (float) hiz.nLevels;
+	data[3] = (float) tan(fov[0]);
+	data[4] = (float) tan(fov[1]);
+	data[5] = (float) IDL_DoubleScalar(outargv[3]);
+	data[6] = (float) (data[5] - zclip[0]);
+	hiz_get(oHiz, &hiz);
+
+	/*  Rasterize the occluders, skipping any that cross the near plane. */
+	for (i = 0; i < nBox; ++i) {
+		hiz_corners(location + i*3, extents + i*3, (oTransform) ? t : NULL,
+			corners);
+		for (n = 0; n < 8; ++n)
+			if (!hiz_project(&hiz, corners[n], proj[n])) break;
+		if (n < 8) continue;
+		for (f = 0; f < 6; ++f) {
+			for (n = 0; n < 4; ++n) {
+				face[n][0] = proj[hizFaces[f][n]][0];
+				face[n][1] = proj[hizFaces[f][n]][1];
+				face[n][2] = proj[hizFaces[f][n]][2];
+			}
+			hiz_polygon(&hiz, (const double (*)[3]) face, 4, -1.);
+		}
+		iz = proj[0][2];
+		for (n = 1; n < 8; ++n)
+			if (iz > proj[n][2]) iz = proj[n][2];
+		nHull = hiz_hull((const double (*)[3]) proj, hull);
+		if (nHull >= 3) hiz_polygon(&hiz, (const double (*)[3]) hull,
+			nHull, iz);
+	}
+
+	memcpy(hiz.zFar[0], hiz.zNear[0], (size_t) hiz.w * hiz.h * sizeof(float));
+	hiz_reduce(&hiz);
+
+	for (n = 0; n < 4; ++n)
+		if (dargv[n] != outargv[n < 3 ? n : 4]) IDL_Deltmp(dargv[n]);
+
+	return oHiz;
+
+}
+
+
+//  RHTgrCamera_HiZTest
+IDL_VPTR IDL_CDECL RHTgrCamera_HiZTest(int argc, IDL_VPTR *argv, char *argk)
+{
+
+    /*
+
+		visible = RHTgrCamera_HiZTest(hiz, location, extents, COUNT=count, $
+				      MASK=mask, STATS=stats, TRANSFORM=transform)
+
+		Tests the boxes given by the 3xN arrays location and extents
+		against a depth pyramid from RHTgrCamera_HiZBuild.  Returns the
+		indices of the boxes that are not occluded in ascending order, or
+		-1 if there are none.  Set TRANSFORM to the 4x4 transform from the
+		space the boxes are given in to view space.
+
+		If MASK holds a byte array with an element per box only the boxes
+		with a non-zero mask are tested (and can be returned) and occluded
+		boxes are cleared in place, so the MASK from RHTgrCamera_BVHCull
+		can be passed straight in.  Otherwise every box is tested and MASK
+		returns a new byte array.  STATS returns a 2 element LONG64 array
+		[boxes tested, boxes occluded].
+
+    */
+
+	short			n;
+	IDL_MEMINT		i, nBox, nTested = 0, nOccluded = 0, nVisible, size[] = {1};
+	IDL_LONG		*visible;
+	IDL_LONG64		*pStats;
+	UCHAR			*mask;
+	double			*location, *extents, t[4][4];
+	HIZ				hiz;
+	IDL_VPTR		oVisible, oMask = NULL, oStatsOut, dargv[2], outargv[3];
+	static IDL_VPTR oCount, oMaskKw, oStats, oTransform;
+
+	static IDL_KW_PAR keywords[]={
+		{"COUNT", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oCount)},
+		{"MASK", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oMaskKw)},
+		{"STATS", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oStats)},
+		{"TRANSFORM", IDL_TYP_UNDEF, 1, IDL_KW_VIN|IDL_KW_ZERO,0,IDL_CHARA(oTransform)},
+		{NULL}
+	};
+
+	IDL_KWGetParams(argc,argv,argk, keywords,outargv,1);
+
+	hiz_get(outargv[0], &hiz);
+
+	for (n = 0; n < 2; ++n) {
+		IDL_ENSURE_ARRAY(outargv[n+1]);
+		dargv[n] = (outargv[n+1]->type == IDL_TYP_DOUBLE) ? outargv[n+1] :
+			IDL_BasicTypeConversion(1, &outargv[n+1], IDL_TYP_DOUBLE);
+	}
+	location = (double *) dargv[0]->value.arr->data;
+	extents = (double *) dargv[1]->value.arr->data;
+	nBox = dargv[0]->value.arr->n_elts / 3;
+
+	if (dargv[1]->value.arr->n_elts != dargv[0]->value.arr->n_elts)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"location and extents must be 3xN arrays of the same size.");
+
+	if (oTransform) {
+		IDL_ENSURE_ARRAY(oTransform);
+		if (oTransform->type != IDL_TYP_DOUBLE ||
+			oTransform->value.arr->n_elts != 16)
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"TRANSFORM must be a 4x4 double array.");
+		for (n = 0; n < 16; ++n)
+			t[n / 4][n % 4] = ((double *) oTransform->value.arr->data)[n];
+	}
+
+	/*  Update the caller's mask in place if it matches these boxes. */
+	if (oMaskKw && (oMaskKw->flags & IDL_V_ARR) &&
+		oMaskKw->type == IDL_TYP_BYTE && oMaskKw->value.arr->n_elts == nBox)
+		mask = (UCHAR *) oMaskKw->value.arr->data;
+	else {
+		size[0] = nBox;
+		mask = (UCHAR *) IDL_MakeTempArray((int)IDL_TYP_BYTE, 1, size,
+			IDL_ARR_INI_NOP, &oMask);
+		memset(mask, 1, (size_t) nBox);
+	}
+
+#ifdef _OPENMP
+	#pragma omp parallel for schedule(static) reduction(+:nTested,nOccluded) if (nBox >= HIZ_MT_MIN)
+#endif
+	for (i = 0; i < nBox; ++i) {
+		if (!mask[i]) continue;
+		++nTested;
+		if (!hiz_test(&hiz, location + i*3, extents + i*3,
+			(oTransform) ? t : NULL)) {
+			mask[i] = 0;
+			++nOccluded;
+		}
+	}
+
+	nVisible = nTested - nOccluded;
+	if (nVisible > 0) {
+		size[0] = nVisible;
+		visible = (IDL_LONG *) IDL_MakeTempArray((int)IDL_TYP_LONG, 1, size,
+			IDL_ARR_INI_NOP, &oVisible);
+		for (i = 0, nVisible = 0; i < nBox; ++i)
+			if (mask[i]) visible[nVisible++] = (IDL_LONG) i;
+	} else oVisible = IDL_GettmpLong(-1);
+
+	if (oCount) IDL_VarCopy(IDL_GettmpLong((IDL_LONG) nVisible), oCount);
+	if (oMask) {
+		if (oMaskKw) IDL_VarCopy(oMask, oMaskKw);
+		else IDL_Deltmp(oMask);
+	}
+	if (oStats) {
+		size[0] = 2;
+		pStats = (IDL_LONG64 *) IDL_MakeTempArray((int)IDL_TYP_LONG64, 1,
+			size, IDL_ARR_INI_NOP, &oStatsOut);
+		pStats[0] = nTested;
+		pStats[1] = nOccluded;
+		IDL_VarCopy(oStatsOut, oStats);
+	}
+
+	for (n = 0; n < 2; ++n)
+		if (dargv[n] != outargv[n+1]) IDL_Deltmp(dargv[n]);
+
+	return oVisible;
+
+}
+
+
+/*
+	Geodesic meshes for RHTgrPSolid.
+
+	Each platonic solid (as triangles inscribed in the unit sphere) is
+	subdivided level times by splitting every triangle into four at its
+	edge midpoints, pushing the new vertices out to the sphere.  Midpoint
+	vertices are looked up in a hash table keyed on the edge so that the
+	triangles sharing an edge share its midpoint and the mesh has no
+	duplicate vertices.  Meshes are kept in a process wide cache keyed by
+	(solid, level) so each one is only built once and every level is built
+	from the cached level below it.
+*/
+#define GEO_NSOLIDS		5
+#define GEO_MAXLEVEL	8
+
+typedef struct {
+	IDL_LONG	nVerts, nTris;
+	float		*verts;
+	IDL_LONG	*tris;
+	double		error;
+} GEOMESH;
+
+static GEOMESH geoCache[GEO_NSOLIDS][GEO_MAXLEVEL+1];
+
+static const int geoFaces[GEO_NSOLIDS] = {4, 6, 8, 12, 20};
+
+static const short geoTetraTris[] = {
+	0,1,2, 0,2,3, 0,3,1, 1,3,2
+};
+static const short geoHexaTris[] = {
+	0,3,2, 0,2,1, 0,1,5, 0,5,4, 0,4,7, 0,7,3,
+	6,5,1, 6,1,2, 6,2,3, 6,3,7, 6,7,4, 6,4,5
+};
+static const short geoOctaTris[] = {
+	4,0,2, 4,2,1, 4,1,3, 4,3,0, 5,2,0, 5,1,2, 5,3,1, 5,0,3
+};
+static const short geoDodecaTris[] = {
+	0,8,9, 0,9,4, 0,4,16, 0,12,13, 0,13,1, 0,1,8,
+	0,16,17, 0,17,2, 0,2,12, 8,1,18, 8,18,5, 8,5,9,
+	12,2,10, 12,10,3, 12,3,13, 16,4,14, 16,14,6, 16,6,17,
+	9,5,15, 9,15,14, 9,14,4, 6,11,10, 6,10,2, 6,2,17,
+	3,19,18, 3,18,1, 3,1,13, 7,15,5, 7,5,18, 7,18,19,
+	7,11,6, 7,6,14, 7,14,15, 7,19,3, 7,3,10, 7,10,11
+};
+static const short geoIcosaTris[] = {
+	0,8,4, 0,5,10, 2,4,9, 2,11,5, 1,6,8, 1,10,7, 3,9,6, 3,7,11,
+	0,10,8, 1,8,10, 2,9,11, 3,11,9, 4,2,0, 5,0,2, 6,1,3, 7,3,1,
+	8,6,4, 9,4,6, 10,5,7, 11,7,5
+};
+
+
+/*  Fill in the base (level 0) vertices of a solid, as RHTgrPSolid had. */
+static IDL_LONG geo_base(int s, double v[20][3], const short **tris)
+{
+	int			i;
+	double		a, b, c;
+
+	static const double hexa[8][3] = {{-1,-1,-1}, {1,-1,-1}, {1,1,-1},
+		{-1,1,-1}, {-1,-1,1}, {1,-1,1}, {1,1,1}, {-1,1,1}};
+	static const double octa[6][3] = {{1,0,0}, {-1,0,0}, {0,1,0},
+		{0,-1,0}, {0,0,1}, {0,0,-1}};
+	static const double dodecaSigns[8][3] = {{1,1,1}, {1,1,-1}, {1,-1,1},
+		{1,-1,-1}, {-1,1,1}, {-1,1,-1}, {-1,-1,1}, {-1,-1,-1}};
+
+	switch (s) {
+	case 0:
+		a = sqrt(2.) / 3.;
+		b = sqrt(6.) / 3.;
+		c = 1. / 3.;
+		v[0][0] = 0; v[0][1] = 0; v[0][2] = 1;
+		v[1][0] = 2*a; v[1][1] = 0; v[1][2] = -c;
+		v[2][0] = -a; v[2][1] = b; v[2][2] = -c;
+		v[3][0] = -a; v[3][1] = -b; v[3][2] = -c;
+		*tris = geoTetraTris;
+		return 4;
+	case 1:
+		for (i = 0; i < 8; ++i) {
+			v[i][0] = hexa[i][0] / sqrt(3.);
+			v[i][1] = hexa[i][1] / sqrt(3.);
+			v[i][2] = hexa[i][2] / sqrt(3.);
+		}
+		*tris = geoHexaTris;
+		return 8;
+	case 2:
+		memcpy(v, octa, sizeof(octa));
+		*tris = geoOctaTris;
+		return 6;
+	case 3:
+		a = 1. / sqrt(3.);
+		b = sqrt((3. - sqrt(5.)) / 6.);
+		c = sqrt((3. + sqrt(5.)) / 6.);
+		for (i = 0; i < 8; ++i) {
+			v[i][0] = a * dodecaSigns[i][0];
+			v[i][1] = a * dodecaSigns[i][1];
+			v[i][2] = a * dodecaSigns[i][2];
+		}
+		for (i = 0; i < 4; ++i) {
+			/*  [+-b, +-c, 0], [+-c, 0, +-b], [0, +-b, +-c] */
+			v[8+i][0] = (i & 1) ? -b : b;
+			v[8+i][1] = (i & 2) ? -c : c;
+			v[8+i][2] = 0;
+			v[12+i][0] = (i & 2) ? -c : c;
+			v[12+i][1] = 0;
+			v[12+i][2] = (i & 1) ? -b : b;
+			v[16+i][0] = 0;
+			v[16+i][1] = (i & 1) ? -b : b;
+			v[16+i][2] = (i & 2) ? -c : c;
+		}
+		*tris = geoDodecaTris;
+		return 20;
+	default:
+		a = 1. + sqrt(5.);
+		c = sqrt(1. + a*a);
+		for (i = 0; i < 4; ++i) {
+			/*  [+-a, +-1, 0], [+-1, 0, +-a], [0, +-a, +-1] */
+			v[i][0] = ((i & 1) ? -a : a) / c;
+			v[i][1] = ((i & 2) ? -1 : 1) / c;
+			v[i][2] = 0;
+			v[4+2*(i&1)+(i>>1)][0] = ((i & 1) ? -1 : 1) / c;
+			v[4+2*(i&1)+(i>>1)][1] = 0;
+			v[4+2*(i&1)+(i>>1)][2] = ((i & 2) ? -a : a) / c;
+			v[8+i][0] = 0;
+			v[8+i][1] = ((i & 1) ? -a : a) / c;
+			v[8+i][2] = ((i & 2) ? -1 : 1) / c;
+		}
+		*tris = geoIcosaTris;
+		return 12;
+	}
+}
+
+
+/*  Largest distance between the mesh surface and the unit sphere. */
+static double geo_error(const GEOMESH *mesh)
+{
+	IDL_LONG	i;
+	short		k;
+	double		a[3], b[3], n[3], len, dist, minDist = 1.0;
+	const float	*v0, *v1, *v2;
+
+	for (i = 0; i < mesh->nTris; ++i) {
+		v0 = mesh->verts + 3 * mesh->tris[i*3];
+		v1 = mesh->verts + 3 * mesh->tris[i*3+1];
+		v2 = mesh->verts + 3 * mesh->tris[i*3+2];
+		for (k = 0; k < 3; ++k) {
+			a[k] = (double) v1[k] - v0[k];
+			b[k] = (double) v2[k] - v0[k];
+		}
+		VXV3(n, a, b);
+		len = sqrt(SQR(n[0]) + SQR(n[1]) + SQR(n[2]));
+		if (len == 0) continue;
+		dist = fabs(n[0]*v0[0] + n[1]*v0[1] + n[2]*v0[2]) / len;
+		if (dist < minDist) minDist = dist;
+	}
+
+	return 1.0 - minDist;
+}
+
+
+/*
+	Return the midpoint vertex of edge a-b, adding it to mesh if it is not
+	in the hash table yet.  The table has mask+1 slots (a power of two at
+	least twice the number of edges) and empty slots hold key 0, which is
+	never a valid key since a != b.
+*/
+static IDL_LONG geo_midpoint(GEOMESH *mesh, IDL_ULONG64 *keys, IDL_LONG *vals,
+	IDL_ULONG64 mask, IDL_LONG a, IDL_LONG b)
+{
+	short			k;
+	IDL_ULONG64		key, slot;
+	double			m[3], len;
+
+	key = (a < b) ? ((IDL_ULONG64) a << 32) | (IDL_ULONG64) b :
+		((IDL_ULONG64) b << 32) | (IDL_ULONG64) a;
+	slot = (key * 0x9E3779B97F4A7C15ULL) >> 20 & mask;
+
+	while (keys[slot] != 0) {
+		if (keys[slot] == key) return vals[slot];
+		slot = (slot + 1) & mask;
+	}
+
+	for (k = 0; k < 3; ++k)
+		m[k] = (double) mesh->verts[a*3+k] + mesh->verts[b*3+k];
+	len = sqrt(SQR(m[0]) + SQR(m[1]) + SQR(m[2]));
+	for (k = 0; k < 3; ++k)
+		mesh->verts[mesh->nVerts*3+k] = (float) (m[k] / len);
+
+	keys[slot] = key;
+	vals[slot] = mesh->nVerts;
+	return mesh->nVerts++;
+}
+
+
+/*  Split every triangle of src into four.  Returns 0 if out of memory. */
+static int geo_subdivide(const GEOMESH *src, GEOMESH *dst)
+{
+	IDL_LONG		i, a, b, c, ab, bc, ca, nEdges, *t;
+	IDL_ULONG64		mask, *keys;
+	IDL_LONG		*vals;
+
+	/*  Every edge of the closed mesh is shared by two triangles. */
+	nEdges = src->nTris * 3 / 2;
+	for (mask = 1; mask < (IDL_ULONG64) nEdges * 2; mask <<= 1) ;
+
+	dst->nVerts = src->nVerts;
+	dst->nTris = src->nTris * 4;
+	dst->verts = (float *) malloc((size_t) (src->nVerts + nEdges) * 3 *
+		sizeof(float));
+	dst->tris = (IDL_LONG *) malloc((size_t) dst->nTris * 3 *
+		sizeof(IDL_LONG));
+	keys = (IDL_ULONG64 *) calloc((size_t) mask, sizeof(IDL_ULONG64));
+	vals = (IDL_LONG *) malloc((size_t) mask * sizeof(IDL_LONG));
+	if (!dst->verts || !dst->tris || !keys || !vals) {
+		free(dst->verts); free(dst->tris); free(keys); free(vals);
+		dst->verts = NULL;
+		dst->tris = NULL;
+		return 0;
+	}
+	mask -= 1;
+
+	memcpy(dst->verts, src->verts, (size_t) src->nVerts * 3 * sizeof(float));
+
+	for (i = 0, t = dst->tris; i < src->nTris; ++i, t += 12) {
+		a = src->tris[i*3];
+		b = src->tris[i*3+1];
+		c = src->tris[i*3+2];
+		ab = geo_midpoint(dst, keys, vals, mask, a, b);
+		bc = geo_midpoint(dst, keys, vals, mask, b, c);
+		ca = geo_midpoint(dst, keys, vals, mask, c, a);
+		t[0] = a;  t[1] = ab;  t[2] = ca;
+		t[3] = ab; t[4] = b;   t[5] = bc;
+		t[6] = ca; t[7] = bc;  t[8] = c;
+		t[9] = ab; t[10] = bc; t[11] = ca;
+	}
+
+	free(keys); free(vals);
+	return 1;
+}
+
+
+/*  Return the cached mesh for solid s at level, building it if needed. */
+static GEOMESH *geo_mesh(int s, int level)
+{
+	int				i;
+	IDL_LONG		nVerts;
+	double			v[20][3];
+	const short		*tris;
+	GEOMESH			*mesh = &geoCache[s][level];
+
+	if (mesh->verts) return mesh;
+
+	if (level == 0) {
+		nVerts = geo_base(s, v, &tris);
+		mesh->verts = (float *) malloc((size_t) nVerts * 3 * sizeof(float));
+		mesh->tris = (IDL_LONG *) malloc((size_t) geoFaces[s] * 9 *
+			sizeof(IDL_LONG));
+		if (!mesh->verts || !mesh->tris) {
+			free(mesh->verts); free(mesh->tris);
+			mesh->verts = NULL;
+			mesh->tris = NULL;
+			return NULL;
+		}
+		mesh->nVerts = nVerts;
+		for (i = 0; i < nVerts * 3; ++i)
+			mesh->verts[i] = (float) v[i / 3][i % 3];
+		mesh->nTris = (s == 1) ? 12 : (s == 3) ? 36 : geoFaces[s];
+		for (i = 0; i < mesh->nTris * 3; ++i)
+			mesh->tris[i] = tris[i];
+	} else {
+		if (!geo_mesh(s, level - 1) ||
+			!geo_subdivide(&geoCache[s][level-1], mesh))
+			return NULL;
+	}
+
+	mesh->error = geo_error(mesh);
+
+	return mesh;
+}
+
+
+//  RHTgrCamera_GeodesicMesh
+IDL_VPTR IDL_CDECL RHTgrCamera_GeodesicMesh(int argc, IDL_VPTR *argv, char *argk)
+{
+
+    /*
+
+		vertices = RHTgrCamera_GeodesicMesh(nfaces, level, ERROR=error, $
+				       POLYGONS=polygons)
+
+		Returns the 3xN float vertices of the platonic solid with nfaces
+		faces (4, 6, 8, 12 or 20) subdivided level times (0 thru 8) with
+		the vertices on the unit sphere.  POLYGONS returns the connectivity
+		in IDLgrPolygon form and ERROR the largest distance between the
+		surface and the sphere.  Meshes are cached for the life of the
+		process.
+
+    */
+
+	int				s, level;
+	IDL_LONG		i, nfaces, *polys;
+	IDL_MEMINT		size[2];
+	GEOMESH			*mesh;
+	IDL_VPTR		oVerts, oPolys, oErr, outargv[2];
+	static IDL_VPTR oError, oPolygons;
+
+	static IDL_KW_PAR keywords[]={
+		{"ERROR", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oError)},
+		{"POLYGONS", IDL_TYP_UNDEF, 1, IDL_KW_OUT|IDL_KW_ZERO,0,IDL_CHARA(oPolygons)},
+		{NULL}
+	};
+
+	IDL_KWGetParams(argc,argv,argk, keywords,outargv,1);
+
+	nfaces = IDL_LongScalar(outargv[0]);
+	level = (int) IDL_LongScalar(outargv[1]);
+	for (s = 0; s < GEO_NSOLIDS; ++s)
+		if (geoFaces[s] == nfaces) break;
+	if (s == GEO_NSOLIDS)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"nfaces must be 4, 6, 8, 12 or 20.");
+	if (level < 0 || level > GEO_MAXLEVEL)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"level must be between 0 and 8.");
+
+	mesh = geo_mesh(s, level);
+	if (!mesh)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"Unable to allocate memory for mesh.");
+
+	size[0] = 3;
+	size[1] = mesh->nVerts;
+	memcpy(IDL_MakeTempArray((int)IDL_TYP_FLOAT, 2, size, IDL_ARR_INI_NOP,
+		&oVerts), mesh->verts, (size_t) mesh->nVerts * 3 * sizeof(float));
+
+	if (oPolygons) {
+		size[0] = (IDL_MEMINT) mesh->nTris * 4;
+		polys = (IDL_LONG *) IDL_MakeTempArray((int)IDL_TYP_LONG, 1, size,
+			IDL_ARR_INI_NOP, &oPolys);
+		for (i = 0; i < mesh->nTris; ++i) {
+			polys[i*4] = 3;
+			polys[i*4+1] = mesh->tris[i*3];
+			polys[i*4+2] = mesh->tris[i*3+1];
+			polys[i*4+3] = mesh->tris[i*3+2];
+		}
+		IDL_VarCopy(oPolys, oPolygons);
+	}
+
+	if (oError) {
+		oErr = IDL_Gettmp();
+		oErr->type = IDL_TYP_DOUBLE;
+		oErr->value.d = mesh->error;
+		IDL_VarCopy(oErr, oError);
+	}
+
+	return oVerts;
+
+}
+
+
+int IDL_Load(void)
+{
+
+	static IDL_SYSFUN_DEF2 function_addr[] = {
+		{(IDL_SYSRTN_GENERIC) RHTgrCamera_AABBIntersectFrustum, "RHTGRCAMERA_AABBINTERSECTFRUSTUM", 3, 3, 
+			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
+		{(IDL_SYSRTN_GENERIC) RHTgrCamera_BVHBuild, "RHTGRCAMERA_BVHBUILD", 2, 2, 
+			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
+		{(IDL_SYSRTN_GENERIC) RHTgrCamera_BVHCull, "RHTGRCAMERA_BVHCULL", 2, 2, 
+			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
+		{(IDL_SYSRTN_GENERIC) RHTgrCamera_ComputeFrustum, "RHTGRCAMERA_COMPUTEFRUSTUM", 3, 3, 
+			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
+		{(IDL_SYSRTN_GENERIC) RHTgrCamera_GeodesicMesh, "RHTGRCAMERA_GEODESICMESH", 2, 2, 
+			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
+		{(IDL_SYSRTN_GENERIC) RHTgrCamera_HiZBuild, "RHTGRCAMERA_HIZBUILD", 5, 5, 
+			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
+		{(IDL_SYSRTN_GENERIC) RHTgrCamera_HiZTest, "RHTGRCAMERA_HIZTEST", 3, 3, 
+			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
+		{(IDL_SYSRTN_GENERIC) RHTgrCamera_Transform, "RHTGRCAMERA_TRANSFORM", 3, 3, 0, 0},
+		{(IDL_SYSRTN_GENERIC) RHTgrCamera_VertT3D, "RHTGRCAMERA_VERTT3D", 2, 2, 
+			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
+	};
+
+	static IDL_SYSFUN_DEF2 procedure_addr[] = {
+		{(IDL_SYSRTN_GENERIC) RHTgrCamera_BVHRefit, "RHTGRCAMERA_BVHREFIT", 3, 3,
+			IDL_SYSFUN_DEF_F_KEYWORDS, 0},
 	};
 
-	return IDL_SysRtnAdd(function_addr, TRUE, ARRLEN(function_addr));
+	return IDL_SysRtnAdd(function_addr, TRUE, ARRLEN(function_addr)) &&
+		IDL_SysRtnAdd(procedure_addr, FALSE, ARRLEN(procedure_addr));
 }
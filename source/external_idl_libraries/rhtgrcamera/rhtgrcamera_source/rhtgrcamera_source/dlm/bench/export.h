@@ -0,0 +1,144 @@
+/*
+	export.h
+
+	Minimal stand-in for IDL's export.h used to build the RHTgrCamera and
+	RHTgrAABB DLM sources into the standalone culling benchmark (vfcbench).
+	Only the types, constants and routines used by those two files are
+	declared and the routines are implemented in idlstub.c.  The layouts
+	follow IDL's 64 bit export.h.  Do not use this file to build the DLMs,
+	use the export.h in $(IDL_DIR)/external.
+*/
+
+#ifndef VFCBENCH_EXPORT_H
+#define VFCBENCH_EXPORT_H
+
+#include <stddef.h>
+
+#define IDL_CDECL
+
+#ifndef TRUE
+#define TRUE	1
+#define FALSE	0
+#endif
+
+typedef unsigned char			UCHAR;
+typedef int						IDL_LONG;
+typedef unsigned int			IDL_ULONG;
+typedef long long				IDL_LONG64;
+typedef unsigned long long		IDL_ULONG64;
+typedef IDL_LONG64				IDL_MEMINT;
+
+#define IDL_MAX_ARRAY_DIM		8
+typedef IDL_MEMINT IDL_ARRAY_DIM[IDL_MAX_ARRAY_DIM];
+
+#define IDL_TYP_UNDEF			0
+#define IDL_TYP_BYTE			1
+#define IDL_TYP_INT				2
+#define IDL_TYP_LONG			3
+#define IDL_TYP_FLOAT			4
+#define IDL_TYP_DOUBLE			5
+#define IDL_TYP_UINT			12
+#define IDL_TYP_ULONG			13
+#define IDL_TYP_LONG64			14
+#define IDL_TYP_ULONG64			15
+#define IDL_TYP_MEMINT			IDL_TYP_LONG64
+
+#define IDL_V_TEMP				2
+#define IDL_V_ARR				4
+
+#define IDL_ARR_INI_ZERO		0
+#define IDL_ARR_INI_NOP			1
+
+typedef struct {
+	IDL_MEMINT		elt_len;
+	IDL_MEMINT		arr_len;
+	IDL_MEMINT		n_elts;
+	UCHAR			*data;
+	UCHAR			n_dim;
+	UCHAR			flags;
+	short			file_unit;
+	IDL_ARRAY_DIM	dim;
+} IDL_ARRAY;
+
+typedef union {
+	char			sc;
+	UCHAR			c;
+	short			i;
+	unsigned short	ui;
+	IDL_LONG		l;
+	IDL_ULONG		ul;
+	float			f;
+	double			d;
+	IDL_LONG64		l64;
+	IDL_ULONG64		ul64;
+	IDL_ARRAY		*arr;
+} IDL_ALLTYPES;
+
+typedef struct {
+	UCHAR			type;
+	UCHAR			flags;
+	IDL_ALLTYPES	value;
+} IDL_VARIABLE;
+
+typedef IDL_VARIABLE *IDL_VPTR;
+
+typedef void (*IDL_SYSRTN_GENERIC)();
+
+typedef struct {
+	IDL_SYSRTN_GENERIC	funct_addr;
+	char				*name;
+	unsigned short		arg_min;
+	unsigned short		arg_max;
+	int					flags;
+	void				*extra;
+} IDL_SYSFUN_DEF2;
+
+#define IDL_SYSFUN_DEF_F_KEYWORDS	1
+
+typedef struct {
+	char			*keyword;
+	UCHAR			type;
+	unsigned short	mask;
+	unsigned short	flags;
+	int				*specified;
+	char			*value;
+} IDL_KW_PAR;
+
+#define IDL_KW_ARRAY			(1 << 12)
+#define IDL_KW_OUT				(1 << 13)
+#define IDL_KW_VIN				(IDL_KW_OUT | IDL_KW_ARRAY)
+#define IDL_KW_ZERO				(1 << 14)
+
+#define IDL_KW_MARK				1
+#define IDL_KW_CLEAN			2
+
+#define IDL_CHARA(x)			((char *) &(x))
+
+#define IDL_M_NAMED_GENERIC		-2
+#define IDL_MSG_LONGJMP			2
+#define IDL_MSG_INFO			5
+
+#define IDL_ENSURE_ARRAY(v)		if (!((v)->flags & IDL_V_ARR)) \
+	IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP, "Expression must be an array.")
+#define IDL_ENSURE_SCALAR(v)	if ((v)->flags & IDL_V_ARR) \
+	IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP, "Expression must be a scalar.")
+#define IDL_EXCLUDE_EXPR(v)
+
+char *IDL_MakeTempArray(int type, int n_dim, IDL_MEMINT dim[], int init,
+	IDL_VPTR *var);
+IDL_VPTR IDL_Gettmp(void);
+IDL_VPTR IDL_GettmpInt(short value);
+IDL_VPTR IDL_GettmpLong(IDL_LONG value);
+IDL_VPTR IDL_GettmpMEMINT(IDL_MEMINT value);
+void IDL_Deltmp(IDL_VPTR p);
+void IDL_VarCopy(IDL_VPTR src, IDL_VPTR dst);
+IDL_VPTR IDL_BasicTypeConversion(int argc, IDL_VPTR argv[], int type);
+double IDL_DoubleScalar(IDL_VPTR p);
+IDL_LONG IDL_LongScalar(IDL_VPTR p);
+int IDL_KWGetParams(int argc, IDL_VPTR *argv, char *argk,
+	IDL_KW_PAR *kw_list, IDL_VPTR plain_args[], int mask);
+void IDL_KWCleanup(int fcn);
+void IDL_Message(int code, int action, ...);
+int IDL_SysRtnAdd(IDL_SYSFUN_DEF2 *defs, int is_function, int cnt);
+
+#endif
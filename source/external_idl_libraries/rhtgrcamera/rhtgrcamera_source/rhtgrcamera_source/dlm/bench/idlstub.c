@@ -0,0 +1,351 @@
+/*
+	idlstub.c
+
+	Just enough of the IDL runtime to call the RHTgrCamera and RHTgrAABB
+	DLM entry points from a C program.  Variables are heap allocated, a
+	temporary owns its array until it is freed by IDL_Deltmp or handed
+	to a named variable by IDL_VarCopy.  IDL_Message prints the message
+	and exits when asked to longjmp.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "idlstub.h"
+
+
+static int stub_typesize(int type)
+{
+	switch (type) {
+		case IDL_TYP_BYTE: return 1;
+		case IDL_TYP_INT: case IDL_TYP_UINT: return 2;
+		case IDL_TYP_LONG: case IDL_TYP_ULONG: case IDL_TYP_FLOAT: return 4;
+		case IDL_TYP_DOUBLE: case IDL_TYP_LONG64: case IDL_TYP_ULONG64: return 8;
+	}
+	return 0;
+}
+
+
+static void *stub_alloc(size_t n)
+{
+	void		*p;
+
+	p = calloc(1, n ? n : 1);
+	if (!p) {
+		fprintf(stderr, "idlstub: out of memory\n");
+		exit(1);
+	}
+	return p;
+}
+
+
+static double stub_get(int type, const void *p, IDL_MEMINT i)
+{
+	switch (type) {
+		case IDL_TYP_BYTE: return ((UCHAR *) p)[i];
+		case IDL_TYP_INT: return ((short *) p)[i];
+		case IDL_TYP_UINT: return ((unsigned short *) p)[i];
+		case IDL_TYP_LONG: return ((IDL_LONG *) p)[i];
+		case IDL_TYP_ULONG: return ((IDL_ULONG *) p)[i];
+		case IDL_TYP_FLOAT: return ((float *) p)[i];
+		case IDL_TYP_DOUBLE: return ((double *) p)[i];
+		case IDL_TYP_LONG64: return (double) ((IDL_LONG64 *) p)[i];
+		case IDL_TYP_ULONG64: return (double) ((IDL_ULONG64 *) p)[i];
+	}
+	IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+		"idlstub: unsupported type.");
+	return 0.;
+}
+
+
+static void stub_put(int type, void *p, IDL_MEMINT i, double v)
+{
+	switch (type) {
+		case IDL_TYP_BYTE: ((UCHAR *) p)[i] = (UCHAR) v; break;
+		case IDL_TYP_INT: ((short *) p)[i] = (short) v; break;
+		case IDL_TYP_UINT: ((unsigned short *) p)[i] = (unsigned short) v; break;
+		case IDL_TYP_LONG: ((IDL_LONG *) p)[i] = (IDL_LONG) v; break;
+		case IDL_TYP_ULONG: ((IDL_ULONG *) p)[i] = (IDL_ULONG) v; break;
+		case IDL_TYP_FLOAT: ((float *) p)[i] = (float) v; break;
+		case IDL_TYP_DOUBLE: ((double *) p)[i] = v; break;
+		case IDL_TYP_LONG64: ((IDL_LONG64 *) p)[i] = (IDL_LONG64) v; break;
+		case IDL_TYP_ULONG64: ((IDL_ULONG64 *) p)[i] = (IDL_ULONG64) v; break;
+		default:
+			IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+				"idlstub: unsupported type.");
+	}
+}
+
+
+static void stub_release(IDL_VPTR var)
+{
+	if (var->flags & IDL_V_ARR) {
+		free(var->value.arr->data);
+		free(var->value.arr);
+	}
+	var->type = IDL_TYP_UNDEF;
+	var->flags = 0;
+}
+
+
+char *IDL_MakeTempArray(int type, int n_dim, IDL_MEMINT dim[], int init,
+	IDL_VPTR *var)
+{
+	int			n;
+	IDL_ARRAY	*arr;
+	IDL_VPTR	v;
+
+	arr = (IDL_ARRAY *) stub_alloc(sizeof(IDL_ARRAY));
+	arr->elt_len = stub_typesize(type);
+	arr->n_elts = 1;
+	arr->n_dim = (UCHAR) n_dim;
+	for (n = 0; n < IDL_MAX_ARRAY_DIM; ++n)
+		arr->dim[n] = (n < n_dim) ? dim[n] : 1;
+	for (n = 0; n < n_dim; ++n)
+		arr->n_elts *= dim[n];
+	arr->arr_len = arr->n_elts * arr->elt_len;
+
+	/*  calloc for both init modes, NOP data is never read before it is
+		written by the DLM. */
+	(void) init;
+	arr->data = (UCHAR *) stub_alloc((size_t) arr->arr_len);
+
+	v = IDL_Gettmp();
+	v->type = (UCHAR) type;
+	v->flags = IDL_V_TEMP | IDL_V_ARR;
+	v->value.arr = arr;
+	*var = v;
+
+	return (char *) arr->data;
+}
+
+
+IDL_VPTR IDL_Gettmp(void)
+{
+	IDL_VPTR	v;
+
+	v = (IDL_VPTR) stub_alloc(sizeof(IDL_VARIABLE));
+	v->flags = IDL_V_TEMP;
+	return v;
+}
+
+
+IDL_VPTR IDL_GettmpInt(short value)
+{
+	IDL_VPTR	v = IDL_Gettmp();
+
+	v->type = IDL_TYP_INT;
+	v->value.i = value;
+	return v;
+}
+
+
+IDL_VPTR IDL_GettmpLong(IDL_LONG value)
+{
+	IDL_VPTR	v = IDL_Gettmp();
+
+	v->type = IDL_TYP_LONG;
+	v->value.l = value;
+	return v;
+}
+
+
+IDL_VPTR IDL_GettmpMEMINT(IDL_MEMINT value)
+{
+	IDL_VPTR	v = IDL_Gettmp();
+
+	v->type = IDL_TYP_MEMINT;
+	v->value.l64 = value;
+	return v;
+}
+
+
+void IDL_Deltmp(IDL_VPTR p)
+{
+	if (!p || !(p->flags & IDL_V_TEMP)) return;
+	stub_release(p);
+	free(p);
+}
+
+
+void IDL_VarCopy(IDL_VPTR src, IDL_VPTR dst)
+{
+	IDL_VPTR	copy;
+
+	if (src == dst) return;
+	if (!(src->flags & IDL_V_TEMP)) {
+		/*  Copying a named variable duplicates its array. */
+		if (src->flags & IDL_V_ARR) {
+			memcpy(IDL_MakeTempArray(src->type, src->value.arr->n_dim,
+				src->value.arr->dim, IDL_ARR_INI_NOP, &copy),
+				src->value.arr->data, (size_t) src->value.arr->arr_len);
+		} else {
+			copy = IDL_Gettmp();
+			copy->type = src->type;
+			copy->value = src->value;
+		}
+		src = copy;
+	}
+
+	stub_release(dst);
+	dst->type = src->type;
+	dst->flags = src->flags & ~IDL_V_TEMP;
+	dst->value = src->value;
+	free(src);
+}
+
+
+IDL_VPTR IDL_BasicTypeConversion(int argc, IDL_VPTR argv[], int type)
+{
+	IDL_MEMINT	i, n;
+	char		*pOut;
+	void		*pIn;
+	IDL_VPTR	src = argv[0], dst;
+
+	(void) argc;
+	if (src->type == type) return src;
+
+	if (src->flags & IDL_V_ARR) {
+		pOut = IDL_MakeTempArray(type, src->value.arr->n_dim,
+			src->value.arr->dim, IDL_ARR_INI_NOP, &dst);
+		pIn = src->value.arr->data;
+		n = src->value.arr->n_elts;
+	} else {
+		dst = IDL_Gettmp();
+		dst->type = (UCHAR) type;
+		pOut = (char *) &dst->value;
+		pIn = &src->value;
+		n = 1;
+	}
+
+	for (i = 0; i < n; ++i)
+		stub_put(type, pOut, i, stub_get(src->type, pIn, i));
+
+	return dst;
+}
+
+
+double IDL_DoubleScalar(IDL_VPTR p)
+{
+	if (p->flags & IDL_V_ARR)
+		IDL_Message(IDL_M_NAMED_GENERIC, IDL_MSG_LONGJMP,
+			"Expression must be a scalar.");
+	return stub_get(p->type, &p->value, 0);
+}
+
+
+IDL_LONG IDL_LongScalar(IDL_VPTR p)
+{
+	return (IDL_LONG) IDL_DoubleScalar(p);
+}
+
+
+int IDL_KWGetParams(int argc, IDL_VPTR *argv, char *argk,
+	IDL_KW_PAR *kw_list, IDL_VPTR plain_args[], int mask)
+{
+	int			n;
+	STUB_KW		*kw;
+	IDL_KW_PAR	*par;
+
+	(void) mask;
+	for (n = 0; n < argc; ++n)
+		plain_args[n] = argv[n];
+
+	for (par = kw_list; par->keyword; ++par) {
+
+		if (par->flags & IDL_KW_ZERO) {
+			if (par->flags & IDL_KW_OUT)
+				*(IDL_VPTR *) par->value = NULL;
+			else
+				memset(par->value, 0, stub_typesize(par->type));
+		}
+		if (par->specified) *par->specified = 0;
+
+		for (kw = (STUB_KW *) argk; kw && kw->name; ++kw)
+			if (!strcmp(kw->name, par->keyword)) break;
+		if (!kw || !kw->name) continue;
+
+		if (par->specified) *par->specified = 1;
+		if (par->flags & IDL_KW_OUT) {
+			/*  VIN keywords must be defined, OUT keywords may be
+				undefined named variables. */
+			if ((par->flags & IDL_KW_VIN) == IDL_KW_VIN &&
+				kw->value->type == IDL_TYP_UNDEF) continue;
+			*(IDL_VPTR *) par->value = kw->value;
+		} else {
+			stub_put(par->type, par->value, 0, IDL_DoubleScalar(kw->value));
+		}
+	}
+
+	return argc;
+}
+
+
+void IDL_KWCleanup(int fcn)
+{
+	(void) fcn;
+}
+
+
+void IDL_Message(int code, int action, ...)
+{
+	va_list		ap;
+
+	va_start(ap, action);
+	if (code == IDL_M_NAMED_GENERIC)
+		fprintf(stderr, "%s\n", va_arg(ap, char *));
+	else
+		fprintf(stderr, "IDL message %d\n", code);
+	va_end(ap);
+
+	if (action == IDL_MSG_LONGJMP) exit(1);
+}
+
+
+int IDL_SysRtnAdd(IDL_SYSFUN_DEF2 *defs, int is_function, int cnt)
+{
+	(void) defs;
+	(void) is_function;
+	(void) cnt;
+	return TRUE;
+}
+
+
+/*  Return a named (non temporary) variable holding an array.  If data is
+	not NULL it is set to the zeroed array data. */
+IDL_VPTR stub_array(int type, int n_dim, IDL_MEMINT d0, IDL_MEMINT d1,
+	IDL_MEMINT d2, void **data)
+{
+	char		*p;
+	IDL_MEMINT	dim[3];
+	IDL_VPTR	v;
+
+	dim[0] = d0;
+	dim[1] = d1;
+	dim[2] = d2;
+	p = IDL_MakeTempArray(type, n_dim, dim, IDL_ARR_INI_ZERO, &v);
+	v->flags &= ~IDL_V_TEMP;
+	if (data) *data = p;
+	return v;
+}
+
+
+IDL_VPTR stub_long(IDL_LONG value)
+{
+	IDL_VPTR	v = IDL_GettmpLong(value);
+
+	v->flags &= ~IDL_V_TEMP;
+	return v;
+}
+
+
+/*  Free a named variable returned by stub_array or stub_long or a result
+	returned by a DLM function. */
+void stub_free(IDL_VPTR var)
+{
+	if (!var) return;
+	stub_release(var);
+	free(var);
+}
@@ -0,0 +1,24 @@
+/*
+	idlstub.h
+
+	Helpers provided by idlstub.c for calling the DLM entry points from C.
+	Keywords are passed to the entry points as a NULL terminated array of
+	STUB_KW cast to char * in place of IDL's argk.
+*/
+
+#ifndef VFCBENCH_IDLSTUB_H
+#define VFCBENCH_IDLSTUB_H
+
+#include "export.h"
+
+typedef struct {
+	char			*name;
+	IDL_VPTR		value;
+} STUB_KW;
+
+IDL_VPTR stub_array(int type, int n_dim, IDL_MEMINT d0, IDL_MEMINT d1,
+	IDL_MEMINT d2, void **data);
+IDL_VPTR stub_long(IDL_LONG value);
+void stub_free(IDL_VPTR var);
+
+#endif
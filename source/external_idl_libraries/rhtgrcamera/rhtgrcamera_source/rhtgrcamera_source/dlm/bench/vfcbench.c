@@ -0,0 +1,730 @@
+/*
+; NAME:
+;       vfcbench.c
+;
+; PURPOSE:
+;
+;       Standalone benchmark of the view frustum culling kernels in the
+;       RHTgrCamera and RHTgrAABB DLMs.  The DLM sources are compiled in
+;       directly and called thru a small stand-in for the IDL runtime
+;       (export.h, idlstub.c) so IDL is not required to run it.
+;
+;       The "Swarm of Orbs" test described in docs/RHTgrCamera_VFCperf.html
+;       and run by demos/camdemo_vfcbench.pro is recreated: a uniformly
+;       distributed cloud of objects is created and the camera is moved
+;       from one end of the cloud, thru the middle, to the other end.
+;       Four scenarios are run for each object count:
+;
+;           objects-static      Boxes are placed once, a BVH is built in
+;                               world space and culled every frame.
+;           objects-dynamic     Every object moves and turns each frame.
+;                               The boxes are recalculated from the data
+;                               ranges (RHTgrAABB_CalcBBArray) and the BVH
+;                               is refit before it is culled.
+;           objects-sparse      As objects-dynamic but only one object in
+;                               a hundred moves.  The moved objects are
+;                               passed to the refit (INDICES) so only the
+;                               BVH nodes above them are visited.
+;           triangles-static    Every object is a geodesic sphere mesh.
+;                               Tight boxes are calculated from the world
+;                               space vertices once (RHTgrAABB_VertexBB).
+;           triangles-dynamic   As triangles-static but the meshes move
+;                               and the boxes are recalculated from the
+;                               vertices and per mesh transforms each frame.
+;
+;       For every frame the view space boxes are also tested one by one
+;       (RHTgrCamera_AABBIntersectFrustum) for comparison with the BVH.
+;       A few walls are rasterized as occluders (RHTgrCamera_HiZBuild)
+;       and the visible set of the BVH, after the occlusion test of the
+;       world space boxes thru the camera transform, is compared with
+;       that of the one by one test after the occlusion test of the view
+;       space boxes, as RHTgrCamera tests its static and dynamic models.
+;       Any difference is reported and vfcbench exits with status 1.
+;       The occlusion tests are not timed.
+;
+;
+; CALLING SEQUENCE:
+;
+;       vfcbench [-s scenario] [-N counts] [-n steps] [-l level]
+;                [-f csv|json] [-o file]
+;
+;           -s  objects-static, objects-dynamic, objects-sparse,
+;               triangles-static, triangles-dynamic or all (the
+;               default).
+;           -N  comma separated object counts.  The default is
+;               100,1000,10000,100000,1000000 for the object scenarios
+;               and 100,1000,10000,100000 for the triangle scenarios.
+;           -n  number of camera positions.  Default is 50.
+;           -l  subdivision level of the icosahedron used for the
+;               triangle scenarios (0 thru 8).  Default is 2 (320
+;               triangles).
+;           -f  output format, csv (the default) or json.
+;           -o  write the results to file instead of stdout.
+;
+;       A table of the results is printed to stderr as the tests run.
+;       Times are in milliseconds.  setup_ms is the time to calculate the
+;       initial boxes and build the BVH, bounds_ms, brute_ms and bvh_ms
+;       are the mean times per frame to calculate the boxes (dynamic
+;       scenarios only), move every box to view space and test it, and
+;       refit (dynamic scenarios only) and cull the BVH.  The BVH is kept
+;       in world space and culled thru the camera transform so it does
+;       not need the view space boxes.
+;
+;
+; MODIFICATION HISTORY:
+;       Written to accompany the BVH, occlusion and LOD additions to the
+;       RHTgrCamera DLM.
+;
+;
+; LICENSE
+;
+;   This program is free software; you can redistribute it and/or
+;   modify it under the terms of the GNU General Public License
+;   as published by the Free Software Foundation; either version 2
+;   of the License, or (at your option) any later version.
+;
+;   This program is distributed in the hope that it will be useful,
+;   but WITHOUT ANY WARRANTY; without even the implied warranty of
+;   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+;   GNU General Public License for more details.
+;
+;   You should have received a copy of the GNU General Public License
+;   along with this program; if not, write to the Free Software
+;   Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+;   02111-1307, USA.
+;
+;   A full copy of the GNU General Public License can be found on
+;   line at http://www.gnu.org/copyleft/gpl.html#SEC1
+;
+;-
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "idlstub.h"
+
+/*  DLM entry points. */
+IDL_VPTR IDL_CDECL RHTgrCamera_Transform(int argc, IDL_VPTR *argv);
+IDL_VPTR IDL_CDECL RHTgrCamera_ComputeFrustum(int argc, IDL_VPTR *argv, char *argk);
+IDL_VPTR IDL_CDECL RHTgrCamera_AABBIntersectFrustum(int argc, IDL_VPTR *argv, char *argk);
+IDL_VPTR IDL_CDECL RHTgrCamera_BVHBuild(int argc, IDL_VPTR *argv, char *argk);
+IDL_VPTR IDL_CDECL RHTgrCamera_BVHCull(int argc, IDL_VPTR *argv, char *argk);
+void IDL_CDECL RHTgrCamera_BVHRefit(int argc, IDL_VPTR *argv, char *argk);
+IDL_VPTR IDL_CDECL RHTgrCamera_HiZBuild(int argc, IDL_VPTR *argv, char *argk);
+IDL_VPTR IDL_CDECL RHTgrCamera_HiZTest(int argc, IDL_VPTR *argv, char *argk);
+IDL_VPTR IDL_CDECL RHTgrCamera_GeodesicMesh(int argc, IDL_VPTR *argv, char *argk);
+IDL_VPTR IDL_CDECL RHTgrAABB_CalcBBArray(int argc, IDL_VPTR *argv, char *argk);
+IDL_VPTR IDL_CDECL RHTgrAABB_VertexBB(int argc, IDL_VPTR *argv, char *argk);
+
+#define SCN_DYNAMIC		1
+#define SCN_TRIANGLES	2
+#define SCN_SPARSE		4
+
+static const struct {
+	char		*name;
+	int			flags;
+} scenarios[] = {
+	{"objects-static", 0},
+	{"objects-dynamic", SCN_DYNAMIC},
+	{"objects-sparse", SCN_DYNAMIC | SCN_SPARSE},
+	{"triangles-static", SCN_TRIANGLES},
+	{"triangles-dynamic", SCN_TRIANGLES | SCN_DYNAMIC}
+};
+#define N_SCENARIOS		(int) (sizeof(scenarios) / sizeof(scenarios[0]))
+
+static const IDL_MEMINT defObjects[] = {100, 1000, 10000, 100000, 1000000};
+static const IDL_MEMINT defTriObjects[] = {100, 1000, 10000, 100000};
+
+typedef struct {
+	const char	*scenario;
+	IDL_MEMINT	nObjects;
+	IDL_LONG	nTris;
+	int			nFrames;
+	double		visible;
+	double		visibleTris;
+	double		setupMs;
+	double		boundsMs;
+	double		bruteMs;
+	double		bvhMs;
+	double		bvhMinMs;
+	double		saved;
+	IDL_MEMINT	mismatches;
+} RESULT;
+
+/*  Occluders: walls across the cloud, facing the camera. */
+static const double occLoc[][3] = {
+	{-12., 20., 60.}, {12., 35., 20.}, {0., 15., -20.}, {-10., 30., -60.}
+};
+static const double occExt[][3] = {
+	{10., 15., 1.}, {8., 12., 1.}, {15., 8., 1.}, {12., 18., 1.}
+};
+#define N_OCCLUDERS		(int) (sizeof(occLoc) / sizeof(occLoc[0]))
+
+
+static double bench_ms(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER	f, c;
+
+	QueryPerformanceFrequency(&f);
+	QueryPerformanceCounter(&c);
+	return 1000. * (double) c.QuadPart / (double) f.QuadPart;
+#else
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return 1000. * (double) ts.tv_sec + 1e-6 * (double) ts.tv_nsec;
+#endif
+}
+
+
+/*  Small LCG so every platform generates the same cloud. */
+static double bench_rand(unsigned long long *seed)
+{
+	*seed = *seed * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (double) (*seed >> 11) / 9007199254740992.;
+}
+
+
+/*  Model transform of object i in frame s: scale, turn about y and
+	translate.  Dynamic objects bob up and down as they turn. */
+static void bench_model(double *t, const double *loc, double scale,
+	double phase, int s, int dynamic)
+{
+	double		a, c, sn;
+
+	a = dynamic ? phase + 0.05 * s : 0.;
+	c = cos(a) * scale;
+	sn = sin(a) * scale;
+
+	memset(t, 0, 16 * sizeof(double));
+	t[0] = c;
+	t[2] = sn;
+	t[3] = loc[0];
+	t[5] = scale;
+	t[7] = loc[1] + (dynamic ? 5. * sin(phase + 0.1 * s) : 0.);
+	t[8] = -sn;
+	t[10] = c;
+	t[11] = loc[2];
+	t[15] = 1.;
+}
+
+
+/*  Convert boxes in the form returned by RHTgrAABB_CalcBB to centers and
+	half widths. */
+static void bench_boxes(const double *box, IDL_MEMINT n, double *loc,
+	double *ext)
+{
+	int			k;
+	IDL_MEMINT	i;
+
+	for (i = 0; i < n; ++i) {
+		for (k = 0; k < 3; ++k) {
+			loc[i*3+k] = 0.5 * (box[i*9+k] + box[i*9+k+3]);
+			ext[i*3+k] = 0.5 * (box[i*9+k+3] - box[i*9+k]);
+		}
+	}
+}
+
+
+static void bench_run(int scn, IDL_MEMINT nObj, int level, int nSteps,
+	RESULT *r)
+{
+	int				s, k, dynamic, triangles, sparse;
+	IDL_LONG		nVerts = 0, *counts = NULL;
+	IDL_MEMINT		i, nVisible;
+	IDL_LONG64		*pStats, stats[5];
+	double			t0, t1, dt, eye, zclip[2], fov[2], *rot, *camLoc;
+	double			*cloud, *radius, *phase, *loc, *ext, *vLoc, *vExt, *t;
+	double			*ranges = NULL, *conv = NULL, *trans = NULL;
+	float			*mesh = NULL, *verts = NULL;
+	IDL_VPTR		oZclip, oFov, oEye, oPlanes, oFrustum, oRot, oCamLoc;
+	IDL_VPTR		oViewZ, oLoc, oExt, oVLoc, oVExt, oBVH = NULL, oTrans = NULL;
+	IDL_VPTR		oRanges = NULL, oConv = NULL, oVerts = NULL;
+	IDL_VPTR		oCounts = NULL, oMesh, oBoxes, oT, oRes, argv[5];
+	IDL_VPTR		oMoved = NULL, oOccLoc, oOccExt, oHiz, oBMask;
+	IDL_MEMINT		*moved, nDiff, first;
+	UCHAR			*bMask, *cMask;
+	short			*inView;
+	double			*occ;
+	IDL_VARIABLE	cMaskVar;
+	IDL_VARIABLE	cache, count, vstats;
+	unsigned long long	seed = 1;
+
+	dynamic = (scenarios[scn].flags & SCN_DYNAMIC) != 0;
+	triangles = (scenarios[scn].flags & SCN_TRIANGLES) != 0;
+	sparse = (scenarios[scn].flags & SCN_SPARSE) != 0;
+	memset(r, 0, sizeof(RESULT));
+	memset(stats, 0, sizeof(stats));
+	r->scenario = scenarios[scn].name;
+	r->nObjects = nObj;
+	r->nFrames = nSteps;
+	r->bvhMinMs = HUGE_VAL;
+
+	/*  Camera.  The same view as camdemo_vfcbench: FRUSTUM_DIMS of
+		[120,120,400], ZERROR of 8 and the default orientation. */
+	zclip[0] = 200.;
+	zclip[1] = -200.;
+	eye = zclip[0] + (zclip[0] * zclip[0] + 8. * zclip[0]) / (65536. * 8.);
+	fov[0] = fov[1] = atan(60. / eye);
+	oZclip = stub_array(IDL_TYP_DOUBLE, 1, 2, 0, 0, (void **) &t);
+	memcpy(t, zclip, sizeof(zclip));
+	oFov = stub_array(IDL_TYP_DOUBLE, 1, 2, 0, 0, (void **) &t);
+	memcpy(t, fov, sizeof(fov));
+	oEye = IDL_Gettmp();
+	oEye->flags = 0;
+	oEye->type = IDL_TYP_DOUBLE;
+	oEye->value.d = eye;
+	oPlanes = IDL_Gettmp();
+	oPlanes->flags = 0;
+	{
+		STUB_KW		kw[] = {{"PLANES", NULL}, {NULL, NULL}};
+
+		kw[0].value = oPlanes;
+		argv[0] = oZclip;
+		argv[1] = oFov;
+		argv[2] = oEye;
+		oFrustum = RHTgrCamera_ComputeFrustum(3, argv, (char *) kw);
+		stub_free(oFrustum);
+	}
+	oRot = stub_array(IDL_TYP_DOUBLE, 2, 4, 4, 0, (void **) &rot);
+	rot[0] = rot[5] = rot[10] = rot[15] = 1.;
+	oCamLoc = stub_array(IDL_TYP_DOUBLE, 1, 3, 0, 0, (void **) &camLoc);
+	oViewZ = oEye;
+
+	/*  The cloud.  Objects are sprinkled about the same volume as the orbs
+		in camdemo_cullnfly. */
+	cloud = (double *) malloc((size_t) nObj * 3 * sizeof(double));
+	radius = (double *) malloc((size_t) nObj * sizeof(double));
+	phase = (double *) malloc((size_t) nObj * sizeof(double));
+	for (i = 0; i < nObj; ++i) {
+		cloud[i*3] = (bench_rand(&seed) - 0.5) * 50.;
+		cloud[i*3+1] = bench_rand(&seed) * 50.;
+		cloud[i*3+2] = (bench_rand(&seed) - 0.5) * 150.;
+	}
+	for (i = 0; i < nObj; ++i) {
+		radius[i] = (bench_rand(&seed) + 1.) * 2.;
+		phase[i] = bench_rand(&seed) * 6.283185307179586;
+	}
+
+	oLoc = stub_array(IDL_TYP_DOUBLE, 2, 3, nObj, 0, (void **) &loc);
+	oExt = stub_array(IDL_TYP_DOUBLE, 2, 3, nObj, 0, (void **) &ext);
+	oVLoc = stub_array(IDL_TYP_DOUBLE, 2, 3, nObj, 0, (void **) &vLoc);
+	oVExt = stub_array(IDL_TYP_DOUBLE, 2, 3, nObj, 0, (void **) &vExt);
+
+	if (triangles) {
+		/*  Every object is a geodesic sphere. */
+		argv[0] = stub_long(20);
+		argv[1] = stub_long(level);
+		oMesh = RHTgrCamera_GeodesicMesh(2, argv, NULL);
+		stub_free(argv[0]);
+		stub_free(argv[1]);
+		nVerts = (IDL_LONG) (oMesh->value.arr->n_elts / 3);
+		mesh = (float *) oMesh->value.arr->data;
+		r->nTris = 20 << (2 * level);
+
+		oVerts = stub_array(IDL_TYP_FLOAT, 2, 3, nObj * nVerts, 0,
+			(void **) &verts);
+		oCounts = stub_array(IDL_TYP_LONG, 1, nObj, 0, 0, (void **) &counts);
+		for (i = 0; i < nObj; ++i)
+			counts[i] = nVerts;
+		if (dynamic) {
+			/*  Dynamic meshes are stored in model space and boxed thru
+				their transforms. */
+			for (i = 0; i < nObj; ++i)
+				memcpy(verts + i * nVerts * 3, mesh, (size_t) nVerts * 3 *
+					sizeof(float));
+		} else {
+			for (i = 0; i < nObj; ++i) {
+				for (k = 0; k < nVerts * 3; ++k)
+					verts[i*nVerts*3+k] = (float) (mesh[k] * radius[i] +
+						cloud[i*3+k%3]);
+			}
+		}
+		stub_free(oMesh);
+	} else if (dynamic) {
+		/*  Dynamic objects are boxed from their data ranges. */
+		oRanges = stub_array(IDL_TYP_DOUBLE, 3, 2, 3, nObj, (void **) &ranges);
+		oConv = stub_array(IDL_TYP_DOUBLE, 3, 2, 3, nObj, (void **) &conv);
+		for (i = 0; i < nObj; ++i) {
+			for (k = 0; k < 3; ++k) {
+				ranges[i*6+k*2] = -radius[i];
+				ranges[i*6+k*2+1] = radius[i];
+				conv[i*6+k*2+1] = 1.;
+			}
+		}
+	}
+	if (dynamic)
+		oTrans = stub_array(IDL_TYP_DOUBLE, 3, 4, 4, nObj, (void **) &trans);
+	if (sparse) {
+		/*  The objects that move, as the caller of the refit knows them. */
+		oMoved = stub_array(IDL_TYP_MEMINT, 1, (nObj + 99) / 100, 0, 0,
+			(void **) &moved);
+		for (i = 0; i < nObj; i += 100)
+			moved[i/100] = i;
+	}
+
+	oOccLoc = stub_array(IDL_TYP_DOUBLE, 2, 3, N_OCCLUDERS, 0, (void **) &occ);
+	memcpy(occ, occLoc, sizeof(occLoc));
+	oOccExt = stub_array(IDL_TYP_DOUBLE, 2, 3, N_OCCLUDERS, 0, (void **) &occ);
+	memcpy(occ, occExt, sizeof(occExt));
+	oBMask = stub_array(IDL_TYP_BYTE, 1, nObj, 0, 0, (void **) &bMask);
+
+	memset(&cache, 0, sizeof(cache));
+	memset(&cMaskVar, 0, sizeof(cMaskVar));
+	memset(&count, 0, sizeof(count));
+	memset(&vstats, 0, sizeof(vstats));
+
+	for (s = -1; s < nSteps; ++s) {
+
+		/*  Frame -1 is the setup: the initial boxes and the BVH build.
+			Dynamic scenarios recalculate the boxes every frame. */
+		if (s < 0 || dynamic) {
+			if (dynamic) {
+				for (i = 0; i < nObj; ++i)
+					bench_model(trans + i * 16, cloud + i * 3, triangles ?
+						radius[i] : 1., phase[i], s < 0 ? 0 : s,
+						!sparse || i % 100 == 0);
+			}
+			t1 = bench_ms();
+			if (triangles) {
+				STUB_KW		kw[] = {{"COUNTS", NULL}, {"TRANSFORM", NULL},
+					{NULL, NULL}};
+
+				kw[0].value = oCounts;
+				if (dynamic) kw[1].value = oTrans;
+				else kw[1].name = NULL;
+				argv[0] = oVerts;
+				oBoxes = RHTgrAABB_VertexBB(1, argv, (char *) kw);
+				bench_boxes((double *) oBoxes->value.arr->data, nObj, loc, ext);
+				stub_free(oBoxes);
+			} else if (dynamic) {
+				argv[0] = oRanges;
+				argv[1] = oConv;
+				argv[2] = oTrans;
+				oBoxes = RHTgrAABB_CalcBBArray(3, argv, NULL);
+				bench_boxes((double *) oBoxes->value.arr->data, nObj, loc, ext);
+				stub_free(oBoxes);
+			} else {
+				for (i = 0; i < nObj; ++i) {
+					for (k = 0; k < 3; ++k) {
+						loc[i*3+k] = cloud[i*3+k];
+						ext[i*3+k] = radius[i];
+					}
+				}
+			}
+			dt = bench_ms() - t1;
+
+			if (s < 0) {
+				t1 = bench_ms();
+				argv[0] = oLoc;
+				argv[1] = oExt;
+				oBVH = RHTgrCamera_BVHBuild(2, argv, NULL);
+				oBVH->flags &= ~IDL_V_TEMP;
+				r->setupMs = dt + bench_ms() - t1;
+				continue;
+			}
+			r->boundsMs += dt;
+		}
+
+		/*  The camera moves thru the cloud along the z axis. */
+		camLoc[0] = 0.;
+		camLoc[1] = 10.;
+		camLoc[2] = 130. - 260. * s / (nSteps > 1 ? nSteps - 1 : 1);
+		argv[0] = oRot;
+		argv[1] = oCamLoc;
+		argv[2] = oViewZ;
+		oT = RHTgrCamera_Transform(3, argv);
+		oT->flags &= ~IDL_V_TEMP;
+		t = (double *) oT->value.arr->data;
+
+		/*  View space boxes for the one by one test. */
+		t0 = bench_ms();
+		for (i = 0; i < nObj; ++i) {
+			for (k = 0; k < 3; ++k) {
+				vLoc[i*3+k] = t[k*4] * loc[i*3] + t[k*4+1] * loc[i*3+1] +
+					t[k*4+2] * loc[i*3+2] + t[k*4+3];
+				vExt[i*3+k] = fabs(t[k*4]) * ext[i*3] +
+					fabs(t[k*4+1]) * ext[i*3+1] + fabs(t[k*4+2]) * ext[i*3+2];
+			}
+		}
+
+		argv[0] = oVLoc;
+		argv[1] = oVExt;
+		argv[2] = oPlanes;
+		oRes = RHTgrCamera_AABBIntersectFrustum(3, argv, NULL);
+		r->bruteMs += bench_ms() - t0;
+		inView = (short *) oRes->value.arr->data;
+		for (i = 0; i < nObj; ++i)
+			bMask[i] = (UCHAR) (inView[i] != 0);
+		stub_free(oRes);
+
+		t0 = bench_ms();
+		if (dynamic) {
+			argv[0] = oBVH;
+			argv[1] = oLoc;
+			argv[2] = oExt;
+			if (sparse) {
+				STUB_KW		kw[] = {{"INDICES", NULL}, {NULL, NULL}};
+
+				kw[0].value = oMoved;
+				RHTgrCamera_BVHRefit(3, argv, (char *) kw);
+			} else
+				RHTgrCamera_BVHRefit(3, argv, NULL);
+		}
+		{
+			STUB_KW		kw[] = {{"CACHE", NULL}, {"COUNT", NULL},
+				{"MASK", NULL}, {"STATS", NULL}, {"TRANSFORM", NULL},
+				{NULL, NULL}};
+
+			kw[0].value = &cache;
+			kw[1].value = &count;
+			kw[2].value = &cMaskVar;
+			kw[3].value = &vstats;
+			kw[4].value = oT;
+			argv[0] = oBVH;
+			argv[1] = oPlanes;
+			oRes = RHTgrCamera_BVHCull(2, argv, (char *) kw);
+		}
+		dt = bench_ms() - t0;
+		r->bvhMs += dt;
+		if (dt < r->bvhMinMs) r->bvhMinMs = dt;
+		stub_free(oRes);
+
+		/*  Occlusion test both visible sets and compare them. */
+		{
+			STUB_KW		kw[] = {{"TRANSFORM", NULL}, {NULL, NULL}};
+
+			kw[0].value = oT;
+			argv[0] = oOccLoc;
+			argv[1] = oOccExt;
+			argv[2] = oFov;
+			argv[3] = oEye;
+			argv[4] = oZclip;
+			oHiz = RHTgrCamera_HiZBuild(5, argv, (char *) kw);
+			oHiz->flags &= ~IDL_V_TEMP;
+		}
+		{
+			STUB_KW		kw[] = {{"MASK", NULL}, {"TRANSFORM", NULL},
+				{NULL, NULL}};
+
+			kw[0].value = &cMaskVar;
+			kw[1].value = oT;
+			argv[0] = oHiz;
+			argv[1] = oLoc;
+			argv[2] = oExt;
+			stub_free(RHTgrCamera_HiZTest(3, argv, (char *) kw));
+			kw[0].value = oBMask;
+			kw[1].name = NULL;
+			argv[1] = oVLoc;
+			argv[2] = oVExt;
+			stub_free(RHTgrCamera_HiZTest(3, argv, (char *) kw));
+		}
+		stub_free(oHiz);
+		stub_free(oT);
+
+		cMask = (UCHAR *) cMaskVar.value.arr->data;
+		for (i = 0, nDiff = 0, first = -1; i < nObj; ++i) {
+			if ((cMask[i] != 0) != (bMask[i] != 0)) {
+				if (first < 0) first = i;
+				++nDiff;
+			}
+		}
+		if (nDiff) {
+			fprintf(stderr, "vfcbench: %s, %lld objects, frame %d: %lld "
+				"objects differ from the one by one test, the first is "
+				"object %lld (BVH %d, one by one %d)\n", r->scenario,
+				(long long) nObj, s, (long long) nDiff, (long long) first,
+				cMask[first] != 0, bMask[first] != 0);
+			r->mismatches += nDiff;
+		}
+
+		nVisible = count.value.l;
+		r->visible += (double) nVisible;
+		r->visibleTris += (double) nVisible * r->nTris;
+		pStats = (IDL_LONG64 *) vstats.value.arr->data;
+		for (k = 0; k < 5; ++k)
+			stats[k] += pStats[k];
+	}
+
+	r->visible /= (double) nSteps * (double) nObj;
+	r->visibleTris /= nSteps;
+	r->boundsMs /= nSteps;
+	r->bruteMs /= nSteps;
+	r->bvhMs /= nSteps;
+	r->saved = stats[0] ? (double) (stats[2] + stats[3]) /
+		(6. * (double) stats[0]) : 0.;
+
+	IDL_VarCopy(IDL_GettmpLong(0), &cache);
+	IDL_VarCopy(IDL_GettmpLong(0), &vstats);
+	IDL_VarCopy(IDL_GettmpLong(0), &cMaskVar);
+	stub_free(oOccLoc);
+	stub_free(oOccExt);
+	stub_free(oBMask);
+	stub_free(oBVH);
+	stub_free(oMoved);
+	stub_free(oLoc);
+	stub_free(oExt);
+	stub_free(oVLoc);
+	stub_free(oVExt);
+	stub_free(oTrans);
+	stub_free(oRanges);
+	stub_free(oConv);
+	stub_free(oVerts);
+	stub_free(oCounts);
+	stub_free(oRot);
+	stub_free(oCamLoc);
+	stub_free(oZclip);
+	stub_free(oFov);
+	stub_free(oEye);
+	stub_free(oPlanes);
+	free(cloud);
+	free(radius);
+	free(phase);
+}
+
+
+static void bench_write(FILE *f, const RESULT *r, int n, int json)
+{
+	int			i;
+
+	if (json) fprintf(f, "[\n");
+	else fprintf(f, "scenario,objects,triangles_per_object,frames,"
+		"visible_fraction,visible_triangles,setup_ms,bounds_ms,brute_ms,"
+		"bvh_ms,bvh_min_ms,bvh_saved_fraction\n");
+
+	for (i = 0; i < n; ++i, ++r) {
+		if (json) {
+			fprintf(f, "  {\"scenario\": \"%s\", \"objects\": %lld, "
+				"\"triangles_per_object\": %d, \"frames\": %d, "
+				"\"visible_fraction\": %.4f, \"visible_triangles\": %.0f, "
+				"\"setup_ms\": %.5f, \"bounds_ms\": %.5f, \"brute_ms\": %.5f, "
+				"\"bvh_ms\": %.5f, \"bvh_min_ms\": %.5f, "
+				"\"bvh_saved_fraction\": %.4f}%s\n", r->scenario,
+				(long long) r->nObjects, (int) r->nTris, r->nFrames,
+				r->visible, r->visibleTris, r->setupMs, r->boundsMs,
+				r->bruteMs, r->bvhMs, r->bvhMinMs, r->saved,
+				i < n - 1 ? "," : "");
+		} else {
+			fprintf(f, "%s,%lld,%d,%d,%.4f,%.0f,%.5f,%.5f,%.5f,%.5f,%.5f,"
+				"%.4f\n", r->scenario, (long long) r->nObjects,
+				(int) r->nTris, r->nFrames, r->visible, r->visibleTris,
+				r->setupMs, r->boundsMs, r->bruteMs, r->bvhMs, r->bvhMinMs,
+				r->saved);
+		}
+	}
+
+	if (json) fprintf(f, "]\n");
+}
+
+
+static void bench_usage(void)
+{
+	fprintf(stderr, "usage: vfcbench [-s scenario] [-N counts] [-n steps] "
+		"[-l level] [-f csv|json] [-o file]\n"
+		"  scenario: all, objects-static, objects-dynamic, "
+		"objects-sparse, triangles-static, triangles-dynamic\n");
+	exit(2);
+}
+
+
+int main(int argc, char **argv)
+{
+	int				a, c, scn = -1, nSteps = 50, level = 2, json = 0;
+	int				nCounts = 0, nResults = 0, nDef, failed = 0;
+	char			*p, *outFile = NULL;
+	const IDL_MEMINT	*def;
+	IDL_MEMINT		counts[64];
+	RESULT			*results, *r;
+	FILE			*f;
+
+	for (a = 1; a < argc; ++a) {
+		if (argv[a][0] != '-' || argv[a][2] || a + 1 >= argc) bench_usage();
+		p = argv[++a];
+		switch (argv[a-1][1]) {
+			case 's':
+				if (!strcmp(p, "all")) break;
+				for (scn = 0; scn < N_SCENARIOS; ++scn)
+					if (!strcmp(p, scenarios[scn].name)) break;
+				if (scn == N_SCENARIOS) bench_usage();
+				break;
+			case 'N':
+				for (nCounts = 0; *p && nCounts < 64; ++nCounts) {
+					counts[nCounts] = strtoll(p, &p, 10);
+					if (counts[nCounts] < 1) bench_usage();
+					if (*p == ',') ++p;
+				}
+				break;
+			case 'n':
+				nSteps = atoi(p);
+				if (nSteps < 2) nSteps = 2;
+				break;
+			case 'l':
+				level = atoi(p);
+				if (level < 0 || level > 8) bench_usage();
+				break;
+			case 'f':
+				if (!strcmp(p, "json")) json = 1;
+				else if (strcmp(p, "csv")) bench_usage();
+				break;
+			case 'o':
+				outFile = p;
+				break;
+			default:
+				bench_usage();
+		}
+	}
+
+	results = (RESULT *) malloc(N_SCENARIOS * (sizeof(counts) /
+		sizeof(counts[0])) * sizeof(RESULT));
+
+	fprintf(stderr, "%-18s %9s %6s %8s %10s %10s %10s %10s %6s\n",
+		"scenario", "objects", "tris", "visible", "setup ms", "bounds ms",
+		"brute ms", "bvh ms", "saved");
+
+	for (a = 0; a < N_SCENARIOS; ++a) {
+		if (scn >= 0 && a != scn) continue;
+		if (nCounts) {
+			def = counts;
+			nDef = nCounts;
+		} else if (scenarios[a].flags & SCN_TRIANGLES) {
+			def = defTriObjects;
+			nDef = sizeof(defTriObjects) / sizeof(defTriObjects[0]);
+		} else {
+			def = defObjects;
+			nDef = sizeof(defObjects) / sizeof(defObjects[0]);
+		}
+		for (c = 0; c < nDef; ++c) {
+			r = results + nResults++;
+			bench_run(a, def[c], level, nSteps, r);
+			fprintf(stderr, "%-18s %9lld %6d %8.3f %10.3f %10.4f %10.4f "
+				"%10.4f %6.3f\n", r->scenario, (long long) r->nObjects,
+				(int) r->nTris, r->visible, r->setupMs, r->boundsMs,
+				r->bruteMs, r->bvhMs, r->saved);
+			if (r->mismatches) failed = 1;
+		}
+	}
+
+	f = outFile ? fopen(outFile, "w") : stdout;
+	if (!f) {
+		fprintf(stderr, "vfcbench: unable to open %s\n", outFile);
+		return 1;
+	}
+	bench_write(f, results, nResults, json);
+	if (outFile) fclose(f);
+	free(results);
+
+	if (failed)
+		fprintf(stderr, "vfcbench: the BVH visible sets differ from the "
+			"one by one test\n");
+
+	return failed;
+}
@@ -36,7 +36,8 @@
 ; CALLING SEQUENCE:
 ;
 ;   oAABB = OBJ_NEW('RHTgrAABB', [oModel], [, COLOR=index or RGB vector]
-;                   [, DOUBLE{Get, Set}={0 | 1}], [, /SHOWBOUNDS {Get, Set}])
+;                   [, DOUBLE{Get, Set}={0 | 1}], [, /SHOWBOUNDS {Get, Set}]
+;                   [, /TIGHT {Get, Set}])
 ;
 ;
 ; KEYWORDS:
@@ -56,6 +57,14 @@
 ;
 ;                       DEFAULT: 0
 ;
+;       Tight:          Set this keyword to calculate the bounding box from the
+;                       vertices of IDLgrPolygon and IDLgrPolyline atoms
+;                       instead of the transformed corners of their data
+;                       range.  The box is tighter for rotated models but
+;                       every vertex must be transformed.
+;
+;                       DEFAULT: 0
+;
 ;
 ; METHODS:
 ;
@@ -142,6 +151,8 @@
 ;
 ; MODIFICATION HISTORY:
 ;       Written by: Rick Towler, 27 October 2002.
+;       CalcBB gathers the atoms of the whole hierarchy and boxes them with
+;       a single call to RHTgrAABB_CalcBBArray.  Added the TIGHT keyword.
 ;
 ;
 ; LICENSE
@@ -174,11 +185,13 @@ function RHTgrAABB::Init,   oModel, $
                             color=color, $
                             double=double, $
                             showBounds=showBounds, $
+                            tight=tight, $
                             _extra=extra
 
     self.double = KEYWORD_SET(double)
     self.showBounds = (N_ELEMENTS(showBounds) ne 1) ? 0B : $
         KEYWORD_SET(showBounds)
+    self.tight = KEYWORD_SET(tight)
     self.pPositions = PTR_NEW(-1)
     self.pExtents = PTR_NEW(-1)
     color = (N_ELEMENTS(color) ne 3) ? [180,180,180] : color
@@ -498,6 +511,7 @@ pro RHTgrAABB::GetProperty, all=all, $
                             position=position, $
                             range=range, $
                             showBounds=showBounds, $
+                            tight=tight, $
                             _ref_extra=extra
 
     compile_opt idl2
@@ -515,6 +529,7 @@ pro RHTgrAABB::GetProperty, all=all, $
     range = [[position - extents], $
              [position + extents]]
     showBounds = self.showBounds
+    tight = self.tight
 
     self -> IDLgrMODEL::GetProperty, _Extra=extra
     self.oPolyObj -> GetProperty, _Extra=extra
@@ -528,6 +543,7 @@ pro RHTgrAABB::SetProperty, double=double, $
                             extents=extents, $
                             position=position, $
                             showBounds=showBounds, $
+                            tight=tight, $
                             _extra=extra
 
     compile_opt idl2
@@ -538,6 +554,7 @@ pro RHTgrAABB::SetProperty, double=double, $
     if (N_ELEMENTS(position) eq 3) then $
         *self.pPositions = (self.double) ? DOUBLE(position) : FLOAT(position)
     if (N_ELEMENTS(showBounds) eq 1) then self.showBounds = KEYWORD_SET(showBounds)
+    if (N_ELEMENTS(tight) eq 1) then self.tight = KEYWORD_SET(tight)
 
     self -> IDLgrModel::SetProperty, _EXTRA=extra
 
@@ -558,12 +575,77 @@ end
 ;   }}}
 
 
+;   RHTgrAABB::GatherAtoms {{{
+pro RHTgrAABB::GatherAtoms, oObject, $
+                            transform, $
+                            nAtoms, $
+                            ranges, $
+                            coordConv, $
+                            transforms, $
+                            pVerts
+
+    ;  Append the data range, coordinate conversion and compound transform
+    ;  of every atom at or below oObject to the gather arrays, growing
+    ;  them as needed.  If TIGHT is set the vertices of polygons and
+    ;  polylines are gathered as well.
+
+    compile_opt IDL2
+
+    if (OBJ_ISA(oObject, 'IDLgrModel')) then begin
+
+        ;  Compound this model's transform and descend.
+        oObject -> GetProperty, TRANSFORM=thisTransform
+        thisTransform = thisTransform # transform
+
+        oContained = oObject -> Get(/ALL, COUNT=nContained)
+        for n=0L, nContained-1 do $
+            self -> GatherAtoms, oContained[n], thisTransform, nAtoms, $
+                ranges, coordConv, transforms, pVerts
+
+    endif else begin
+
+        ;  Double the size of the gather arrays when full.
+        nMax = (SIZE(ranges, /DIMENSIONS))[1]
+        if (nAtoms eq nMax) then begin
+            ranges = [[ranges], [DBLARR(6, nMax)]]
+            coordConv = [[coordConv], [DBLARR(6, nMax)]]
+            transforms = [[transforms], [DBLARR(16, nMax)]]
+            pVerts = [pVerts, PTRARR(nMax)]
+        endif
+
+        ;  Get this atom's data range and "coordinate conversion".
+        oObject -> IDLgrGraphic::GetProperty, XRANGE=xRange, $
+            YRANGE=yRange, ZRANGE=zRange, XCOORD_CONV=xCoordConv, $
+            YCOORD_CONV=yCoordConv, ZCOORD_CONV=zCoordConv
+
+        ranges[*,nAtoms] = [xRange, yRange, zRange]
+        coordConv[*,nAtoms] = [xCoordConv, yCoordConv, zCoordConv]
+        transforms[*,nAtoms] = transform[*]
+
+        ;  Keep 3xN vertex data for tight boxes.
+        if (self.tight and (OBJ_ISA(oObject, 'IDLgrPolygon') or $
+            OBJ_ISA(oObject, 'IDLgrPolyline'))) then begin
+            oObject -> GetProperty, DATA=data
+            if ((SIZE(data, /DIMENSIONS))[0] eq 3) then $
+                pVerts[nAtoms] = PTR_NEW(data, /NO_COPY)
+        endif
+
+        nAtoms = nAtoms + 1L
+
+    endelse
+
+end
+;   }}}
+
+
 ;   RHTgrAABB::CalcBB {{{
 function RHTgrAABB::CalcBB, oModel, $
                             top=top, $
                             transform=transform
 
-    ;  Calculate the bounding box containing the provided model.
+    ;  Calculate the bounding box containing the provided model.  The
+    ;  atoms below the model are gathered first and then boxed by the DLM
+    ;  in one call rather than one call per atom.
 
     compile_opt IDL2
 
@@ -582,50 +664,92 @@ function RHTgrAABB::CalcBB, oModel, $
         transform = thisTransform else $
         transform = thisTransform # transform
 
-    ;  Loop thru objects contained in this model.
+    ;  Gather the atoms below each contained object.
+    nAtoms = 0L
+    ranges = DBLARR(6, 64)
+    coordConv = DBLARR(6, 64)
+    transforms = DBLARR(16, 64)
+    pVerts = PTRARR(64)
+    counts = LONARR(nContained > 1)
     for n=0L, nContained-1 do begin
-        if (OBJ_ISA(oContained[n], 'IDLgrModel')) then begin
+        first = nAtoms
+        self -> GatherAtoms, oContained[n], transform, nAtoms, ranges, $
+            coordConv, transforms, pVerts
+        counts[n] = nAtoms - first
+    endfor
 
-            ;  Calculate the bounding box for this model.
-            bBox = self -> CalcBB(oContained[n], TRANSFORM=transform[*,*])
+    ;  Box the atoms.  Data ranges are boxed by transforming their
+    ;  8 corners, gathered vertices are transformed and reduced.
+    if (nAtoms gt 0) then begin
 
-        endif else begin
+        boxes = DBLARR(3, 3, nAtoms)
+        hasVerts = PTR_VALID(pVerts[0:nAtoms-1])
+        r = WHERE(hasVerts eq 0, nR, COMPLEMENT=v, NCOMPLEMENT=nV)
 
-            ;  Get this atom's data range and "coordinate conversion".
-            oContained[n] -> IDLgrGraphic::GetProperty, XRANGE=xRange, $
-                YRANGE=yRange, ZRANGE=zRange, XCOORD_CONV=xCoordConv, $
-                YCOORD_CONV=yCoordConv, ZCOORD_CONV=zCoordConv
+        if (nR gt 0) then boxes[*,*,r] = RHTgrAABB_CalcBBArray(ranges[*,r], $
+            coordConv[*,r], transforms[*,r])
 
-            ;  Calculate this atom's bounding box.
-            bBox = RHTgrAABB_CalcBB(xRange, yRange, zRange, xCoordConv, $
-                yCoordConv, zCoordConv, transform)
+        if (nV gt 0) then begin
+            nVerts = LONARR(nV)
+            isDouble = 0B
+            for i=0L, nV-1 do begin
+                nVerts[i] = N_ELEMENTS(*pVerts[v[i]]) / 3
+                isDouble = isDouble or (SIZE(*pVerts[v[i]], /TYPE) eq 5)
+            endfor
+            vertices = (isDouble) ? DBLARR(3, TOTAL(nVerts, /INTEGER)) : $
+                FLTARR(3, TOTAL(nVerts, /INTEGER))
+            first = 0L
+            for i=0L, nV-1 do begin
+                vertices[0,first] = *pVerts[v[i]]
+                first = first + nVerts[i]
+            endfor
+            boxes[*,*,v] = RHTgrAABB_VertexBB(vertices, COUNTS=nVerts, $
+                COORD_CONV=coordConv[*,v], TRANSFORM=transforms[*,v])
+        endif
 
-        endelse
+        ;  Drop atoms without a valid box (bBox[0,2] is 0) and count the
+        ;  valid atoms of each contained object.
+        valid = REFORM(boxes[0,2,*]) ne 0
+        cumValid = [0L, TOTAL(valid, /CUMULATIVE, /INTEGER)]
+        last = TOTAL(counts, /CUMULATIVE, /INTEGER)
+        counts = cumValid[last] - cumValid[last - counts]
+        v = WHERE(valid, nValid)
 
-        ;  Grow box.
-        if (N_ELEMENTS(minMax) ne 0) then begin
-            if (bBox[0,2]) then begin
-                minMax[*,0] = minMax[*,0] < bBox[*,0]
-                minMax[*,1] = bBox[*,1] >  minMax[*,1]
-            endif
-        endif else minMax = bBox
+    endif else nValid = 0L
 
-    endfor
+    PTR_FREE, pVerts
 
-    ;  Calculate position and extents - handle empty models.
-    if (N_ELEMENTS(minMax) eq 0) then begin
+    ;  Handle empty models.
+    if (nValid eq 0) then begin
         minMax = REPLICATE(0., 3, 3)
-        extents = [0., 0., 0.]
-        position = [0., 0., 0.]
+        boxes = REPLICATE(0., 3, 3, nContained > 1)
     endif else begin
-        extents = (minMax[*,1] - minMax[*,0]) * 0.5
-        position = minMax[*,0] + extents
+
+        ;  Merge the valid atom boxes into one box per contained object
+        ;  and one for the whole model by boxing their min and max
+        ;  corners.  Objects with no valid atoms get an empty box.
+        corners = REFORM(boxes[*,0:1,v], 3, 2 * nValid)
+        boxes = RHTgrAABB_VertexBB(corners, COUNTS=2 * counts)
+        minMax = RHTgrAABB_VertexBB(corners)
+
     endelse
 
+    ;  Calculate position and extents.
+    extents = (minMax[*,1] - minMax[*,0]) * 0.5
+    position = minMax[*,0] + extents
+
     ;  Store position and extents - if needed.
     if (top) then begin
         (*self.pExtents)[*,0] = extents
         (*self.pPositions)[*,0] = position
+        if (nContained gt 0) then begin
+            boxes = REFORM(boxes, 3, 3, nContained)
+            modelExtents = REFORM(boxes[*,1,*] - boxes[*,0,*], 3, $
+                nContained) * 0.5
+            (*self.pExtents)[*,1:nContained] = modelExtents
+            (*self.pPositions)[*,1:nContained] = REFORM(boxes[*,0,*], 3, $
+                nContained) + modelExtents
+        endif
     endif else begin
         inTop = self -> IsContained(oModel, POSITION=pos)
         if (inTop) then begin
@@ -666,7 +790,8 @@ pro RHTgrAABB__Define
             oPolyObj:OBJ_NEW(), $
             pExtents:PTR_NEW(), $
             pPositions:PTR_NEW(), $
-            showBounds:0B $
+            showBounds:0B, $
+            tight:0B $
            }
 
 end
@@ -59,6 +59,21 @@
 ;                   Default: [0.,0.,1.]
 ;
 ;
+;       CULL_STATS: (Get only) Returns a 5 element LONG64 array of view frustum
+;                   culling counters accumulated since the counters were last reset:
+;
+;                   [boxes tested, plane tests, plane tests saved by plane masking,
+;                    plane tests saved by early rejection, boxes rejected by the
+;                    plane that rejected them on the previous frame]
+;
+;                   Each box could take 6 plane tests.  BVH nodes only test the
+;                   planes their parent straddles and every node remembers the
+;                   plane that last rejected it, so when the camera moves only a
+;                   little between frames most plane tests are skipped.  Dynamic
+;                   models are tested one by one and are not counted.  Set the
+;                   RESET_CULL_STATS keyword (SetProperty only) to zero the counters.
+;
+;
 ;        DEPTH_CUE: Set this keyword to a 2 element vector [zbright, zdim] specifying the
 ;                   the near and far Z planes between which depth cueing is in effect.
 ;                   Depth (Z) distance is measured in positive units away from the camera.
@@ -73,6 +88,11 @@
 ;                   Default: [0.0, 0.0]
 ;
 ;
+;      DYNAMIC_LOD: (Get only) Returns a byte array holding the level of detail
+;                   last chosen for each dynamic model (see LOD_ERRORS).  Models
+;                   that have been culled keep the level they were last drawn at.
+;
+;
 ;         FORCE_AR: Set this keyword to lock the pixel aspect ratio based on
 ;                   the camera's viewplane dimensions and the initial dimensions
 ;                   of the destination object.  Subsequent changes to the
@@ -108,6 +128,31 @@
 ;                   Default: 1
 ;
 ;
+;       LOD_ERRORS: Set this keyword to a vector holding the geometric error of
+;                   each level of detail of the culled models, finest first, as a
+;                   fraction of the model's bounding radius (see the LOD_ERRORS
+;                   property of RHTgrPSolid).  While culling, the camera projects
+;                   each visible model's bounding radius and sets the LEVEL
+;                   property of every RHTgrPSolid model to the coarsest level
+;                   whose projected error is within LOD_TOLERANCE.  Set to a
+;                   scalar to disable level of detail selection.
+;
+;                   Default: None.  Level of detail selection is disabled.
+;
+;
+;    LOD_TOLERANCE: Set this keyword to the largest tolerated screen space error
+;                   as a fraction of the viewport height.
+;
+;                   Default: 0.002 (about 1 pixel in a 500 pixel high view)
+;
+;
+;  OCCLUSION_STATS: (Get only) Returns a 2 element LONG64 array of occlusion
+;                   culling counters accumulated since the counters were last
+;                   reset: [boxes tested, boxes occluded].  Only boxes that pass
+;                   the view frustum test are tested.  These counters are also
+;                   zeroed by the RESET_CULL_STATS keyword.
+;
+;
 ;            PITCH: Set this keyword to a scalar defining the pitch (rotation about the
 ;                   X axis) of the camera in degrees. 0 > pitch < 360
 ;
@@ -120,6 +165,10 @@
 ;                   Default: 0.0
 ;
 ;
+;       STATIC_LOD: (Get only) Returns a byte array holding the level of detail
+;                   last chosen for each static model (see LOD_ERRORS).
+;
+;
 ;     THIRD_PERSON: Set this keyword to a scalar defining the number of units the
 ;                   camera will lag behind the defined camera position.  This creates
 ;                   a simple 3rd person effect. Setting this keyword equal to 0 will
@@ -176,19 +225,30 @@
 ;                   Set the DYNAMIC keyword to add the model(s) as dynamically
 ;                   culled content.  During transformation, the extent of dynamic
 ;                   models is determined and any models falling completly outside
-;                   the viewing frustum will not be rendered.
+;                   the viewing frustum will not be rendered.  Every dynamic box
+;                   is tested on every transformation, which is cheaper than
+;                   refitting and traversing a BVH since the boxes are in view
+;                   space and all of them move whenever the camera does.
 ;
 ;                   The performance of dynamic view frustum culling depends on
 ;                   many factors.  Follow the hints provided in the HTML
 ;                   documentation and experiment.
 ;
 ;                   Set the STATIC keyword to add the model(s) as statically
-;                   culled content.  A binary tree is constructed to spatialy
-;                   partition the static model space.  During transformation,
-;                   this tree is traversed to determine which models fall within
-;                   the view frustum.  Models outside the view frustum will not be
-;                   rendered.  Static model geometry and transformations must not
-;                   be modified after being added to the camera.
+;                   culled content.  A bounding volume hierarchy is constructed
+;                   to spatialy partition the static model space.  During
+;                   transformation, this BVH is traversed (in the DLM) to
+;                   determine which models fall within the view frustum.  Models
+;                   outside the view frustum will not be rendered.  If the
+;                   geometry or transformation of a static model is changed
+;                   after it has been added call UpdateStatic so the BVH
+;                   follows it.
+;
+;                   Set the BVH keyword along with STATIC to supply a BVH built
+;                   with RHTgrCamera_BVHBuild instead of having the camera build
+;                   one.  The BVH must have been built from the world space
+;                   bounding boxes of all of the static models in the order they
+;                   were added.
 ;
 ;                   Set the MOTHER keyword to add the model(s) as non-culled,
 ;                   NON-TRANSFORMED content.  These models will not be transformed
@@ -232,6 +292,26 @@
 ;                   oCamera -> Roll, 10.0
 ;
 ;
+;   SetOccluders:   This procedure method enables occlusion culling of static and
+;                   dynamic content.  You supply two 3xN arrays giving the world
+;                   space centers and half widths of N boxes that hide whatever is
+;                   behind them.  On each transformation the boxes are drawn into a
+;                   small software depth buffer (256x256 by default, set the
+;                   DIMENSIONS keyword to change it) and models that survive the
+;                   view frustum test but are completely hidden behind the
+;                   occluders are not rendered.
+;
+;                   Occluders are drawn as solid boxes, so each must lie entirely
+;                   inside solid geometry (use the box inscribed in a sphere, not
+;                   its bounding box) or visible models will be hidden.  A handful
+;                   of large occluders close to the camera works best.  Call
+;                   SetOccluders with no arguments to disable occlusion culling.
+;
+;                   To use a large building as an occluder:
+;
+;                   oCamera -> SetOccluders, [0., 25., -100.], [40., 25., 10.]
+;
+;
 ;   SetClipPlanes:  This procedure method applies clipping planes to the scene
 ;                   using the CLIP_PLANES property of IDLgrModel.  You supply a
 ;                   4xN array [A,B,C,D] which defines the planes Ax+By+Cz+d=0.  See
@@ -293,6 +373,20 @@
 ;                   oCamera -> Truck, [0, 0, 1], 10.
 ;
 ;
+;   UpdateStatic:   This procedure method updates the BVH after the geometry
+;                   or transformation of static models has changed.  Pass the
+;                   models that changed.  Their world space boxes are
+;                   recalculated and only the BVH nodes above them are refit,
+;                   which is much cheaper than removing and adding the models
+;                   since that rebuilds the BVH.  If more than a quarter of
+;                   the static models change at once the BVH is marked stale
+;                   and every static box is tested until a later update with
+;                   few changes refits it.  Models that change every frame
+;                   are better added as dynamic content.
+;
+;                   oCamera -> UpdateStatic, oOrb
+;
+;
 ;   Zoom:           This procedure method "zooms" the camera by specified zoom
 ;                   factor.  Setting ZOOM equal to 0 disables zooming.
 ;
@@ -395,7 +489,16 @@ function RHTgrCamera::Init,     camera_location=cameraLocation, $
     self.pStaticMask = PTR_NEW(-1)
     self.pStaticModels = PTR_NEW(-1)
     self.pTempMask = PTR_NEW(-1)
-    self.pRootNode = self -> GetRootNode(/NULL)
+    self.pStaticBVH = PTR_NEW(-1)
+    self.pStaticCache = PTR_NEW(0B)
+    self.pStaticPosition = PTR_NEW(-1)
+    self.pStaticExtents = PTR_NEW(-1)
+    self.pOccluderPosition = PTR_NEW(-1)
+    self.pOccluderExtents = PTR_NEW(-1)
+    self.pStaticLOD = PTR_NEW(-1)
+    self.pDynamicLOD = PTR_NEW(-1)
+    self.pLODErrors = PTR_NEW(-1)
+    self.lodTolerance = 0.002D
 
     ;  Set Double RADEG - D. Jackson
     self.dRadeg = 180D / !DPI
@@ -448,7 +551,7 @@ end
 
 ;   RHTgrCamera::Add {{{
 pro RHTgrCamera::Add,   oModel, $
-                        binTreeStruct=binTreeStruct, $
+                        bvh=bvh, $
                         dynamic=dynamic, $
                         mother=mother, $
                         static=static, $
@@ -498,8 +601,9 @@ pro RHTgrCamera::Add,   oModel, $
                 self.cameraLocation, self.viewZ)
             self.oDynamicModel -> SetProperty, TRANSFORM=transform
             self.oDynamicModel -> GetAABB, POSITION=pos, EXTENTS=ext, /ALL
-            inview = RHTgrCamera_AABBIntersectFrustum(pos, ext, self.frustPlanes)
-            *self.pDynamicMask = inView
+            *self.pDynamicMask = BYTE(RHTgrCamera_AABBIntersectFrustum(pos, $
+                ext, self.frustPlanes))
+            *self.pDynamicLOD = REPLICATE(255B, self.nDynamic)
             for n=0L, self.nDynamic-1 do $
                 (*self.pDynamicModels)[n] -> SetProperty, $
                     HIDE=1 xor (*self.pDynamicMask)[n]
@@ -520,26 +624,23 @@ pro RHTgrCamera::Add,   oModel, $
             self.nStatic = nStatic
             *self.pTempMask = REPLICATE(1B, self.nStatic)
 
-            ;  Construct binary tree.
-            if (SIZE(binTreeStruct, /TYPE) eq 8) then begin
-                ;  A binary tree struct has been passed. Assume proper structure.
-                *self.pRootNode = binTreeStruct
-            endif else begin
-                ;  Free existing tree.
-                self -> FreeBTree, self.pRootNode
-
-                ;  Get the root node.
-                self.pRootNode = self -> GetRootNode()
-
-                ;  Build the new tree.
-                self -> BuildBTree, self.pRootNode
-            endelse
+            ;  Store the world space boxes and construct the BVH.
+            self.oStaticModel -> GetAABB, POSITION=position, $
+                EXTENTS=extents, /ALL
+            *self.pStaticPosition = position
+            *self.pStaticExtents = extents
+            if (SIZE(bvh, /N_DIMENSIONS) eq 2) then begin
+                ;  A BVH has been passed. Assume it matches the models.
+                *self.pStaticBVH = DOUBLE(bvh)
+            endif else self -> BuildBVH
+            *self.pStaticCache = 0B
 
             ;  Set initial HIDE state and visibility mask
             transform = RHTgrCamera_Transform(self.oOrientation -> GetCTM(), $
                 self.cameraLocation, self.viewZ)
-            self -> CullStatic, self.pRootNode, transform, /ROOT
+            self -> CullStatic, transform
             *self.pStaticMask = *self.pTempMask
+            *self.pStaticLOD = REPLICATE(255B, self.nStatic)
             for n=0L, self.nStatic-1 do $
                 (*self.pStaticModels)[n] -> SetProperty, $
                     HIDE=1 xor (*self.pStaticMask)[n]
@@ -600,6 +701,8 @@ pro RHTgrCamera::Remove,    oModel, $
     self.oDynamicModel -> Remove, oModel, ALL=all
     *self.pDynamicModels = self.oDynamicModel -> Get(/ALL, $
         COUNT=nDynamic, ISA='IDLgrModel')
+    if (self.nDynamic ne nDynamic) then $
+        *self.pDynamicLOD = (nDynamic gt 0) ? REPLICATE(255B, nDynamic) : -1
     self.nDynamic = nDynamic
 
     ;  Remove static models.
@@ -607,8 +710,8 @@ pro RHTgrCamera::Remove,    oModel, $
     *self.pStaticModels = self.oStaticModel -> Get(/ALL, $
         COUNT=nStatic, ISA='IDLgrModel')
     if (self.nStatic ne nStatic) then begin
-        self -> FreeBTree, self.pRootNode
-        self.pRootNode = self -> GetRootNode(/NULL)
+        *self.pStaticBVH = -1
+        *self.pStaticCache = 0B
         if (nStatic ne 0) then begin
             self.oStaticModel -> Remove, /ALL
             self -> Add, *self.pStaticModels, /STATIC
@@ -844,6 +947,41 @@ end
 ;   }}}
 
 
+;   RHTgrCamera::SetOccluders {{{
+pro RHTgrCamera::SetOccluders,  position, $
+                                extents, $
+                                dimensions=dimensions
+
+    ;  Set the world space boxes used for occlusion culling.  Call with
+    ;  no arguments to disable occlusion culling.
+
+    compile_opt IDL2
+
+    if (N_PARAMS() eq 0) then begin
+        self.occlusion = 0B
+        *self.pOccluderPosition = -1
+        *self.pOccluderExtents = -1
+        RETURN
+    endif
+
+    if (N_ELEMENTS(position) eq 0) or $
+        (N_ELEMENTS(position) mod 3 ne 0) or $
+        (N_ELEMENTS(extents) ne N_ELEMENTS(position)) then begin
+        MESSAGE, 'position and extents must be 3xN arrays of the ' + $
+            'same size', /CONTINUE
+        RETURN
+    endif
+
+    *self.pOccluderPosition = DOUBLE(position)
+    *self.pOccluderExtents = DOUBLE(extents)
+    self.hizDims = (N_ELEMENTS(dimensions) eq 2) ? $
+        1 > LONG(dimensions) < 4096 : [256L, 256L]
+    self.occlusion = 1B
+
+end
+;   }}}
+
+
 ;   RHTgrCamera::SetClipPlanes {{{
 pro RHTgrCamera::SetClipPlanes, clip_planes
 
@@ -874,6 +1012,8 @@ pro RHTgrCamera::SetProperty,   camera_location=cameraLocation, $
                                 fov=fov, $
                                 frustum_dims=viewDims, $
                                 lock=lock, $
+                                lod_errors=lodErrors, $
+                                lod_tolerance=lodTolerance, $
                                 lookat=lookat, $
                                 no_transform=noTransform, $
                                 orientation=orientation, $
@@ -881,6 +1021,7 @@ pro RHTgrCamera::SetProperty,   camera_location=cameraLocation, $
                                 override=override, $
                                 projection=projection, $
                                 reset_AR=resetAR, $
+                                reset_cull_stats=resetCullStats, $
                                 roll=roll, $
                                 third_person=thirdPerson, $
                                 track=track, $
@@ -898,6 +1039,24 @@ pro RHTgrCamera::SetProperty,   camera_location=cameraLocation, $
     if (N_ELEMENTS(cameraLocation) eq 3) then $
         self.cameraLocation = cameraLocation
 
+    if (KEYWORD_SET(resetCullStats)) then begin
+        self.cullStats = 0LL
+        self.occlusionStats = 0LL
+    endif
+
+    if (N_ELEMENTS(lodErrors) gt 0) then begin
+        self.lod = N_ELEMENTS(lodErrors) gt 1
+        *self.pLODErrors = (self.lod) ? DOUBLE(lodErrors) : -1
+        ;  Push every model's level on the next transformation.
+        if (self.nStatic gt 0) then $
+            *self.pStaticLOD = REPLICATE(255B, self.nStatic)
+        if (self.nDynamic gt 0) then $
+            *self.pDynamicLOD = REPLICATE(255B, self.nDynamic)
+    endif
+
+    if (N_ELEMENTS(lodTolerance) eq 1) then $
+        self.lodTolerance = 1D-6 > lodTolerance
+
     if (N_ELEMENTS(depthCue) eq 2) then begin
         self.dcue = depthCue
         updateView = 1B
@@ -997,17 +1156,23 @@ end
 
 ;   RHTgrCamera::GetProperty {{{
 pro RHTgrCamera::GetProperty,   camera_location=cameraLocation, $
+                                cull_stats=cullStats, $
                                 depth_cue=depthCue, $
+                                dynamic_lod=dynamicLOD, $
                                 force_AR=forceAR, $
                                 fov=fov, $
                                 frustum_dims=viewDims, $
                                 frustum_planes=frustPlanes, $
                                 frustum_verts=frustVerts, $
                                 lock=lock, $
+                                lod_errors=lodErrors, $
+                                lod_tolerance=lodTolerance, $
                                 lookat=lookat, $
+                                occlusion_stats=occlusionStats, $
                                 pitch=pitch, $
                                 quaternion=quaternion, $
                                 roll=roll, $
+                                static_lod=staticLOD, $
                                 third_person=thirdPerson, $
                                 track=track, $
                                 view_frustum=viewFrust, $
@@ -1020,16 +1185,22 @@ pro RHTgrCamera::GetProperty,   camera_location=cameraLocation, $
     compile_opt idl2
 
     cameraLocation = self.cameraLocation
+    cullStats = self.cullStats
     depthCue = self.dcue
+    dynamicLOD = *self.pDynamicLOD
     forceAR = self.aspectRatio[0]
     fov = self.fov * self.dRadeg * 2.0
     frustPlanes = self.frustPlanes
     frustVerts = self.frustum
     lock = self.lock
+    lodErrors = *self.pLODErrors
+    lodTolerance = self.lodTolerance
     lookat = self.lookat
+    occlusionStats = self.occlusionStats
     pitch = self.pitch
     quaternion = self.oOrientation
     roll = self.roll
+    staticLOD = *self.pStaticLOD
     thirdPerson = self.thirdPerson
     track = self.track
     viewDims = [self.view[2:3],TOTAL(ABS(self.zclip))]
@@ -1102,14 +1273,26 @@ pro RHTgrCamera::Transform
         self.cameraLocation, self.viewZ)
     self.oCamModel -> SetProperty, TRANSFORM=transform
 
+    ;  Rasterize the occluders.
+    if (self.occlusion) then $
+        hiz = RHTgrCamera_HiZBuild(*self.pOccluderPosition, $
+            *self.pOccluderExtents, self.fov, self.eye[2], self.zclip, $
+            DIMENSIONS=self.hizDims, TRANSFORM=transform)
+
     ;  Cull static content.
     if (self.nStatic gt 0) then begin
 
         ;  Apply transform to static model.
         self.oStaticModel -> SetProperty, TRANSFORM=transform
 
-        ;  Test frustum / B-tree intersection.
-        self -> CullStatic, self.pRootNode, transform, /ROOT
+        ;  Test frustum / BVH intersection.
+        self -> CullStatic, transform, LOD=lod
+        if (self.occlusion) then begin
+            null = RHTgrCamera_HiZTest(hiz, *self.pStaticPosition, $
+                *self.pStaticExtents, TRANSFORM=transform, $
+                MASK=*self.pTempMask, STATS=stats)
+            self.occlusionStats = self.occlusionStats + stats
+        endif
         change = *self.pTempMask xor *self.pStaticMask
         *self.pStaticMask = *self.pTempMask
 
@@ -1119,6 +1302,10 @@ pro RHTgrCamera::Transform
             (*self.pStaticModels)[chIdx[n]] -> SetProperty, $
                 HIDE=1 xor (*self.pStaticMask)[chIdx[n]]
 
+        ;  Set static model levels of detail.
+        if (self.lod) then self -> SetLOD, *self.pStaticModels, $
+            *self.pStaticLOD, lod, *self.pStaticMask
+
     endif
 
     ;  Cull dynamic content.
@@ -1130,8 +1317,16 @@ pro RHTgrCamera::Transform
         ;  Get the bounding boxes for the dynamic models.
         self.oDynamicModel -> GetAABB, POSITION=pos, EXTENTS=ext, /ALL
 
-        ;  Test frustum / bounding box intersection.
-        inview = RHTgrCamera_AABBIntersectFrustum(pos,ext,self.frustPlanes)
+        ;  Test frustum / bounding box intersection.  The boxes are in view
+        ;  space so every one of them moves with the camera, and refitting
+        ;  a BVH over them costs more than testing them one by one.
+        inView = BYTE(RHTgrCamera_AABBIntersectFrustum(pos, ext, $
+            self.frustPlanes))
+        if (self.occlusion) then begin
+            null = RHTgrCamera_HiZTest(hiz, pos, ext, MASK=inView, $
+                STATS=stats)
+            self.occlusionStats = self.occlusionStats + stats
+        endif
         change = inView xor *self.pDynamicMask
         *self.pDynamicMask = inView
 
@@ -1141,160 +1336,169 @@ pro RHTgrCamera::Transform
             (*self.pDynamicModels)[chIdx[n]] -> SetProperty, $
                 HIDE=1 xor (*self.pDynamicMask)[chIdx[n]]
 
+        ;  Set dynamic model levels of detail.
+        if (self.lod) then self -> SetLOD, *self.pDynamicModels, $
+            *self.pDynamicLOD, self -> BoxLOD(pos, ext, inView), $
+            *self.pDynamicMask
+
     endif
 
 end
 ;   }}}
 
 
-;   RHTgrCamera::BuildBTree {{{
-pro RHTgrCamera::BuildBTree,    node
+;   RHTgrCamera::UpdateStatic {{{
+pro RHTgrCamera::UpdateStatic,  oModel
 
-    ;  Construct the binary tree used for static frustum culling.
+    ;  Refit the static BVH after the geometry or transformation of the
+    ;  static models oModel has changed.
 
-    compile_opt IDL2
+    compile_opt idl2
 
-    ;  Determine bounding box long axis and bisect
-    null = MAX(ABS((*node).data.extents), axis)
-    location = ((*node).data.position)[axis]
-    oAABB = OBJ_NEW('RHTgrAABB', (*self.pStaticModels)[(*node).data.models], $
-        /ALIAS)
-    data = oAABB -> Bisect(axis, location, DUPLICATES=duplicates)
-    OBJ_DESTROY, oAABB
-
-    ;  Store duplicates.  They need special treatment during culling.
-    *(*node).data.duplicates = duplicates
-    nDuplicates = N_ELEMENTS(duplicates)
-
-    ;  Create the leaves.
-    if (data.right.nModels gt 0) then begin
-        models = LONARR(data.right.nModels, /NOZERO)
-        for n=0, data.right.nModels-1 do  $
-            models[n] = WHERE(*self.pStaticModels eq data.right.models[n])
-        (*node).right = PTR_NEW({data:{position:data.right.position, $
-            extents:data.right.extents, models:models, $
-            duplicates:PTR_NEW([[-1],[-1]])}, $
-            left:PTR_NEW(), right:PTR_NEW()})
-        if (data.right.nModels gt nDuplicates) then $
-            self -> BuildBTree, (*node).right
+    CATCH, error
+    if (error ne 0) then begin
+       CATCH, /CANCEL
+       MESSAGE, !Error_State.Msg, /CONTINUE
+       RETURN
     endif
 
-    if (data.left.nModels gt 0) then begin
-        models = LONARR(data.left.nModels, /NOZERO)
-        for n=0, data.left.nModels-1 do  $
-            models[n] = WHERE(*self.pStaticModels eq data.left.models[n])
-        (*node).left = PTR_NEW({data:{position:data.left.position, $
-            extents:data.left.extents, models:models, $
-            duplicates:PTR_NEW([[-1],[-1]])}, $
-            left:PTR_NEW(), right:PTR_NEW()})
-         if (data.left.nModels gt nDuplicates) then $
-            self -> BuildBTree, (*node).left
+    if (self.nStatic eq 0) then RETURN
+
+    ;  Find the models in the static content.
+    nModels = N_ELEMENTS(oModel)
+    indices = LONARR(nModels)
+    for n=0, nModels-1 do $
+        indices[n] = (WHERE(*self.pStaticModels eq oModel[n]))[0]
+    if (MIN(indices) lt 0) then begin
+        MESSAGE, 'Models must have been added as static content', /CONTINUE
+        RETURN
     endif
 
+    ;  Recalculate the world space boxes and refit the BVH above the
+    ;  models that changed.
+    self.oStaticModel -> GetProperty, TRANSFORM=transform
+    self.oStaticModel -> Reset
+    self.oStaticModel -> GetAABB, POSITION=position, EXTENTS=extents, /ALL
+    self.oStaticModel -> SetProperty, TRANSFORM=transform
+    RHTgrCamera_BVHRefit, *self.pStaticBVH, position, extents, $
+        INDICES=indices[UNIQ(indices, SORT(indices))]
+    *self.pStaticPosition = position
+    *self.pStaticExtents = extents
+
+    ;  Update model transforms and cull.
+    self -> Transform
+
 end
 ;   }}}
 
 
-;   RHTgrCamera::FreeBTree {{{
-pro RHTgrCamera::FreeBTree,    pNode
+;   RHTgrCamera::BuildBVH {{{
+pro RHTgrCamera::BuildBVH
 
-    ;  Free pointers associated with the binary tree.
+    ;  Construct the bounding volume hierarchy used for static frustum
+    ;  culling from the world space boxes stored when the static models
+    ;  were added.
 
     compile_opt IDL2
 
-    PTR_FREE, (*pNode).data.duplicates
+    *self.pStaticBVH = RHTgrCamera_BVHBuild(*self.pStaticPosition, $
+        *self.pStaticExtents)
 
-    if (PTR_VALID((*pNode).left)) then self -> FreeBTree, (*pNode).left
-    if (PTR_VALID((*pNode).right)) then self -> FreeBTree, (*pNode).right
+end
+;   }}}
 
-    PTR_FREE, pNode
+
+;   RHTgrCamera::CullStatic {{{
+pro RHTgrCamera::CullStatic,    transform, $
+                                lod=lod
+
+    ;  Traverse the static BVH and create the static model visibility mask
+    ;  based on current transformation and frustum dimensions.  The BVH is
+    ;  in world space so the frustum planes are moved into world space by
+    ;  the DLM rather than transforming every node.  The plane cache carries
+    ;  each node's last rejecting plane over to the next frame.  When level
+    ;  of detail selection is enabled the DLM returns the level of each
+    ;  visible model from the same traversal.
+
+    compile_opt idl2
+
+    if (self.lod) then $
+        null = RHTgrCamera_BVHCull(*self.pStaticBVH, self.frustPlanes, $
+            TRANSFORM=transform, CACHE=*self.pStaticCache, MASK=mask, $
+            STATS=stats, EYE=self.eye[2], LOD=lod, $
+            LOD_ERRORS=self -> LODErrors()) $
+    else null = RHTgrCamera_BVHCull(*self.pStaticBVH, self.frustPlanes, $
+        TRANSFORM=transform, CACHE=*self.pStaticCache, MASK=mask, $
+        STATS=stats)
+    *self.pTempMask = mask
+    self.cullStats = self.cullStats + stats
 
 end
 ;   }}}
 
 
-;   RHTgrCamera::CullStatic {{{
-pro RHTgrCamera::CullStatic,    node, $
-                                transform, $
-                                root=root
+;   RHTgrCamera::LODErrors {{{
+function RHTgrCamera::LODErrors
 
-    ;  Traverse binary tree and create static model visibility mask
-    ;  based on current transformation and frustum dimensions.
+    ;  Scale the level of detail errors so that an error of 1 is the
+    ;  tolerated error for a model of unit radius at unit distance from
+    ;  the eye.  The view plane is eye[2] from the eye and view[3] high.
 
     compile_opt idl2
 
-    root = KEYWORD_SET(root)
-    if (root) then *self.pTempMask = REPLICATE(0B, self.nStatic)
-
-    ;  Calculate node min and max, transform and test intersection
-    minMax = DBLARR(3,2, /NOZERO)
-    minMax[*,0] = (*node).data.position - (*node).data.extents
-    minMax[*,1] = (*node).data.position + (*node).data.extents
-    minMax = RHTgrAABB_CalcBB(minMax[0,*], minMax[1,*], minMax[2,*], [0D,1D], $
-        [0D,1D], [0D,1D], transform)
-    ext = (minMax[*,1] - minMax[*,0]) * 0.5
-    pos = minMax[*,0] + ext
-    inview = RHTgrCamera_AABBIntersectFrustum(pos, ext, self.frustPlanes, $
-        CLIPMASK=clip)
-
-    ;  Node completely out of view.
-    if (not(inview)) then begin
-        (*self.ptempmask)[(*node).data.models] = 0B
-        RETURN
-    endif
+    RETURN, *self.pLODErrors * (self.eye[2] / (self.view[3] * $
+        self.lodTolerance))
 
-    ;  Node completely in view.
-    if (clip eq 0) then begin
-        (*self.ptempmask)[(*node).data.models] = 1B
-        RETURN
-    endif
+end
+;   }}}
 
-    ;  Node partially in view.  Continue with right node.
-    if (PTR_VALID((*node).right)) then begin
-        (*self.ptempmask)[(*(*node).right).data.models] = 1B
-        self -> CullStatic, (*node).right, transform
-    endif
 
-    ;  Save the state of any duplicate models.
-    if ((*(*node).data.duplicates)[0] ge 0) then $
-        c = (*self.ptempmask)[(*(*node).right).data.models[ $
-            (*(*node).data.duplicates)[*,1]]]
+;   RHTgrCamera::BoxLOD {{{
+function RHTgrCamera::BoxLOD,   position, $
+                                extents, $
+                                mask
 
-    ;  On to the left node...
-    if (PTR_VALID((*node).left)) then begin
-        (*self.ptempmask)[(*(*node).left).data.models] = 1B
-        self -> CullStatic, (*node).left, transform
-    endif
+    ;  Pick the level of detail of view space boxes in the same way as
+    ;  RHTgrCamera_BVHCull: the coarsest level whose scaled error times
+    ;  the box radius is within the distance from the eye.  Boxes around
+    ;  the eye and culled boxes get level 0.
+
+    compile_opt idl2
+
+    errors = self -> LODErrors()
+    radius = SQRT(TOTAL(extents^2, 1))
+    dist = self.eye[2] - REFORM(position[2,*])
+
+    lod = BYTARR(N_ELEMENTS(radius))
+    for l=1, N_ELEMENTS(errors)-1 do $
+        lod = lod > BYTE(l * (errors[l] * radius le dist))
+    lod[WHERE((dist le radius) or (mask eq 0), /NULL)] = 0B
 
-    ;  'OR' left vs right duplicates.
-    if ((*(*node).data.duplicates)[0] ge 0) then $
-        (*self.ptempmask)[(*(*node).left).data.models[ $
-            (*(*node).data.duplicates)[*,0]]] = (*self.ptempmask)[$
-            (*(*node).left).data.models[(*(*node).data.duplicates)[*,0]]] or c
+    RETURN, lod
 
 end
 ;   }}}
 
 
-;   RHTgrCamera::GetRootNode {{{
-function RHTgrCamera::GetRootNode,  null=null
+;   RHTgrCamera::SetLOD {{{
+pro RHTgrCamera::SetLOD,    oModels, $
+                            levels, $
+                            lod, $
+                            mask
 
-    ;  Return root btree node.
+    ;  Pass changed levels of detail on to the visible RHTgrPSolid models
+    ;  and record them in levels.  Culled models keep their last level.
 
-    compile_opt IDL2
+    compile_opt idl2
 
-    if (KEYWORD_SET(null)) then begin
-        pNode = PTR_NEW({data:{position:0, extents:0, $
-            models:0, duplicates:PTR_NEW([[-1],[-1]])}, $
-            left:PTR_NEW(), right:PTR_NEW()})
-    endif else begin
-        self.oStaticModel -> GetAABB, POSITION=position, EXTENTS=extents
-        pNode = PTR_NEW({data:{position:position, extents:extents, $
-            models:LINDGEN(self.nstatic), duplicates:PTR_NEW([[-1],[-1]])}, $
-            left:PTR_NEW(), right:PTR_NEW()})
-    endelse
+    chIdx = WHERE(mask and (lod ne levels), nChange)
+    if (nChange eq 0) then RETURN
+    levels[chIdx] = lod[chIdx]
 
-    RETURN, pNode
+    solids = WHERE(OBJ_ISA(oModels[chIdx], 'RHTgrPSolid'), nChange)
+    for n=0L, nChange-1 do $
+        oModels[chIdx[solids[n]]] -> SetProperty, $
+            LEVEL=levels[chIdx[solids[n]]]
 
 end
 ;   }}}
@@ -1305,13 +1509,14 @@ pro RHTgrCamera::Cleanup
 
     compile_opt IDL2
 
-    self -> FreeBTree, self.pRootNode
-
     OBJ_DESTROY, [self.oOrientation, self.oQuatA, self.oQuatB, $
         self.oDynamicModel, self.oCamModel, self.oStaticModel]
 
     PTR_FREE, self.pDynamicMask, self.pDynamicModels, self.pStaticModels, $
-        self.pStaticMask, self.pRootNode, self.pTempMask
+        self.pStaticMask, self.pStaticBVH, self.pStaticCache, self.pTempMask, $
+        self.pStaticPosition, self.pStaticExtents, self.pOccluderPosition, $
+        self.pOccluderExtents, self.pStaticLOD, self.pDynamicLOD, $
+        self.pLODErrors
 
     self -> IDLgrView::Cleanup
 
@@ -1338,19 +1543,33 @@ pro RHTgrCamera__Define
             pStaticMask:PTR_NEW(), $
             pTempMask:PTR_NEW(), $
             pStaticModels:PTR_NEW(), $
-            pRootNode:PTR_NEW(), $
+            pStaticBVH:PTR_NEW(), $
+            pStaticCache:PTR_NEW(), $
+            pStaticPosition:PTR_NEW(), $
+            pStaticExtents:PTR_NEW(), $
+            pOccluderPosition:PTR_NEW(), $
+            pOccluderExtents:PTR_NEW(), $
+            pStaticLOD:PTR_NEW(), $
+            pDynamicLOD:PTR_NEW(), $
+            pLODErrors:PTR_NEW(), $
 
             aspectRatio:FLTARR(3), $
             cameraLocation:DBLARR(3), $
+            cullStats:LON64ARR(5), $
             dcue:DBLARR(2), $
             destDims:INTARR(2), $
             dRadeg:0D, $
             fov:DBLARR(2), $
             frustum:DBLARR(3,8), $
+            hizDims:LONARR(2), $
             lock:0B, $
+            lod:0B, $
+            lodTolerance:0D, $
             lookat:DBLARR(3), $
             nDynamic:0L, $
             nStatic:0L, $
+            occlusion:0B, $
+            occlusionStats:LON64ARR(2), $
             pitch:0D, $
             frustPlanes:DBLARR(4,6), $
             roll:0D, $
@@ -26,7 +26,7 @@
 ;
 ;   oModel = OBJ_NEW('RHTgrPsolid' [,/TETRAHEDRON] [,/HEXAHEDRON] $
 ;               [,/OCTAHEDRON] [,/ICOSAHEDRON] [,/DODECAHEDRON] $
-;               [,POSITION={x,y,z}] [,RADIUS=float])
+;               [,POSITION={x,y,z}] [,RADIUS=float] [,LEVELS=n] [,LEVEL=l])
 ;
 ;
 ; KEYWORDS:
@@ -43,6 +43,24 @@
 ;        icosohedron:   Set this keyword to create the 20 faced polygon
 ;                       object known as the icosohedron.
 ;
+;              level:   Set this keyword to the level of detail to display.
+;                       Level 0 is the finest.  Default: 0
+;
+;             levels:   Set this keyword to the number of levels of detail
+;                       to build.  Level 0 is the solid subdivided LEVELS-1
+;                       times with every new vertex pushed out to the
+;                       circumscribed sphere, level LEVELS-1 is the plain
+;                       solid.  Each subdivision splits every triangle into
+;                       four.  Up to 9 levels.  Default: 1
+;
+;         lod_errors:   (Get only) Returns a LEVELS element vector holding
+;                       the largest distance between each level's surface
+;                       and the sphere as a fraction of the radius.  Pass
+;                       these to the LOD_ERRORS property of RHTgrCamera to
+;                       have the camera choose the level of each solid.
+;
+;           n_levels:   (Get only) Returns the number of levels of detail.
+;
 ;         octahedron:   Set this keyword to create the 8 faced polygon
 ;                       object known as the dodecahedron.
 ;
@@ -57,7 +75,7 @@
 ;       SetProperty:
 ;
 ;
-; DEPENDENCIES: None.
+; DEPENDENCIES: RHTgrCamera.dlm
 ;
 ;
 ; EXAMPLE:
@@ -74,6 +92,11 @@
 ;
 ; MODIFICATION HISTORY:
 ;       Written by: Rick Towler, 27 October 2002.
+;       Added subdivided levels of detail (LEVELS, LEVEL, LOD_ERRORS).
+;       Meshes are now generated with shared vertices and cached by the
+;       RHTgrCamera DLM.
+;       Solids of the same type now share each level's vertex data
+;       (SHARE_DATA) instead of holding a copy per solid.
 ;
 ;
 ; LICENSE
@@ -107,6 +130,9 @@ function RHTgrPSolid::Init, tetrahedron=tetra, $
                             octahedron=octa, $
                             dodecahedron=dodeca, $
                             icosahedron=icosa, $
+                            hide=hide, $
+                            level=level, $
+                            levels=levels, $
                             radius=radius, $
                             position=position, $
                             _extra=extra
@@ -123,11 +149,20 @@ function RHTgrPSolid::Init, tetrahedron=tetra, $
     self.position = (N_ELEMENTS(position) ne 3) ? [0.,0.,0.] : position
     self.radius = (N_ELEMENTS(radius) ne 1) ? 1.0 : radius
 
-    ok = self->IDLgrModel::Init(/SELECT_TARGET, _Extra=extra)
+    ok = self->IDLgrModel::Init(/SELECT_TARGET, HIDE=hide, _Extra=extra)
     if (not ok) then RETURN, 0
 
-    self.oPolygon = OBJ_NEW('IDLgrPolygon', _EXTRA=extra)
-    self -> Add, self.oPolygon
+    self.nLevels = (N_ELEMENTS(levels) ne 1) ? 1 : 1 > FIX(levels) < 9
+    self.pLevels = PTR_NEW(OBJARR(self.nLevels))
+    self.pErrors = PTR_NEW(FLTARR(self.nLevels))
+    for n=0, self.nLevels-1 do begin
+        (*self.pLevels)[n] = OBJ_NEW('IDLgrPolygon', HIDE=1, _EXTRA=extra)
+        self -> Add, (*self.pLevels)[n]
+    endfor
+    self.level = (N_ELEMENTS(level) ne 1) ? 0 : 0 > FIX(level) < $
+        (self.nLevels - 1)
+    self.oPolygon = (*self.pLevels)[self.level]
+    self.oPolygon -> SetProperty, HIDE=0
 
     self -> MeshSolid, nfaces
     self -> Scale, self.radius, self.radius, self.radius
@@ -143,174 +178,32 @@ end
 ;   RHTgrPSolid::MeshSolid {{{
 pro RHTgrPSolid::MeshSolid, nfaces
 
-    compile_opt idl2
+    ;  Build every level of detail.  Each (type, level) mesh is generated
+    ;  once per IDL session and kept in a hidden IDLgrPolygon in the
+    ;  RHTgrPSolid_Meshes common block.  The levels of every solid render
+    ;  that polygon's vertices thru SHARE_DATA rather than holding their
+    ;  own copy, so only the first solid of each type pays for the mesh.
 
-    case nfaces of
-        4:begin
-            a = SQRT(2.)/3.
-            b = SQRT(6.)/3.
-            c = 1./3.
-            vertices = [[0.,0.,1.], $
-                        [2*a,0.,-c], $
-                        [-a, b,-c], $
-                        [-a, -b,-c]]
-
-            polygons = [3,0,1,2, $
-                        3,0,2,3, $
-                        3,0,3,1, $
-                        3,1,3,2]
-        end
-
-        6:begin
-            vertices = [[-1.,-1.,-1.], $
-                        [1.,-1.,-1.], $
-                        [1.,1.,-1.], $
-                        [-1.,1.,-1.], $
-                        [-1.,-1.,1], $
-                        [1.,-1.,1.], $
-                        [1.,1.,1.], $
-                        [-1.,1.,1.]]
-            vertices = TEMPORARY(vertices) / SQRT(3.0)
-
-            polygons = [3,0,3,2, $
-                        3,0,2,1, $
-                        3,0,1,5, $
-                        3,0,5,4, $
-                        3,0,4,7, $
-                        3,0,7,3, $
-                        3,6,5,1, $
-                        3,6,1,2, $
-                        3,6,2,3, $
-                        3,6,3,7, $
-                        3,6,7,4, $
-                        3,6,4,5]
-        end
-
-        8:begin
-            vertices = [[1.,0.,0.], $
-                        [-1.,0.,0.], $
-                        [0.,1.,0.], $
-                        [0.,-1.,0.], $
-                        [0.,0.,1.], $
-                        [0.,0.,-1.]]
-
-            polygons = [3,4,0,2, $
-                        3,4,2,1, $
-                        3,4,1,3, $
-                        3,4,3,0, $
-                        3,5,2,0, $
-                        3,5,1,2, $
-                        3,5,3,1, $
-                        3,5,0,3]
-        end
-
-        12:begin
-            a = 1. / SQRT(3.)
-            b = SQRT((3. - SQRT(5.))/6.)
-            c = SQRT((3. + SQRT(5.))/6.)
-
-            vertices = [[a,a,a], $
-                        [a,a,-a], $
-                        [a,-a,a], $
-                        [a,-a,-a], $
-                        [-a,a,a], $
-                        [-a,a,-a], $
-                        [-a,-a,a], $
-                        [-a,-a,-a], $
-                        [b,c,0.], $
-                        [-b,c,0.], $
-                        [b,-c,0.], $
-                        [-b,-c,0.], $
-                        [c,0.,b], $
-                        [c,0.,-b], $
-                        [-c,0.,b], $
-                        [-c,0.,-b], $
-                        [0.,b,c], $
-                        [0.,-b,c], $
-                        [0.,b,-c], $
-                        [0.,-b,-c]]
-
-            polygons = [3,0,8,9, $
-                        3,0,9,4, $
-                        3,0,4,16, $
-                        3,0,12,13, $
-                        3,0,13,1, $
-                        3,0,1,8, $
-                        3,0,16,17, $
-                        3,0,17,2, $
-                        3,0,2,12, $
-                        3,8,1,18, $
-                        3,8,18,5, $
-                        3,8,5,9, $
-                        3,12,2,10, $
-                        3,12,10,3, $
-                        3,12,3,13, $
-                        3,16,4,14, $
-                        3,16,14,6, $
-                        3,16,6,17, $
-                        3,9,5,15, $
-                        3,9,15,14, $
-                        3,9,14,4, $
-                        3,6,11,10, $
-                        3,6,10,2, $
-                        3,6,2,17, $
-                        3,3,19,18, $
-                        3,3,18,1, $
-                        3,3,1,13, $
-                        3,7,15,5, $
-                        3,7,5,18, $
-                        3,7,18,19, $
-                        3,7,11,6, $
-                        3,7,6,14, $
-                        3,7,14,15, $
-                        3,7,19,3, $
-                        3,7,3,10, $
-                        3,7,10,11]
-
-        end
-        20:begin
-
-            a = 1. + SQRT(5.)
-
-            vertices = [[a,1.,0.], $
-                        [-a,1.,0.], $
-                        [a,-1.,0.], $
-                        [-a,-1.,0.], $
-                        [1.,0.,a], $
-                        [1.,0.,-a], $
-                        [-1.,0.,a], $
-                        [-1.,0.,-a], $
-                        [0.,a,1.], $
-                        [0.,-a,1.], $
-                        [0.,a,-1.], $
-                        [0.,-a,-1.]]
-
-            vertices = TEMPORARY(vertices) / SQRT(1. + a^2)
-
-            polygons = [3,0,8,4, $
-                        3,0,5,10, $
-                        3,2,4,9, $
-                        3,2,11,5, $
-                        3,1,6,8, $
-                        3,1,10,7, $
-                        3,3,9,6, $
-                        3,3,7,11, $
-                        3,0,10,8, $
-                        3,1,8,10, $
-                        3,2,9,11, $
-                        3,3,11,9, $
-                        3,4,2,0, $
-                        3,5,0,2, $
-                        3,6,1,3, $
-                        3,7,3,1, $
-                        3,8,6,4, $
-                        3,9,4,6, $
-                        3,10,5,7, $
-                        3,11,7,5]
-        end
-    endcase
+    compile_opt idl2
 
-    self.oPolygon -> SetProperty, DATA=vertices, POLYGONS=polygons
+    common RHTgrPSolid_Meshes, meshes
+
+    if (N_ELEMENTS(meshes) eq 0) then meshes = HASH()
+
+    for l=0, self.nLevels-1 do begin
+        subdiv = self.nLevels - 1 - l
+        key = STRING(nfaces, subdiv, FORMAT='(I0,"_",I0)')
+        if (~meshes.HasKey(key)) then begin
+            vertices = RHTgrCamera_GeodesicMesh(nfaces, subdiv, $
+                POLYGONS=polygons, ERROR=error)
+            meshes[key] = {oData:OBJ_NEW('IDLgrPolygon', vertices, $
+                POLYGONS=polygons, /HIDE), polygons:polygons, error:error}
+        endif
+        mesh = meshes[key]
+        (*self.pErrors)[l] = mesh.error
+        (*self.pLevels)[l] -> SetProperty, SHARE_DATA=mesh.oData, $
+            POLYGONS=mesh.polygons
+    endfor
 
 end
 ;   }}}
@@ -322,6 +215,8 @@ pro RHTgrPSolid::SetProperty,   tetrahedron=tetra, $
                                 octahedron=octa, $
                                 dodecahedron=dodeca, $
                                 icosahedron=icosa, $
+                                hide=hide, $
+                                level=level, $
                                 radius=radius, $
                                 position=position, $
                                 _extra=extra
@@ -330,8 +225,20 @@ pro RHTgrPSolid::SetProperty,   tetrahedron=tetra, $
 
     update = 0B
 
-    self -> IDLgrModel::SetProperty, _EXTRA=extra
-    self.oPolygon -> SetProperty, _EXTRA=extra
+    ;  HIDE applies to the model, the levels hide themselves.
+    self -> IDLgrModel::SetProperty, HIDE=hide, _EXTRA=extra
+    for n=0, self.nLevels-1 do $
+        (*self.pLevels)[n] -> SetProperty, _EXTRA=extra
+
+    if (N_ELEMENTS(level) eq 1) then begin
+        level = 0 > FIX(level) < (self.nLevels - 1)
+        if (level ne self.level) then begin
+            self.oPolygon -> SetProperty, HIDE=1
+            self.level = level
+            self.oPolygon = (*self.pLevels)[level]
+            self.oPolygon -> SetProperty, HIDE=0
+        endif
+    endif
 
     if (KEYWORD_SET(tetra)) then self -> MeshSolid, 4
     if (KEYWORD_SET(hexa)) then self -> MeshSolid, 6
@@ -361,12 +268,18 @@ end
 
 
 ;   RHTgrPSolid::GetProperty {{{
-pro RHTgrPSolid::GetProperty,   object=object, $
+pro RHTgrPSolid::GetProperty,   level=level, $
+                                lod_errors=lodErrors, $
+                                n_levels=nLevels, $
+                                object=object, $
                                 _ref_extra=extra
 
 
     compile_opt idl2
 
+    level = self.level
+    lodErrors = *self.pErrors
+    nLevels = self.nLevels
     object = self.oPolygon
 
     self -> IDLgrModel::GetProperty, _EXTRA=extra
@@ -381,7 +294,8 @@ pro RHTgrPSolid::Cleanup
 
     compile_opt idl2
 
-    OBJ_DESTROY, self.oPolygon
+    OBJ_DESTROY, *self.pLevels
+    PTR_FREE, self.pLevels, self.pErrors
 
     self->IDLgrModel::Cleanup
 
@@ -395,6 +309,10 @@ pro RHTgrPSolid__Define
     struct={RHTgrPSolid, $
             Inherits IDLgrModel, $
             oPolygon:OBJ_NEW(), $
+            pLevels:PTR_NEW(), $
+            pErrors:PTR_NEW(), $
+            level:0, $
+            nLevels:0, $
             radius:0., $
             position:FLTARR(3) $
            }
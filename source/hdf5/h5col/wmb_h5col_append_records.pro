@@ -0,0 +1,52 @@
+;
+; wmb_h5col_append_records
+; 
+; Purpose: Adds records to the end of a column table. 
+;
+; Description: Each column is extended to hold the new records, and the
+;              fields of the records are written to their columns.
+;              
+; Parameters:
+; 
+; loc_id
+;     IN: Identifier of the file or group in which the table is located. 
+; group_name
+;     IN: The name of the group holding the table. 
+; nrecords
+;     IN: The number of records to insert. 
+; databuffer
+;     IN: Buffer with data. 
+;
+
+pro wmb_h5col_append_records, loc_id, $
+                              group_name, $
+                              nrecords, $
+                              databuffer
+
+    compile_opt idl2, strictarrsubs
+
+    ; get the original number of records and fields
+
+    wmb_h5col_get_table_info, loc_id, group_name, nfields, nrecords_orig
+
+    gid = h5g_open(loc_id, group_name)
+
+    for i = 0, nfields-1 do begin
+
+        tmpstr = 'FIELD_' + strtrim(string(i),2) + '_NAME'
+        wmb_h5lt_get_attribute_disk, gid, tmpstr, field_name
+
+        did = h5d_open(gid, field_name)
+
+        wmb_h5tb_common_append_records, did, $
+                                        nrecords, $
+                                        nrecords_orig, $
+                                        databuffer.(i)
+
+        h5d_close, did
+
+    endfor
+
+    h5g_close, gid
+
+end
@@ -0,0 +1,57 @@
+;
+; wmb_h5col_get_field_info
+;
+; Purpose: Gets the record definition of a column table.
+;
+; Description: Returns a structure variable with one field for each 
+;              column, in the order of the FIELD_n_NAME attributes.  As
+;              for wmb_h5tb_get_field_info, string fields are filled 
+;              with underscore "_" characters to represent their size.
+;
+; Parameters:
+;
+;    loc_id
+;        IN: Identifier of the file or group where the table is located.
+;    group_name
+;        IN: The name of the group holding the table.
+;    record_definition
+;       OUT: The record definition.
+;
+
+
+pro wmb_h5col_get_field_info, loc_id, $
+                              group_name, $
+                              record_definition
+
+    compile_opt idl2, strictarrsubs
+
+    gid = h5g_open(loc_id, group_name)
+
+    nfields = h5g_get_num_objs(gid)
+
+    for i = 0, nfields-1 do begin
+
+        tmpstr = 'FIELD_' + strtrim(string(i),2) + '_NAME'
+        wmb_h5lt_get_attribute_disk, gid, tmpstr, field_name
+
+        did = h5d_open(gid, field_name)
+        tid = h5d_get_type(did)
+
+        if h5t_get_class(tid) eq 'H5T_STRING' then begin
+            data_def = string(replicate(95b, h5t_get_size(tid)-1))
+        endif else begin
+            data_def = fix(0, TYPE=h5t_idltype(tid))
+        endelse
+
+        h5t_close, tid
+        h5d_close, did
+
+        if i eq 0 then record_definition = create_struct(field_name, data_def) $
+                  else record_definition = create_struct(record_definition, $
+                                                         field_name, data_def)
+
+    endfor
+
+    h5g_close, gid
+
+end
@@ -0,0 +1,64 @@
+;
+; wmb_h5col_get_table_info
+;
+; Purpose: Gets the number of fields and records of a column table.
+;
+; Parameters:
+;
+;    loc_id
+;        IN: Identifier of the file or group where the table is located.
+;    group_name
+;        IN: The name of the group holding the table.
+;    nfields
+;       OUT: The number of fields.
+;    nrecords
+;       OUT: The number of records.
+;    title, class
+;       OUT: The TITLE and CLASS attributes (optional keywords).
+;
+
+
+pro wmb_h5col_get_table_info, loc_id, $
+                              group_name, $
+                              nfields, $
+                              nrecords, $
+                              title=title, $
+                              class=class
+
+    compile_opt idl2, strictarrsubs
+
+    ; open the group
+
+    gid = h5g_open(loc_id, group_name)
+
+    ; each field is stored in one dataset
+
+    nfields = ulong64(h5g_get_num_objs(gid))
+
+    ; the number of records is the length of the first column
+
+    wmb_h5lt_get_attribute_disk, gid, 'FIELD_0_NAME', field_name
+
+    did = h5d_open(gid, field_name)
+    sid = h5d_get_space(did)
+
+    dims = h5s_get_simple_extent_dims(sid)
+
+    nrecords = ulong64(dims[0])
+
+    h5s_close, sid
+    h5d_close, did
+
+    ; get the table title and class attributes
+
+    wmb_h5lt_get_attribute_disk, gid, 'TITLE', table_title
+    wmb_h5lt_get_attribute_disk, gid, 'CLASS', gid_class
+
+    title = table_title
+    class = gid_class
+
+    ; close
+
+    h5g_close, gid
+
+end
@@ -0,0 +1,118 @@
+;
+; wmb_h5col_make_table
+;
+; Purpose:      Creates and writes a column table.
+;
+; Description:  wmb_h5col_make_table creates a group named group_name 
+;               attached to the object specified by the identifier 
+;               loc_id, which holds one chunked, extendible dataset for
+;               each field of the record definition.  A column can then
+;               be read or written without reading the other fields.
+;               
+;               The group has the attributes CLASS (COLUMN_TABLE), 
+;               VERSION and TITLE, and the attributes FIELD_n_NAME give
+;               the order of the fields, as for an H5TB table.
+;
+; Notes: The fields must be scalar numbers or strings.
+;
+; Parameters:
+; 
+; table_title
+;     IN: The title of the table.
+; loc_id
+;     IN: Identifier of the file or group to create the table within.
+; group_name
+;     IN: The name of the group to create.
+; nrecords
+;     IN: The number of records in the table.
+; record_definition
+;     IN: A structure variable which defines the field names and data types 
+;         of each record.
+; chunk_size
+;     IN: The chunk size, in records.
+; compress
+;     IN: Flag that turns compression on or off.
+; databuffer 
+;     IN: Data to be written to the table (optional).
+;     
+
+
+pro wmb_h5col_make_table, table_title, $
+                          loc_id, $
+                          group_name, $
+                          nrecords, $
+                          record_definition, $
+                          chunk_size, $
+                          compress, $
+                          databuffer = databuffer
+
+    compile_opt idl2, strictarrsubs
+
+    dims = ulon64arr(1)
+    maxdims = lon64arr(1)
+    dims_chunk = ulon64arr(1)
+
+    const_TABLE_CLASS = 'COLUMN_TABLE'
+    const_TABLE_VER = 1.0
+
+    dims[0] = nrecords
+    dims_chunk[0] = chunk_size
+
+    ; a simple data space with unlimited size
+
+    maxdims[0] = -1
+
+    nfields = n_tags(record_definition)
+    field_names = tag_names(record_definition)
+
+    ; create the group
+
+    gid = h5g_create(loc_id, group_name)
+
+    for i = 0, nfields-1 do begin
+
+        ; create the column
+
+        type_id = h5t_idl_create(record_definition.(i))
+
+        sid = h5s_create_simple(dims, max_dimensions = maxdims)
+
+        if compress eq 0 then begin
+
+            did = h5d_create(gid, field_names[i], type_id, sid, $
+                             CHUNK_DIMENSIONS=dims_chunk)
+
+        endif else begin
+
+            compr_level = 6
+            did = h5d_create(gid, field_names[i], type_id, sid, $
+                             CHUNK_DIMENSIONS=dims_chunk, GZIP=compr_level)
+
+        endelse
+
+        ; only write if there is something to write
+
+        if N_elements(databuffer) ne 0 then h5d_write, did, databuffer.(i)
+
+        h5s_close, sid
+        h5d_close, did
+        h5t_close, type_id
+
+    endfor
+
+    h5g_close, gid
+
+    ; attach the CLASS, VERSION, TITLE and FIELD_ name attributes
+
+    wmb_h5lt_set_attribute_string, loc_id, group_name, 'CLASS', const_TABLE_CLASS
+    wmb_h5lt_set_attribute_string, loc_id, group_name, 'VERSION', const_TABLE_VER
+    wmb_h5lt_set_attribute_string, loc_id, group_name, 'TITLE', table_title
+
+    for i = 0, nfields-1 do begin
+
+        tmpstr = 'FIELD_' + strtrim(string(i),2) + '_NAME'
+        wmb_h5lt_set_attribute_string, loc_id, group_name, tmpstr, field_names[i]
+
+    endfor
+
+end
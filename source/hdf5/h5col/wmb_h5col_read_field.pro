@@ -0,0 +1,67 @@
+;
+; wmb_h5col_read_field
+;
+; Purpose: Reads records of one column of a column table.
+;
+; Description: Only the dataset holding the column is read.  The 
+;              records are selected by the keywords, as described in
+;              wmb_h5col_select.
+;
+; Parameters:
+;
+;    loc_id
+;        IN: Identifier of the file or group where the table is located.
+;    group_name
+;        IN: The name of the group holding the table.
+;    field_index
+;        IN: The index of the field to read.
+;    databuffer
+;       OUT: Array of the column values.
+;    start, nrecords, stride, index
+;        IN: The records to read (optional keywords).
+;
+
+
+pro wmb_h5col_read_field, loc_id, $
+                          group_name, $
+                          field_index, $
+                          databuffer, $
+                          start = start, $
+                          nrecords = nrecords, $
+                          stride = stride, $
+                          index = index
+
+    compile_opt idl2, strictarrsubs
+
+    mem_size = ulon64arr(1)
+
+    ; open the column
+
+    gid = h5g_open(loc_id, group_name)
+
+    tmpstr = 'FIELD_' + strtrim(string(field_index),2) + '_NAME'
+    wmb_h5lt_get_attribute_disk, gid, tmpstr, field_name
+
+    did = h5d_open(gid, field_name)
+
+    sid = h5d_get_space(did)
+
+    ; select the records
+
+    mem_size[0] = wmb_h5col_select(sid, start = start, $
+                                        nrecords = nrecords, $
+                                        stride = stride, $
+                                        index = index)
+
+    m_sid = h5s_create_simple(mem_size)
+
+    databuffer = h5d_read(did, MEMORY_SPACE=m_sid, FILE_SPACE=sid)
+
+    ; close
+
+    h5s_close, m_sid
+    h5s_close, sid
+    h5d_close, did
+    h5g_close, gid
+
+end
@@ -0,0 +1,52 @@
+;
+; wmb_h5col_read_records
+;
+; Purpose: Reads records from a column table.
+;
+; Description: Each column is read in turn and copied into an array of
+;              records.  The records are selected by the keywords, as
+;              described in wmb_h5col_select.
+;
+; Parameters:
+;
+;    loc_id
+;        IN: Identifier of the file or group where the table is located.
+;    group_name
+;        IN: The name of the group holding the table.
+;    databuffer
+;       OUT: Array of records.
+;    start, nrecords, stride, index
+;        IN: The records to read (optional keywords).
+;
+
+
+pro wmb_h5col_read_records, loc_id, $
+                            group_name, $
+                            databuffer, $
+                            start = start, $
+                            nrecords = nrecords, $
+                            stride = stride, $
+                            index = index
+
+    compile_opt idl2, strictarrsubs
+
+    wmb_h5col_get_field_info, loc_id, group_name, record_definition
+
+    nfields = n_tags(record_definition)
+
+    for i = 0, nfields-1 do begin
+
+        wmb_h5col_read_field, loc_id, group_name, i, field_data, $
+                              start = start, $
+                              nrecords = nrecords, $
+                              stride = stride, $
+                              index = index
+
+        if i eq 0 then databuffer = replicate(record_definition, $
+                                              N_elements(field_data))
+
+        databuffer.(i) = temporary(field_data)
+
+    endfor
+
+end
@@ -0,0 +1,91 @@
+;
+; wmb_h5col_select
+;
+; Purpose: Private function which selects records in the data space of
+;          one column of a column table.
+;
+; Description: The records are either given by an array of record 
+;              indices, or by a range of nrecords records beginning at
+;              start, with a stride which may be negative.  The records
+;              are transferred in the order in which they are given.
+;
+; Return value: The number of records selected.
+;
+; Parameters:
+;
+;    sid
+;        IN: The data space of the column.
+;    start, nrecords, stride
+;        IN: The range of records (optional keywords).  By default all
+;            records from start to the end of the column are selected.
+;    index
+;        IN: The indices of the records (optional keyword).
+;
+
+
+function wmb_h5col_select, sid, $
+                           start = start, $
+                           nrecords = nrecords, $
+                           stride = stride, $
+                           index = index
+
+    compile_opt idl2, strictarrsubs
+
+    dims = h5s_get_simple_extent_dims(sid)
+    table_size = long64(dims[0])
+
+    if N_elements(start) eq 0 then start = 0LL
+    if N_elements(stride) eq 0 then stride = 1LL
+
+    if stride eq 0 then message, 'Invalid stride value'
+
+    if N_elements(index) eq 0 then begin
+
+        if N_elements(nrecords) eq 0 then $
+            nrecords = (table_size - start + abs(stride) - 1) / abs(stride)
+
+        ; a negative stride is read as a list of records
+
+        if stride lt 0 then index = start + stride * l64indgen(nrecords)
+
+    endif
+
+
+    if N_elements(index) ne 0 then begin
+
+        n_sel = N_elements(index)
+
+        ; make sure the indices are in bounds
+
+        if min(index) lt 0 || max(index) gt (table_size-1) then $
+            message, 'Invalid index value'
+
+        elements = ulon64arr(1, n_sel)
+        elements[0] = index
+
+        h5s_select_elements, sid, elements, /RESET
+
+    endif else begin
+
+        n_sel = long64(nrecords)
+
+        ; make sure the request is in bounds
+
+        if start lt 0 || (start + (n_sel-1) * stride) ge table_size then $
+            message, 'Request out of bounds'
+
+        offset = ulon64arr(1)
+        count = ulon64arr(1)
+        rangestride = ulon64arr(1)
+
+        offset[0] = start
+        count[0] = n_sel
+        rangestride[0] = stride
+
+        h5s_select_hyperslab, sid, offset, count, STRIDE=rangestride, /RESET
+
+    endelse
+
+    return, ulong64(n_sel)
+
+end
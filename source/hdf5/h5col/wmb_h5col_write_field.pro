@@ -0,0 +1,80 @@
+;
+; wmb_h5col_write_field
+;
+; Purpose: Writes records of one column of a column table.
+;
+; Description: Only the dataset holding the column is written.  The 
+;              records are selected by the keywords, as described in
+;              wmb_h5col_select.  A single value is written to every
+;              selected record.
+;
+; Parameters:
+;
+;    loc_id
+;        IN: Identifier of the file or group where the table is located.
+;    group_name
+;        IN: The name of the group holding the table.
+;    field_index
+;        IN: The index of the field to write.
+;    databuffer
+;        IN: Array of the column values.
+;    start, nrecords, stride, index
+;        IN: The records to write (optional keywords).  By default
+;            nrecords is the number of elements of databuffer.
+;
+
+
+pro wmb_h5col_write_field, loc_id, $
+                           group_name, $
+                           field_index, $
+                           databuffer, $
+                           start = start, $
+                           nrecords = nrecords, $
+                           stride = stride, $
+                           index = index
+
+    compile_opt idl2, strictarrsubs
+
+    mem_size = ulon64arr(1)
+
+    if N_elements(nrecords) eq 0 && N_elements(index) eq 0 then $
+        nrecords = N_elements(databuffer)
+
+    ; open the column
+
+    gid = h5g_open(loc_id, group_name)
+
+    tmpstr = 'FIELD_' + strtrim(string(field_index),2) + '_NAME'
+    wmb_h5lt_get_attribute_disk, gid, tmpstr, field_name
+
+    did = h5d_open(gid, field_name)
+
+    sid = h5d_get_space(did)
+
+    ; select the records
+
+    mem_size[0] = wmb_h5col_select(sid, start = start, $
+                                        nrecords = nrecords, $
+                                        stride = stride, $
+                                        index = index)
+
+    if N_elements(databuffer) eq 1 && mem_size[0] gt 1 then begin
+        tmp_data = replicate(databuffer[0], mem_size[0])
+    endif else begin
+        if N_elements(databuffer) ne mem_size[0] then $
+            message, 'Array subscript does not match size of input data'
+        tmp_data = databuffer
+    endelse
+
+    m_sid = h5s_create_simple(mem_size)
+
+    h5d_write, did, tmp_data, MEMORY_SPACE_ID = m_sid, FILE_SPACE_ID = sid
+
+    ; close
+
+    h5s_close, m_sid
+    h5s_close, sid
+    h5d_close, did
+    h5g_close, gid
+
+end
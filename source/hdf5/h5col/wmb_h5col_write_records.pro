@@ -0,0 +1,46 @@
+;
+; wmb_h5col_write_records
+;
+; Purpose: Writes records to a column table.
+;
+; Description: Each field of the records is written to its column.  The
+;              fields of databuffer must be in the order of the columns.
+;              The records are selected by the keywords, as described in
+;              wmb_h5col_write_field.
+;
+; Parameters:
+;
+;    loc_id
+;        IN: Identifier of the file or group where the table is located.
+;    group_name
+;        IN: The name of the group holding the table.
+;    databuffer
+;        IN: Array of records.
+;    start, nrecords, stride, index
+;        IN: The records to write (optional keywords).
+;
+
+
+pro wmb_h5col_write_records, loc_id, $
+                             group_name, $
+                             databuffer, $
+                             start = start, $
+                             nrecords = nrecords, $
+                             stride = stride, $
+                             index = index
+
+    compile_opt idl2, strictarrsubs
+
+    nfields = n_tags(databuffer)
+
+    for i = 0, nfields-1 do begin
+
+        wmb_h5col_write_field, loc_id, group_name, i, databuffer.(i), $
+                               start = start, $
+                               nrecords = nrecords, $
+                               stride = stride, $
+                               index = index
+
+    endfor
+
+end
@@ -0,0 +1,39 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_axis_angle_to_quaternion_array
+;
+;   Batch form of wmb_axis_angle_to_quaternion.  The input is a 4xN
+;   array of [axis_x, axis_y, axis_z, angle_rad] and the result is a
+;   4xN double array of quaternions [x, y, z, w].
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_axis_angle_to_quaternion_array, axisangle_arr
+
+    compile_opt idl2, strictarrsubs
+
+    naa = N_elements(axisangle_arr) / 4
+
+    if naa eq 0 || N_elements(axisangle_arr) ne 4*naa then $
+        message, 'Invalid input'
+
+    AA = reform(axisangle_arr, 4, naa)
+
+    if size(AA, /TYPE) ne 5 then AA = double(AA)
+
+    axis_norm = sqrt(total(AA[0:2,*]^2, 1))
+
+    half_angle = reform(AA[3,*])/2.0D
+
+    sin_half = sin(half_angle)
+
+    q = dblarr(4, naa, /NOZERO)
+
+    q[0,*] = (reform(AA[0,*]) / axis_norm) * sin_half
+    q[1,*] = (reform(AA[1,*]) / axis_norm) * sin_half
+    q[2,*] = (reform(AA[2,*]) / axis_norm) * sin_half
+    q[3,*] = cos(half_angle)
+
+    return, q
+
+end
@@ -0,0 +1,55 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_axis_angle_to_rotation_array
+;
+;   Batch form of wmb_axis_angle_to_rotation.  The input is a 4xN
+;   array of [axis_x, axis_y, axis_z, angle_rad] and the result is a
+;   3x3xN double array in which R[*,*,i] is the rotation matrix of
+;   axis-angle i.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_axis_angle_to_rotation_array, axisangle_arr
+
+    compile_opt idl2, strictarrsubs
+
+    naa = N_elements(axisangle_arr) / 4
+
+    if naa eq 0 || N_elements(axisangle_arr) ne 4*naa then $
+        message, 'Invalid input'
+
+    AA = reform(axisangle_arr, 4, naa)
+
+    if size(AA, /TYPE) ne 5 then AA = double(AA)
+
+    axis_norm = sqrt(total(AA[0:2,*]^2, 1))
+
+    ux = reform(AA[0,*]) / axis_norm
+    uy = reform(AA[1,*]) / axis_norm
+    uz = reform(AA[2,*]) / axis_norm
+
+    uxy = ux * uy
+    uxz = ux * uz
+    uyz = uy * uz
+
+    c = cos(reform(AA[3,*]))
+    s = sin(reform(AA[3,*]))
+    omc = (1.0D - c)
+
+    AA = 0
+
+    R = dblarr(3, 3, naa, /NOZERO)
+
+    R[0,0,*] = c + ux*ux*omc
+    R[1,0,*] = uxy*omc - uz*s
+    R[2,0,*] = uxz*omc + uy*s
+    R[0,1,*] = uxy*omc + uz*s
+    R[1,1,*] = c + uy*uy*omc
+    R[2,1,*] = uyz*omc - ux*s
+    R[0,2,*] = uxz*omc - uy*s
+    R[1,2,*] = uyz*omc + ux*s
+    R[2,2,*] = c + uz*uz*omc
+
+    return, R
+
+end
@@ -0,0 +1,71 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_quaternion_multiply_array
+;
+;   Hamilton product q1 * q2 of quaternions [x, y, z, w].  q1 and q2
+;   are 4xN arrays, or either may be a single quaternion which is
+;   applied to every quaternion in the other.  The result is a 4xN
+;   double array.
+;
+;   With the convention of wmb_quaternion_to_rotation the product is
+;   the rotation q2 followed by q1:
+;
+;   wmb_quaternion_to_rotation(wmb_quaternion_multiply_array(q1, q2))
+;       = wmb_quaternion_to_rotation(q1) ## wmb_quaternion_to_rotation(q2)
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_quaternion_multiply_array, q1, q2
+
+    compile_opt idl2, strictarrsubs
+
+    n1 = N_elements(q1) / 4
+    n2 = N_elements(q2) / 4
+
+    if n1 eq 0 || N_elements(q1) ne 4*n1 || $
+       n2 eq 0 || N_elements(q2) ne 4*n2 || $
+       (n1 ne n2 && n1 ne 1 && n2 ne 1) then message, 'Invalid input'
+
+    a = double(reform(q1, 4, n1))
+    b = double(reform(q2, 4, n2))
+
+    x1 = reform(a[0,*])
+    y1 = reform(a[1,*])
+    z1 = reform(a[2,*])
+    w1 = reform(a[3,*])
+
+    x2 = reform(b[0,*])
+    y2 = reform(b[1,*])
+    z2 = reform(b[2,*])
+    w2 = reform(b[3,*])
+
+    a = 0
+    b = 0
+
+    ; a single quaternion is a one element array here, make it a
+    ; scalar so that it is applied to every element of the other
+
+    if n1 eq 1 then begin
+        x1 = x1[0]
+        y1 = y1[0]
+        z1 = z1[0]
+        w1 = w1[0]
+    endif
+
+    if n2 eq 1 then begin
+        x2 = x2[0]
+        y2 = y2[0]
+        z2 = z2[0]
+        w2 = w2[0]
+    endif
+
+    q = dblarr(4, n1 > n2, /NOZERO)
+
+    q[0,*] = w1*x2 + x1*w2 + y1*z2 - z1*y2
+    q[1,*] = w1*y2 - x1*z2 + y1*w2 + z1*x2
+    q[2,*] = w1*z2 + x1*y2 - y1*x2 + z1*w2
+    q[3,*] = w1*w2 - x1*x2 - y1*y2 - z1*z2
+
+    return, q
+
+end
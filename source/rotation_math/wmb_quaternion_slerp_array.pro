@@ -0,0 +1,77 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_quaternion_slerp_array
+;
+;   Spherical linear interpolation between quaternions [x, y, z, w].
+;   q1 and q2 are 4xN arrays, or either may be a single quaternion,
+;   and t is a scalar or an N element array of interpolation
+;   fractions (0 returns q1, 1 returns q2).  The result is a 4xN
+;   double array of unit quaternions.
+;
+;   The inputs are normalized and q2 is negated where needed so that
+;   the interpolation follows the shorter arc.  Where q1 and q2 are
+;   nearly parallel the quaternions are interpolated linearly and
+;   normalized instead.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_quaternion_slerp_array, q1, q2, t
+
+    compile_opt idl2, strictarrsubs
+
+    n1 = N_elements(q1) / 4
+    n2 = N_elements(q2) / 4
+    nt = N_elements(t)
+    n = n1 > n2 > nt
+
+    if n1 eq 0 || N_elements(q1) ne 4*n1 || $
+       n2 eq 0 || N_elements(q2) ne 4*n2 || nt eq 0 || $
+       (n1 ne n && n1 ne 1) || (n2 ne n && n2 ne 1) || $
+       (nt ne n && nt ne 1) then message, 'Invalid input'
+
+    a = double(reform(q1, 4, n1))
+    b = double(reform(q2, 4, n2))
+
+    if n1 eq 1 then a = rebin(a, 4, n, /SAMPLE)
+    if n2 eq 1 then b = rebin(b, 4, n, /SAMPLE)
+
+    frac = (nt eq 1) ? replicate(double(t[0]), n) : double(reform(t, n))
+
+    a = a / rebin(reform(sqrt(total(a^2, 1)), 1, n), 4, n, /SAMPLE)
+    b = b / rebin(reform(sqrt(total(b^2, 1)), 1, n), 4, n, /SAMPLE)
+
+    ; shorter arc
+
+    cos_theta = total(a * b, 1)
+
+    idx = where(cos_theta lt 0.0D, cnt)
+
+    if cnt gt 0 then begin
+        b[*,idx] = -b[*,idx]
+        cos_theta[idx] = -cos_theta[idx]
+    endif
+
+    ; interpolation weights
+
+    wa = 1.0D - frac
+    wb = frac
+
+    idx = where(cos_theta lt 0.9995D, cnt)
+
+    if cnt gt 0 then begin
+        theta = acos(cos_theta[idx] < 1.0D)
+        sin_theta = sin(theta)
+        wa[idx] = sin(wa[idx] * theta) / sin_theta
+        wb[idx] = sin(wb[idx] * theta) / sin_theta
+    endif
+
+    q = a * rebin(reform(wa, 1, n), 4, n, /SAMPLE) + $
+        b * rebin(reform(wb, 1, n), 4, n, /SAMPLE)
+
+    ; the linear interpolation is not of unit length
+
+    q = q / rebin(reform(sqrt(total(q^2, 1)), 1, n), 4, n, /SAMPLE)
+
+    return, q
+
+end
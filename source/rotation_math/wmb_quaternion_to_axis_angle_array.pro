@@ -0,0 +1,35 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_quaternion_to_axis_angle_array
+;
+;   Batch form of wmb_quaternion_to_axis_angle.  The input is a 4xN
+;   array of quaternions [x, y, z, w] and the result is a 4xN double
+;   array of [axis_x, axis_y, axis_z, angle_rad].
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_quaternion_to_axis_angle_array, input_quaternions
+
+    compile_opt idl2, strictarrsubs
+
+    nq = N_elements(input_quaternions) / 4
+
+    if nq eq 0 || N_elements(input_quaternions) ne 4*nq then $
+        message, 'Invalid input'
+
+    q = reform(input_quaternions, 4, nq)
+
+    if size(q, /TYPE) ne 5 then q = double(q)
+
+    nqxyz = sqrt(total(q[0:2,*]^2, 1))
+
+    AA = dblarr(4, nq, /NOZERO)
+
+    AA[0,*] = reform(q[0,*]) / nqxyz
+    AA[1,*] = reform(q[1,*]) / nqxyz
+    AA[2,*] = reform(q[2,*]) / nqxyz
+    AA[3,*] = 2.0D * atan(nqxyz, reform(q[3,*]))
+
+    return, AA
+
+end
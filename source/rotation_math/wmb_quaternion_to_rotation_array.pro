@@ -0,0 +1,139 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_quaternion_to_rotation_array
+;
+;   Batch form of wmb_quaternion_to_rotation.  The input is a 4xN
+;   array of quaternions [x, y, z, w] and the result is a 3x3xN array
+;   in which rotmat[*,*,i] is the rotation matrix of quaternion i, with
+;   the same index convention as wmb_quaternion_to_rotation.  Each
+;   quaternion is normalized before conversion.
+;
+;   The result is double if the input is double and float otherwise.
+;   PARTIAL_DERIVATIVES returns a 3x3x4xN array of the partial
+;   derivatives of each matrix with respect to each element of the
+;   (normalized) quaternion.
+;
+;   test_coords = [[1,0],[0,1],[0,0]]
+;   q = [[0,0,1,1],[1,0,0,0]]
+;   rotmat = wmb_quaternion_to_rotation_array(q)
+;   transformed_coords = rotmat[*,*,0] ## test_coords
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_quaternion_to_rotation_array, input_quaternions, $
+                                           partial_derivatives = partial_derivatives
+
+    compile_opt idl2, strictarrsubs
+
+    nq = N_elements(input_quaternions) / 4
+
+    if nq eq 0 || N_elements(input_quaternions) ne 4*nq then $
+        message, 'Invalid input'
+
+    q = reform(input_quaternions, 4, nq)
+
+    chk_double = size(q,/TYPE) eq 5
+
+    if ~chk_double then q = float(q)
+
+    qnorm = sqrt(total(q^2, 1, DOUBLE = chk_double))
+
+    x = reform(q[0,*]) / qnorm
+    y = reform(q[1,*]) / qnorm
+    z = reform(q[2,*]) / qnorm
+    r = reform(q[3,*]) / qnorm
+
+    q = 0
+    qnorm = 0
+
+    rotmat = make_array(3, 3, nq, TYPE = chk_double ? 5 : 4, /NOZERO)
+
+    xx = x * x
+    yy = y * y
+    zz = z * z
+    rr = r * r
+
+    rotmat[0,0,*] = rr + xx - yy - zz
+    rotmat[1,1,*] = rr - xx + yy - zz
+    rotmat[2,2,*] = rr - xx - yy + zz
+
+    xx = 0
+    yy = 0
+    zz = 0
+    rr = 0
+
+    rotmat[1,0,*] = 2 * (x * y - z * r)
+    rotmat[2,0,*] = 2 * (x * z + y * r)
+    rotmat[0,1,*] = 2 * (x * y + z * r)
+    rotmat[2,1,*] = 2 * (y * z - x * r)
+    rotmat[0,2,*] = 2 * (x * z - y * r)
+    rotmat[1,2,*] = 2 * (y * z + x * r)
+
+
+    if Arg_present(partial_derivatives) eq 1 then begin
+
+        ; partial derivatives of each matrix element with respect to
+        ; [x, y, z, r], see wmb_quaternion_to_rotation
+
+        pd = make_array(3, 3, 4, nq, TYPE = chk_double ? 5 : 4, /NOZERO)
+
+        x2 = 2 * x
+        y2 = 2 * y
+        z2 = 2 * z
+        r2 = 2 * r
+
+        ; derivative of R[1,0] = 2 * (xy - zr)
+        pd[1,0,0,*] = y2
+        pd[1,0,1,*] = x2
+        pd[1,0,2,*] = -r2
+        pd[1,0,3,*] = -z2
+        ; derivative of R[2,0] = 2 * (xz + yr)
+        pd[2,0,0,*] = z2
+        pd[2,0,1,*] = r2
+        pd[2,0,2,*] = x2
+        pd[2,0,3,*] = y2
+        ; derivative of R[0,1] = 2 * (xy + zr)
+        pd[0,1,0,*] = y2
+        pd[0,1,1,*] = x2
+        pd[0,1,2,*] = r2
+        pd[0,1,3,*] = z2
+        ; derivative of R[2,1] = 2 * (yz - xr)
+        pd[2,1,0,*] = -r2
+        pd[2,1,1,*] = z2
+        pd[2,1,2,*] = y2
+        pd[2,1,3,*] = -x2
+        ; derivative of R[0,2] = 2 * (xz - yr)
+        pd[0,2,0,*] = z2
+        pd[0,2,1,*] = -r2
+        pd[0,2,2,*] = x2
+        pd[0,2,3,*] = -y2
+        ; derivative of R[1,2] = 2 * (yz + xr)
+        pd[1,2,0,*] = r2
+        pd[1,2,1,*] = z2
+        pd[1,2,2,*] = y2
+        pd[1,2,3,*] = x2
+
+        ; derivative of R[0,0] = r2 + x2 - y2 - z2
+        pd[0,0,0,*] = x2
+        pd[0,0,1,*] = -y2
+        pd[0,0,2,*] = -z2
+        pd[0,0,3,*] = r2
+        ; derivative of R[1,1] = r2 - x2 + y2 - z2
+        pd[1,1,0,*] = -x2
+        pd[1,1,1,*] = y2
+        pd[1,1,2,*] = -z2
+        pd[1,1,3,*] = r2
+        ; derivative of R[2,2] = r2 - x2 - y2 + z2
+        pd[2,2,0,*] = -x2
+        pd[2,2,1,*] = -y2
+        pd[2,2,2,*] = z2
+        pd[2,2,3,*] = r2
+
+        partial_derivatives = temporary(pd)
+
+    endif
+
+
+    return, rotmat
+
+end
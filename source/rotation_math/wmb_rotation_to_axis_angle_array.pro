@@ -0,0 +1,18 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_rotation_to_axis_angle_array
+;
+;   Batch form of wmb_rotation_to_axis_angle.  The input is a 3x3xN
+;   array of rotation matrices and the result is a 4xN double array
+;   of [axis_x, axis_y, axis_z, angle_rad].
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_rotation_to_axis_angle_array, input_rotation_matrices
+
+    compile_opt idl2, strictarrsubs
+
+    return, wmb_quaternion_to_axis_angle_array( $
+                wmb_rotation_to_quaternion_array(input_rotation_matrices))
+
+end
@@ -0,0 +1,106 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_rotation_to_quaternion_array
+;
+;   Batch form of wmb_rotation_to_quaternion.  The input is a 3x3xN
+;   array of rotation matrices and the result is a 4xN double array
+;   of quaternions [x, y, z, w].  Each matrix takes the same branch
+;   (positive trace, or the largest diagonal element) as it would in
+;   wmb_rotation_to_quaternion.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_rotation_to_quaternion_array, input_rotation_matrices
+
+    compile_opt idl2, strictarrsubs
+
+    nr = N_elements(input_rotation_matrices) / 9
+
+    if nr eq 0 || N_elements(input_rotation_matrices) ne 9*nr then $
+        message, 'Invalid input'
+
+    R = reform(input_rotation_matrices, 9, nr)
+
+    ; R[i,j] of each matrix is R[i+3*j,*]
+
+    R00 = reform(R[0,*])
+    R10 = reform(R[1,*])
+    R20 = reform(R[2,*])
+    R01 = reform(R[3,*])
+    R11 = reform(R[4,*])
+    R21 = reform(R[5,*])
+    R02 = reform(R[6,*])
+    R12 = reform(R[7,*])
+    R22 = reform(R[8,*])
+
+    R = 0
+
+    q = dblarr(4, nr)
+
+    tmp_T = R00 + R11 + R22
+
+    ; positive trace
+
+    idx = where(tmp_T gt 0.0D, cnt)
+
+    if cnt gt 0 then begin
+
+        tmp_S = sqrt(tmp_T[idx] + 1.0D) * 2.0D
+
+        q[3,idx] = 0.25D * tmp_S
+        q[0,idx] = (R12[idx] - R21[idx]) / tmp_S
+        q[1,idx] = (R20[idx] - R02[idx]) / tmp_S
+        q[2,idx] = (R01[idx] - R10[idx]) / tmp_S
+
+    endif
+
+    ; otherwise branch on the largest diagonal element, taking the
+    ; first one in case of a tie as MAX does
+
+    chk_else = ~(tmp_T gt 0.0D)
+    chk_0 = chk_else and (R00 ge R11) and (R00 ge R22)
+    chk_1 = chk_else and (~chk_0) and (R11 ge R22)
+    chk_2 = chk_else and (~chk_0) and (~chk_1)
+
+    idx = where(chk_0, cnt)
+
+    if cnt gt 0 then begin
+
+        tmp_S = sqrt(1.0D + R00[idx] - R11[idx] - R22[idx]) * 2.0D
+
+        q[3,idx] = (R12[idx] - R21[idx]) / tmp_S
+        q[0,idx] = 0.25D * tmp_S
+        q[1,idx] = (R10[idx] + R01[idx]) / tmp_S
+        q[2,idx] = (R20[idx] + R02[idx]) / tmp_S
+
+    endif
+
+    idx = where(chk_1, cnt)
+
+    if cnt gt 0 then begin
+
+        tmp_S = sqrt(1.0D + R11[idx] - R00[idx] - R22[idx]) * 2.0D
+
+        q[3,idx] = (R20[idx] - R02[idx]) / tmp_S
+        q[0,idx] = (R10[idx] + R01[idx]) / tmp_S
+        q[1,idx] = 0.25 * tmp_S
+        q[2,idx] = (R21[idx] + R12[idx]) / tmp_S
+
+    endif
+
+    idx = where(chk_2, cnt)
+
+    if cnt gt 0 then begin
+
+        tmp_S = sqrt(1.0D + R22[idx] - R00[idx] - R11[idx]) * 2.0D
+
+        q[3,idx] = (R01[idx] - R10[idx]) / tmp_S
+        q[0,idx] = (R20[idx] + R02[idx]) / tmp_S
+        q[1,idx] = (R21[idx] + R12[idx]) / tmp_S
+        q[2,idx] = 0.25 * tmp_S
+
+    endif
+
+    return, q
+
+end
@@ -0,0 +1,127 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_sort_columns_rank
+;
+;   Returns the dense rank (0, 1, 2, ...) of each element of x, so
+;   that equal values share a rank.  NaN values sort last and all
+;   share the highest rank.  The number of distinct ranks is
+;   returned in nranks.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_sort_columns_rank, x, nranks=nranks
+
+    compile_opt idl2, strictarrsubs
+
+    n = N_elements(x)
+
+    rank = lon64arr(n)
+
+    if n eq 1 then begin
+        nranks = 1LL
+        return, rank
+    endif
+
+    xind = sort(x)
+    xs = x[xind]
+
+    ; a new rank starts wherever the sorted value changes; NaN values
+    ; are at the end of the sorted array and compare unequal to
+    ; everything, so a step is only counted if the previous value is
+    ; not NaN
+
+    step = xs[1:*] ne xs[0:n-2]
+
+    if wmb_typecode_is_real(size(x, /TYPE)) then $
+        step = step and (xs[0:n-2] eq xs[0:n-2])
+
+    xs = 0
+
+    rank[xind] = [0LL, total(temporary(step), /CUMULATIVE, /INTEGER)]
+
+    nranks = rank[xind[n-1]] + 1
+
+    return, rank
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_sort_columns
+;
+;   Returns the permutation which sorts a set of key columns, with
+;   the first column as the primary key, the second column as the
+;   secondary key, and so on.  The sort is stable: records with
+;   equal keys keep their original order.
+;
+;   columns is a list of key columns of equal length, each of which
+;   may be an array or a list.  A single array is sorted as one key.
+;
+;   Each column is replaced by its dense rank, and the ranks of
+;   successive columns are folded into a single composite rank
+;   (rank * nranks_next + rank_next), which is re-ranked after each
+;   column so that it never exceeds n^2.  The final composite rank
+;   is ordered with a counting sort (HISTOGRAM reverse indices),
+;   which lists the records of each rank in their original order.
+;   This replaces a loop over every group of equal primary keys with
+;   a fixed number of whole-array sorts.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_sort_columns, columns
+
+    compile_opt idl2, strictarrsubs
+
+    if isa(columns, 'List') then n_keys = N_elements(columns) $
+                            else n_keys = 1
+
+    if n_keys eq 0 then message, 'No sort columns'
+
+    for k = 0, n_keys-1 do begin
+
+        if isa(columns, 'List') then tmpcol = columns[k] $
+                                else tmpcol = columns
+
+        if isa(tmpcol, 'List') then tmpcol = tmpcol.ToArray()
+
+        if k eq 0 then begin
+
+            n = N_elements(tmpcol)
+
+            if n eq 0 then message, 'Invalid sort column'
+
+            rank = wmb_sort_columns_rank(temporary(tmpcol), nranks=nranks)
+
+        endif else begin
+
+            if N_elements(tmpcol) ne n then $
+                message, 'Sort columns must have equal length'
+
+            ; once every composite rank is distinct the remaining keys
+            ; cannot change the order
+
+            if nranks eq n then break
+
+            ; fold the next key into the composite rank
+
+            tmprank = wmb_sort_columns_rank(temporary(tmpcol), nranks=tmpnranks)
+
+            rank = wmb_sort_columns_rank(temporary(rank) * tmpnranks + $
+                                         temporary(tmprank), nranks=nranks)
+
+        endelse
+
+    endfor
+
+    if n eq 1 then return, [0L]
+
+    ; counting sort on the dense composite rank; the reverse indices of
+    ; each bin are in ascending order, which makes the sort stable
+
+    tmphist = histogram(rank, MIN=0, MAX=nranks-1, BINSIZE=1, $
+                        REVERSE_INDICES=tmpri)
+
+    return, tmpri[nranks+1:*]
+
+end
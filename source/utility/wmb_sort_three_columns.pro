@@ -2,6 +2,9 @@
 ;
 ;   wmb_sort_three_columns
 ;
+;   Returns the stable permutation which sorts by col_a, then by
+;   col_b, then by col_c.  See wmb_sort_columns.
+;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
 
@@ -9,47 +12,41 @@ function wmb_sort_three_columns, col_a, col_b, col_c
 
     compile_opt idl2, strictarrsubs
 
+    ; if the sort fails, return the inputs to the caller before the
+    ; error is passed on
 
-    ; perform simple sort on the primary sort column
-
-    inda = sort(col_a)
-
-    sorted_col_a = col_a[inda]
-    sorted_col_b = col_b[inda]
-    sorted_col_c = col_c[inda]
+    catch, error_status
 
-    ; extract boundaries of equal values in major index (sorted_col_a)
+    if error_status ne 0 then begin
 
-    uind = uniq(sorted_col_a)
-    uind = [ -1, uind ]   ; add first startindex (use -1 because it is
-                          ; interpreted as the last index from previous item)
+        catch, /cancel
 
-    nuind = n_elements(uind)
+        if obj_valid(tmpcols) then begin
+            col_a = tmpcols.Remove(0)
+            col_b = tmpcols.Remove(0)
+            col_c = tmpcols.Remove(0)
+            obj_destroy, tmpcols
+        endif
 
-    ; perform sort on subsets of data with equal major variable
-    ; note that the first element of uind is now -1
+        message, /REISSUE_LAST
 
-    for i=long(0), nuind-2 do begin
+    endif
 
-        i1 = uind[i]+1
-        i2 = uind[i+1]
+    ; move the inputs into a list without copying them
 
-        ; if i1 and i2 are equal, then there is only one element for this value
-        ; of the major index and nothing more needs to happen
+    tmpcols = list(col_a, col_b, col_c, /NO_COPY)
 
-        if(i2 gt i1) then begin
+    inda = wmb_sort_columns(tmpcols)
 
-            subdat_b = sorted_col_b[i1:i2]
-            subdat_c = sorted_col_c[i1:i2]
-            sub_inda = inda[i1:i2]
+    ; return the input variables to their original state
 
-            indb = wmb_sort_two_columns(subdat_b, subdat_c)
-            
-            inda[i1:i2] = sub_inda[indb]
+    col_a = tmpcols.Remove(0)
+    col_b = tmpcols.Remove(0)
+    col_c = tmpcols.Remove(0)
 
-        endif
+    obj_destroy, tmpcols
 
-    endfor
+    catch, /cancel
 
     return, inda
 
@@ -3,6 +3,9 @@
 ;   wmb_sort_two_columns
 ;
 ;   Note that this function works with both arrays and lists.
+;
+;   Returns the stable permutation which sorts by col_a, then by
+;   col_b.  See wmb_sort_columns.
 ;   
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
@@ -11,65 +14,39 @@ function wmb_sort_two_columns, col_a, col_b
 
     compile_opt idl2, strictarrsubs
 
+    ; if the sort fails, return the inputs to the caller before the
+    ; error is passed on
 
-    ; check if the inputs are lists
-    
-    input_a_list = isa(col_a, 'List')
-    input_b_list = isa(col_b, 'List')
-    
-    if input_a_list eq 1 then col_a_mod = col_a.ToArray() $
-                         else col_a_mod = temporary(col_a)
-
-    if input_b_list eq 1 then col_b_mod = col_b.ToArray() $
-                         else col_b_mod = temporary(col_b)
-
-
-
-    ; perform simple sort on the primary sort column
-
-    inda = sort(col_a_mod)
-
-    sorted_col_a = col_a_mod[inda]
-    sorted_col_b = col_b_mod[inda]
+    catch, error_status
 
-    ; extract boundaries of equal values in major index (sorted_col_a)
+    if error_status ne 0 then begin
 
-    uind = uniq(sorted_col_a)
-    uind = [ -1, uind ]   ; add first startindex (use -1 because it is
-                          ; interpreted as the last index from previous item)
+        catch, /cancel
 
-    nuind = n_elements(uind)
-
-    ; perform sort on subsets of data with equal major variable
-    ; note that the first element of uind is now -1
-
-    for i=long(0), nuind-2 do begin
+        if obj_valid(tmpcols) then begin
+            col_a = tmpcols.Remove(0)
+            col_b = tmpcols.Remove(0)
+            obj_destroy, tmpcols
+        endif
 
-        i1 = uind[i]+1
-        i2 = uind[i+1]
+        message, /REISSUE_LAST
 
-        ; if i1 and i2 are equal, then there is only one element for this value
-        ; of the major index and nothing more needs to happen
+    endif
 
-        if(i2 gt i1) then begin
+    ; move the inputs into a list without copying them
 
-            subdat_b = sorted_col_b[i1:i2]
-            sub_inda = inda[i1:i2]
+    tmpcols = list(col_a, col_b, /NO_COPY)
 
-            indb = sort(subdat_b)
-            
-            inda[i1:i2] = sub_inda[indb]
+    inda = wmb_sort_columns(tmpcols)
 
-        endif
-
-    endfor
+    ; return the input variables to their original state
 
+    col_a = tmpcols.Remove(0)
+    col_b = tmpcols.Remove(0)
 
-    ; return the input variables to their original state
-    
-    if input_a_list eq 0 then col_a = temporary(col_a_mod)
-    if input_b_list eq 0 then col_b = temporary(col_b_mod)
+    obj_destroy, tmpcols
 
+    catch, /cancel
 
     return, inda
 
@@ -0,0 +1,26 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_varray_brick_header_struct
+;
+;   Returns an empty bricked array file header.  The fields are
+;   naturally aligned, and the header is padded to 512 bytes when
+;   it is written.  See wmb_varray_read_brick_header.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_varray_brick_header_struct
+
+    compile_opt idl2, strictarrsubs
+
+    return, {magic       : bytarr(8),      $
+             byteorder   : 0L,             $
+             version     : 0L,             $
+             codec       : 0L,             $
+             datatype    : 0L,             $
+             rank        : 0L,             $
+             reserved    : 0L,             $
+             dims        : lon64arr(8),    $
+             brick_dims  : lon64arr(8),    $
+             data_offset : 0LL             }
+
+end
@@ -4,10 +4,11 @@ pro wmb_varray_generate_read_sequence, isrange, $
                                        arr_dims, $
                                        output_scalar, $
                                        output_dims, $
-                                       n_reads, $                                       
+                                       n_reads, $
                                        read_size, $
-                                       read_start, $                                    
-                                       readstart_pos_array
+                                       read_start, $
+                                       readstart_pos_array, $
+                                       brick_dims = brick_dims
 
 
     compile_opt idl2, strictarrsubs
@@ -18,250 +19,229 @@ pro wmb_varray_generate_read_sequence, isrange, $
     endif
 
     n_subscripts = N_elements(isrange)
-    
+
     arr_rank = N_elements(arr_dims)
-    
+
     if n_subscripts ne arr_rank then begin
         message, 'Invalid number of subscripts'
         return
     endif
 
-    ; determine the dimensions of the output array and convert all 
-    ; inputs to positive ranges
-    
+    ; convert all inputs to lists of positive indices, and determine
+    ; the dimensions of the output array
+
+    index_list = list()
+
     read_data_dims = lon64arr(n_subscripts)
-    
-    range_start = lon64arr(n_subscripts)
-    range_end = lon64arr(n_subscripts)
-    range_stride = lon64arr(n_subscripts)    
-    
-    range_span_flag = bytarr(n_subscripts)
-    
-    
+
+    index_is_array = bytarr(n_subscripts)
+    index_contiguous = bytarr(n_subscripts)
+
+
     for i = 0, n_subscripts-1 do begin
 
-        chkdim = arr_dims[i]
+        chkdim = long64(arr_dims[i])
         tmp_input = subscript_list[i]
 
         if ~isrange[i] then begin
 
-            ; an index
+            ; an index, or an index array
+
+            index_is_array[i] = size(tmp_input, /N_DIMENSIONS) gt 0
+
+            tmp_index = long64(reform([tmp_input], N_elements(tmp_input)))
 
-            tmp_start = tmp_input
-            tmp_end = tmp_input
-            tmp_stride = 1
+            tmp_neg = where(tmp_index lt 0, tmp_count)
+            if tmp_count gt 0 then tmp_index[tmp_neg] = tmp_index[tmp_neg] + chkdim
 
         endif else begin
-            
+
             ; a range
-            
-            tmp_start = tmp_input[0]
-            tmp_end = tmp_input[1]
-            tmp_stride = tmp_input[2]
-                         
+
+            tmp_start = long64(tmp_input[0])
+            tmp_end = long64(tmp_input[1])
+            tmp_stride = long64(tmp_input[2])
+
+            if tmp_start lt 0 then tmp_start = tmp_start + chkdim
+            if tmp_end lt 0 then tmp_end = tmp_end + chkdim
+
+            tmp_n = abs((tmp_end - tmp_start) / tmp_stride) + 1
+
+            tmp_index = tmp_start + (tmp_stride * l64indgen(tmp_n))
+
         endelse
-        
-        if tmp_start lt 0 then tmp_start = tmp_start + chkdim
-        if tmp_end lt 0 then tmp_end = tmp_end + chkdim
-        
-        range_start[i] = tmp_start
-        range_end[i] = tmp_end
-        range_stride[i] = tmp_stride
-        
-        range_span_flag[i] = ((tmp_end - tmp_start) + 1) eq chkdim and $
-                             (tmp_stride eq 1)
-            
-        read_data_dims[i] = abs((tmp_end - tmp_start) / tmp_stride) + 1
-        
+
+        tmp_n = N_elements(tmp_index)
+
+        read_data_dims[i] = tmp_n
+
+        ; a run of ascending consecutive indices can be read in one piece
+
+        if tmp_n eq 1 then begin
+            index_contiguous[i] = 1
+        endif else begin
+            index_contiguous[i] = array_equal(tmp_index[1:*] - $
+                                              tmp_index[0:tmp_n-2], 1)
+        endelse
+
+        index_list.Add, tmp_index
+
     endfor
-    
-    
-    ; for simple file access, this object does not allow stride values 
-    ; other than unity
-    
-    tmp_index = where(range_stride ne 1, tmp_count)
-    if tmp_count ne 0 then begin
-        message, 'Non-unity stride values are not supported'
-        return
+
+
+    dimension_span_size = product(arr_dims, /integer, /cumulative)
+    dimension_span_multiplier = long64(shift(dimension_span_size,1))
+    dimension_span_multiplier[0] = 1
+
+
+    ; the position of each index along its dimension - in a bricked
+    ; file the bricks are stored one after the other, with the first
+    ; dimension varying fastest both between and within bricks
+
+    chk_bricked = N_elements(brick_dims) gt 0
+
+    if chk_bricked then begin
+
+        tmp_bdims = long64(brick_dims[0:n_subscripts-1])
+        tmp_nbricks = (long64(arr_dims) + tmp_bdims - 1) / tmp_bdims
+
+        tmp_brick_elems = product(tmp_bdims, /integer)
+
+        brick_span_multiplier = long64(shift(product(tmp_nbricks, /integer, $
+                                                      /cumulative), 1))
+        brick_span_multiplier[0] = 1
+
+        within_span_multiplier = long64(shift(product(tmp_bdims, /integer, $
+                                                       /cumulative), 1))
+        within_span_multiplier[0] = 1
+
     endif
-    
-
-    ; test if the result will be scalar, and determine the final dimensions
-    ; of the output array
-    
-    tmp_output_scalar = 0
-    
-    rangedimindex = where(isrange eq 1, chkcount)
-    
-    if chkcount gt 0 then begin
-        
-        tmp_output_dims = read_data_dims[rangedimindex]
-        
-    endif else begin
-        
-        tmp_output_scalar = 1    
-        tmp_output_dims = [1]
-        
-    endelse
 
-    
-    ; determine the number of reads and the read chunk size
-    
-    tmp_n_reads = 1ULL
-    chk_contiguous = 1
-    first_non_contiguous_dim = -1
-    read_chunk_size = 1ULL
+    offset_list = list()
 
     for i = 0, n_subscripts-1 do begin
-    
-        if chk_contiguous eq 1 then begin
-    
-            ; we are in the contiguous part of the range
-    
-            if range_span_flag[i] eq 1 then begin
-                
-                read_chunk_size = read_chunk_size * read_data_dims[i]
-                
-            endif else begin
-                
-                if range_stride[i] eq 1 then begin
-                    
-                    read_chunk_size = read_chunk_size * read_data_dims[i]
-                    
-                endif 
-                
-                ; we have reached the end of the contiguous part       
-                chk_contiguous = 0
-                
-            endelse
-        
+
+        tmp_index = index_list[i]
+
+        if chk_bricked then begin
+
+            offset_list.Add, (tmp_index / tmp_bdims[i]) * $
+                             (brick_span_multiplier[i] * tmp_brick_elems) + $
+                             (tmp_index mod tmp_bdims[i]) * $
+                             within_span_multiplier[i]
+
         endif else begin
-            
-            ; we are in the non-contiguous part of the range
-            
-            tmp_n_reads = tmp_n_reads * read_data_dims[i]
-            
-            ; if this is the first dimension in the non-contiguous part, 
-            ; record this
-            
-            if first_non_contiguous_dim eq -1 then begin
-                
-                first_non_contiguous_dim = i
-                
-            endif
-            
+
+            offset_list.Add, tmp_index * dimension_span_multiplier[i]
+
         endelse
 
     endfor
-    
 
-    dimension_span_size = product(arr_dims, /integer, /cumulative)
-    dimension_span_multiplier = shift(dimension_span_size,1)
-    dimension_span_multiplier[0] = 1
-   
-    first_read_index = range_start
-    
-    first_read_pos = total(first_read_index * dimension_span_multiplier, $
-                           /integer)
-    
-    
-    ; calculate the sequence of steps needed to traverse the array
-    
-    output_num_steps = []        
-    output_step_size = []
-    tmp_readstart_pos_array = []
-    
-    if tmp_n_reads ne 1 then begin
-       
-        last_total_jump_size = 0
-
-        for i = first_non_contiguous_dim, n_subscripts-1 do begin
-    
-            tmp_start = range_start[i]
-            tmp_end = range_end[i]
-        
-            if read_data_dims[i] gt 1 then begin
-                
-                if N_elements(output_num_steps) eq 0 then begin
-                
-                    ; the first step
-                
-                    output_num_steps = [(tmp_end - tmp_start)]
-                    output_step_size = [dimension_span_multiplier[i]]
-                
-                    last_total_jump_size = total( output_num_steps * $
-                                                  output_step_size, $
-                                                  /integer)
-                     
-                endif else begin
-                    
-                    ; a higher order step sequence
-                    
-                    tmp_next_num_steps = (tmp_end - tmp_start) 
-                    
-                    tmp_next_step_size = dimension_span_multiplier[i] $
-                                         - last_total_jump_size
-                    
-                    tmparr1 = [1, output_num_steps]
-                    tmparr2 = [tmp_next_step_size, output_step_size]
-                    
-                    tmparr3 = []
-                    tmparr4 = []
-                    
-                    for j = 0, tmp_next_num_steps-1 do begin
-                        
-                        tmparr3 = [tmparr3,tmparr1]
-                        tmparr4 = [tmparr4,tmparr2]
-                        
-                    endfor
-                    
-                    output_num_steps = [output_num_steps, tmparr3]
-                    output_step_size = [output_step_size, tmparr4]
-                    
-                    last_total_jump_size = total( output_num_steps * $
-                                                  output_step_size, $
-                                                  /integer)
-                    
-                endelse
-    
-            endif
+
+    ; index arrays without any ranges are combined element by element,
+    ; as for IDL arrays - otherwise each subscript adds a dimension
+
+    rangedimindex = where(isrange eq 1, rangecount)
+    arraydimindex = where(index_is_array eq 1, arraycount)
+
+    if rangecount eq 0 && arraycount gt 0 then begin
+
+        tmp_n = read_data_dims[arraydimindex[0]]
+
+        if ~ array_equal(read_data_dims[arraydimindex], tmp_n) then begin
+            message, 'Array subscripts must have the same number of elements'
+            return
+        endif
+
+        tmp_output_scalar = 0
+        tmp_output_dims = size(subscript_list[arraydimindex[0]], /DIMENSIONS)
+
+        tmp_readstart_pos_array = replicate(0LL, tmp_n)
+
+        for i = 0, n_subscripts-1 do begin
+
+            ; scalar indices are applied to every element
+
+            tmp_offsets = offset_list[i]
+            if N_elements(tmp_offsets) eq 1 then tmp_offsets = tmp_offsets[0]
+
+            tmp_readstart_pos_array = tmp_readstart_pos_array + tmp_offsets
+
         endfor
-        
-
-        tmp_steplist = lon64arr(total(output_num_steps,/integer)+1)
-        tmp_steplist[0] = first_read_pos
-        cnta = 1ULL
-        
-        foreach tmp_stepsize, output_step_size, indexa do begin
-            
-            tmpnum = output_num_steps[indexa]
-            tmparr = replicate(tmp_stepsize, tmpnum)
-            tmp_steplist[cnta] = temporary(tmparr)
-            cnta = cnta + tmpnum
-            
-        endforeach
-
-        tmp_readstart_pos_array = total(temporary(tmp_steplist), $
-                                        /cumulative, $
-                                        /integer)
 
+        read_chunk_size = 1LL
 
     endif else begin
-        
-        ; tmp_n_reads equals one
-        
-        tmp_readstart_pos_array = [first_read_pos]
-        
+
+        ; test if the result will be scalar, and determine the final
+        ; dimensions of the output array
+
+        keepdimindex = where((isrange eq 1) or (index_is_array eq 1), keepcount)
+
+        if keepcount gt 0 then begin
+
+            tmp_output_scalar = 0
+            tmp_output_dims = read_data_dims[keepdimindex]
+
+        endif else begin
+
+            tmp_output_scalar = 1
+            tmp_output_dims = [1]
+
+        endelse
+
+
+        ; the leading dimensions which span the whole array, and the
+        ; contiguous part of the next dimension, are read in one piece - 
+        ; in a bricked file each element is read separately
+
+        read_chunk_size = 1LL
+        first_read_pos = 0LL
+
+        k = 0
+
+        while (k lt n_subscripts) && (~ chk_bricked) do begin
+
+            if ~ index_contiguous[k] then break
+
+            tmp_offsets = offset_list[k]
+
+            read_chunk_size = read_chunk_size * read_data_dims[k]
+            first_read_pos = first_read_pos + tmp_offsets[0]
+
+            k = k + 1
+
+            if read_data_dims[k-1] ne arr_dims[k-1] then break
+
+        endwhile
+
+
+        ; the read positions are the outer sum of the remaining
+        ; dimensions, with the first dimension varying fastest
+
+        if k lt n_subscripts then begin
+
+            tmp_readstart_pos_array = $
+                wmb_varray_outer_index(offset_list[k:n_subscripts-1], $
+                                       base = first_read_pos)
+
+        endif else begin
+
+            tmp_readstart_pos_array = [first_read_pos]
+
+        endelse
+
     endelse
 
 
     output_scalar = tmp_output_scalar
     output_dims = tmp_output_dims
     read_size = read_chunk_size
-    read_start = first_read_pos
-    n_reads = tmp_n_reads
+    read_start = tmp_readstart_pos_array[0]
+    n_reads = N_elements(tmp_readstart_pos_array)
 
     readstart_pos_array = temporary(tmp_readstart_pos_array)
 
 
-end
\ No newline at end of file
+end
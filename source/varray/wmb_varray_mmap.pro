@@ -0,0 +1,43 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_varray_mmap
+;
+;   Memory maps the first n_elements elements of type datatype in a
+;   file, starting at the beginning of the file, and returns the
+;   name of the shared memory segment.  The data can then be
+;   accessed with shmvar(segment_name) and the mapping released with
+;   shmunmap, segment_name.
+;
+;   If the private keyword is set the mapping is copy-on-write, which
+;   allows read-only files to be mapped.
+;
+;   Returns an empty string if the file cannot be mapped (for
+;   example if it is larger than the address space of a 32 bit IDL).
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_varray_mmap, filename, datatype, n_elements, private = private
+
+    compile_opt idl2, strictarrsubs
+
+    catch, error_status
+
+    if error_status ne 0 then begin
+        ; the file could not be mapped
+        catch, /cancel
+        return, ''
+    endif
+
+    if N_elements(private) eq 0 then private = 0
+
+    shmmap, DIMENSION = long64(n_elements), $
+            TYPE = datatype, $
+            FILENAME = filename, $
+            PRIVATE = private, $
+            GET_NAME = segment_name
+
+    catch, /cancel
+
+    return, segment_name
+
+end
@@ -0,0 +1,47 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_varray_outer_index
+;
+;   Returns the outer sum of a list of offset arrays, one for each
+;   dimension, with the first dimension varying fastest.  This is
+;   the list of linear positions of the elements selected by a set
+;   of per-dimension subscripts, when each offset array holds the
+;   selected indices multiplied by the span of the dimension.
+;
+;   The optional base is added to every position.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_varray_outer_index, offset_list, base = base
+
+    compile_opt idl2, strictarrsubs
+
+    if N_elements(base) eq 0 then base = 0LL
+
+    positions = [long64(base)]
+
+    foreach tmp_offsets, offset_list do begin
+
+        tmp_np = N_elements(positions)
+        tmp_n = N_elements(tmp_offsets)
+
+        if tmp_n eq 1 then begin
+
+            positions = positions + tmp_offsets[0]
+
+        endif else begin
+
+            positions = rebin(reform(positions, tmp_np, 1), $
+                              tmp_np, tmp_n, /SAMPLE) + $
+                        rebin(reform(tmp_offsets, 1, tmp_n), $
+                              tmp_np, tmp_n, /SAMPLE)
+
+            positions = reform(positions, tmp_np * tmp_n, /OVERWRITE)
+
+        endelse
+
+    endforeach
+
+    return, positions
+
+end
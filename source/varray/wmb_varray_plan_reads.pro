@@ -0,0 +1,61 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_varray_plan_reads
+;
+;   Plans the order in which a list of read positions is served
+;   from the data chunks of a virtual array.
+;
+;   read_order returns the indices of the positions in ascending
+;   position order, so that each chunk is read once and the file
+;   is read sequentially.  block_list returns the chunks which are
+;   touched, in ascending order, and the positions in chunk
+;   block_list[i] are read_order[block_bounds[i]:block_bounds[i+1]-1].
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_varray_plan_reads, positions, $
+                           block_size, $
+                           read_order, $
+                           block_list, $
+                           block_bounds
+
+    compile_opt idl2, strictarrsubs
+
+    n_pos = N_elements(positions)
+
+    if n_pos eq 0 then begin
+        message, 'Invalid read positions'
+        return
+    endif
+
+    ; sort the positions, unless they are already in order
+
+    if n_pos gt 1 && min(positions[1:*] - positions[0:n_pos-2]) lt 0 then begin
+
+        read_order = sort(positions, /L64)
+
+    endif else begin
+
+        read_order = l64indgen(n_pos)
+
+    endelse
+
+    if N_params() lt 4 then return
+
+    ; group the sorted positions by chunk
+
+    tmp_blocks = positions[read_order] / block_size
+
+    if n_pos gt 1 then begin
+        tmp_starts = where(tmp_blocks[1:*] ne tmp_blocks[0:n_pos-2], tmp_count, $
+                           /L64) + 1
+    endif else begin
+        tmp_count = 0
+    endelse
+
+    if tmp_count gt 0 then block_bounds = [0LL, tmp_starts, n_pos] $
+                      else block_bounds = [0LL, n_pos]
+
+    block_list = tmp_blocks[block_bounds[0:-2]]
+
+end
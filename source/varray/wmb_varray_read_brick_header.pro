@@ -0,0 +1,65 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_varray_read_brick_header
+;
+;   Reads the header of a bricked array file written by
+;   wmb_varray_write_bricks.  Returns the header structure, or 0 if
+;   the file is not a bricked array file.
+;
+;   The file consists of a 512 byte header followed by the bricks.
+;   The header is written in the byte order of the machine which
+;   wrote the file, and the byteorder field (always 1) is used to
+;   detect files which must be byte swapped.  The swap field of the
+;   returned structure is set for such files.
+;
+;   The bricks are stored one after the other, with the first
+;   dimension varying fastest, starting at byte data_offset.  The
+;   elements within each brick are also stored with the first
+;   dimension varying fastest.  Bricks at the edge of the array are
+;   padded to the full brick size by repeating the last element 
+;   along each dimension, so that the padding does not change the
+;   minimum and maximum of the data.
+;
+;   If the codec field is 1 the bricks are compressed: the bytes of
+;   each brick are shuffled into byte planes and compressed with
+;   zlib.  A table of n_bricks+1 64 bit byte offsets follows the
+;   header, giving the start of each brick and the end of the last.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_varray_read_brick_header, filename
+
+    compile_opt idl2, strictarrsubs
+
+    header_size = 512
+
+    tmp_fileinfo = file_info(filename)
+
+    if tmp_fileinfo.read eq 0 || tmp_fileinfo.regular eq 0 || $
+       tmp_fileinfo.size lt header_size then return, 0
+
+    header = wmb_varray_brick_header_struct()
+
+    openr, tmplun, filename, /GET_LUN, error=errstatus
+
+    if errstatus ne 0 then return, 0
+
+    readu, tmplun, header
+
+    free_lun, tmplun
+
+    if string(header.magic) ne 'WMBBRICK' then return, 0
+
+    chk_swap = header.byteorder ne 1
+
+    if chk_swap then header = swap_endian(header)
+
+    if header.byteorder ne 1 || header.version ne 1 || $
+       header.codec lt 0 || header.codec gt 1 then begin
+        message, 'Unsupported bricked array file'
+        return, 0
+    endif
+
+    return, create_struct(header, 'swap', fix(chk_swap))
+
+end
@@ -0,0 +1,83 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_varray_readahead_bridge
+;
+;   Starts a background IDL process (an IDL_IDLBridge) which reads
+;   data chunks of a virtual array file into a shared memory buffer.
+;
+;   The buffer holds n_slots chunks of chunk_size elements, and its
+;   segment name is returned in the segname keyword.  The file is
+;   opened in the bridge process as it is by wmb_VirtualArray::Init,
+;   so the chunks arrive with their byte order corrected.
+;
+;   To read a list of chunks, set the variable ra_chunks in the
+;   bridge and execute, without waiting, the command returned in the
+;   read_command keyword.  Chunk ra_chunks[i] is read into slot i.
+;
+;   Returns a null object if the bridge cannot be started, and the
+;   caller should then read the file synchronously.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_varray_readahead_bridge, filename, $
+                                      datatype, $
+                                      chunk_size, $
+                                      fileoffset_bytes, $
+                                      fileswapendian, $
+                                      n_slots, $
+                                      segname = segname, $
+                                      read_command = read_command
+
+    compile_opt idl2, strictarrsubs
+
+    segname = ''
+    bridge = obj_new()
+
+    catch, error_status
+
+    if error_status ne 0 then begin
+
+        ; the bridge could not be started
+
+        catch, /cancel
+
+        if obj_valid(bridge) then obj_destroy, bridge
+        if segname ne '' then shmunmap, segname
+
+        segname = ''
+        read_command = ''
+
+        return, obj_new()
+
+    endif
+
+    n_buf = long64(n_slots) * chunk_size
+
+    shmmap, DIMENSION = n_buf, TYPE = datatype, GET_NAME = segname
+
+    bridge = obj_new('IDL_IDLBridge')
+
+    bridge->SetVar, 'ra_file', filename
+
+    bridge->Execute, 'openr, ra_lun, ra_file, /GET_LUN, SWAP_ENDIAN=' + $
+                     strtrim(fix(fileswapendian),2)
+
+    bridge->Execute, 'ra_assoc = assoc(ra_lun, make_array(' + $
+                     strtrim(chunk_size,2) + 'LL, TYPE=' + $
+                     strtrim(datatype,2) + ', /NOZERO), ' + $
+                     strtrim(fileoffset_bytes,2) + 'LL)'
+
+    bridge->Execute, 'shmmap, ''' + segname + ''', DIMENSION=' + $
+                     strtrim(n_buf,2) + 'LL, TYPE=' + strtrim(datatype,2)
+
+    bridge->Execute, 'ra_buf = shmvar(''' + segname + ''')'
+
+    catch, /cancel
+
+    read_command = 'for ra_i = 0LL, N_elements(ra_chunks)-1 do ' + $
+                   'ra_buf[ra_i*' + strtrim(chunk_size,2) + 'LL] = ' + $
+                   'ra_assoc[ra_chunks[ra_i]]'
+
+    return, bridge
+
+end
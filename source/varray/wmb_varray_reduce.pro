@@ -0,0 +1,181 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_varray_reduce
+;
+;   Accumulates the statistics of a block of data into a state
+;   structure, so that the statistics of a large data set can be
+;   computed in one pass over blocks of the data.
+;
+;   If state is undefined a new state is created.  The histogram
+;   keywords are only used at this point: NBINS bins of width
+;   BINSIZE from HIST_MIN to HIST_MAX (default hist_min +
+;   nbins*binsize).  Bin i counts the values v with
+;   hist_min + i*binsize <= v < hist_min + (i+1)*binsize, except
+;   that the last bin counts every value up to and including
+;   HIST_MAX, so that rounding of the bin width never drops the
+;   maximum.  Values outside [HIST_MIN, HIST_MAX] are not counted.
+;   If NBINS is not set no histogram is computed.
+;
+;   Non-finite floating point values are ignored.
+;
+;   Set the finish keyword to compute the final statistics.  The
+;   state structure then contains the fields n, min, max, sum, mean,
+;   variance, stddev, hist_min, hist_max, binsize and histogram.
+;
+;   The means and variances of the blocks are combined with the
+;   pairwise update of Chan et al., which is stable for large
+;   numbers of elements.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_varray_reduce, state, $
+                       data, $
+                       nbins = nbins, $
+                       hist_min = hist_min, $
+                       hist_max = hist_max, $
+                       binsize = binsize, $
+                       finish = finish
+
+    compile_opt idl2, strictarrsubs
+
+    if N_elements(finish) eq 0 then finish = 0
+
+    if N_elements(state) eq 0 then begin
+
+        if N_elements(nbins) eq 0 then nbins = 0
+
+        if nbins gt 0 then begin
+
+            if N_elements(hist_min) eq 0 || N_elements(binsize) eq 0 || $
+               binsize le 0 then message, 'Invalid histogram range'
+
+            tmp_hist = lon64arr(nbins)
+
+            if N_elements(hist_max) eq 0 then $
+                hist_max = hist_min + (nbins * double(binsize))
+
+        endif else begin
+
+            tmp_hist = 0LL
+
+        endelse
+
+        state = {n         : 0LL,             $
+                 min       : !values.d_nan,   $
+                 max       : !values.d_nan,   $
+                 sum       : 0.0D,            $
+                 mean      : 0.0D,            $
+                 m2        : 0.0D,            $
+                 nbins     : long64(nbins),   $
+                 hist_min  : (nbins gt 0) ? double(hist_min) : 0.0D, $
+                 hist_max  : (nbins gt 0) ? double(hist_max) : 0.0D, $
+                 binsize   : (nbins gt 0) ? double(binsize) : 0.0D,  $
+                 histogram : tmp_hist}
+
+    endif
+
+
+    if N_elements(data) gt 0 then begin
+
+        dtype = size(data, /TYPE)
+
+        if dtype eq 6 || dtype eq 9 then $
+            message, 'Statistics of complex data are not supported'
+
+        ; drop non-finite values
+
+        if dtype eq 4 || dtype eq 5 then begin
+
+            tmp_finite = where(finite(data), tmp_n, /L64)
+
+            if tmp_n lt N_elements(data) then begin
+                if tmp_n gt 0 then data_ok = data[tmp_finite]
+            endif else begin
+                data_ok = data
+            endelse
+
+        endif else begin
+
+            tmp_n = N_elements(data)
+            data_ok = data
+
+        endelse
+
+
+        if tmp_n gt 0 then begin
+
+            tmp_min = min(data_ok, MAX = tmp_max)
+
+            tmp_sum = total(data_ok, /DOUBLE)
+            tmp_mean = tmp_sum / tmp_n
+            tmp_m2 = total((data_ok - tmp_mean)^2, /DOUBLE)
+
+            if state.n eq 0 then begin
+
+                state.min = tmp_min
+                state.max = tmp_max
+                state.mean = tmp_mean
+                state.m2 = tmp_m2
+
+            endif else begin
+
+                state.min = state.min < tmp_min
+                state.max = state.max > tmp_max
+
+                tmp_total = state.n + tmp_n
+                tmp_delta = tmp_mean - state.mean
+
+                state.mean = state.mean + tmp_delta * (double(tmp_n) / tmp_total)
+                state.m2 = state.m2 + tmp_m2 + $
+                           tmp_delta^2 * (double(state.n) * tmp_n / tmp_total)
+
+            endelse
+
+            state.n = state.n + tmp_n
+            state.sum = state.sum + tmp_sum
+
+            if state.nbins gt 0 then begin
+
+                tmp_bin = floor((data_ok - state.hist_min) / state.binsize, /L64)
+
+                ; the last bin runs up to and including hist_max, which
+                ; the rounded bin index of hist_max can overshoot;
+                ; values above hist_max are dropped
+
+                tmp_index = where(tmp_bin ge state.nbins-1, tmp_count, /L64)
+
+                if tmp_count gt 0 then $
+                    tmp_bin[tmp_index] = state.nbins - $
+                                         (data_ok[tmp_index] le state.hist_max)
+
+                tmp_hist = histogram(temporary(tmp_bin), MIN = 0LL, $
+                                     MAX = state.nbins-1)
+
+                state.histogram = state.histogram + tmp_hist
+
+            endif
+
+        endif
+
+    endif
+
+
+    if finish then begin
+
+        tmp_var = (state.n gt 1) ? state.m2 / (state.n - 1) : !values.d_nan
+
+        state = {n         : state.n,                             $
+                 min       : state.min,                           $
+                 max       : state.max,                           $
+                 sum       : state.sum,                           $
+                 mean      : (state.n gt 0) ? state.mean : !values.d_nan, $
+                 variance  : tmp_var,                             $
+                 stddev    : sqrt(tmp_var),                       $
+                 hist_min  : state.hist_min,                      $
+                 hist_max  : state.hist_max,                      $
+                 binsize   : state.binsize,                       $
+                 histogram : state.histogram}
+
+    endif
+
+end
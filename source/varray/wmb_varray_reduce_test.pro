@@ -0,0 +1,62 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_varray_reduce_test
+;
+;   Checks that a histogram spanning the data range, built block by
+;   block with wmb_varray_reduce the way the Statistics methods build
+;   it, counts every element, including those equal to the maximum.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_varray_reduce_test
+
+    compile_opt idl2, strictarrsubs
+
+    ; ranges whose bin width is not exactly representable, so that
+    ; hist_min + nbins*binsize rounds away from hist_max
+
+    ranges = [[0.1D, 0.7D], [-3.3D, 12.9D], [1D-7, 0.3D]]
+    nbins = [3, 7, 10, 255]
+
+    seed = 42L
+
+    for r = 0, (size(ranges, /DIMENSIONS))[1]-1 do begin
+
+        hist_min = ranges[0,r]
+        hist_max = ranges[1,r]
+
+        data = hist_min + randomu(seed, 10000, /DOUBLE) * (hist_max - hist_min)
+        data = [hist_min, data, replicate(hist_max, 17)]
+
+        n = N_elements(data)
+
+        foreach nb, nbins do begin
+
+            binsize = (hist_max - hist_min) / nb
+
+            state = !null
+
+            for s0 = 0LL, n-1, 1000 do $
+                wmb_varray_reduce, state, data[s0:(s0+999) < (n-1)], $
+                                   nbins = nb, $
+                                   hist_min = hist_min, $
+                                   hist_max = hist_max, $
+                                   binsize = binsize
+
+            wmb_varray_reduce, state, /finish
+
+            if total(state.histogram, /INTEGER) ne n then $
+                message, string(hist_min, hist_max, nb, $
+                    total(state.histogram, /INTEGER), n, $
+                    FORMAT='("Histogram [",G0,", ",G0,"] with ",I0,' + $
+                           '" bins counts ",I0," of ",I0," values")')
+
+            if state.n ne n then message, 'Wrong element count'
+
+        endforeach
+
+    endfor
+
+    print, 'wmb_varray_reduce_test: passed'
+
+end
@@ -0,0 +1,244 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_varray_write_bricks
+;
+;   Converts an array to a bricked array file, which can be opened
+;   with wmb_VirtualArray.  Any slice through a bricked file reads
+;   only the bricks which intersect the slice, so that slices along
+;   every axis of a large stack are fast.
+;
+;   source may be an IDL array, a wmb_VirtualArray or a
+;   wmb_DataStack.  Object sources are read one layer of bricks at a
+;   time, so the file can be larger than the available memory.  The
+;   file holds the data as the object returns it, so a virtual array
+;   is written with its output type, scale and offset applied.
+;
+;   brick_dims gives the size of the bricks, which defaults to
+;   64x64x16 and is limited to the array dimensions.
+;
+;   If the compress keyword is set, the bytes of each brick are
+;   shuffled (all of the first bytes of the elements, then all of
+;   the second bytes, and so on) and compressed with zlib.  This 
+;   compresses noisy integer data much better than compressing the
+;   raw bytes.
+;
+;   See wmb_varray_read_brick_header for the file format.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_varray_write_bricks, source, $
+                             filename, $
+                             brick_dims = brick_dims, $
+                             compress = compress
+
+    compile_opt idl2, strictarrsubs
+
+    header_size = 512
+
+    if N_elements(source) eq 0 then message, 'Invalid source data'
+    if N_elements(filename) eq 0 then message, 'Invalid filename'
+
+    if N_elements(compress) eq 0 then compress = 0
+
+    chk_object = size(source, /TYPE) eq 11
+
+    if chk_object then begin
+
+        ; a virtual array returns its output type rather than the
+        ; type stored in its file
+
+        if obj_isa(source, 'wmb_VirtualArray') then $
+            source->GetProperty, datadims=datadims, output_type=datatype $
+        else $
+            source->GetProperty, datadims=datadims, datatype=datatype
+
+    endif else begin
+
+        datadims = size(source, /DIMENSIONS)
+        datatype = size(source, /TYPE)
+
+    endelse
+
+    datadims = long64(datadims)
+    rank = N_elements(datadims)
+
+    if rank lt 1 || rank gt 8 then message, 'Invalid data dimensions'
+
+    if datatype eq 0 || datatype eq 7 || datatype eq 8 || $
+       datatype eq 10 || datatype eq 11 then message, 'Unsupported data type'
+
+
+    ; determine the brick size
+
+    default_brick_dims = [64LL, 64LL, 16LL, 1LL, 1LL, 1LL, 1LL, 1LL]
+
+    if N_elements(brick_dims) eq 0 then begin
+
+        tmp_bdims = default_brick_dims[0:rank-1]
+
+    endif else begin
+
+        if N_elements(brick_dims) ne rank then message, 'Invalid brick size'
+
+        tmp_bdims = long64(brick_dims)
+
+        if min(tmp_bdims) lt 1 then message, 'Invalid brick size'
+
+    endelse
+
+    tmp_bdims = tmp_bdims < datadims
+
+    tmp_nbricks = (datadims + tmp_bdims - 1) / tmp_bdims
+
+    brick_elems = product(tmp_bdims, /integer)
+
+    n_bricks = product(tmp_nbricks, /integer)
+
+    dtype_size = wmb_sizeoftype(datatype)
+
+
+    ; write the header
+
+    header = wmb_varray_brick_header_struct()
+
+    header.magic = byte('WMBBRICK')
+    header.byteorder = 1
+    header.version = 1
+    header.codec = (compress ne 0) ? 1 : 0
+    header.datatype = datatype
+    header.rank = rank
+    header.dims[0:rank-1] = datadims
+    header.dims[rank:*] = 1
+    header.brick_dims[0:rank-1] = tmp_bdims
+    header.brick_dims[rank:*] = 1
+    header.data_offset = header_size
+
+    ; a compressed file has a table of the offsets of the bricks, and
+    ; of the end of the last brick, following the header
+
+    if compress then begin
+        brick_offsets = lon64arr(n_bricks + 1)
+        header.data_offset = header_size + 8 * (n_bricks + 1)
+        brick_offsets[0] = header.data_offset
+    endif
+
+    openw, tmplun, filename, /GET_LUN, error=errstatus
+
+    if errstatus ne 0 then message, 'Error at file open'
+
+    writeu, tmplun, header
+    writeu, tmplun, bytarr(header_size - n_tags(header, /DATA_LENGTH))
+
+    if compress then writeu, tmplun, brick_offsets
+
+
+    ; the data is read one layer of bricks at a time along the last
+    ; dimension
+
+    last = rank - 1
+
+    layer_dims = datadims
+    layer_dims[last] = tmp_bdims[last]
+
+    layer_mult = long64(shift(product(layer_dims, /integer, /cumulative), 1))
+    layer_mult[0] = 1
+
+    n_layer_bricks = n_bricks / tmp_nbricks[last]
+
+    brick_count = 0LL
+
+    isrange = replicate(1, rank)
+
+    for layer = 0LL, tmp_nbricks[last]-1 do begin
+
+        tmp_first = layer * tmp_bdims[last]
+        tmp_last = ((tmp_first + tmp_bdims[last]) < datadims[last]) - 1
+
+        if chk_object then begin
+
+            subs = list()
+            for i = 0, 7 do subs.Add, [0,-1,1]
+            subs[last] = [tmp_first, tmp_last, 1]
+
+            layer_data = source->_overloadBracketsRightSide(isrange[0:last], $
+                                subs[0], subs[1], subs[2], subs[3], $
+                                subs[4], subs[5], subs[6], subs[7])
+
+            tmp_base = 0LL
+
+        endif else begin
+
+            ; the layer is addressed in the source array directly
+
+            tmp_base = tmp_first * layer_mult[last]
+
+        endelse
+
+
+        ; extract each brick of the layer, repeating the last element
+        ; of each dimension to pad the bricks at the edge
+
+        for j = 0LL, n_layer_bricks-1 do begin
+
+            tmp_coords = (rank gt 1) ? $
+                         array_indices(tmp_nbricks[0:last-1], j, /DIMENSIONS) : $
+                         [0LL]
+
+            offset_list = list()
+
+            for i = 0, rank-1 do begin
+
+                if i eq last then begin
+                    tmp_start = 0LL
+                    tmp_max = tmp_last - tmp_first
+                endif else begin
+                    tmp_start = tmp_coords[i] * tmp_bdims[i]
+                    tmp_max = datadims[i] - 1
+                endelse
+
+                tmp_index = (tmp_start + l64indgen(tmp_bdims[i])) < tmp_max
+
+                offset_list.Add, tmp_index * layer_mult[i]
+
+            endfor
+
+            tmp_index = wmb_varray_outer_index(offset_list, base = tmp_base)
+
+            if chk_object then tmp_brick = layer_data[tmp_index] $
+                          else tmp_brick = source[tmp_index]
+
+            if size(tmp_brick, /TYPE) ne datatype then $
+                tmp_brick = fix(temporary(tmp_brick), TYPE=datatype)
+
+            if compress then begin
+
+                tmp_bytes = byte(temporary(tmp_brick), 0, brick_elems * dtype_size)
+
+                if dtype_size gt 1 then $
+                    tmp_bytes = reform(transpose(reform(tmp_bytes, dtype_size, $
+                                                        brick_elems)), $
+                                       brick_elems * dtype_size)
+
+                tmp_brick = zlib_compress(temporary(tmp_bytes))
+
+                brick_offsets[brick_count+1] = brick_offsets[brick_count] + $
+                                               N_elements(tmp_brick)
+
+            endif
+
+            writeu, tmplun, tmp_brick
+
+            brick_count = brick_count + 1
+
+        endfor
+
+    endfor
+
+    if compress then begin
+        point_lun, tmplun, header_size
+        writeu, tmplun, brick_offsets
+    endif
+
+    free_lun, tmplun
+
+end
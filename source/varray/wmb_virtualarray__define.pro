@@ -73,176 +73,1012 @@ function wmb_VirtualArray::_overloadBracketsRightSide, isRange, sub1, $
     endif
     
     
-    ; test which subscripts correspond to index arrays
+    ; calculate the number of file reads required, and the list of 
+    ; read positions
+
+    if ptr_valid(self.va_brick_dimsptr) then brick_dims = *self.va_brick_dimsptr
+
+    wmb_varray_generate_read_sequence, isrange, $
+                                       subscript_list, $
+                                       arr_dims, $
+                                       output_scalar, $
+                                       output_dims, $
+                                       n_reads, $                                       
+                                       read_size, $
+                                       read_start, $                                    
+                                       readstart_pos_array, $
+                                       brick_dims = brick_dims
+
     
-    index_is_array = intarr(n_inputs)
+    ; if the file is memory mapped, copy the data directly from the
+    ; mapping - this bypasses the chunk cache, its counters and the
+    ; read-ahead, which is why Init does not map a file by default
+    ; when a cache size or read-ahead is given
     
-    for i = 0, n_inputs-1 do begin
-        
-        tmp_input = subscript_list[i]
-        
-        index_is_array[i] = (isrange[i] eq 0) && (N_elements(tmp_input) gt 1)
+    if self.va_map_segname ne '' then begin
+    
+        return, self._ConvertOutput(self._ReadMapped(output_scalar, $
+                                    output_dims, n_reads, read_size, $
+                                    readstart_pos_array))
+    
+    endif
+    
+    
+    ; many short reads are gathered from each chunk in one operation
+    
+    if n_reads gt 1 && read_size lt 64 then begin
+    
+        return, self._ConvertOutput(self._GatherChunks(output_scalar, $
+                                    output_dims, read_size, $
+                                    readstart_pos_array))
+    
+    endif
+    
+
+    ; make an output array of the appropriate size
+    
+    dtype = self.va_dtype
+    od = make_array(output_dims, type=dtype, /nozero)
         
-    endfor
+    ; calculate the read end positions
     
+    readend_pos_array = readstart_pos_array + (read_size-1)
     
-    ; the virtual array object does not support index arrays at present
     
-    if total(index_is_array) gt 0 then message, 'Invalid array index'
+    ; for each element of the read position list, calculate in which
+    ; data chunk it is contained
     
+    tmp_data_chunk_size = self.va_data_chunk_size
     
-    ; calculate the number of file reads required, and the list of 
-    ; read positions
+    readstart_chunk_arr = readstart_pos_array / tmp_data_chunk_size
+    readend_chunk_arr = readend_pos_array / tmp_data_chunk_size
+    
+    readstart_relative_pos = readstart_pos_array mod tmp_data_chunk_size
+    readend_relative_pos = readend_pos_array mod tmp_data_chunk_size
+    
+    span_chunks = readstart_chunk_arr ne readend_chunk_arr
+
+
+    ; read the data in file order and transfer it to the output array
+    
+    wmb_varray_plan_reads, readstart_pos_array, tmp_data_chunk_size, read_order
+    
+    loaded_chunk = -1LL
+    
+    foreach indexa, read_order do begin
+    
+        tmp_readstart_rel = readstart_relative_pos[indexa]
+        tmp_write_pos = indexa * read_size
+    
+        if span_chunks[indexa] eq 0 then begin
+        
+            ; this read operation does not span a chunk boundary
+        
+            tmp_read_chunk = readstart_chunk_arr[indexa]
+        
+            if tmp_read_chunk ne loaded_chunk then begin
+                
+                tmp_block_ptr = self._CacheChunk(tmp_read_chunk)
+
+                loaded_chunk = tmp_read_chunk
+                
+                ;print, 'Virtual array: File read'
+                
+            endif else begin
+                
+                ;print, 'Virtual array: Memory read'
+                
+            endelse
+        
+            readend = readend_relative_pos[indexa]
+        
+            od[tmp_write_pos] = (*tmp_block_ptr)[tmp_readstart_rel:readend]
+            
+        endif else begin
+            
+            ; the read operation spans a chunk boundary
+            
+            ;print, 'Virtual array: Span chunks'
+            
+            startchunk = readstart_chunk_arr[indexa]
+            endchunk = readend_chunk_arr[indexa]
+            
+            nchunks_span = endchunk - startchunk + 1
+            
+            for i = 0, nchunks_span-1 do begin
+                
+                tmp_read_chunk = startchunk + i
+                
+                if tmp_read_chunk ne loaded_chunk then begin
+                    
+                    tmp_block_ptr = self._CacheChunk(tmp_read_chunk)
+
+                    loaded_chunk = tmp_read_chunk
+                    
+                endif 
+                
+                if i eq 0 then readstart = tmp_readstart_rel $
+                          else readstart = 0LL
+                          
+                if i eq (nchunks_span-1) then begin
+                    
+                    readend = readend_relative_pos[indexa]
+                    
+                endif else begin
+                    
+                    ; last element in the chunk
+                    readend = tmp_data_chunk_size - 1  
+                    
+                endelse
+                
+                od[tmp_write_pos] = (*tmp_block_ptr)[readstart:readend]
+        
+                tmp_write_pos = tmp_write_pos + ((readend - readstart) + 1)
+                
+            endfor
+        endelse
+        
+    endforeach
+
+
+    ; ensure that the output array has the correct dimensions
+
+    if output_scalar then begin
+    
+        od = od[0]
+        
+    endif else begin
+        
+        od = reform(od, output_dims, /overwrite)
+        
+    endelse
+
+    return, self._ConvertOutput(od)
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   Overload array assignment for the wmb_VirtualArray object
+;
+;   Writes to the file, if the virtual array was created with the
+;   writable keyword.  The value is converted to the data type of
+;   the file.  A scalar value is written to every selected element,
+;   and an array assigned to a scalar subscript is written starting 
+;   at that element, as for IDL arrays.
+;
+;   A memory mapped file is written through a shared mapping, and
+;   the operating system writes the modified pages back to the file
+;   in the background.  Otherwise the modified chunks are held in
+;   the chunk cache until they are evicted, or written by Flush.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+
+pro wmb_VirtualArray::_overloadBracketsLeftSide, objref, rvalue, isRange, $
+                           sub1, sub2, sub3, sub4, sub5, sub6, sub7, sub8
+
+    compile_opt idl2, strictarrsubs
+
+
+    if ~ ptr_valid(self.va_dirty) then begin
+        message, 'The virtual array is not writable'
+        return
+    endif
+
+    if self.va_out_scale ne 1 || self.va_out_offset ne 0 then begin
+        message, 'Cannot write through an output scale or offset'
+        return
+    endif
+
+    arr_rank = self.va_rank
+    arr_dims = *self.va_dimsptr
+
+    if N_elements(sub1) eq 0 then begin
+        message, 'No array subscript specified'
+        return
+    endif
+    
+    if N_elements(sub2) eq 0 then sub2=[0,0,1]
+    if N_elements(sub3) eq 0 then sub3=[0,0,1]
+    if N_elements(sub4) eq 0 then sub4=[0,0,1]
+    if N_elements(sub5) eq 0 then sub5=[0,0,1]
+    if N_elements(sub6) eq 0 then sub6=[0,0,1]
+    if N_elements(sub7) eq 0 then sub7=[0,0,1]
+    if N_elements(sub8) eq 0 then sub8=[0,0,1]
+
+    n_inputs = N_elements(isrange)
+
+    if n_inputs ne arr_rank then begin
+        message, 'Invalid number of array subscripts'
+        return
+    endif
+
+    subscript_list = list(sub1,sub2,sub3,sub4,sub5,sub6,sub7,sub8) 
+
+    chkpass = 1
+
+    for i = 0, n_inputs-1 do begin
+        
+        tmp_input = subscript_list[i]
+        
+        if isrange[i] eq 1 then begin
+            if ~ wmb_Rangevalid(tmp_input, arr_dims[i]) then chkpass = 0
+        endif else begin
+            if ~ wmb_Indexvalid(tmp_input, arr_dims[i]) then chkpass = 0
+        endelse
+    endfor
+    
+    if chkpass eq 0 then begin
+        message, 'Array subscript out of range'
+        return
+    endif
+
+
+    ; calculate the list of write positions
+
+    if ptr_valid(self.va_brick_dimsptr) then brick_dims = *self.va_brick_dimsptr
+
+    wmb_varray_generate_read_sequence, isrange, $
+                                       subscript_list, $
+                                       arr_dims, $
+                                       output_scalar, $
+                                       output_dims, $
+                                       n_reads, $
+                                       read_size, $
+                                       read_start, $
+                                       readstart_pos_array, $
+                                       brick_dims = brick_dims
+
+    value = rvalue
+    if size(value, /TYPE) ne self.va_dtype then $
+        value = fix(temporary(value), TYPE=self.va_dtype)
+
+    n_value = N_elements(value)
+    n_out = n_reads * read_size
+
+    if output_scalar && n_value gt 1 then begin
+
+        ; insert the array starting at the element
+
+        if ptr_valid(self.va_brick_dimsptr) then begin
+            message, 'Array insertion is not supported for bricked files'
+            return
+        endif
+
+        if read_start + n_value gt product(arr_dims, /integer) then begin
+            message, 'Out of range subscript encountered'
+            return
+        endif
+
+        n_reads = 1LL
+        read_size = long64(n_value)
+        readstart_pos_array = [read_start]
+
+    endif else if n_value eq 1 then begin
+
+        value = replicate(value[0], n_out)
+
+    endif else if n_value ne n_out then begin
+
+        message, 'Array dimensions must agree'
+        return
+
+    endif
+
+    value = reform(value, N_elements(value), /overwrite)
+
+    if self.va_map_segname ne '' then begin
+        self._WriteMapped, value, read_size, readstart_pos_array
+    endif else begin
+        self._WriteCached, value, read_size, readstart_pos_array
+    endelse
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _ReadMapped method
+;
+;   Reads data from a memory mapped file.  A single contiguous read
+;   is copied out of the mapping in one operation.  Multiple reads
+;   are gathered into the output array, using a single index array
+;   when the reads are short.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_VirtualArray::_ReadMapped, output_scalar, $
+                                        output_dims, $
+                                        n_reads, $
+                                        read_size, $
+                                        readstart_pos_array
+
+    compile_opt idl2, strictarrsubs
+
+    mapdata = shmvar(self.va_map_segname)
+
+    ; the mapping starts at the beginning of the file
+
+    tmp_pos = readstart_pos_array + self.va_map_offset
+
+    if n_reads eq 1 then begin
+
+        od = mapdata[tmp_pos[0]:tmp_pos[0]+read_size-1]
+
+    endif else if read_size lt 64 then begin
+
+        ; gather the short reads with one index array
+
+        tmp_index = rebin(l64indgen(read_size), read_size, n_reads, $
+                          /SAMPLE) + $
+                    rebin(reform(tmp_pos, 1, n_reads), read_size, n_reads, $
+                          /SAMPLE)
+
+        od = mapdata[temporary(tmp_index)]
+
+    endif else begin
+
+        od = make_array(output_dims, type=self.va_dtype, /nozero)
+
+        tmp_write_pos = 0LL
+
+        foreach tmp_start, tmp_pos do begin
+
+            od[tmp_write_pos] = mapdata[tmp_start:tmp_start+read_size-1]
+
+            tmp_write_pos = tmp_write_pos + read_size
+
+        endforeach
+
+    endelse
+
+    mapdata = 0
+
+    if self.va_swapendian then swap_endian_inplace, od
+
+
+    ; ensure that the output array has the correct dimensions
+
+    if output_scalar then begin
+
+        od = od[0]
+
+    endif else begin
+
+        od = reform(od, output_dims, /overwrite)
+
+    endelse
+
+    return, od
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _GatherChunks method
+;
+;   Reads many short pieces of data through the chunk cache.  The
+;   element positions are sorted and grouped by chunk, and the
+;   elements in each chunk are scattered to their positions in the
+;   output array with a single index operation.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_VirtualArray::_GatherChunks, output_scalar, $
+                                          output_dims, $
+                                          read_size, $
+                                          readstart_pos_array
+
+    compile_opt idl2, strictarrsubs
+
+    n_reads = N_elements(readstart_pos_array)
+
+    elem_pos = rebin(l64indgen(read_size), read_size, n_reads, /SAMPLE) + $
+               rebin(reform(readstart_pos_array, 1, n_reads), $
+                     read_size, n_reads, /SAMPLE)
+
+    elem_pos = reform(elem_pos, read_size * n_reads, /OVERWRITE)
+
+    tmp_data_chunk_size = self.va_data_chunk_size
+
+    wmb_varray_plan_reads, elem_pos, tmp_data_chunk_size, $
+                           read_order, block_list, block_bounds
+
+    od = make_array(output_dims, type=self.va_dtype, /nozero)
+
+    foreach tmp_chunk, block_list, i do begin
+
+        tmp_block_ptr = self._CacheChunk(tmp_chunk)
+
+        tmp_sel = read_order[block_bounds[i]:block_bounds[i+1]-1]
+
+        od[tmp_sel] = (*tmp_block_ptr)[elem_pos[tmp_sel] - $
+                                       (tmp_chunk * tmp_data_chunk_size)]
+
+    endforeach
+
+
+    ; ensure that the output array has the correct dimensions
+
+    if output_scalar then begin
+
+        od = od[0]
+
+    endif else begin
+
+        od = reform(od, output_dims, /overwrite)
+
+    endelse
+
+    return, od
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _WriteMapped method
+;
+;   Writes data to a file which is mapped with a shared mapping,
+;   records the chunks which have been modified, and drops them
+;   from the chunk cache.  Each run of
+;   read_size elements starting at a position in the position array 
+;   takes the next read_size elements of value.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_VirtualArray::_WriteMapped, value, $
+                                    read_size, $
+                                    readstart_pos_array
+
+    compile_opt idl2, strictarrsubs
+
+    n_reads = N_elements(readstart_pos_array)
+
+    if self.va_swapendian then swap_endian_inplace, value
+
+    mapdata = shmvar(self.va_map_segname)
+
+    tmp_pos = readstart_pos_array + self.va_map_offset
+
+    if n_reads eq 1 then begin
+
+        mapdata[tmp_pos[0]] = value
+
+    endif else if read_size lt 64 then begin
+
+        ; scatter the short writes with one index array
+
+        tmp_index = rebin(l64indgen(read_size), read_size, n_reads, $
+                          /SAMPLE) + $
+                    rebin(reform(tmp_pos, 1, n_reads), read_size, n_reads, $
+                          /SAMPLE)
+
+        mapdata[temporary(tmp_index)] = value
+
+    endif else begin
+
+        tmp_read_pos = 0LL
+
+        foreach tmp_start, tmp_pos do begin
+
+            mapdata[tmp_start] = value[tmp_read_pos:tmp_read_pos+read_size-1]
+
+            tmp_read_pos = tmp_read_pos + read_size
+
+        endforeach
+
+    endelse
+
+    mapdata = 0
+
+
+    ; a run no longer than a chunk touches at most two chunks
+
+    tmp_cs = self.va_data_chunk_size
+
+    tmp_first = readstart_pos_array / tmp_cs
+    tmp_last = (readstart_pos_array + read_size - 1) / tmp_cs
+
+    if read_size le tmp_cs then begin
+
+        (*self.va_dirty)[tmp_first] = 1B
+        (*self.va_dirty)[tmp_last] = 1B
+
+    endif else begin
+
+        for i = 0LL, n_reads-1 do (*self.va_dirty)[tmp_first[i]:tmp_last[i]] = 1B
+
+    endelse
+
+
+    ; drop the cached copies of the chunks which were written, so that
+    ; they are read again from the mapping; a prefetch in progress may
+    ; hold old data, so it is collected first
+
+    if obj_valid(self.va_ra_bridge) then self._CollectPrefetch, /wait
+
+    tmp_slots = where(*self.va_cache_chunks ge 0, n_slots, /L64)
+
+    if n_slots eq 0 then return
+
+    tmp_cached = (*self.va_cache_chunks)[tmp_slots]
+
+    if n_reads gt 1 then tmp_sorted = readstart_pos_array[sort(readstart_pos_array)] $
+                    else tmp_sorted = readstart_pos_array
+
+    ; the run starting last before the end of a chunk reaches furthest
+
+    tmp_run = value_locate(tmp_sorted, (tmp_cached + 1) * tmp_cs - 1)
+
+    tmp_stale = where((tmp_run ge 0) and $
+                      (tmp_sorted[tmp_run > 0] + read_size gt tmp_cached * tmp_cs), $
+                      n_stale, /L64)
+
+    if n_stale eq 0 then return
+
+    (*self.va_cache_chunks)[tmp_slots[tmp_stale]] = -1LL
+    (*self.va_cache_lastuse)[tmp_slots[tmp_stale]] = 0LL
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _WriteCached method
+;
+;   Writes data into the chunks in the chunk cache, loading them if
+;   necessary, and marks the chunks as modified.  The modified
+;   chunks are written to the file when they are evicted from the
+;   cache, or by the Flush method.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_VirtualArray::_WriteCached, value, $
+                                    read_size, $
+                                    readstart_pos_array
+
+    compile_opt idl2, strictarrsubs
+
+    n_reads = N_elements(readstart_pos_array)
+
+    tmp_cs = self.va_data_chunk_size
+
+    if n_reads gt 1 && read_size lt 64 then begin
+
+        ; scatter many short writes one chunk at a time
+
+        elem_pos = rebin(l64indgen(read_size), read_size, n_reads, /SAMPLE) + $
+                   rebin(reform(readstart_pos_array, 1, n_reads), $
+                         read_size, n_reads, /SAMPLE)
+
+        elem_pos = reform(elem_pos, read_size * n_reads, /OVERWRITE)
+
+        wmb_varray_plan_reads, elem_pos, tmp_cs, $
+                               read_order, block_list, block_bounds
+
+        foreach tmp_chunk, block_list, i do begin
+
+            tmp_block_ptr = self._CacheChunk(tmp_chunk)
+
+            tmp_sel = read_order[block_bounds[i]:block_bounds[i+1]-1]
+
+            (*tmp_block_ptr)[elem_pos[tmp_sel] - (tmp_chunk * tmp_cs)] = $
+                value[tmp_sel]
+
+            (*self.va_dirty)[tmp_chunk] = 1B
+
+        endforeach
+
+        return
+
+    endif
+
+    for i = 0LL, n_reads-1 do begin
+
+        tmp_pos = readstart_pos_array[i]
+        tmp_end = tmp_pos + read_size - 1
+        tmp_read_pos = i * read_size
+
+        ; split the run at the chunk boundaries
+
+        while tmp_pos le tmp_end do begin
+
+            tmp_chunk = tmp_pos / tmp_cs
+            tmp_rel = tmp_pos mod tmp_cs
+
+            tmp_n = (tmp_cs - tmp_rel) < (tmp_end - tmp_pos + 1)
+
+            tmp_block_ptr = self._CacheChunk(tmp_chunk)
+
+            (*tmp_block_ptr)[tmp_rel] = value[tmp_read_pos:tmp_read_pos+tmp_n-1]
+
+            (*self.va_dirty)[tmp_chunk] = 1B
+
+            tmp_pos = tmp_pos + tmp_n
+            tmp_read_pos = tmp_read_pos + tmp_n
+
+        endwhile
+
+    endfor
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _WriteChunk method
+;
+;   Writes the chunk held in a cache slot to the file, through the
+;   assoc variable, and marks it as unmodified.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_VirtualArray::_WriteChunk, chunk_index, slot
+
+    compile_opt idl2, strictarrsubs
+
+    ; the file was opened with the swap_endian keyword
+
+    tmp_assoc = *self.va_assoc_ptr
+
+    tmp_assoc[chunk_index] = *((*self.va_cache_data)[slot])
+
+    (*self.va_dirty)[chunk_index] = 0B
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Flush method
+;
+;   Writes the modified chunks in the chunk cache to the file.  The
+;   modified pages of a memory mapped file are written back by the
+;   operating system in the background, so for a mapped file this 
+;   only clears the record of modified chunks.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_VirtualArray::Flush
+
+    compile_opt idl2, strictarrsubs
+
+    if ~ ptr_valid(self.va_dirty) then return
+
+    if self.va_map_segname eq '' then begin
+
+        foreach tmp_chunk, *self.va_cache_chunks, slot do begin
+
+            if tmp_chunk lt 0 then continue
+
+            if (*self.va_dirty)[tmp_chunk] then self._WriteChunk, tmp_chunk, slot
+
+        endforeach
+
+        flush, self.va_lun
+
+    endif
+
+    (*self.va_dirty)[*] = 0B
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _ReadChunk method
+;
+;   Returns data chunk chunk_index, from the memory mapped file if
+;   it is mapped, by decompressing it if the file is compressed, and
+;   otherwise from the assoc variable, or from the chunk cache if
+;   the file is writable.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_VirtualArray::_ReadChunk, chunk_index
+
+    compile_opt idl2, strictarrsubs
+
+    if ptr_valid(self.va_chunk_offsets) then $
+        return, self._ReadCompressedChunk(chunk_index)
+
+    if self.va_map_segname eq '' then begin
+
+        ; the cached copy of a chunk may have been modified
+
+        if ptr_valid(self.va_dirty) then begin
+            slot = (where(*self.va_cache_chunks eq chunk_index, cnt))[0]
+            if cnt gt 0 then return, *((*self.va_cache_data)[slot])
+        endif
+
+        return, (*self.va_assoc_ptr)[chunk_index]
+
+    endif
+
+    mapdata = shmvar(self.va_map_segname)
+
+    tmp_start = self.va_map_offset + (chunk_index * self.va_data_chunk_size)
+
+    tmp_chunk = mapdata[tmp_start:tmp_start+self.va_data_chunk_size-1]
+
+    mapdata = 0
+
+    if self.va_swapendian then swap_endian_inplace, tmp_chunk
+
+    return, tmp_chunk
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _ReadCompressedChunk method
+;
+;   Reads and decompresses data chunk chunk_index of a compressed
+;   bricked file.  The bytes of the chunk are stored shuffled into
+;   byte planes, in the byte order of the machine which wrote it.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_VirtualArray::_ReadCompressedChunk, chunk_index
+
+    compile_opt idl2, strictarrsubs
+
+    tmp_start = (*self.va_chunk_offsets)[chunk_index]
+    tmp_end = (*self.va_chunk_offsets)[chunk_index+1]
+
+    tmp_comp = bytarr(tmp_end - tmp_start, /NOZERO)
+
+    point_lun, self.va_lun, tmp_start
+    readu, self.va_lun, tmp_comp
+
+    tmp_bytes = zlib_uncompress(temporary(tmp_comp), TYPE=1)
+
+    tmp_n = self.va_data_chunk_size
+    tmp_dsize = self.va_dtype_size
+
+    if N_elements(tmp_bytes) ne tmp_n * tmp_dsize then $
+        message, 'Invalid compressed data'
+
+    if tmp_dsize gt 1 then $
+        tmp_bytes = reform(transpose(reform(tmp_bytes, tmp_n, tmp_dsize)), $
+                           tmp_n * tmp_dsize)
+
+    tmp_chunk = fix(tmp_bytes, 0, tmp_n, TYPE=self.va_dtype)
+
+    if self.va_swapendian then swap_endian_inplace, tmp_chunk
+
+    return, tmp_chunk
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _CacheChunk method
+;
+;   Returns a pointer to data chunk chunk_index in the chunk cache,
+;   loading it if necessary.  When the cache is full the least 
+;   recently used chunk is evicted and its slot reused, so the 
+;   pointer is only valid until the next call.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_VirtualArray::_CacheChunk, chunk_index
+
+    compile_opt idl2, strictarrsubs
+
+    self.va_cache_clock = self.va_cache_clock + 1
+
+    slot = (where(*self.va_cache_chunks eq chunk_index, cnt))[0]
+
+    if cnt eq 0 && obj_valid(self.va_ra_bridge) then begin
+
+        ; collect the prefetched chunks, waiting if this chunk is 
+        ; being read
+
+        chk_pending = max(*self.va_ra_chunks eq chunk_index)
+
+        self._CollectPrefetch, wait = chk_pending
+
+        slot = (where(*self.va_cache_chunks eq chunk_index, cnt))[0]
+
+    endif
+
+    if cnt gt 0 then begin
+
+        self.va_cache_hits = self.va_cache_hits + 1
+
+    endif else begin
+
+        self.va_cache_misses = self.va_cache_misses + 1
+
+        slot = self._CacheSlot()
+
+        *((*self.va_cache_data)[slot]) = self._ReadChunk(chunk_index)
+
+        (*self.va_cache_chunks)[slot] = chunk_index
+
+    endelse
+
+    (*self.va_cache_lastuse)[slot] = self.va_cache_clock
+
+    if obj_valid(self.va_ra_bridge) then self._ReadAhead, chunk_index
+
+    return, (*self.va_cache_data)[slot]
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _CacheSlot method
+;
+;   Returns an empty cache slot, or evicts the least recently used
+;   chunk and returns its slot.  An evicted chunk which has been
+;   modified is written to the file.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_VirtualArray::_CacheSlot
+
+    compile_opt idl2, strictarrsubs
+
+    tmp = min(*self.va_cache_lastuse, slot)
+
+    tmp_chunk = (*self.va_cache_chunks)[slot]
+
+    if tmp_chunk ge 0 then begin
+
+        self.va_cache_evictions = self.va_cache_evictions + 1
+
+        ; a modified chunk is written to the file before its slot is
+        ; reused
+
+        if ptr_valid(self.va_dirty) then $
+            if (*self.va_dirty)[tmp_chunk] then self._WriteChunk, tmp_chunk, slot
+
+    endif
+
+    (*self.va_cache_chunks)[slot] = -1LL
+
+    return, slot
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _ReadAhead method
+;
+;   Detects sequential or strided access to the chunks, and asks the
+;   read-ahead process to read the next chunks in the sequence in 
+;   the background.  Nothing is done while a read is in progress.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_VirtualArray::_ReadAhead, chunk_index
+
+    compile_opt idl2, strictarrsubs
+
+    if chunk_index eq self.va_ra_last then return
+
+    tmp_stride = chunk_index - self.va_ra_last
+
+    chk_pattern = tmp_stride eq self.va_ra_stride
+
+    self.va_ra_last = chunk_index
+    self.va_ra_stride = tmp_stride
+
+    if ~ chk_pattern then return
+
+    ; finish any previous read first
+
+    if (*self.va_ra_chunks)[0] ge 0 then self._CollectPrefetch
+
+    if (*self.va_ra_chunks)[0] ge 0 then return
+
+
+    ; the next chunks in the sequence which are not cached
+
+    n_slots = N_elements(*self.va_ra_chunks)
+
+    tmp_chunks = chunk_index + tmp_stride * (l64indgen(n_slots) + 1)
+
+    tmp_index = where((tmp_chunks ge 0) and (tmp_chunks lt self.va_nchunks), $
+                      tmp_count)
+
+    if tmp_count eq 0 then return
+
+    tmp_chunks = tmp_chunks[tmp_index]
+
+    tmp_cached = *self.va_cache_chunks
+    tmp_keep = bytarr(tmp_count) + 1B
+
+    foreach tmp_chunk, tmp_chunks, i do $
+        tmp_keep[i] = ~ max(tmp_cached eq tmp_chunk)
+
+    tmp_index = where(tmp_keep, tmp_count)
 
-    wmb_varray_generate_read_sequence, isrange, $
-                                       subscript_list, $
-                                       arr_dims, $
-                                       output_scalar, $
-                                       output_dims, $
-                                       n_reads, $                                       
-                                       read_size, $
-                                       read_start, $                                    
-                                       readstart_pos_array
+    if tmp_count eq 0 then return
 
-    
+    tmp_chunks = tmp_chunks[tmp_index]
 
-    ; make an output array of the appropriate size
-    
-    dtype = self.va_dtype
-    od = make_array(output_dims, type=dtype, /nozero)
-        
-    ; calculate the read end positions
-    
-    readend_pos_array = readstart_pos_array + (read_size-1)
-    
-    
-    ; for each element of the read position list, calculate in which
-    ; data chunk it is contained
-    
-    tmp_data_chunk_size = self.va_data_chunk_size
-    
-    readstart_chunk_arr = readstart_pos_array / tmp_data_chunk_size
-    readend_chunk_arr = readend_pos_array / tmp_data_chunk_size
-    
-    readstart_relative_pos = readstart_pos_array mod tmp_data_chunk_size
-    readend_relative_pos = readend_pos_array mod tmp_data_chunk_size
-    
-    span_chunks = readstart_chunk_arr ne readend_chunk_arr
+    self.va_ra_bridge->SetVar, 'ra_chunks', tmp_chunks
+    self.va_ra_bridge->Execute, self.va_ra_command, /NOWAIT
 
+    (*self.va_ra_chunks)[0:tmp_count-1] = tmp_chunks
 
-    ; read the data and transfer it to the output array
-    
-    tmp_write_pos = 0ULL
-    loaded_chunk = self.va_data_current_chunk
-    if loaded_chunk ge 0 then tmp_data_block = *(self.va_data_chunk_ptr)
-    
-    foreach tmp_readstart_rel, readstart_relative_pos, indexa do begin
-    
-        if span_chunks[indexa] eq 0 then begin
-        
-            ; this read operation does not span a chunk boundary
-        
-            tmp_read_chunk = readstart_chunk_arr[indexa]
-        
-            if tmp_read_chunk ne loaded_chunk then begin
-                
-                tmp_data_block = (*self.va_assoc_ptr)[tmp_read_chunk]
+end
 
-                loaded_chunk = tmp_read_chunk
-                
-                ;print, 'Virtual array: File read'
-                
-            endif else begin
-                
-                ;print, 'Virtual array: Memory read'
-                
-            endelse
-        
-            readend = readend_relative_pos[indexa]
-        
-            od[tmp_write_pos] = tmp_data_block[tmp_readstart_rel:readend]
-        
-            tmp_write_pos = tmp_write_pos + read_size
-            
-        endif else begin
-            
-            ; the read operation spans a chunk boundary
-            
-            ;print, 'Virtual array: Span chunks'
-            
-            startchunk = readstart_chunk_arr[indexa]
-            endchunk = readend_chunk_arr[indexa]
-            
-            nchunks_span = endchunk - startchunk + 1
-            
-            for i = 0, nchunks_span-1 do begin
-                
-                tmp_read_chunk = startchunk + i
-                
-                if tmp_read_chunk ne loaded_chunk then begin
-                    
-                    tmp_data_block = (*self.va_assoc_ptr)[tmp_read_chunk]
 
-                    loaded_chunk = tmp_read_chunk
-                    
-                endif 
-                
-                if i eq 0 then readstart = tmp_readstart_rel $
-                          else readstart = 0LL
-                          
-                if i eq (nchunks_span-1) then begin
-                    
-                    readend = readend_relative_pos[indexa]
-                    
-                endif else begin
-                    
-                    ; last element in the chunk
-                    readend = tmp_data_chunk_size - 1  
-                    
-                endelse
-                
-                od[tmp_write_pos] = tmp_data_block[readstart:readend]
-        
-                tmp_write_pos = tmp_write_pos + ((readend - readstart) + 1)
-                
-            endfor
-        endelse
-        
-    endforeach
-    
-    
-    if loaded_chunk ne self.va_data_current_chunk then begin
-        
-        ; store the loaded chunk in memory
-        
-        if ptr_valid(self.va_data_chunk_ptr) eq 1 then begin
-            
-            *self.va_data_chunk_ptr = temporary(tmp_data_block)
-            
-        endif else begin
-            
-            self.va_data_chunk_ptr = ptr_new(tmp_data_block, /NO_COPY)
-            
-        endelse
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _CollectPrefetch method
+;
+;   Moves the chunks read by the read-ahead process into the chunk
+;   cache.  If the read is still in progress, this returns without
+;   doing anything unless the wait keyword is set.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_VirtualArray::_CollectPrefetch, wait = chk_wait
+
+    compile_opt idl2, strictarrsubs
 
-        self.va_data_current_chunk = loaded_chunk
+    if N_elements(chk_wait) eq 0 then chk_wait = 0
+
+    tmp_pending = *self.va_ra_chunks
+
+    if tmp_pending[0] lt 0 then return
+
+    tmp_status = self.va_ra_bridge->Status()
+
+    if tmp_status eq 1 then begin
+
+        if ~ chk_wait then return
+
+        while tmp_status eq 1 do begin
+            wait, 0.001
+            tmp_status = self.va_ra_bridge->Status()
+        endwhile
 
     endif
 
+    (*self.va_ra_chunks)[*] = -1LL
 
-    ; ensure that the output array has the correct dimensions
+    ; status 2 is a completed command - anything else is an error
 
-    if output_scalar then begin
-    
-        od = od[0]
-        
-    endif else begin
-        
-        od = reform(od, output_dims, /overwrite)
-        
-    endelse
+    if tmp_status ne 2 then return
 
-    return, od
+    ra_buf = shmvar(self.va_ra_segname)
+
+    tmp_cs = self.va_data_chunk_size
+
+    foreach tmp_chunk, tmp_pending, i do begin
+
+        if tmp_chunk lt 0 then break
+
+        ; the chunk may have been read since it was requested
+
+        if max(*self.va_cache_chunks eq tmp_chunk) then continue
+
+        slot = self._CacheSlot()
+
+        *((*self.va_cache_data)[slot]) = ra_buf[i*tmp_cs:(i+1)*tmp_cs-1]
+
+        (*self.va_cache_chunks)[slot] = tmp_chunk
+        (*self.va_cache_lastuse)[slot] = self.va_cache_clock
+
+        self.va_ra_prefetched = self.va_ra_prefetched + 1
+
+    endforeach
+
+    ra_buf = 0
 
 end
 
@@ -305,6 +1141,8 @@ pro wmb_VirtualArray::Copy, dest_lun, $
     ; calculate the number of file reads required, and the list of 
     ; read positions
 
+    if ptr_valid(self.va_brick_dimsptr) then brick_dims = *self.va_brick_dimsptr
+
     wmb_varray_generate_read_sequence, isrange, $
                                        source_data_range, $
                                        arr_dims, $
@@ -313,7 +1151,31 @@ pro wmb_VirtualArray::Copy, dest_lun, $
                                        n_reads, $                                       
                                        read_size, $
                                        read_start, $                                    
-                                       readstart_pos_array
+                                       readstart_pos_array, $
+                                       brick_dims = brick_dims
+
+
+    ; the elements of a bricked file are gathered from the bricks in
+    ; blocks, and written in order
+
+    if N_elements(brick_dims) gt 0 then begin
+
+        tmp_block = self.va_data_chunk_size * 10
+
+        for tmp_start = 0LL, n_reads-1, tmp_block do begin
+
+            tmp_end = ((tmp_start + tmp_block) < n_reads) - 1
+
+            writeu, dest_lun, $
+                self._GatherChunks(0, [tmp_end - tmp_start + 1], 1, $
+                                   readstart_pos_array[tmp_start:tmp_end])
+
+        endfor
+
+        return
+
+    endif
+
 
     ; calculate the read end positions
     
@@ -355,8 +1217,7 @@ pro wmb_VirtualArray::Copy, dest_lun, $
     
     tmp_write_pos = 0ULL
 
-    loaded_chunk = self.va_data_current_chunk
-    if loaded_chunk ge 0 then tmp_data_block = *(self.va_data_chunk_ptr)
+    loaded_chunk = -1LL
     
     foreach tmp_readstart_rel, readstart_relative_pos, indexa do begin
     
@@ -377,7 +1238,7 @@ pro wmb_VirtualArray::Copy, dest_lun, $
         
             if tmp_read_chunk ne loaded_chunk then begin
                 
-                tmp_data_block = (*self.va_assoc_ptr)[tmp_read_chunk]
+                tmp_block_ptr = self._CacheChunk(tmp_read_chunk)
 
                 loaded_chunk = tmp_read_chunk
                 
@@ -389,11 +1250,11 @@ pro wmb_VirtualArray::Copy, dest_lun, $
             if tmp_use_data_buf eq 1 then begin
                 
                 tmp_data_buf[tmp_write_pos] = $
-                                    tmp_data_block[tmp_readstart_rel:readend]
+                                    (*tmp_block_ptr)[tmp_readstart_rel:readend]
         
             endif else begin
                 
-                writeu, dest_lun, tmp_data_block[tmp_readstart_rel:readend]
+                writeu, dest_lun, (*tmp_block_ptr)[tmp_readstart_rel:readend]
                 
             endelse
             
@@ -415,7 +1276,7 @@ pro wmb_VirtualArray::Copy, dest_lun, $
                 
                 if tmp_read_chunk ne loaded_chunk then begin
                     
-                    tmp_data_block = (*self.va_assoc_ptr)[tmp_read_chunk]
+                    tmp_block_ptr = self._CacheChunk(tmp_read_chunk)
 
                     loaded_chunk = tmp_read_chunk
                     
@@ -439,11 +1300,11 @@ pro wmb_VirtualArray::Copy, dest_lun, $
                 if tmp_use_data_buf eq 1 then begin
                     
                     tmp_data_buf[tmp_write_pos] = $
-                                        tmp_data_block[readstart:readend]
+                                        (*tmp_block_ptr)[readstart:readend]
                                         
                 endif else begin
                     
-                    writeu, dest_lun, tmp_data_block[readstart:readend]
+                    writeu, dest_lun, (*tmp_block_ptr)[readstart:readend]
                     
                 endelse
                     
@@ -456,133 +1317,392 @@ pro wmb_VirtualArray::Copy, dest_lun, $
     endforeach
     
     
-    if loaded_chunk ne self.va_data_current_chunk then begin
+    ;empty the data buffer
+    if tmp_use_data_buf eq 1 and tmp_write_pos gt 0 then begin
         
-        ; store the loaded chunk in memory
+        writeu, dest_lun, tmp_data_buf[0:(tmp_write_pos-1)]
         
-        if ptr_valid(self.va_data_chunk_ptr) eq 1 then begin
-            
-            *self.va_data_chunk_ptr = temporary(tmp_data_block)
-            
-        endif else begin
-            
-            self.va_data_chunk_ptr = ptr_new(tmp_data_block, /NO_COPY)
-            
-        endelse
+    endif
+    
+;    n_bytes_copied = tmp_write_pos * self.va_dtype_size
+    
+;    ; convert the read positions and read size to bytes
+;    
+;    dtype_size = self.va_dtype_size
+;    
+;    readstart_pos_array_bytes = (readstart_pos_array * dtype_size) + $
+;                                self.va_offset
+;  
+;    read_size_bytes = read_size * dtype_size
+;    
+;    
+;    ; copy the data to the destination file
+;    
+;    src_lun = self.va_lun
+;    total_bytes_written = 0ULL
+;    
+;    for i = 0, n_reads-1 do begin
+;    
+;        point_lun, src_lun, readstart_pos_array_bytes[i]
+;        
+;        copy_lun, src_lun, dest_lun, read_size_bytes, $
+;                  TRANSFER_COUNT = bytes_written
+;    
+;        total_bytes_written += bytes_written 
+;            
+;    endfor
+;            
+;    n_bytes_copied = total_bytes_written
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _ReadBlock method
+;
+;   Reads count elements starting at element position start, in
+;   one read from the file or one copy from the memory mapping.  
+;   The chunk cache is not used.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_VirtualArray::_ReadBlock, start, count
+
+    compile_opt idl2, strictarrsubs
+
+    if ptr_valid(self.va_chunk_offsets) then begin
+
+        ; decompress the chunks which contain the block
+
+        tmp_cs = self.va_data_chunk_size
+
+        tmp_first = start / tmp_cs
+        tmp_last = (start + count - 1) / tmp_cs
+
+        tmp_block = make_array((tmp_last - tmp_first + 1) * tmp_cs, $
+                               TYPE=self.va_dtype, /NOZERO)
+
+        for i = tmp_first, tmp_last do $
+            tmp_block[(i - tmp_first) * tmp_cs] = self._ReadCompressedChunk(i)
+
+        tmp_start = start - (tmp_first * tmp_cs)
+
+        return, tmp_block[tmp_start:tmp_start+count-1]
+
+    endif
+
+    if self.va_map_segname ne '' then begin
+
+        mapdata = shmvar(self.va_map_segname)
+
+        tmp_start = self.va_map_offset + start
+
+        tmp_block = mapdata[tmp_start:tmp_start+count-1]
+
+        mapdata = 0
+
+        if self.va_swapendian then swap_endian_inplace, tmp_block
+
+    endif else begin
+
+        ; write any modified chunks before reading the file, which
+        ; was opened with the swap_endian keyword
+
+        if ptr_valid(self.va_dirty) then self.Flush
+
+        tmp_block = make_array(count, TYPE=self.va_dtype, /NOZERO)
+
+        point_lun, self.va_lun, self.va_offset + (start * self.va_dtype_size)
+
+        readu, self.va_lun, tmp_block
+
+    endelse
+
+    return, tmp_block
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _BrickValidIndex method
+;
+;   Returns the positions of the data elements, leaving out the 
+;   padding, in a block of n_bricks bricks of a bricked file 
+;   starting at brick first_brick.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_VirtualArray::_BrickValidIndex, first_brick, n_bricks
+
+    compile_opt idl2, strictarrsubs
+
+    tmp_dims = *self.va_dimsptr
+    tmp_bdims = *self.va_brick_dimsptr
+    tmp_nbricks = (tmp_dims + tmp_bdims - 1) / tmp_bdims
+
+    brick_elems = self.va_data_chunk_size
+
+    within_mult = long64(shift(product(tmp_bdims, /integer, /cumulative), 1))
+    within_mult[0] = 1
 
-        self.va_data_current_chunk = loaded_chunk
+    valid_index = []
 
+    for j = 0LL, n_bricks-1 do begin
+
+        tmp_coords = array_indices(tmp_nbricks, first_brick + j, /DIMENSIONS)
+
+        offset_list = list()
+
+        foreach tmp_bdim, tmp_bdims, i do begin
+
+            tmp_extent = tmp_bdim < (tmp_dims[i] - tmp_coords[i] * tmp_bdim)
+
+            offset_list.Add, l64indgen(tmp_extent) * within_mult[i]
+
+        endforeach
+
+        valid_index = [valid_index, $
+                       wmb_varray_outer_index(offset_list, $
+                                              base = j * brick_elems)]
+
+    endfor
+
+    return, valid_index
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Statistics method
+;
+;   Computes the statistics of the whole array in one pass over the
+;   file, and returns a structure with the fields n, min, max, sum,
+;   mean, variance, stddev, hist_min, hist_max, binsize and
+;   histogram.  The 
+;   statistics are returned as double precision values, and
+;   non-finite values are ignored.  See wmb_varray_reduce.
+;
+;   If NBINS is set a histogram of NBINS equal bins from HIST_MIN
+;   to HIST_MAX is computed.  If the histogram range is not given,
+;   it is 0 to 256 for byte data, and otherwise the data range, 
+;   which requires a second pass over the file.
+;
+;   The statistics are of the data after the output conversion (see
+;   _ConvertOutput).
+;
+;   The file is read in blocks of about BLOCKSIZE_BYTES (default
+;   16MB), which are a whole number of data chunks.  The reductions
+;   on each block use the IDL thread pool.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_VirtualArray::Statistics, nbins = nbins, $
+                                       hist_min = hist_min, $
+                                       hist_max = hist_max, $
+                                       blocksize_bytes = blocksize_bytes
+
+    compile_opt idl2, strictarrsubs
+
+    if N_elements(nbins) eq 0 then nbins = 0
+    if N_elements(blocksize_bytes) eq 0 then blocksize_bytes = 16777216LL
+
+    self.GetProperty, output_type = dtype
+
+    if dtype eq 6 || dtype eq 9 then $
+        message, 'Statistics of complex data are not supported'
+
+    n_total = self.va_nchunks * self.va_data_chunk_size
+
+    tmp_chunks_per_block = (long64(blocksize_bytes) / $
+                           (self.va_data_chunk_size * self.va_dtype_size)) > 1LL
+
+    block_size = tmp_chunks_per_block * self.va_data_chunk_size
+
+    chk_padded = 0
+
+    if ptr_valid(self.va_brick_dimsptr) then begin
+        brick_elems = self.va_data_chunk_size
+        chk_padded = max((*self.va_dimsptr mod *self.va_brick_dimsptr) ne 0)
     endif
-    
-    
-    ;empty the data buffer
-    if tmp_use_data_buf eq 1 and tmp_write_pos gt 0 then begin
-        
-        writeu, dest_lun, tmp_data_buf[0:(tmp_write_pos-1)]
-        
+
+
+    ; determine the histogram bins
+
+    if nbins gt 0 then begin
+
+        if N_elements(hist_min) eq 0 || N_elements(hist_max) eq 0 then begin
+
+            if dtype eq 1 then begin
+
+                tmp_hmin = 0.0D
+                tmp_hmax = 256.0D
+
+            endif else begin
+
+                tmp_stats = self.Statistics(blocksize_bytes = blocksize_bytes)
+
+                tmp_hmin = tmp_stats.min
+                tmp_hmax = tmp_stats.max
+
+            endelse
+
+            if N_elements(hist_min) eq 0 then hist_min = tmp_hmin
+            if N_elements(hist_max) eq 0 then hist_max = tmp_hmax
+
+        endif
+
+        if hist_max lt hist_min then message, 'Invalid histogram range'
+
+        tmp_binsize = (hist_max eq hist_min) ? 1.0D : $
+                      (double(hist_max) - hist_min) / nbins
+
     endif
-    
-;    n_bytes_copied = tmp_write_pos * self.va_dtype_size
-    
-;    ; convert the read positions and read size to bytes
-;    
-;    dtype_size = self.va_dtype_size
-;    
-;    readstart_pos_array_bytes = (readstart_pos_array * dtype_size) + $
-;                                self.va_offset
-;  
-;    read_size_bytes = read_size * dtype_size
-;    
-;    
-;    ; copy the data to the destination file
-;    
-;    src_lun = self.va_lun
-;    total_bytes_written = 0ULL
-;    
-;    for i = 0, n_reads-1 do begin
-;    
-;        point_lun, src_lun, readstart_pos_array_bytes[i]
-;        
-;        copy_lun, src_lun, dest_lun, read_size_bytes, $
-;                  TRANSFER_COUNT = bytes_written
-;    
-;        total_bytes_written += bytes_written 
-;            
-;    endfor
-;            
-;    n_bytes_copied = total_bytes_written
+
+
+    ; reduce the data one block at a time
+
+    for tmp_start = 0LL, n_total-1, block_size do begin
+
+        tmp_count = block_size < (n_total - tmp_start)
+
+        tmp_data = self._ReadBlock(tmp_start, tmp_count)
+
+        ; leave out the padding of the bricks at the edge of a bricked
+        ; file
+
+        if chk_padded then $
+            tmp_data = tmp_data[self._BrickValidIndex(tmp_start / brick_elems, $
+                                                      tmp_count / brick_elems)]
+
+        tmp_data = self._ConvertOutput(temporary(tmp_data))
+
+        wmb_varray_reduce, state, $
+                           temporary(tmp_data), $
+                           nbins = nbins, $
+                           hist_min = hist_min, $
+                           hist_max = hist_max, $
+                           binsize = tmp_binsize
+
+    endfor
+
+    wmb_varray_reduce, state, /finish
+
+    return, state
 
 end
 
 
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
-;   This is the Max_Value method
+;   This is the _ScanExtreme method
 ;
-;   Returns the maximum value in the array.
+;   Returns the maximum value in the file, or the minimum value if
+;   the minimum keyword is set, before any output conversion.
 ;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-function wmb_VirtualArray::Max_Value
+function wmb_VirtualArray::_ScanExtreme, minimum = minimum
 
     compile_opt idl2, strictarrsubs
 
-    tmpassoc = self.va_assoc_ptr
-    
+    if N_elements(minimum) eq 0 then minimum = 0
+
     n_chunks = self.va_nchunks
     
-    tmpdata = tmpassoc[0]
+    tmpdata = self._ReadChunk(0LL)
     
-    maxvalue = max(tmpdata)
+    if minimum then extvalue = min(tmpdata) else extvalue = max(tmpdata)
     
     if n_chunks gt 1 then begin
         
         for i = long64(1), n_chunks-1 do begin
             
-            tmpdata = tmpassoc[i]
-            maxvalue = maxvalue > max(tmpdata)
+            tmpdata = self._ReadChunk(i)
+            
+            if minimum then extvalue = extvalue < min(tmpdata) $
+                       else extvalue = extvalue > max(tmpdata)
             
         endfor
 
     endif
 
-    return, maxvalue
+    return, extvalue
 
 end
 
 
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
-;   This is the Min_Value method
+;   This is the Max_Value method
 ;
 ;   Returns the maximum value in the array.
 ;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
+function wmb_VirtualArray::Max_Value
+
+    compile_opt idl2, strictarrsubs
+
+    ; a negative output scale exchanges the maximum and minimum
+
+    return, self._ConvertOutput(self._ScanExtreme( $
+                                    minimum = (self.va_out_scale lt 0)))
+
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the Min_Value method
+;
+;   Returns the minimum value in the array.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
 function wmb_VirtualArray::Min_Value
 
     compile_opt idl2, strictarrsubs
 
-    tmpassoc = self.va_assoc_ptr
-    
-    n_chunks = self.va_nchunks
-    
-    tmpdata = tmpassoc[0]
-    
-    minvalue = min(tmpdata)
-    
-    if n_chunks gt 1 then begin
-        
-        for i = long64(1), n_chunks-1 do begin
-            
-            tmpdata = tmpassoc[i]
-            minvalue = minvalue < min(tmpdata)
-            
-        endfor
+    return, self._ConvertOutput(self._ScanExtreme( $
+                                    minimum = (self.va_out_scale ge 0)))
 
-    endif
+end
+
+
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   This is the _ConvertOutput method
+;
+;   Converts data read from the file to the output data type, and
+;   applies the output scale and offset, in place where possible.
+;   The scale and offset are converted to the output type, which
+;   SetProperty only allows when they are whole numbers or the output
+;   type is floating point or complex.
+;
+;   Byte swapping has already been done as the data was read, so
+;   the data is converted in one pass after it leaves the file or
+;   chunk buffer.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+function wmb_VirtualArray::_ConvertOutput, od
+
+    compile_opt idl2, strictarrsubs
+
+    tmp_type = self.va_out_type
+
+    if tmp_type ne 0 && tmp_type ne self.va_dtype then $
+        od = fix(temporary(od), TYPE=tmp_type)
+
+    tmp_type = size(od, /TYPE)
 
-    return, minvalue
+    if self.va_out_scale ne 1 then od *= fix(self.va_out_scale, TYPE=tmp_type)
+    if self.va_out_offset ne 0 then od += fix(self.va_out_offset, TYPE=tmp_type)
+
+    return, od
 
 end
 
@@ -593,10 +1713,37 @@ end
 ;
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
-pro wmb_VirtualArray::SetProperty, _Extra=extra
+pro wmb_VirtualArray::SetProperty, output_type=output_type, $
+                                   output_scale=output_scale, $
+                                   output_offset=output_offset, $
+                                   _Extra=extra
 
     compile_opt idl2, strictarrsubs
 
+    tmp_type = (N_elements(output_type) ne 0) ? output_type : self.va_out_type
+    tmp_scale = (N_elements(output_scale) ne 0) ? output_scale : self.va_out_scale
+    tmp_offset = (N_elements(output_offset) ne 0) ? output_offset : self.va_out_offset
+
+    if (tmp_type eq 7) or (tmp_type eq 8) or $
+       (tmp_type eq 10) or (tmp_type eq 11) then $
+        message, 'Unsupported output data type'
+
+    ; an integer output type would truncate a fractional scale or
+    ; offset, so use a floating point output type for those
+
+    if tmp_type eq 0 then tmp_type = self.va_dtype
+
+    chk_int = total(tmp_type eq [1,2,3,12,13,14,15]) gt 0
+
+    if chk_int && (tmp_scale ne round(tmp_scale) || $
+                   tmp_offset ne round(tmp_offset)) then $
+        message, 'A fractional output scale or offset requires a ' + $
+                 'floating point output type'
+
+    if N_elements(output_type) ne 0 then self.va_out_type = output_type
+    if N_elements(output_scale) ne 0 then self.va_out_scale = output_scale
+    if N_elements(output_offset) ne 0 then self.va_out_offset = output_offset
+
 
     ; pass extra keywords
 
@@ -617,6 +1764,19 @@ pro wmb_VirtualArray::GetProperty,  filename=filename, $
                                     datadims=datadims, $
                                     datatype=datatype, $                 
                                     filewritable=filewritable, $
+                                    mmap=mmap, $
+                                    cachesize_bytes=cachesize_bytes, $
+                                    cache_hits=cache_hits, $
+                                    cache_misses=cache_misses, $
+                                    cache_evictions=cache_evictions, $
+                                    cache_prefetched=cache_prefetched, $
+                                    readahead_chunks=readahead_chunks, $
+                                    brick_dims=brick_dims, $
+                                    output_type=output_type, $
+                                    output_scale=output_scale, $
+                                    output_offset=output_offset, $
+                                    writable=writable, $
+                                    dirty_chunks=dirty_chunks, $
                                     _Ref_Extra=extra
 
     compile_opt idl2, strictarrsubs
@@ -628,6 +1788,49 @@ pro wmb_VirtualArray::GetProperty,  filename=filename, $
     if Arg_present(datadims) ne 0 then datadims=(*self.va_dimsptr)    
     if Arg_present(datatype) ne 0 then datatype=self.va_dtype 
     if Arg_present(filewritable) ne 0 then filewritable=self.va_writeable
+    if Arg_present(mmap) ne 0 then mmap=(self.va_map_segname ne '')
+    
+    if Arg_present(writable) ne 0 then writable=ptr_valid(self.va_dirty)
+    
+    ; a byte flag for each data chunk, set if the chunk has been
+    ; modified and not yet flushed, or all zero if the file is not
+    ; writable
+
+    if Arg_present(dirty_chunks) ne 0 then begin
+        if ptr_valid(self.va_dirty) then dirty_chunks = *self.va_dirty $
+                                    else dirty_chunks = bytarr(self.va_nchunks)
+    endif
+    
+    if Arg_present(output_type) ne 0 then begin
+        if self.va_out_type ne 0 then output_type = self.va_out_type $
+                                 else output_type = self.va_dtype
+    endif
+    
+    if Arg_present(output_scale) ne 0 then output_scale=self.va_out_scale
+    if Arg_present(output_offset) ne 0 then output_offset=self.va_out_offset
+    
+    if Arg_present(brick_dims) ne 0 then begin
+        if ptr_valid(self.va_brick_dimsptr) then $
+            brick_dims = *self.va_brick_dimsptr $
+        else brick_dims = 0
+    endif
+    
+    if Arg_present(cachesize_bytes) ne 0 then $
+        cachesize_bytes = N_elements(*self.va_cache_chunks) * $
+                          self.va_data_chunk_size * self.va_dtype_size
+    
+    if Arg_present(cache_hits) ne 0 then cache_hits=self.va_cache_hits
+    if Arg_present(cache_misses) ne 0 then cache_misses=self.va_cache_misses
+    if Arg_present(cache_evictions) ne 0 then $
+        cache_evictions=self.va_cache_evictions
+    if Arg_present(cache_prefetched) ne 0 then $
+        cache_prefetched=self.va_ra_prefetched
+    
+    if Arg_present(readahead_chunks) ne 0 then begin
+        if obj_valid(self.va_ra_bridge) then $
+            readahead_chunks = N_elements(*self.va_ra_chunks) $
+        else readahead_chunks = 0
+    endif
     
     
     ; pass extra keywords
@@ -650,8 +1853,15 @@ function wmb_VirtualArray::Init, filename, $
                                  datadims, $
                                  datatype, $                  
                                  chunksize_bytes=chunksize_bytes, $           
+                                 cachesize_bytes=cachesize_bytes, $
+                                 readahead_chunks=readahead_chunks, $
                                  fileoffset_bytes=fileoffset_bytes, $
-                                 fileswapendian=fileswapendian
+                                 fileswapendian=fileswapendian, $
+                                 mmap=mmap, $
+                                 writable=writable, $
+                                 output_type=output_type, $
+                                 output_scale=output_scale, $
+                                 output_offset=output_offset
                              
 
     compile_opt idl2, strictarrsubs
@@ -664,6 +1874,26 @@ function wmb_VirtualArray::Init, filename, $
         return, 0
     endif
 
+    ; a bricked array file contains its dimensions, data type and 
+    ; byte order, which replace any values given here
+
+    brick_header = wmb_varray_read_brick_header(filename)
+
+    chk_bricked = size(brick_header, /TYPE) eq 8
+
+    if chk_bricked then begin
+
+        datadims = brick_header.dims[0:brick_header.rank-1]
+        datatype = brick_header.datatype
+        fileoffset_bytes = brick_header.data_offset
+        fileswapendian = brick_header.swap
+
+        tmp_brick_dims = brick_header.brick_dims[0:brick_header.rank-1]
+
+    endif
+
+    chk_compressed = chk_bricked && (brick_header.codec eq 1)
+
     if N_elements(datadims) eq 0 then begin
         message, 'Invalid data dimensions'
         return, 0
@@ -676,6 +1906,16 @@ function wmb_VirtualArray::Init, filename, $
     
 
     ; check keyword parameters
+
+    ; subscripts of a memory mapped file copy the data straight from
+    ; the mapping, so the chunk cache and read-ahead are used only by
+    ; Copy and the other block reads.  Files are mapped by default
+    ; unless the caller sized the cache or asked for read-ahead, in
+    ; which case the reads go through the cache unless MMAP is set.
+
+    if N_elements(mmap) eq 0 then $
+        mmap = (N_elements(cachesize_bytes) eq 0) && $
+               (N_elements(readahead_chunks) eq 0)
     
     if N_elements(chunksize_bytes) eq 0 then begin
         
@@ -687,8 +1927,18 @@ function wmb_VirtualArray::Init, filename, $
     
     tmp_chunksize_bytes = long64(chunksize_bytes)
 
+    if N_elements(cachesize_bytes) eq 0 then begin
+        
+        ; this sets the default chunk cache size (bytes)
+        
+        cachesize_bytes = 16777216LL    ; 16MB
+        
+    endif
+
     if N_elements(fileoffset_bytes) eq 0 then fileoffset_bytes = 0
     if N_elements(fileswapendian) eq 0 then fileswapendian = 0
+    if N_elements(readahead_chunks) eq 0 then readahead_chunks = 0
+    if N_elements(writable) eq 0 then writable = 0
 
 
     ; convert the data dims to long64
@@ -719,11 +1969,31 @@ function wmb_VirtualArray::Init, filename, $
         return, 0
     endif
 
+    if writable ne 0 && (chk_write eq 0 || chk_compressed) then begin
+        message, 'The file cannot be written'
+        return, 0
+    endif
+
     ; check the file size
 
     datadims_product = product(tmp_datadims, /integer)
     tmp_dtype_size = wmb_sizeoftype(datatype)
-    expected_filesize = (datadims_product * tmp_dtype_size) + fileoffset_bytes
+
+    ; the bricks at the edge of a bricked file are padded
+
+    if chk_bricked then begin
+        file_elements = product((tmp_datadims + tmp_brick_dims - 1) / $
+                                tmp_brick_dims, /integer) * $
+                        product(tmp_brick_dims, /integer)
+    endif else begin
+        file_elements = datadims_product
+    endelse
+
+    expected_filesize = (file_elements * tmp_dtype_size) + fileoffset_bytes
+
+    ; the size of a compressed file is checked against its offset table
+    
+    if chk_compressed then expected_filesize = fileoffset_bytes
     
     if tmp_size lt expected_filesize then begin
         message, 'File size smaller than expected'
@@ -790,6 +2060,11 @@ function wmb_VirtualArray::Init, filename, $
         
     endelse
     
+    ; in a bricked file each chunk is one brick
+    
+    if chk_bricked then adjusted_data_chunk_size = product(tmp_brick_dims, $
+                                                           /integer)
+    
     
     ; open the file
 
@@ -816,7 +2091,29 @@ function wmb_VirtualArray::Init, filename, $
     
     
     ; calculate the number of data chunks in the assoc array
-    n_chunks = datadims_product / adjusted_data_chunk_size
+    n_chunks = file_elements / adjusted_data_chunk_size
+    
+    ; read the brick offset table of a compressed file, which follows 
+    ; the 512 byte header
+    
+    chunk_offsets_ptr = ptr_new()
+    
+    if chk_compressed then begin
+    
+        tmp_offsets = lon64arr(n_chunks + 1)
+        
+        point_lun, tmplun, 512
+        readu, tmplun, tmp_offsets
+        
+        if tmp_size lt tmp_offsets[n_chunks] then begin
+            free_lun, tmplun
+            message, 'File size smaller than expected'
+            return, 0
+        endif
+        
+        chunk_offsets_ptr = ptr_new(tmp_offsets, /NO_COPY)
+    
+    endif
     
     ; create an assoc variable linked to the file, with the appropriate
     ; offset and chunk size
@@ -827,6 +2124,64 @@ function wmb_VirtualArray::Init, filename, $
     filedata_assoc_ptr = ptr_new(filedata_assoc)
 
 
+    ; create the chunk cache, with at least one slot
+
+    n_cache_slots = long64(cachesize_bytes) / $
+                    (adjusted_data_chunk_size * tmp_dtype_size)
+    
+    n_cache_slots = (n_cache_slots < n_chunks) > 1LL
+    
+    cache_data = ptrarr(n_cache_slots, /ALLOCATE_HEAP)
+    cache_chunks = replicate(-1LL, n_cache_slots)
+    cache_lastuse = lon64arr(n_cache_slots)
+
+
+    ; memory map the file, if possible - the mapping starts at the 
+    ; beginning of the file, so the offset must be a whole number of 
+    ; data elements.  A writable file has a shared mapping, so that 
+    ; changes are written to the file.
+    
+    map_segname = ''
+    map_offset = 0LL
+    
+    if mmap ne 0 && (fileoffset_bytes mod tmp_dtype_size) eq 0 && $
+       (~ chk_compressed) then begin
+    
+        map_offset = long64(fileoffset_bytes) / tmp_dtype_size
+        
+        map_segname = wmb_varray_mmap(filename, datatype, $
+                                      map_offset + file_elements, $
+                                      private = (writable eq 0))
+    
+    endif
+
+
+    ; start the read-ahead process, for files which are not mapped or
+    ; written - the cache must hold the chunks read ahead and the 
+    ; chunk in use
+    
+    n_ra_slots = long64(readahead_chunks) < (n_cache_slots - 1)
+    
+    if writable ne 0 then n_ra_slots = 0LL
+    
+    ra_bridge = obj_new()
+    ra_segname = ''
+    ra_command = ''
+    
+    if n_ra_slots gt 0 && map_segname eq '' && (~ chk_compressed) then begin
+    
+        ra_bridge = wmb_varray_readahead_bridge(filename, $
+                                                datatype, $
+                                                adjusted_data_chunk_size, $
+                                                fileoffset_bytes, $
+                                                fileswapendian, $
+                                                n_ra_slots, $
+                                                segname = ra_segname, $
+                                                read_command = ra_command)
+    
+    endif
+
+
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 ;
 ;   populate the self fields
@@ -835,6 +2190,8 @@ function wmb_VirtualArray::Init, filename, $
 
     self.va_rank = data_rank
     self.va_dimsptr = ptr_new(tmp_datadims)
+    if chk_bricked then self.va_brick_dimsptr = ptr_new(tmp_brick_dims)
+    self.va_chunk_offsets = chunk_offsets_ptr
     self.va_dtype = datatype
     
     self.va_dtype_size = tmp_dtype_size
@@ -844,10 +2201,25 @@ function wmb_VirtualArray::Init, filename, $
     self.va_offset = fileoffset_bytes
     self.va_swapendian = fileswapendian
     self.va_writeable = chk_write
-    self.va_data_current_chunk = -1LL
     self.va_data_chunk_size = adjusted_data_chunk_size
     self.va_nchunks = n_chunks
     self.va_assoc_ptr = filedata_assoc_ptr
+    self.va_map_segname = map_segname
+    self.va_map_offset = map_offset
+    self.va_cache_data = ptr_new(cache_data, /NO_COPY)
+    self.va_cache_chunks = ptr_new(cache_chunks, /NO_COPY)
+    self.va_cache_lastuse = ptr_new(cache_lastuse, /NO_COPY)
+    self.va_ra_bridge = ra_bridge
+    self.va_ra_segname = ra_segname
+    self.va_ra_command = ra_command
+    self.va_ra_chunks = ptr_new(replicate(-1LL, n_ra_slots > 1))
+    self.va_ra_last = -1LL
+    if writable ne 0 then self.va_dirty = ptr_new(bytarr(n_chunks))
+    self.va_out_scale = 1.0D
+
+    self.SetProperty, output_type = output_type, $
+                      output_scale = output_scale, $
+                      output_offset = output_offset
 
 
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
@@ -880,11 +2252,34 @@ pro wmb_VirtualArray::Cleanup
 
     compile_opt idl2, strictarrsubs
 
+    ; write any modified chunks
+
+    if ptr_valid(self.va_dirty) && ptr_valid(self.va_cache_data) then self.Flush
+
+    ptr_free, self.va_dirty
+
     ptr_free, self.va_dimsptr
+
+    ptr_free, self.va_brick_dimsptr
+
+    ptr_free, self.va_chunk_offsets
     
     ptr_free, self.va_assoc_ptr
 
-    ptr_free, self.va_data_chunk_ptr
+    if ptr_valid(self.va_cache_data) then ptr_free, *self.va_cache_data
+
+    ptr_free, self.va_cache_data, self.va_cache_chunks, self.va_cache_lastuse
+
+    if obj_valid(self.va_ra_bridge) then begin
+        if self.va_ra_bridge->Status() eq 1 then self.va_ra_bridge->Abort
+        obj_destroy, self.va_ra_bridge
+    endif
+
+    if self.va_ra_segname ne '' then shmunmap, self.va_ra_segname
+
+    ptr_free, self.va_ra_chunks
+
+    if self.va_map_segname ne '' then shmunmap, self.va_map_segname
 
     close, self.va_lun
 
@@ -928,6 +2323,48 @@ end
 ;                   
 ;   va_offset: The number of bytes to skip at the start
 ;              of the file.
+;
+;   va_brick_dimsptr: Pointer to the brick dimensions of a bricked
+;                     array file, or a null pointer for a file
+;                     stored in array order.
+;
+;   va_chunk_offsets: Pointer to the brick offset table of a 
+;                     compressed bricked file, or a null pointer.
+;
+;   va_out_type: The data type returned by subscripting, or 0 for 
+;                the file data type.
+;
+;   va_out_scale, va_out_offset: Applied to the data returned by
+;                                subscripting, after conversion to
+;                                va_out_type.
+;
+;   va_map_segname: The name of the shared memory segment
+;                   mapping the file, or '' if the file is 
+;                   not memory mapped.
+;
+;   va_map_offset: The file offset in units of the data type.
+;
+;   va_dirty: Pointer to an array with a flag for each data chunk,
+;             set when the chunk has been modified and not yet
+;             flushed, or a null pointer if the file is not writable.
+;
+;   va_cache_data: Pointer to an array of pointers to the cached
+;                  data chunks.
+;
+;   va_cache_chunks: Pointer to an array of the chunk index held in
+;                    each cache slot, -1 for an empty slot.
+;
+;   va_cache_lastuse: Pointer to an array of the value of 
+;                     va_cache_clock when each slot was last used.
+;
+;   va_ra_bridge: The read-ahead process, or a null object if read-
+;                 ahead is disabled.
+;
+;   va_ra_chunks: Pointer to an array of the chunks being read by
+;                 the read-ahead process, -1 for an unused slot.
+;
+;   va_ra_last, va_ra_stride: The last chunk accessed and the step
+;                             from the chunk accessed before it.
 ;                     
 ;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
 
@@ -942,6 +2379,11 @@ pro wmb_VirtualArray__define
                                                       $
                 va_rank               : fix(0),       $
                 va_dimsptr            : ptr_new(),    $
+                va_brick_dimsptr      : ptr_new(),    $
+                va_chunk_offsets      : ptr_new(),    $
+                va_out_type           : fix(0),       $
+                va_out_scale          : 0.0D,         $
+                va_out_offset         : 0.0D,         $
                 va_dtype              : fix(0),       $
                                                       $
                 va_dtype_size         : fix(0),       $               
@@ -951,11 +2393,26 @@ pro wmb_VirtualArray__define
                 va_offset             : long64(0),    $   
                 va_swapendian         : fix(0),       $         
                 va_writeable          : fix(0),       $
-                va_data_current_chunk : 0LL,          $
-                va_data_chunk_ptr     : ptr_new(),    $
                 va_data_chunk_size    : long64(0),    $
                 va_nchunks            : long64(0),    $
-                va_assoc_ptr          : ptr_new()     }
+                va_assoc_ptr          : ptr_new(),    $
+                va_map_segname        : '',           $
+                va_dirty              : ptr_new(),    $
+                va_map_offset         : 0LL,          $
+                va_cache_data         : ptr_new(),    $
+                va_cache_chunks       : ptr_new(),    $
+                va_cache_lastuse      : ptr_new(),    $
+                va_cache_clock        : 0LL,          $
+                va_cache_hits         : 0LL,          $
+                va_cache_misses       : 0LL,          $
+                va_cache_evictions    : 0LL,          $
+                va_ra_bridge          : obj_new(),    $
+                va_ra_segname         : '',           $
+                va_ra_command         : '',           $
+                va_ra_chunks          : ptr_new(),    $
+                va_ra_last            : 0LL,          $
+                va_ra_stride          : 0LL,          $
+                va_ra_prefetched      : 0LL           }
 
 end
 
@@ -0,0 +1,81 @@
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+;
+;   wmb_virtualarray_write_test
+;
+;   Checks that writes to a memory mapped virtual array are seen by
+;   reads which go through the chunk cache.  The chunks are loaded
+;   into the cache by a Copy, some elements are written through the
+;   mapping, and a second Copy must return the new values.
+;
+;cccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccccc
+
+pro wmb_virtualarray_write_test
+
+    compile_opt idl2, strictarrsubs
+
+    n = 4096L
+    chunk_elems = 256L
+
+    data = lindgen(n)
+
+    tmp_dir = filepath('', /TMP)
+    src_file = filepath('wmb_virtualarray_write_test.dat', ROOT_DIR=tmp_dir)
+    dst_file = filepath('wmb_virtualarray_write_test.out', ROOT_DIR=tmp_dir)
+
+    openw, lun, src_file, /GET_LUN
+    writeu, lun, data
+    free_lun, lun
+
+    va = obj_new('wmb_VirtualArray', src_file, [n], 3, $
+                 chunksize_bytes = chunk_elems * 4, $
+                 /mmap, /writable)
+
+    va.GetProperty, mmap = chk_mmap
+    if ~ chk_mmap then message, 'The file was not memory mapped'
+
+    ; load every chunk into the cache
+
+    openw, lun, dst_file, /GET_LUN
+    va.Copy, lun, /all
+    free_lun, lun
+
+    va.GetProperty, cache_misses = tmp_misses
+    if tmp_misses eq 0 then message, 'The chunks were not cached'
+
+    ; a single element, a run across a chunk boundary, and a set of
+    ; short scattered runs
+
+    va[300] = -7L
+    data[300] = -7L
+
+    va[chunk_elems-5:chunk_elems+4] = -lindgen(10) - 100
+    data[chunk_elems-5:chunk_elems+4] = -lindgen(10) - 100
+
+    tmp_index = [10L, 1000L, 2050L, 4000L]
+    va[tmp_index] = -1L
+    data[tmp_index] = -1L
+
+    openw, lun, dst_file, /GET_LUN
+    va.Copy, lun, /all
+    free_lun, lun
+
+    result = lonarr(n)
+
+    openr, lun, dst_file, /GET_LUN
+    readu, lun, result
+    free_lun, lun
+
+    obj_destroy, va
+
+    file_delete, src_file, dst_file, /ALLOW_NONEXISTENT
+
+    tmp_bad = where(result ne data, n_bad)
+
+    if n_bad gt 0 then $
+        message, string(n_bad, tmp_bad[0], result[tmp_bad[0]], data[tmp_bad[0]], $
+                        FORMAT='(I0," stale elements, first at ",I0,' + $
+                               '": ",I0," instead of ",I0)')
+
+    print, 'wmb_virtualarray_write_test: passed'
+
+end